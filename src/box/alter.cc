@@ -236,6 +236,16 @@ index_opts_decode(struct index_opts *opts, const char *map,
 			  "bloom_fpr must be greater than 0 and "
 			  "less than or equal to 1");
 	}
+	if (opts->bloom_type == bloom_type_MAX) {
+		tnt_raise(ClientError, ER_WRONG_INDEX_OPTIONS,
+			  BOX_INDEX_FIELD_OPTS, "bloom_type must be either "
+			  "'bloom' or 'xor'");
+	}
+	if (opts->compaction == compaction_policy_MAX) {
+		tnt_raise(ClientError, ER_WRONG_INDEX_OPTIONS,
+			  BOX_INDEX_FIELD_OPTS, "compaction must be either "
+			  "'leveled' or 'tiered'");
+	}
 }
 
 /**
@@ -1840,6 +1850,11 @@ on_replace_dd_space(struct trigger * /* trigger */, void *event)
 			tnt_raise(ClientError, ER_ALTER_SPACE,
 				  space_name(old_space),
 				  "replication group is immutable");
+		if (def->opts.compact_field_map !=
+		    old_space->def->opts.compact_field_map)
+			tnt_raise(ClientError, ER_ALTER_SPACE,
+				  space_name(old_space),
+				  "compact_field_map is immutable");
 		if (def->opts.is_view != old_space->def->opts.is_view)
 			tnt_raise(ClientError, ER_ALTER_SPACE,
 				  space_name(old_space),
@@ -48,9 +48,86 @@
 #include "error.h"
 #include "session.h"
 #include "cfg.h"
+#include "schema.h"
+#include "space.h"
+#include "txn.h"
+#include "rmean.h"
+#include "scoped_guard.h"
+
+#include <small/region.h>
 
 STRS(applier_state, applier_STATE);
 
+const char *applier_stat_strs[] = {
+	"rows",
+	"txns",
+};
+
+enum {
+	/** Max number of rows in a batch. */
+	APPLIER_BATCH_ROWS_MAX = 1024,
+	/** Max number of batches the fetcher may read ahead. */
+	APPLIER_QUEUE_BATCHES_MAX = 4,
+};
+
+/**
+ * A batch of rows received from the master and waiting to be
+ * applied. All rows of a batch originate from the same replica.
+ * Row bodies are copied to the batch region, so that the input
+ * buffer can be reused while the batch is waiting in the queue.
+ */
+struct applier_batch {
+	/** Link in applier->batch_queue. */
+	struct stailq_entry in_queue;
+	/** Memory for row bodies. */
+	struct region region;
+	/** Number of rows in the batch. */
+	int row_count;
+	/** Rows of the batch. */
+	struct xrow_header rows[APPLIER_BATCH_ROWS_MAX];
+};
+
+static struct applier_batch *
+applier_batch_new(void)
+{
+	struct applier_batch *batch = (struct applier_batch *)
+		malloc(sizeof(*batch));
+	if (batch == NULL) {
+		tnt_raise(OutOfMemory, sizeof(*batch), "malloc",
+			  "struct applier_batch");
+	}
+	region_create(&batch->region, &cord()->slabc);
+	batch->row_count = 0;
+	return batch;
+}
+
+static void
+applier_batch_delete(struct applier_batch *batch)
+{
+	region_destroy(&batch->region);
+	free(batch);
+}
+
+/** Append a copy of a row to a batch. */
+static void
+applier_batch_add_row(struct applier_batch *batch, struct xrow_header *row)
+{
+	assert(batch->row_count < APPLIER_BATCH_ROWS_MAX);
+	struct xrow_header *copy = &batch->rows[batch->row_count];
+	*copy = *row;
+	for (int i = 0; i < row->bodycnt; i++) {
+		size_t size = row->body[i].iov_len;
+		void *data = region_alloc(&batch->region, size);
+		if (data == NULL) {
+			tnt_raise(OutOfMemory, size, "region",
+				  "applier row body");
+		}
+		memcpy(data, row->body[i].iov_base, size);
+		copy->body[i].iov_base = data;
+	}
+	batch->row_count++;
+}
+
 static inline void
 applier_set_state(struct applier *applier, enum applier_state state)
 {
@@ -373,6 +450,494 @@ applier_join(struct applier *applier)
 	applier_set_state(applier, APPLIER_READY);
 }
 
+/**
+ * Queue a row received from the master for the reader fiber.
+ * The row is appended to the last batch in the queue if the
+ * batch has room for it, otherwise a new batch is started,
+ * provided the fetcher is not too far ahead of the reader.
+ */
+static void
+applier_queue_row(struct applier *applier, struct xrow_header *row)
+{
+	struct applier_batch *batch = NULL;
+	if (!stailq_empty(&applier->batch_queue)) {
+		batch = stailq_last_entry(&applier->batch_queue,
+					  struct applier_batch, in_queue);
+		if (batch->row_count == APPLIER_BATCH_ROWS_MAX ||
+		    batch->rows[0].replica_id != row->replica_id)
+			batch = NULL;
+	}
+	if (batch == NULL) {
+		while (applier->batch_count >= APPLIER_QUEUE_BATCHES_MAX) {
+			fiber_cond_wait(&applier->queue_cond);
+			fiber_testcancel();
+		}
+		batch = applier_batch_new();
+		stailq_add_tail_entry(&applier->batch_queue, batch, in_queue);
+		applier->batch_count++;
+	}
+	applier_batch_add_row(batch, row);
+}
+
+/**
+ * Read rows from the master and queue them until an error
+ * occurs or the fiber is cancelled.
+ */
+static void
+applier_fetch(struct applier *applier)
+{
+	struct ev_io *coio = &applier->io;
+	struct ibuf *ibuf = &applier->ibuf;
+	struct xrow_header row;
+
+	while (true) {
+		/*
+		 * Tarantool < 1.7.7 does not send periodic heartbeat
+		 * messages so we can't assume that if we haven't heard
+		 * from the master for quite a while the connection is
+		 * broken - the master might just be idle.
+		 */
+		if (applier->version_id < version_id(1, 7, 7)) {
+			coio_read_xrow(coio, ibuf, &row);
+		} else {
+			double timeout = replication_disconnect_timeout();
+			coio_read_xrow_timeout_xc(coio, ibuf, &row, timeout);
+		}
+
+		if (iproto_type_is_error(row.type))
+			xrow_decode_error_xc(&row);  /* error */
+		/* Replication request. */
+		if (row.replica_id == REPLICA_ID_NIL ||
+		    row.replica_id >= VCLOCK_MAX) {
+			/*
+			 * A safety net, this can only occur
+			 * if we're fed a strangely broken xlog.
+			 */
+			tnt_raise(ClientError, ER_UNKNOWN_REPLICA,
+				  int2str(row.replica_id),
+				  tt_uuid_str(&REPLICASET_UUID));
+		}
+
+		applier->lag = ev_now(loop()) - row.tm;
+		applier->last_row_time = ev_monotonic_now(loop());
+
+		/*
+		 * Heartbeats and rows that have already been
+		 * applied are not queued, but still wake up the
+		 * reader so that it re-evaluates the applier
+		 * state and sends an ACK.
+		 */
+		if (vclock_get(&replicaset.vclock, row.replica_id) < row.lsn)
+			applier_queue_row(applier, &row);
+		fiber_cond_signal(&applier->batch_cond);
+		if (ibuf_used(ibuf) == 0)
+			ibuf_reset(ibuf);
+		fiber_gc();
+	}
+}
+
+/**
+ * Fiber function to read rows from the master ahead of the
+ * applier fiber. While the applier is waiting for WAL to commit
+ * a batch of rows, the next batch is received and decoded here.
+ * On error the fiber stops and the applier re-throws the error
+ * once it has applied all rows queued so far.
+ */
+static int
+applier_fetch_f(va_list ap)
+{
+	struct applier *applier = va_arg(ap, struct applier *);
+	try {
+		applier_fetch(applier);
+	} catch (FiberIsCancelled *e) {
+		/* Cancelled by applier_disconnect(). */
+		diag_clear(diag_get());
+		return 0;
+	} catch (Exception *e) {
+		fiber_cond_signal(&applier->batch_cond);
+		return -1;
+	}
+	unreachable();
+	return 0;
+}
+
+/**
+ * Return the space a row can be applied to as a part of a
+ * multi-statement transaction or NULL if the row must be applied
+ * on its own. The latter is the case for rows of system spaces,
+ * since DDL can't be executed in a multi-statement transaction,
+ * and for rows that don't modify any space, such as NOP.
+ */
+static struct space *
+applier_row_space(struct xrow_header *row)
+{
+	if (row->type == IPROTO_NOP || !iproto_type_is_dml(row->type))
+		return NULL;
+	struct request request;
+	if (xrow_decode_dml(row, &request, 0) != 0) {
+		/* Let applier_apply_row() report the error. */
+		diag_clear(diag_get());
+		return NULL;
+	}
+	struct space *space = space_by_id(request.space_id);
+	if (space == NULL || space_is_system(space))
+		return NULL;
+	return space;
+}
+
+/**
+ * Apply a single row in its own transaction.
+ */
+static void
+applier_apply_row(struct applier *applier, struct xrow_header *row)
+{
+	/**
+	 * Promote the replica set vclock before
+	 * applying the row. If there is an
+	 * exception (conflict) applying the row,
+	 * the row is skipped when the replication
+	 * is resumed.
+	 */
+	vclock_follow_xrow(&replicaset.vclock, row);
+	if (xstream_write(applier->subscribe_stream, row) != 0) {
+		struct error *e = diag_last_error(diag_get());
+		/**
+		 * Silently skip ER_TUPLE_FOUND error if such
+		 * option is set in config.
+		 */
+		if (e->type == &type_ClientError &&
+		    box_error_code(e) == ER_TUPLE_FOUND &&
+		    replication_skip_conflict)
+			diag_clear(diag_get());
+		else
+			diag_raise();
+	}
+	rmean_collect(applier->rmean, APPLIER_STAT_ROWS, 1);
+	rmean_collect(applier->rmean, APPLIER_STAT_TXNS, 1);
+}
+
+/**
+ * Apply consecutive rows of the same replica in one transaction,
+ * so that they are written to WAL at once. If the transaction
+ * fails, fall back on applying the rows one by one: this way
+ * a conflict is skipped (see replication_skip_conflict) or
+ * reported for the row that caused it, exactly as if the rows
+ * had never been batched.
+ */
+static void
+applier_apply_rows(struct applier *applier, struct xrow_header *rows,
+		   int count)
+{
+	if (count > 1) {
+		if (box_txn_begin() != 0)
+			diag_raise();
+		int i;
+		for (i = 0; i < count; i++) {
+			if (xstream_write(applier->subscribe_stream,
+					  &rows[i]) != 0)
+				break;
+		}
+		if (i == count && box_txn_commit() == 0) {
+			struct xrow_header *last = &rows[count - 1];
+			/*
+			 * Rows of this instance coming back from
+			 * the master promote the vclock on WAL write.
+			 */
+			if (vclock_get(&replicaset.vclock,
+				       last->replica_id) < last->lsn)
+				vclock_follow_xrow(&replicaset.vclock, last);
+			rmean_collect(applier->rmean, APPLIER_STAT_ROWS, count);
+			rmean_collect(applier->rmean, APPLIER_STAT_TXNS, 1);
+			return;
+		}
+		box_txn_rollback();
+		diag_clear(diag_get());
+	}
+	for (int i = 0; i < count; i++)
+		applier_apply_row(applier, &rows[i]);
+}
+
+/**
+ * A fiber applying rows dispatched to it by the applier,
+ * see applier_apply_pipelined().
+ */
+struct applier_worker {
+	/** The applier this worker belongs to. */
+	struct applier *applier;
+	/** Worker fiber. */
+	struct fiber *fiber;
+	/** Rows to apply, linked by applier_task::in_worker. */
+	struct stailq tasks;
+	/** Signaled when a task is queued. */
+	struct fiber_cond cond;
+};
+
+/**
+ * Rows dispatched to worker fibers. Although the rows are
+ * applied by different fibers, they are executed and submitted
+ * to WAL strictly in the order of their LSNs: each row waits
+ * for its turn, which is passed to the next row as soon as the
+ * row has been submitted. So it's only WAL writes of the rows
+ * that overlap, which is enough to make the apply throughput
+ * scale with the number of workers.
+ */
+struct applier_segment {
+	/** Rows to apply. */
+	struct xrow_header *rows;
+	/** Index of the row whose turn it is to be applied. */
+	int turn;
+	/** Number of rows not processed yet. */
+	int pending;
+	/** Error of the first row that failed to apply. */
+	struct diag diag;
+	/** Signaled whenever turn or pending changes. */
+	struct fiber_cond cond;
+};
+
+/** A row of a segment dispatched to a worker. */
+struct applier_task {
+	/** Link in applier_worker::tasks. */
+	struct stailq_entry in_worker;
+	/** Segment the row belongs to. */
+	struct applier_segment *segment;
+	/** Index of the row in the segment. */
+	int idx;
+};
+
+/**
+ * Apply a dispatched row. Rows of a segment following a failed
+ * one are dropped, as the applier would stop at the failed row
+ * if it applied rows one by one.
+ */
+static void
+applier_task_execute(struct applier *applier, struct applier_task *task)
+{
+	struct applier_segment *segment = task->segment;
+	while (segment->turn != task->idx)
+		fiber_cond_wait(&segment->cond);
+	struct xrow_header *row = &segment->rows[task->idx];
+	bool is_dropped = !diag_is_empty(&segment->diag);
+	int rc = 0;
+	if (!is_dropped) {
+		/* See applier_apply_row(). */
+		vclock_follow_xrow(&replicaset.vclock, row);
+		if (box_txn_begin() != 0 ||
+		    xstream_write(applier->subscribe_stream, row) != 0)
+			rc = -1;
+	}
+	/*
+	 * Pass the turn to the next row. The row won't be
+	 * executed until this fiber yields, i.e. until this
+	 * row has been submitted to WAL, because a memtx
+	 * transaction is aborted if it yields.
+	 */
+	segment->turn++;
+	fiber_cond_broadcast(&segment->cond);
+	if (is_dropped)
+		goto out;
+	if (rc == 0)
+		rc = box_txn_commit();
+	if (rc != 0) {
+		box_txn_rollback();
+		struct error *e = diag_last_error(diag_get());
+		/**
+		 * Silently skip ER_TUPLE_FOUND error if such
+		 * option is set in config.
+		 */
+		if (e->type == &type_ClientError &&
+		    box_error_code(e) == ER_TUPLE_FOUND &&
+		    replication_skip_conflict) {
+			diag_clear(diag_get());
+		} else {
+			diag_move(diag_get(), &segment->diag);
+			goto out;
+		}
+	}
+	rmean_collect(applier->rmean, APPLIER_STAT_ROWS, 1);
+	rmean_collect(applier->rmean, APPLIER_STAT_TXNS, 1);
+out:
+	segment->pending--;
+	fiber_cond_broadcast(&segment->cond);
+}
+
+static int
+applier_worker_f(va_list ap)
+{
+	struct applier_worker *worker = va_arg(ap, struct applier_worker *);
+	/*
+	 * Set correct session type for use in on_replace()
+	 * triggers.
+	 */
+	current_session()->type = SESSION_TYPE_APPLIER;
+	while (!fiber_is_cancelled()) {
+		if (stailq_empty(&worker->tasks)) {
+			fiber_cond_wait(&worker->cond);
+			continue;
+		}
+		struct applier_task *task =
+			stailq_shift_entry(&worker->tasks,
+					   struct applier_task, in_worker);
+		applier_task_execute(worker->applier, task);
+		fiber_gc();
+	}
+	return 0;
+}
+
+/** Start worker fibers if configured, see replication_wal_pipeline. */
+static void
+applier_start_workers(struct applier *applier)
+{
+	assert(applier->workers == NULL);
+	int count = replication_wal_pipeline;
+	if (count <= 1)
+		return;
+	struct applier_worker *workers = (struct applier_worker *)
+		calloc(count, sizeof(*workers));
+	if (workers == NULL) {
+		tnt_raise(OutOfMemory, count * sizeof(*workers), "calloc",
+			  "applier workers");
+	}
+	applier->workers = workers;
+	char name[FIBER_NAME_MAX];
+	for (int i = 0; i < count; i++) {
+		struct applier_worker *worker = &workers[i];
+		worker->applier = applier;
+		stailq_create(&worker->tasks);
+		fiber_cond_create(&worker->cond);
+		applier->worker_count++;
+
+		int pos = snprintf(name, sizeof(name), "applier%d/", i);
+		uri_format(name + pos, sizeof(name) - pos,
+			   &applier->uri, false);
+		worker->fiber = fiber_new_xc(name, applier_worker_f);
+		fiber_set_joinable(worker->fiber, true);
+		fiber_start(worker->fiber, worker);
+	}
+}
+
+/** Stop worker fibers started by applier_start_workers(). */
+static void
+applier_stop_workers(struct applier *applier)
+{
+	for (int i = 0; i < applier->worker_count; i++) {
+		struct applier_worker *worker = &applier->workers[i];
+		if (worker->fiber != NULL) {
+			fiber_cancel(worker->fiber);
+			fiber_join(worker->fiber);
+		}
+		assert(stailq_empty(&worker->tasks));
+		fiber_cond_destroy(&worker->cond);
+	}
+	free(applier->workers);
+	applier->workers = NULL;
+	applier->worker_count = 0;
+}
+
+/**
+ * Apply memtx rows pipelining their WAL writes. The rows are
+ * not applied concurrently: WAL requires rows of the same
+ * replica to be submitted in the order of their LSNs, so each
+ * row is executed only after the previous one has been sent to
+ * WAL, see applier_task_execute(). Since a worker is busy until
+ * the WAL write of its row completes, the rows are dispatched
+ * to the workers round-robin, which lets up to worker_count
+ * rows be written to WAL at once.
+ */
+static void
+applier_apply_pipelined(struct applier *applier, struct xrow_header *rows,
+			int count)
+{
+	struct applier_task *tasks = (struct applier_task *)
+		region_alloc(&fiber()->gc, count * sizeof(*tasks));
+	if (tasks == NULL) {
+		tnt_raise(OutOfMemory, count * sizeof(*tasks), "region",
+			  "applier tasks");
+	}
+	struct applier_segment segment;
+	segment.rows = rows;
+	segment.turn = 0;
+	segment.pending = count;
+	diag_create(&segment.diag);
+	fiber_cond_create(&segment.cond);
+
+	for (int i = 0; i < count; i++) {
+		assert(applier_row_space(&rows[i]) != NULL &&
+		       space_is_memtx(applier_row_space(&rows[i])));
+		struct applier_worker *worker =
+			&applier->workers[i % applier->worker_count];
+		struct applier_task *task = &tasks[i];
+		task->segment = &segment;
+		task->idx = i;
+		stailq_add_tail_entry(&worker->tasks, task, in_worker);
+		fiber_cond_signal(&worker->cond);
+	}
+	/*
+	 * The segment is referenced by the workers, so wait
+	 * for all rows to be processed even if cancelled.
+	 */
+	while (segment.pending > 0)
+		fiber_cond_wait(&segment.cond);
+	fiber_cond_destroy(&segment.cond);
+	if (!diag_is_empty(&segment.diag)) {
+		diag_move(&segment.diag, diag_get());
+		diag_raise();
+	}
+}
+
+/**
+ * Apply a batch of rows received from the master. The batch
+ * is split into runs of rows that can be committed in one
+ * transaction, see applier_row_space(). If worker fibers are
+ * running, WAL writes of runs of memtx rows are pipelined.
+ */
+static void
+applier_apply_batch(struct applier *applier, struct applier_batch *batch)
+{
+	if (batch->row_count == 0)
+		return;
+	uint32_t replica_id = batch->rows[0].replica_id;
+	struct replica *replica = replica_by_id(replica_id);
+	struct latch *latch = (replica ? &replica->order_latch :
+			       &replicaset.applier.order_latch);
+	/*
+	 * In a full mesh topology, the same set of changes
+	 * may arrive via two concurrently running appliers.
+	 * Rows already applied by another applier are skipped
+	 * by the vclock check below, but the remaining ones may
+	 * execute out of order, when the transaction yields on
+	 * WAL. Hence we need a latch to strictly order all
+	 * changes which belong to the same server id.
+	 */
+	latch_lock(latch);
+	auto latch_guard = make_scoped_guard([=] {
+		latch_unlock(latch);
+	});
+	int i = 0;
+	while (i < batch->row_count) {
+		struct xrow_header *row = &batch->rows[i];
+		if (vclock_get(&replicaset.vclock, replica_id) >= row->lsn) {
+			i++;
+			continue;
+		}
+		int end = i + 1;
+		struct space *space = applier_row_space(row);
+		while (space != NULL && end < batch->row_count &&
+		       batch->rows[end].lsn > batch->rows[end - 1].lsn) {
+			struct space *next =
+				applier_row_space(&batch->rows[end]);
+			if (next == NULL || next->engine != space->engine)
+				break;
+			end++;
+		}
+		if (applier->workers != NULL && space != NULL &&
+		    space_is_memtx(space))
+			applier_apply_pipelined(applier, row, end - i);
+		else
+			applier_apply_rows(applier, row, end - i);
+		i = end;
+	}
+}
+
 /**
  * Execute and process SUBSCRIBE request (follow updates from a master).
  */
@@ -453,10 +1018,24 @@ applier_subscribe(struct applier *applier)
 
 	applier->lag = TIMEOUT_INFINITY;
 
+	/* Start reading rows ahead of applying them. */
+	assert(applier->fetcher == NULL);
+	char name[FIBER_NAME_MAX];
+	int pos = snprintf(name, sizeof(name), "applierf/");
+	uri_format(name + pos, sizeof(name) - pos, &applier->uri, false);
+
+	applier->fetcher = fiber_new_xc(name, applier_fetch_f);
+	fiber_set_joinable(applier->fetcher, true);
+	fiber_start(applier->fetcher, applier);
+
+	applier_start_workers(applier);
+
 	/*
 	 * Process a stream of rows from the binary log.
 	 */
 	while (true) {
+		fiber_testcancel();
+
 		if (applier->state == APPLIER_FINAL_JOIN &&
 		    instance_id != REPLICA_ID_NIL) {
 			say_info("final data received");
@@ -478,82 +1057,34 @@ applier_subscribe(struct applier *applier)
 			applier_set_state(applier, APPLIER_FOLLOW);
 		}
 
-		/*
-		 * Tarantool < 1.7.7 does not send periodic heartbeat
-		 * messages so we can't assume that if we haven't heard
-		 * from the master for quite a while the connection is
-		 * broken - the master might just be idle.
-		 */
-		if (applier->version_id < version_id(1, 7, 7)) {
-			coio_read_xrow(coio, ibuf, &row);
-		} else {
-			double timeout = replication_disconnect_timeout();
-			coio_read_xrow_timeout_xc(coio, ibuf, &row, timeout);
-		}
-
-		if (iproto_type_is_error(row.type))
-			xrow_decode_error_xc(&row);  /* error */
-		/* Replication request. */
-		if (row.replica_id == REPLICA_ID_NIL ||
-		    row.replica_id >= VCLOCK_MAX) {
+		if (!stailq_empty(&applier->batch_queue)) {
+			struct applier_batch *batch =
+				stailq_shift_entry(&applier->batch_queue,
+						   struct applier_batch,
+						   in_queue);
+			applier->batch_count--;
+			fiber_cond_signal(&applier->queue_cond);
+			auto batch_guard = make_scoped_guard([=] {
+				applier_batch_delete(batch);
+			});
+			applier_apply_batch(applier, batch);
+		} else if (fiber_is_dead(applier->fetcher)) {
 			/*
-			 * A safety net, this can only occur
-			 * if we're fed a strangely broken xlog.
+			 * All rows received before the fetcher
+			 * failed have been applied, re-throw its
+			 * error.
 			 */
-			tnt_raise(ClientError, ER_UNKNOWN_REPLICA,
-				  int2str(row.replica_id),
-				  tt_uuid_str(&REPLICASET_UUID));
-		}
-
-		applier->lag = ev_now(loop()) - row.tm;
-		applier->last_row_time = ev_monotonic_now(loop());
-
-		if (vclock_get(&replicaset.vclock, row.replica_id) < row.lsn) {
-			/**
-			 * Promote the replica set vclock before
-			 * applying the row. If there is an
-			 * exception (conflict) applying the row,
-			 * the row is skipped when the replication
-			 * is resumed.
-			 */
-			vclock_follow_xrow(&replicaset.vclock, &row);
-			struct replica *replica = replica_by_id(row.replica_id);
-			struct latch *latch = (replica ? &replica->order_latch :
-					       &replicaset.applier.order_latch);
-			/*
-			 * In a full mesh topology, the same set
-			 * of changes may arrive via two
-			 * concurrently running appliers. Thanks
-			 * to vclock_follow() above, the first row
-			 * in the set will be skipped - but the
-			 * remaining may execute out of order,
-			 * when the following xstream_write()
-			 * yields on WAL. Hence we need a latch to
-			 * strictly order all changes which belong
-			 * to the same server id.
-			 */
-			latch_lock(latch);
-			int res = xstream_write(applier->subscribe_stream, &row);
-			latch_unlock(latch);
-			if (res != 0) {
-				struct error *e = diag_last_error(diag_get());
-				/**
-				 * Silently skip ER_TUPLE_FOUND error if such
-				 * option is set in config.
-				 */
-				if (e->type == &type_ClientError &&
-				    box_error_code(e) == ER_TUPLE_FOUND &&
-				    replication_skip_conflict)
-					diag_clear(diag_get());
-				else
-					diag_raise();
-			}
+			struct fiber *fetcher = applier->fetcher;
+			applier->fetcher = NULL;
+			if (fiber_join(fetcher) != 0)
+				diag_raise();
+			unreachable();
+		} else {
+			fiber_cond_wait(&applier->batch_cond);
 		}
 		if (applier->state == APPLIER_SYNC ||
 		    applier->state == APPLIER_FOLLOW)
 			fiber_cond_signal(&applier->writer_cond);
-		if (ibuf_used(ibuf) == 0)
-			ibuf_reset(ibuf);
 		fiber_gc();
 	}
 }
@@ -567,6 +1098,26 @@ applier_disconnect(struct applier *applier, enum applier_state state)
 		fiber_join(applier->writer);
 		applier->writer = NULL;
 	}
+	if (applier->fetcher != NULL) {
+		fiber_cancel(applier->fetcher);
+		/*
+		 * Keep the error that stopped the applier rather
+		 * than the one the fetcher might have failed with.
+		 */
+		struct diag diag;
+		diag_create(&diag);
+		diag_move(diag_get(), &diag);
+		fiber_join(applier->fetcher);
+		diag_move(&diag, diag_get());
+		applier->fetcher = NULL;
+	}
+	applier_stop_workers(applier);
+	struct applier_batch *batch, *next;
+	stailq_foreach_entry_safe(batch, next, &applier->batch_queue,
+				  in_queue)
+		applier_batch_delete(batch);
+	stailq_create(&applier->batch_queue);
+	applier->batch_count = 0;
 
 	coio_close(loop(), &applier->io);
 	/* Clear all unparsed input. */
@@ -724,6 +1275,16 @@ applier_new(const char *uri, struct xstream *join_stream,
 	rlist_create(&applier->on_state);
 	fiber_cond_create(&applier->resume_cond);
 	fiber_cond_create(&applier->writer_cond);
+	stailq_create(&applier->batch_queue);
+	fiber_cond_create(&applier->batch_cond);
+	fiber_cond_create(&applier->queue_cond);
+	applier->rmean = rmean_new(applier_stat_strs, APPLIER_STAT_LAST);
+	if (applier->rmean == NULL) {
+		diag_set(OutOfMemory, sizeof(struct rmean), "rmean_new",
+			 "struct rmean");
+		applier_delete(applier);
+		return NULL;
+	}
 
 	return applier;
 }
@@ -732,11 +1293,17 @@ void
 applier_delete(struct applier *applier)
 {
 	assert(applier->reader == NULL && applier->writer == NULL);
+	assert(applier->fetcher == NULL && applier->workers == NULL);
+	assert(stailq_empty(&applier->batch_queue));
 	ibuf_destroy(&applier->ibuf);
 	assert(applier->io.fd == -1);
 	trigger_destroy(&applier->on_state);
 	fiber_cond_destroy(&applier->resume_cond);
 	fiber_cond_destroy(&applier->writer_cond);
+	fiber_cond_destroy(&applier->batch_cond);
+	fiber_cond_destroy(&applier->queue_cond);
+	if (applier->rmean != NULL)
+		rmean_delete(applier->rmean);
 	free(applier);
 }
 
@@ -38,6 +38,7 @@
 #include <small/ibuf.h>
 
 #include "fiber_cond.h"
+#include "salad/stailq.h"
 #include "trigger.h"
 #include "trivia/util.h"
 #include "tt_uuid.h"
@@ -46,9 +47,22 @@
 #include "xrow.h"
 
 struct xstream;
+struct rmean;
+struct applier_worker;
 
 enum { APPLIER_SOURCE_MAXLEN = 1024 }; /* enough to fit URI with passwords */
 
+/** Applier statistics, see box.info.replication[n].upstream.apply */
+enum applier_stat {
+	/** Rows applied. */
+	APPLIER_STAT_ROWS,
+	/** Local transactions the rows were applied in. */
+	APPLIER_STAT_TXNS,
+	APPLIER_STAT_LAST,
+};
+
+extern const char *applier_stat_strs[];
+
 #define applier_STATE(_)                                             \
 	_(APPLIER_OFF, 0)                                            \
 	_(APPLIER_CONNECT, 1)                                        \
@@ -78,6 +92,29 @@ struct applier {
 	struct fiber *writer;
 	/** Writer cond. */
 	struct fiber_cond writer_cond;
+	/**
+	 * Background fiber reading rows from the master ahead
+	 * of the reader fiber applying them.
+	 */
+	struct fiber *fetcher;
+	/** Batches of rows read but not applied yet. */
+	struct stailq batch_queue;
+	/** Number of batches in batch_queue. */
+	int batch_count;
+	/** Signaled by the fetcher when a row is queued or it stops. */
+	struct fiber_cond batch_cond;
+	/** Signaled by the reader when a batch is dequeued. */
+	struct fiber_cond queue_cond;
+	/** Apply throughput, see enum applier_stat. */
+	struct rmean *rmean;
+	/**
+	 * Fibers pipelining WAL writes of applied rows, see
+	 * replication_wal_pipeline. NULL if rows are
+	 * applied by the reader fiber.
+	 */
+	struct applier_worker *workers;
+	/** Number of elements in the workers array. */
+	int worker_count;
 	/** Finite-state machine */
 	enum applier_state state;
 	/** Local time of this replica when the last row has been received */
@@ -155,7 +155,8 @@ blackhole_engine_create_space(struct engine *engine, struct space_def *def,
 	/* Allocate tuples on runtime arena, but check space format. */
 	struct tuple_format *format;
 	format = tuple_format_new(&tuple_format_runtime->vtab, NULL, 0, 0,
-				  def->fields, def->field_count, def->dict);
+				  0, false, def->fields, def->field_count,
+				  def->dict);
 	if (format == NULL) {
 		free(space);
 		return NULL;
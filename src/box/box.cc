@@ -465,6 +465,17 @@ box_check_replication_sync_lag(void)
 	return lag;
 }
 
+static int
+box_check_replication_wal_pipeline(void)
+{
+	int count = cfg_geti("replication_wal_pipeline");
+	if (count <= 0) {
+		tnt_raise(ClientError, ER_CFG, "replication_wal_pipeline",
+			  "the value must be greater than 0");
+	}
+	return count;
+}
+
 static double
 box_check_replication_sync_timeout(void)
 {
@@ -515,6 +526,42 @@ box_check_readahead(int readahead)
 	}
 }
 
+static int
+box_check_iproto_threads(int threads)
+{
+	if (threads < 1 || threads > IPROTO_THREADS_MAX) {
+		tnt_raise(ClientError, ER_CFG, "iproto_threads",
+			  tt_sprintf("must be greater than or equal to 1 "
+				     "and less than or equal to %d",
+				     IPROTO_THREADS_MAX));
+	}
+	return threads;
+}
+
+static int
+box_check_memtx_snap_threads(int threads)
+{
+	if (threads < 1 || threads > MEMTX_SNAP_THREADS_MAX) {
+		tnt_raise(ClientError, ER_CFG, "memtx_snap_threads",
+			  tt_sprintf("must be greater than or equal to 1 "
+				     "and less than or equal to %d",
+				     MEMTX_SNAP_THREADS_MAX));
+	}
+	return threads;
+}
+
+static int
+box_check_memtx_sort_threads(int threads)
+{
+	if (threads < 0 || threads > MEMTX_SORT_THREADS_MAX) {
+		tnt_raise(ClientError, ER_CFG, "memtx_sort_threads",
+			  tt_sprintf("must be greater than or equal to 0 "
+				     "and less than or equal to %d",
+				     MEMTX_SORT_THREADS_MAX));
+	}
+	return threads;
+}
+
 static void
 box_check_checkpoint_count(int checkpoint_count)
 {
@@ -546,6 +593,78 @@ box_check_wal_max_size(int64_t wal_max_size)
 	return wal_max_size;
 }
 
+static int64_t
+box_check_wal_cache(int64_t size)
+{
+	if (size < 0) {
+		tnt_raise(ClientError, ER_CFG, "wal_cache",
+			  "must not be less than 0");
+	}
+	return size;
+}
+
+static double
+box_check_wal_group_commit_timeout(double timeout)
+{
+	if (timeout < 0) {
+		tnt_raise(ClientError, ER_CFG, "wal_group_commit_timeout",
+			  "must not be less than 0");
+	}
+	return timeout;
+}
+
+static int64_t
+box_check_wal_group_commit_bytes(int64_t bytes)
+{
+	if (bytes < 0) {
+		tnt_raise(ClientError, ER_CFG, "wal_group_commit_bytes",
+			  "must not be less than 0");
+	}
+	return bytes;
+}
+
+static int
+box_check_wal_stripe_dirs(void)
+{
+	int count = cfg_getarr_size("wal_stripe_dirs");
+	if (count > WAL_STRIPE_MAX - 1) {
+		tnt_raise(ClientError, ER_CFG, "wal_stripe_dirs",
+			  tt_sprintf("the number of directories must not "
+				     "exceed %d", WAL_STRIPE_MAX - 1));
+	}
+	for (int i = 0; i < count; i++) {
+		const char *dir = cfg_getarr_elem("wal_stripe_dirs", i);
+		if (dir == NULL || *dir == '\0') {
+			tnt_raise(ClientError, ER_CFG, "wal_stripe_dirs",
+				  "expected a directory name");
+		}
+	}
+	if (count > 0 && cfg_geti("hot_standby")) {
+		tnt_raise(ClientError, ER_CFG, "wal_stripe_dirs",
+			  "hot standby mode is not supported with "
+			  "WAL stripes");
+	}
+	return count;
+}
+
+int
+box_wal_dirs(const char **dirs)
+{
+	/*
+	 * cfg_gets() returns a pointer to a rotating buffer,
+	 * so copy the names to keep them valid for the caller.
+	 */
+	static char names[WAL_STRIPE_MAX][PATH_MAX];
+	int count = box_check_wal_stripe_dirs() + 1;
+	for (int i = 0; i < count; i++) {
+		const char *dir = i == 0 ? cfg_gets("wal_dir") :
+			cfg_getarr_elem("wal_stripe_dirs", i - 1);
+		snprintf(names[i], sizeof(names[i]), "%s", dir);
+		dirs[i] = names[i];
+	}
+	return count;
+}
+
 static int64_t
 box_check_memtx_memory(int64_t memory)
 {
@@ -566,6 +685,26 @@ box_check_vinyl_memory(int64_t memory)
 	return memory;
 }
 
+static int
+box_check_vinyl_max_subcompactions(int count)
+{
+	if (count < 1) {
+		tnt_raise(ClientError, ER_CFG, "vinyl_max_subcompactions",
+			  "must be greater than or equal to 1");
+	}
+	return count;
+}
+
+static int
+box_check_vinyl_readahead(int pages)
+{
+	if (pages < 0) {
+		tnt_raise(ClientError, ER_CFG, "vinyl_readahead",
+			  "must be greater than or equal to 0");
+	}
+	return pages;
+}
+
 static void
 box_check_vinyl_options(void)
 {
@@ -578,6 +717,8 @@ box_check_vinyl_options(void)
 	double bloom_fpr = cfg_getd("vinyl_bloom_fpr");
 
 	box_check_vinyl_memory(cfg_geti64("vinyl_memory"));
+	box_check_vinyl_max_subcompactions(cfg_geti("vinyl_max_subcompactions"));
+	box_check_vinyl_readahead(cfg_geti("vinyl_readahead"));
 
 	if (read_threads < 1) {
 		tnt_raise(ClientError, ER_CFG, "vinyl_read_threads",
@@ -624,11 +765,20 @@ box_check_config()
 	box_check_replication_connect_quorum();
 	box_check_replication_sync_lag();
 	box_check_replication_sync_timeout();
+	box_check_replication_wal_pipeline();
 	box_check_readahead(cfg_geti("readahead"));
+	box_check_iproto_threads(cfg_geti("iproto_threads"));
+	box_check_memtx_snap_threads(cfg_geti("memtx_snap_threads"));
+	box_check_memtx_sort_threads(cfg_geti("memtx_sort_threads"));
 	box_check_checkpoint_count(cfg_geti("checkpoint_count"));
 	box_check_wal_max_rows(cfg_geti64("rows_per_wal"));
 	box_check_wal_max_size(cfg_geti64("wal_max_size"));
 	box_check_wal_mode(cfg_gets("wal_mode"));
+	box_check_wal_cache(cfg_geti64("wal_cache"));
+	box_check_wal_group_commit_timeout(
+		cfg_getd("wal_group_commit_timeout"));
+	box_check_wal_group_commit_bytes(cfg_geti64("wal_group_commit_bytes"));
+	box_check_wal_stripe_dirs();
 	box_check_memtx_memory(cfg_geti64("memtx_memory"));
 	box_check_memtx_min_tuple_size(cfg_geti64("memtx_min_tuple_size"));
 	box_check_vinyl_options();
@@ -755,6 +905,12 @@ box_set_replication_skip_conflict(void)
 	replication_skip_conflict = cfg_geti("replication_skip_conflict");
 }
 
+void
+box_set_replication_wal_pipeline(void)
+{
+	replication_wal_pipeline = box_check_replication_wal_pipeline();
+}
+
 void
 box_listen(void)
 {
@@ -818,6 +974,42 @@ box_set_memtx_max_tuple_size(void)
 			cfg_geti("memtx_max_tuple_size"));
 }
 
+void
+box_set_memtx_snap_threads(void)
+{
+	struct memtx_engine *memtx;
+	memtx = (struct memtx_engine *)engine_by_name("memtx");
+	assert(memtx != NULL);
+	memtx_engine_set_snap_threads(memtx,
+		box_check_memtx_snap_threads(cfg_geti("memtx_snap_threads")));
+}
+
+void
+box_set_memtx_sort_threads(void)
+{
+	struct memtx_engine *memtx;
+	memtx = (struct memtx_engine *)engine_by_name("memtx");
+	assert(memtx != NULL);
+	memtx_engine_set_sort_threads(memtx,
+		box_check_memtx_sort_threads(cfg_geti("memtx_sort_threads")));
+}
+
+void
+box_set_wal_cache(void)
+{
+	wal_set_cache_size(box_check_wal_cache(cfg_geti64("wal_cache")));
+}
+
+void
+box_set_wal_group_commit(void)
+{
+	double timeout = box_check_wal_group_commit_timeout(
+		cfg_getd("wal_group_commit_timeout"));
+	int64_t bytes = box_check_wal_group_commit_bytes(
+		cfg_geti64("wal_group_commit_bytes"));
+	wal_set_group_commit(timeout, bytes);
+}
+
 void
 box_set_too_long_threshold(void)
 {
@@ -874,6 +1066,46 @@ box_set_vinyl_cache(void)
 	vinyl_engine_set_cache(vinyl, cfg_geti64("vinyl_cache"));
 }
 
+void
+box_set_vinyl_page_cache(void)
+{
+	struct vinyl_engine *vinyl;
+	vinyl = (struct vinyl_engine *)engine_by_name("vinyl");
+	assert(vinyl != NULL);
+	vinyl_engine_set_page_cache(vinyl, cfg_geti64("vinyl_page_cache"));
+}
+
+void
+box_set_vinyl_run_index_cache(void)
+{
+	struct vinyl_engine *vinyl;
+	vinyl = (struct vinyl_engine *)engine_by_name("vinyl");
+	assert(vinyl != NULL);
+	vinyl_engine_set_run_index_cache(vinyl,
+			cfg_geti64("vinyl_run_index_cache"));
+}
+
+void
+box_set_vinyl_max_subcompactions(void)
+{
+	struct vinyl_engine *vinyl;
+	vinyl = (struct vinyl_engine *)engine_by_name("vinyl");
+	assert(vinyl != NULL);
+	vinyl_engine_set_max_subcompactions(vinyl,
+		box_check_vinyl_max_subcompactions(
+			cfg_geti("vinyl_max_subcompactions")));
+}
+
+void
+box_set_vinyl_readahead(void)
+{
+	struct vinyl_engine *vinyl;
+	vinyl = (struct vinyl_engine *)engine_by_name("vinyl");
+	assert(vinyl != NULL);
+	vinyl_engine_set_readahead(vinyl,
+		box_check_vinyl_readahead(cfg_geti("vinyl_readahead")));
+}
+
 void
 box_set_vinyl_timeout(void)
 {
@@ -888,8 +1120,10 @@ box_set_net_msg_max(void)
 {
 	int new_iproto_msg_max = cfg_geti("net_msg_max");
 	iproto_set_msg_max(new_iproto_msg_max);
+	/* net_msg_max is a limit of each network thread. */
 	fiber_pool_set_max_size(&tx_fiber_pool,
 				new_iproto_msg_max *
+				cfg_geti("iproto_threads") *
 				IPROTO_FIBER_POOL_SIZE_FACTOR);
 }
 
@@ -1690,6 +1924,8 @@ engine_init()
 				    cfg_getd("slab_alloc_factor"));
 	engine_register((struct engine *)memtx);
 	box_set_memtx_max_tuple_size();
+	box_set_memtx_snap_threads();
+	box_set_memtx_sort_threads();
 
 	struct sysview_engine *sysview = sysview_engine_new_xc();
 	engine_register((struct engine *)sysview);
@@ -1703,9 +1939,15 @@ engine_init()
 				    cfg_geti("vinyl_read_threads"),
 				    cfg_geti("vinyl_write_threads"),
 				    cfg_geti("force_recovery"));
+	vinyl_engine_set_io_uring(vinyl, cfg_getb("io_uring") == 1);
+	vinyl_engine_set_direct_io(vinyl, cfg_getb("vinyl_direct_io") == 1);
 	engine_register((struct engine *)vinyl);
 	box_set_vinyl_max_tuple_size();
 	box_set_vinyl_cache();
+	box_set_vinyl_page_cache();
+	box_set_vinyl_run_index_cache();
+	box_set_vinyl_max_subcompactions();
+	box_set_vinyl_readahead();
 	box_set_vinyl_timeout();
 }
 
@@ -1883,8 +2125,10 @@ local_recovery(const struct tt_uuid *instance_uuid,
 	struct wal_stream wal_stream;
 	wal_stream_create(&wal_stream, cfg_geti64("rows_per_wal"));
 
+	const char *wal_dirs[WAL_STRIPE_MAX];
+	int wal_dir_count = box_wal_dirs(wal_dirs);
 	struct recovery *recovery;
-	recovery = recovery_new(cfg_gets("wal_dir"),
+	recovery = recovery_new(wal_dirs, wal_dir_count,
 				cfg_geti("force_recovery"),
 				checkpoint_vclock);
 	auto guard = make_scoped_guard([=]{ recovery_delete(recovery); });
@@ -2033,9 +2277,13 @@ box_cfg_xc(void)
 	schema_init();
 	replication_init();
 	port_init();
-	iproto_init();
+	iproto_init(box_check_iproto_threads(cfg_geti("iproto_threads")));
 	sql_init();
-	wal_thread_start();
+	/* Writing to /dev/null doesn't need more than one thread. */
+	if (box_check_wal_mode(cfg_gets("wal_mode")) == WAL_NONE)
+		wal_thread_start(1);
+	else
+		wal_thread_start(box_check_wal_stripe_dirs() + 1);
 
 	title("loading");
 
@@ -2052,6 +2300,7 @@ box_cfg_xc(void)
 	box_set_replication_sync_lag();
 	box_set_replication_sync_timeout();
 	box_set_replication_skip_conflict();
+	box_set_replication_wal_pipeline();
 	xstream_create(&join_stream, apply_initial_join_row);
 	xstream_create(&subscribe_stream, apply_row);
 
@@ -2099,8 +2348,12 @@ box_cfg_xc(void)
 	int64_t wal_max_rows = box_check_wal_max_rows(cfg_geti64("rows_per_wal"));
 	int64_t wal_max_size = box_check_wal_max_size(cfg_geti64("wal_max_size"));
 	enum wal_mode wal_mode = box_check_wal_mode(cfg_gets("wal_mode"));
-	if (wal_init(wal_mode, cfg_gets("wal_dir"), &INSTANCE_UUID,
-		      &replicaset.vclock, wal_max_rows, wal_max_size)) {
+	int64_t wal_cache_size = box_check_wal_cache(cfg_geti64("wal_cache"));
+	const char *wal_dirs[WAL_STRIPE_MAX];
+	box_wal_dirs(wal_dirs);
+	if (wal_init(wal_mode, wal_dirs, &INSTANCE_UUID,
+		      &replicaset.vclock, wal_max_rows, wal_max_size,
+		      wal_cache_size, cfg_getb("io_uring") == 1)) {
 		diag_raise();
 	}
 
@@ -178,6 +178,15 @@ box_process_vote(struct ballot *ballot);
 void
 box_check_config();
 
+/**
+ * Fill @dirs with the WAL directory of each stripe:
+ * box.cfg.wal_dir followed by box.cfg.wal_stripe_dirs.
+ * The array must fit WAL_STRIPE_MAX entries.
+ * Returns the number of stripes.
+ */
+int
+box_wal_dirs(const char **dirs);
+
 void box_listen(void);
 void box_set_replication(void);
 void box_set_log_level(void);
@@ -185,13 +194,21 @@ void box_set_log_format(void);
 void box_set_io_collect_interval(void);
 void box_set_snap_io_rate_limit(void);
 void box_set_too_long_threshold(void);
+void box_set_wal_cache(void);
+void box_set_wal_group_commit(void);
 void box_set_readahead(void);
 void box_set_checkpoint_count(void);
 void box_set_memtx_memory(void);
 void box_set_memtx_max_tuple_size(void);
+void box_set_memtx_snap_threads(void);
+void box_set_memtx_sort_threads(void);
 void box_set_vinyl_memory(void);
 void box_set_vinyl_max_tuple_size(void);
 void box_set_vinyl_cache(void);
+void box_set_vinyl_page_cache(void);
+void box_set_vinyl_run_index_cache(void);
+void box_set_vinyl_max_subcompactions(void);
+void box_set_vinyl_readahead(void);
 void box_set_vinyl_timeout(void);
 void box_set_replication_timeout(void);
 void box_set_replication_connect_timeout(void);
@@ -199,6 +216,7 @@ void box_set_replication_connect_quorum(void);
 void box_set_replication_sync_lag(void);
 void box_set_replication_sync_timeout(void);
 void box_set_replication_skip_conflict(void);
+void box_set_replication_wal_pipeline(void);
 void box_set_net_msg_max(void);
 
 extern "C" {
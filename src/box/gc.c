@@ -247,7 +247,7 @@ gc_run(void)
 	if (vclock_sum(&gc_wal_vclock) > vclock_sum(&gc.wal_vclock)) {
 		vclock_copy(&gc.wal_vclock, &gc_wal_vclock);
 		if (rc == 0)
-			wal_collect_garbage(vclock_sum(&gc_wal_vclock));
+			wal_collect_garbage(&gc_wal_vclock);
 	}
 
 	latch_unlock(&gc.latch);
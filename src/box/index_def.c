@@ -36,6 +36,8 @@ const char *index_type_strs[] = { "HASH", "TREE", "BITSET", "RTREE" };
 
 const char *rtree_index_distance_type_strs[] = { "EUCLID", "MANHATTAN" };
 
+const char *compaction_policy_strs[] = { "leveled", "tiered" };
+
 const struct index_opts index_opts_default = {
 	/* .unique              = */ true,
 	/* .dimension           = */ 2,
@@ -45,6 +47,10 @@ const struct index_opts index_opts_default = {
 	/* .run_count_per_level = */ 2,
 	/* .run_size_ratio      = */ 3.5,
 	/* .bloom_fpr           = */ 0.05,
+	/* .bloom_type          = */ BLOOM_TYPE_BLOOM,
+	/* .compaction          = */ COMPACTION_POLICY_LEVELED,
+	/* .expire_field        = */ 0,
+	/* .blob_threshold      = */ 0,
 	/* .lsn                 = */ 0,
 	/* .sql                 = */ NULL,
 	/* .stat                = */ NULL,
@@ -60,6 +66,13 @@ const struct opt_def index_opts_reg[] = {
 	OPT_DEF("run_count_per_level", OPT_INT64, struct index_opts, run_count_per_level),
 	OPT_DEF("run_size_ratio", OPT_FLOAT, struct index_opts, run_size_ratio),
 	OPT_DEF("bloom_fpr", OPT_FLOAT, struct index_opts, bloom_fpr),
+	OPT_DEF_ENUM("bloom_type", bloom_type, struct index_opts,
+		     bloom_type, NULL),
+	OPT_DEF_ENUM("compaction", compaction_policy, struct index_opts,
+		     compaction, NULL),
+	OPT_DEF("expire_field", OPT_UINT32, struct index_opts, expire_field),
+	OPT_DEF("blob_threshold", OPT_UINT32, struct index_opts,
+		blob_threshold),
 	OPT_DEF("lsn", OPT_INT64, struct index_opts, lsn),
 	OPT_DEF("sql", OPT_STRPTR, struct index_opts, sql),
 	OPT_END,
@@ -33,6 +33,7 @@
 
 #include "key_def.h"
 #include "opt_def.h"
+#include "tuple_bloom.h"
 #include "small/rlist.h"
 
 #if defined(__cplusplus)
@@ -58,6 +59,16 @@ enum rtree_index_distance_type {
 };
 extern const char *rtree_index_distance_type_strs[];
 
+/** Vinyl compaction policy, see vy_range_update_compact_priority(). */
+enum compaction_policy {
+	/* Runs are merged in levels of growing size. */
+	COMPACTION_POLICY_LEVELED,
+	/* Runs are only merged with runs of a similar size. */
+	COMPACTION_POLICY_TIERED,
+	compaction_policy_MAX
+};
+extern const char *compaction_policy_strs[];
+
 /** Simple alias to represent logarithm metrics. */
 typedef int16_t log_est_t;
 
@@ -153,6 +164,26 @@ struct index_opts {
 	double run_size_ratio;
 	/* Bloom filter false positive rate. */
 	double bloom_fpr;
+	/* Type of filters used for vinyl runs. */
+	enum bloom_type bloom_type;
+	/**
+	 * Policy used for choosing vinyl runs to compact.
+	 */
+	enum compaction_policy compaction;
+	/**
+	 * 1-based number of the field storing the time when
+	 * a tuple expires, in seconds since the Epoch. Expired
+	 * tuples are dropped on vinyl dump and compaction.
+	 * 0 means that tuples never expire.
+	 */
+	uint32_t expire_field;
+	/**
+	 * Values of fields of type 'any' that are at least
+	 * that many bytes long are stored in separate blob
+	 * files of a vinyl primary index, see vy_blob.h.
+	 * 0 means that values are stored inline.
+	 */
+	uint32_t blob_threshold;
 	/**
 	 * LSN from the time of index creation.
 	 */
@@ -212,6 +243,14 @@ index_opts_cmp(const struct index_opts *o1, const struct index_opts *o2)
 		return o1->run_size_ratio < o2->run_size_ratio ? -1 : 1;
 	if (o1->bloom_fpr != o2->bloom_fpr)
 		return o1->bloom_fpr < o2->bloom_fpr ? -1 : 1;
+	if (o1->bloom_type != o2->bloom_type)
+		return o1->bloom_type < o2->bloom_type ? -1 : 1;
+	if (o1->compaction != o2->compaction)
+		return o1->compaction < o2->compaction ? -1 : 1;
+	if (o1->expire_field != o2->expire_field)
+		return o1->expire_field < o2->expire_field ? -1 : 1;
+	if (o1->blob_threshold != o2->blob_threshold)
+		return o1->blob_threshold < o2->blob_threshold ? -1 : 1;
 	if ((o1->sql == NULL) != (o2->sql == NULL))
 		return 1;
 	if (o1->sql != NULL)
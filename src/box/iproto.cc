@@ -124,7 +124,11 @@ struct iproto_kharon {
  */
 unsigned iproto_readahead = 16320;
 
-/* The maximal number of iproto messages in fly. */
+/*
+ * The maximal number of iproto messages in fly, the limit is
+ * applied to each network thread separately. Only accessed by
+ * tx, network threads use iproto_thread::msg_max.
+ */
 static int iproto_msg_max = IPROTO_MSG_MAX_MIN;
 
 /**
@@ -215,7 +219,86 @@ struct iproto_msg
 	bool close_connection;
 };
 
-static struct mempool iproto_msg_pool;
+/**
+ * Context of a single network thread. All client connections
+ * accepted by a thread are served by it until they are closed,
+ * including all reads, request header decoding and writes.
+ * Only the first thread listens on the binary port. It hands
+ * accepted connections over to all threads round-robin, see
+ * iproto_on_accept().
+ */
+struct iproto_thread {
+	/** Thread ordinal number, 0 <= id < iproto_threads_count. */
+	int id;
+	/** Network thread. */
+	struct cord net_cord;
+	/**
+	 * A pipe from tx to this network thread and a pipe from
+	 * this network thread to tx.
+	 *
+	 * A single global queue for all requests in all connections
+	 * of the thread. All requests from all connections are
+	 * processed concurrently.
+	 * Is also used as a queue for just established connections and to
+	 * execute disconnect triggers. A few notes about these triggers:
+	 * - they need to be run in a fiber
+	 * - unlike an ordinary request failure, on_connect trigger
+	 *   failure must lead to connection close.
+	 * - on_connect trigger must be processed before any other
+	 *   request on this connection.
+	 */
+	struct cpipe tx_pipe;
+	struct cpipe net_pipe;
+	/** Pool of iproto_msg objects of this thread. */
+	struct mempool iproto_msg_pool;
+	/** Pool of iproto_connection objects of this thread. */
+	struct mempool iproto_connection_pool;
+	/**
+	 * Connections of this thread which input was stopped
+	 * because net_msg_max limit was reached.
+	 */
+	struct rlist stopped_connections;
+	/**
+	 * The maximal number of messages in fly in this thread.
+	 * A copy of iproto_msg_max owned by the thread, updated
+	 * by iproto_do_cfg_f().
+	 */
+	int msg_max;
+	/** Iproto binary listener, only used by the first thread. */
+	struct evio_service binary;
+	/**
+	 * Pipes from the first thread to the other threads, used
+	 * for handing over accepted connections, indexed by thread
+	 * id. Only set in the first thread.
+	 */
+	struct cpipe *accept_pipes;
+	/** Id of the thread to serve the next accepted connection. */
+	int next_accept_thread;
+	/** Network statistics of this thread. */
+	struct rmean *rmean;
+	/** Name of the cbus endpoint of the thread. */
+	char endpoint_name[FIBER_NAME_MAX];
+	/*
+	 * Message routes. Since they refer to the thread pipes,
+	 * each thread has its own copy.
+	 */
+	struct cmsg_hop disconnect_route[2];
+	struct cmsg_hop push_route[2];
+	struct cmsg_hop misc_route[2];
+	struct cmsg_hop call_route[2];
+	struct cmsg_hop select_route[2];
+	struct cmsg_hop process1_route[2];
+	struct cmsg_hop sql_route[2];
+	const struct cmsg_hop *dml_route[IPROTO_TYPE_STAT_MAX];
+	struct cmsg_hop join_route[2];
+	struct cmsg_hop subscribe_route[2];
+	struct cmsg_hop error_route[2];
+	struct cmsg_hop connect_route[2];
+};
+
+/** Network threads, see box.cfg.iproto_threads. */
+static struct iproto_thread *iproto_threads;
+static int iproto_threads_count;
 
 static struct iproto_msg *
 iproto_msg_new(struct iproto_connection *con);
@@ -224,37 +307,14 @@ iproto_msg_new(struct iproto_connection *con);
  * Resume stopped connections, if any.
  */
 static void
-iproto_resume();
+iproto_resume(struct iproto_thread *iproto_thread);
 
 static void
 iproto_msg_decode(struct iproto_msg *msg, const char **pos, const char *reqend,
 		  bool *stop_input);
 
 static inline void
-iproto_msg_delete(struct iproto_msg *msg)
-{
-	mempool_free(&iproto_msg_pool, msg);
-	iproto_resume();
-}
-
-/**
- * A single global queue for all requests in all connections. All
- * requests from all connections are processed concurrently.
- * Is also used as a queue for just established connections and to
- * execute disconnect triggers. A few notes about these triggers:
- * - they need to be run in a fiber
- * - unlike an ordinary request failure, on_connect trigger
- *   failure must lead to connection close.
- * - on_connect trigger must be processed before any other
- *   request on this connection.
- */
-static struct cpipe tx_pipe;
-static struct cpipe net_pipe;
-
-/**
- * Network thread.
- */
-static struct cord net_cord;
+iproto_msg_delete(struct iproto_msg *msg);
 
 /**
  * Slab cache used for allocating memory for output network buffers
@@ -262,8 +322,6 @@ static struct cord net_cord;
  */
 static struct slab_cache net_slabc;
 
-struct rmean *rmean_net;
-
 enum rmean_net_name {
 	IPROTO_SENT,
 	IPROTO_RECEIVED,
@@ -278,11 +336,6 @@ tx_process_disconnect(struct cmsg *m);
 static void
 net_finish_disconnect(struct cmsg *m);
 
-static const struct cmsg_hop disconnect_route[] = {
-	{ tx_process_disconnect, &net_pipe },
-	{ net_finish_disconnect, NULL },
-};
-
 /**
  * Kharon is in the dead world (iproto). Schedule an event to
  * flush new obuf as reflected in the fresh wpos.
@@ -300,12 +353,6 @@ iproto_process_push(struct cmsg *m);
 static void
 tx_end_push(struct cmsg *m);
 
-static const struct cmsg_hop push_route[] = {
-	{ iproto_process_push, &tx_pipe },
-	{ tx_end_push, NULL }
-};
-
-
 /* }}} */
 
 /* {{{ iproto_connection - declaration and definition */
@@ -435,6 +482,8 @@ struct iproto_connection
 	 *                          ...
 	 */
 	struct iproto_kharon kharon;
+	/** Network thread serving the connection. */
+	struct iproto_thread *iproto_thread;
 	/**
 	 * The following fields are used exclusively by the tx thread.
 	 * Align them to prevent false-sharing.
@@ -455,27 +504,24 @@ struct iproto_connection
 	char salt[IPROTO_SALT_SIZE];
 };
 
-static struct mempool iproto_connection_pool;
-static RLIST_HEAD(stopped_connections);
-
 /**
  * Return true if we have not enough spare messages
- * in the message pool.
+ * in the message pool of the thread.
  */
 static inline bool
-iproto_check_msg_max()
+iproto_check_msg_max(struct iproto_thread *iproto_thread)
 {
-	size_t request_count = mempool_count(&iproto_msg_pool);
-	return request_count > (size_t) iproto_msg_max;
+	size_t request_count = mempool_count(&iproto_thread->iproto_msg_pool);
+	return request_count > (size_t) iproto_thread->msg_max;
 }
 
 static struct iproto_msg *
 iproto_msg_new(struct iproto_connection *con)
 {
-	struct iproto_msg *msg =
-		(struct iproto_msg *) mempool_alloc(&iproto_msg_pool);
+	struct mempool *pool = &con->iproto_thread->iproto_msg_pool;
+	struct iproto_msg *msg = (struct iproto_msg *) mempool_alloc(pool);
 	ERROR_INJECT(ERRINJ_TESTING, {
-		mempool_free(&iproto_msg_pool, msg);
+		mempool_free(pool, msg);
 		msg = NULL;
 	});
 	if (msg == NULL) {
@@ -488,6 +534,14 @@ iproto_msg_new(struct iproto_connection *con)
 	return msg;
 }
 
+static inline void
+iproto_msg_delete(struct iproto_msg *msg)
+{
+	struct iproto_thread *iproto_thread = msg->connection->iproto_thread;
+	mempool_free(&iproto_thread->iproto_msg_pool, msg);
+	iproto_resume(iproto_thread);
+}
+
 /**
  * A connection is idle when the client is gone
  * and there are no outstanding msgs in the msg queue.
@@ -537,7 +591,8 @@ iproto_connection_stop_msg_max_limit(struct iproto_connection *con)
 	 * Important to add to tail and fetch from head to ensure
 	 * strict lifo order (fairness) for stopped connections.
 	 */
-	rlist_add_tail(&stopped_connections, &con->in_stop_list);
+	rlist_add_tail(&con->iproto_thread->stopped_connections,
+		       &con->in_stop_list);
 }
 
 /**
@@ -580,7 +635,7 @@ iproto_connection_close(struct iproto_connection *con)
 	if (iproto_connection_is_idle(con)) {
 		assert(con->is_disconnected == false);
 		con->is_disconnected = true;
-		cpipe_push(&tx_pipe, &con->disconnect);
+		cpipe_push(&con->iproto_thread->tx_pipe, &con->disconnect);
 	}
 	rlist_del(&con->in_stop_list);
 }
@@ -689,13 +744,14 @@ static inline int
 iproto_enqueue_batch(struct iproto_connection *con, struct ibuf *in)
 {
 	assert(rlist_empty(&con->in_stop_list));
+	struct cpipe *tx_pipe = &con->iproto_thread->tx_pipe;
 	int n_requests = 0;
 	bool stop_input = false;
 	const char *errmsg;
 	while (con->parse_size != 0 && !stop_input) {
-		if (iproto_check_msg_max()) {
+		if (iproto_check_msg_max(con->iproto_thread)) {
 			iproto_connection_stop_msg_max_limit(con);
-			cpipe_flush_input(&tx_pipe);
+			cpipe_flush_input(tx_pipe);
 			return 0;
 		}
 		const char *reqstart = in->wpos - con->parse_size;
@@ -704,7 +760,7 @@ iproto_enqueue_batch(struct iproto_connection *con, struct ibuf *in)
 		if (mp_typeof(*pos) != MP_UINT) {
 			errmsg = "packet length";
 err_msgpack:
-			cpipe_flush_input(&tx_pipe);
+			cpipe_flush_input(tx_pipe);
 			diag_set(ClientError, ER_INVALID_MSGPACK,
 				 errmsg);
 			return -1;
@@ -740,7 +796,7 @@ err_msgpack:
 		 * This can't throw, but should not be
 		 * done in case of exception.
 		 */
-		cpipe_push_input(&tx_pipe, &msg->base);
+		cpipe_push_input(tx_pipe, &msg->base);
 		n_requests++;
 		/* Request is parsed */
 		assert(reqend > reqstart);
@@ -778,7 +834,7 @@ err_msgpack:
 		 */
 		ev_feed_event(con->loop, &con->input, EV_READ);
 	}
-	cpipe_flush_input(&tx_pipe);
+	cpipe_flush_input(tx_pipe);
 	return 0;
 }
 
@@ -790,7 +846,7 @@ err_msgpack:
 static void
 iproto_connection_resume(struct iproto_connection *con)
 {
-	assert(! iproto_check_msg_max());
+	assert(! iproto_check_msg_max(con->iproto_thread));
 	rlist_del(&con->in_stop_list);
 	/*
 	 * Enqueue_batch() stops the connection again, if the
@@ -814,15 +870,18 @@ iproto_connection_resume(struct iproto_connection *con)
  * necessary to use up the limit.
  */
 static void
-iproto_resume()
+iproto_resume(struct iproto_thread *iproto_thread)
 {
-	while (!iproto_check_msg_max() && !rlist_empty(&stopped_connections)) {
+	struct rlist *stopped_connections =
+		&iproto_thread->stopped_connections;
+	while (!iproto_check_msg_max(iproto_thread) &&
+	       !rlist_empty(stopped_connections)) {
 		/*
 		 * Shift from list head to ensure strict FIFO
 		 * (fairness) for resumed connections.
 		 */
 		struct iproto_connection *con =
-			rlist_first_entry(&stopped_connections,
+			rlist_first_entry(stopped_connections,
 					  struct iproto_connection,
 					  in_stop_list);
 		iproto_connection_resume(con);
@@ -844,7 +903,7 @@ iproto_connection_on_input(ev_loop *loop, struct ev_io *watcher,
 	 * otherwise we might deplete the fiber pool in tx
 	 * thread and deadlock.
 	 */
-	if (iproto_check_msg_max()) {
+	if (iproto_check_msg_max(con->iproto_thread)) {
 		iproto_connection_stop_msg_max_limit(con);
 		return;
 	}
@@ -867,7 +926,7 @@ iproto_connection_on_input(ev_loop *loop, struct ev_io *watcher,
 			return;
 		}
 		/* Count statistics */
-		rmean_collect(rmean_net, IPROTO_RECEIVED, nrd);
+		rmean_collect(con->iproto_thread->rmean, IPROTO_RECEIVED, nrd);
 
 		/* Update the read position and connection state. */
 		in->wpos += nrd;
@@ -925,7 +984,7 @@ iproto_flush(struct iproto_connection *con)
 	ssize_t nwr = sio_writev(fd, iov, iovcnt);
 
 	/* Count statistics */
-	rmean_collect(rmean_net, IPROTO_SENT, nwr);
+	rmean_collect(con->iproto_thread->rmean, IPROTO_SENT, nwr);
 	if (nwr > 0) {
 		if (begin->used + nwr == end->used) {
 			*begin = *end;
@@ -969,15 +1028,16 @@ iproto_connection_on_output(ev_loop *loop, struct ev_io *watcher,
 }
 
 static struct iproto_connection *
-iproto_connection_new(int fd)
+iproto_connection_new(struct iproto_thread *iproto_thread, int fd)
 {
 	struct iproto_connection *con = (struct iproto_connection *)
-		mempool_alloc(&iproto_connection_pool);
+		mempool_alloc(&iproto_thread->iproto_connection_pool);
 	if (con == NULL) {
 		diag_set(OutOfMemory, sizeof(*con), "mempool_alloc", "con");
 		return NULL;
 	}
 	con->input.data = con->output.data = con;
+	con->iproto_thread = iproto_thread;
 	con->loop = loop();
 	ev_io_init(&con->input, iproto_connection_on_input, fd, EV_READ);
 	ev_io_init(&con->output, iproto_connection_on_output, fd, EV_WRITE);
@@ -994,7 +1054,7 @@ iproto_connection_new(int fd)
 	con->session = NULL;
 	rlist_create(&con->in_stop_list);
 	/* It may be very awkward to allocate at close. */
-	cmsg_init(&con->disconnect, disconnect_route);
+	cmsg_init(&con->disconnect, iproto_thread->disconnect_route);
 	con->is_disconnected = false;
 	con->tx.is_push_pending = false;
 	con->tx.is_push_sent = false;
@@ -1019,7 +1079,7 @@ iproto_connection_delete(struct iproto_connection *con)
 	       con->obuf[0].iov[0].iov_base == NULL);
 	assert(con->obuf[1].pos == 0 &&
 	       con->obuf[1].iov[0].iov_base == NULL);
-	mempool_free(&iproto_connection_pool, con);
+	mempool_free(&con->iproto_thread->iproto_connection_pool, con);
 }
 
 /* }}} iproto_connection */
@@ -1062,67 +1122,12 @@ net_end_join(struct cmsg *msg);
 static void
 net_end_subscribe(struct cmsg *msg);
 
-static const struct cmsg_hop misc_route[] = {
-	{ tx_process_misc, &net_pipe },
-	{ net_send_msg, NULL },
-};
-
-static const struct cmsg_hop call_route[] = {
-	{ tx_process_call, &net_pipe },
-	{ net_send_msg, NULL },
-};
-
-static const struct cmsg_hop select_route[] = {
-	{ tx_process_select, &net_pipe },
-	{ net_send_msg, NULL },
-};
-
-static const struct cmsg_hop process1_route[] = {
-	{ tx_process1, &net_pipe },
-	{ net_send_msg, NULL },
-};
-
-static const struct cmsg_hop sql_route[] = {
-	{ tx_process_sql, &net_pipe },
-	{ net_send_msg, NULL },
-};
-
-static const struct cmsg_hop *dml_route[IPROTO_TYPE_STAT_MAX] = {
-	NULL,                                   /* IPROTO_OK */
-	select_route,                           /* IPROTO_SELECT */
-	process1_route,                         /* IPROTO_INSERT */
-	process1_route,                         /* IPROTO_REPLACE */
-	process1_route,                         /* IPROTO_UPDATE */
-	process1_route,                         /* IPROTO_DELETE */
-	call_route,                             /* IPROTO_CALL_16 */
-	misc_route,                             /* IPROTO_AUTH */
-	call_route,                             /* IPROTO_EVAL */
-	process1_route,                         /* IPROTO_UPSERT */
-	call_route,                             /* IPROTO_CALL */
-	sql_route,                              /* IPROTO_EXECUTE */
-	NULL,                                   /* IPROTO_NOP */
-};
-
-static const struct cmsg_hop join_route[] = {
-	{ tx_process_join_subscribe, &net_pipe },
-	{ net_end_join, NULL },
-};
-
-static const struct cmsg_hop subscribe_route[] = {
-	{ tx_process_join_subscribe, &net_pipe },
-	{ net_end_subscribe, NULL },
-};
-
-static const struct cmsg_hop error_route[] = {
-	{ tx_reply_iproto_error, &net_pipe },
-	{ net_send_error, NULL },
-};
-
 static void
 iproto_msg_decode(struct iproto_msg *msg, const char **pos, const char *reqend,
 		  bool *stop_input)
 {
 	uint8_t type;
+	struct iproto_thread *iproto_thread = msg->connection->iproto_thread;
 
 	if (xrow_header_decode(&msg->header, pos, reqend))
 		goto error;
@@ -1145,40 +1150,41 @@ iproto_msg_decode(struct iproto_msg *msg, const char **pos, const char *reqend,
 		if (xrow_decode_dml(&msg->header, &msg->dml,
 				    dml_request_key_map(type)))
 			goto error;
-		assert(type < sizeof(dml_route)/sizeof(*dml_route));
-		cmsg_init(&msg->base, dml_route[type]);
+		assert(type < sizeof(iproto_thread->dml_route) /
+			      sizeof(*iproto_thread->dml_route));
+		cmsg_init(&msg->base, iproto_thread->dml_route[type]);
 		break;
 	case IPROTO_CALL_16:
 	case IPROTO_CALL:
 	case IPROTO_EVAL:
 		if (xrow_decode_call(&msg->header, &msg->call))
 			goto error;
-		cmsg_init(&msg->base, call_route);
+		cmsg_init(&msg->base, iproto_thread->call_route);
 		break;
 	case IPROTO_EXECUTE:
 		if (xrow_decode_sql(&msg->header, &msg->sql, &fiber()->gc))
 			goto error;
-		cmsg_init(&msg->base, sql_route);
+		cmsg_init(&msg->base, iproto_thread->sql_route);
 		break;
 	case IPROTO_PING:
-		cmsg_init(&msg->base, misc_route);
+		cmsg_init(&msg->base, iproto_thread->misc_route);
 		break;
 	case IPROTO_JOIN:
-		cmsg_init(&msg->base, join_route);
+		cmsg_init(&msg->base, iproto_thread->join_route);
 		*stop_input = true;
 		break;
 	case IPROTO_SUBSCRIBE:
-		cmsg_init(&msg->base, subscribe_route);
+		cmsg_init(&msg->base, iproto_thread->subscribe_route);
 		*stop_input = true;
 		break;
 	case IPROTO_VOTE_DEPRECATED:
 	case IPROTO_VOTE:
-		cmsg_init(&msg->base, misc_route);
+		cmsg_init(&msg->base, iproto_thread->misc_route);
 		break;
 	case IPROTO_AUTH:
 		if (xrow_decode_auth(&msg->header, &msg->auth))
 			goto error;
-		cmsg_init(&msg->base, misc_route);
+		cmsg_init(&msg->base, iproto_thread->misc_route);
 		break;
 	default:
 		diag_set(ClientError, ER_UNKNOWN_REQUEST_TYPE,
@@ -1191,7 +1197,7 @@ error:
 	diag_log();
 	diag_create(&msg->diag);
 	diag_move(&fiber()->diag, &msg->diag);
-	cmsg_init(&msg->base, error_route);
+	cmsg_init(&msg->base, iproto_thread->error_route);
 }
 
 static void
@@ -1284,7 +1290,8 @@ tx_discard_input(struct iproto_msg *msg)
 		{ net_discard_input, NULL },
 	};
 	cmsg_init(&msg->discard_input, discard_input_route);
-	cpipe_push(&net_pipe, &msg->discard_input);
+	cpipe_push(&msg->connection->iproto_thread->net_pipe,
+		   &msg->discard_input);
 }
 
 /**
@@ -1757,7 +1764,8 @@ net_send_greeting(struct cmsg *m)
 						 obuf_iovcnt(out));
 
 			/* Count statistics */
-			rmean_collect(rmean_net, IPROTO_SENT, nwr);
+			rmean_collect(con->iproto_thread->rmean,
+				      IPROTO_SENT, nwr);
 		} catch (Exception *e) {
 			e->log();
 		}
@@ -1778,24 +1786,17 @@ net_send_greeting(struct cmsg *m)
 	iproto_msg_delete(msg);
 }
 
-static const struct cmsg_hop connect_route[] = {
-	{ tx_process_connect, &net_pipe },
-	{ net_send_greeting, NULL },
-};
-
 /** }}} */
 
 /**
  * Create a connection and start input.
  */
 static void
-iproto_on_accept(struct evio_service * /* service */, int fd,
-		 struct sockaddr *addr, socklen_t addrlen)
+iproto_thread_accept(struct iproto_thread *iproto_thread, int fd)
 {
-	(void) addr;
-	(void) addrlen;
 	struct iproto_msg *msg;
-	struct iproto_connection *con = iproto_connection_new(fd);
+	struct iproto_connection *con =
+		iproto_connection_new(iproto_thread, fd);
 	if (con == NULL)
 		goto error_conn;
 	/*
@@ -1806,64 +1807,180 @@ iproto_on_accept(struct evio_service * /* service */, int fd,
 	msg = iproto_msg_new(con);
 	if (msg == NULL)
 		goto error_msg;
-	cmsg_init(&msg->base, connect_route);
+	cmsg_init(&msg->base, iproto_thread->connect_route);
 	msg->p_ibuf = con->p_ibuf;
 	msg->wpos = con->wpos;
 	msg->close_connection = false;
-	cpipe_push(&tx_pipe, &msg->base);
+	cpipe_push(&iproto_thread->tx_pipe, &msg->base);
 	return;
 error_msg:
-	mempool_free(&iproto_connection_pool, con);
+	mempool_free(&iproto_thread->iproto_connection_pool, con);
 error_conn:
 	close(fd);
 	return;
 }
 
-static struct evio_service binary; /* iproto binary listener */
+/**
+ * A connection accepted by the first network thread and
+ * handed over to another one, see iproto_on_accept().
+ */
+struct iproto_accept_msg {
+	struct cmsg base;
+	/** Network thread to serve the connection. */
+	struct iproto_thread *iproto_thread;
+	/** Accepted socket. */
+	int fd;
+};
+
+static void
+net_accept(struct cmsg *m)
+{
+	struct iproto_accept_msg *msg = (struct iproto_accept_msg *) m;
+	iproto_thread_accept(msg->iproto_thread, msg->fd);
+	free(msg);
+}
+
+static const struct cmsg_hop accept_route[] = {
+	{ net_accept, NULL },
+};
+
+/**
+ * Close connections handed over to a network thread which
+ * stopped before it could serve them, see iproto_on_accept().
+ */
+static void
+iproto_thread_close_accepted(struct cbus_endpoint *endpoint)
+{
+	struct stailq output;
+	stailq_create(&output);
+	cbus_endpoint_fetch(endpoint, &output);
+	struct cmsg *msg, *msg_next;
+	stailq_foreach_entry_safe(msg, msg_next, &output, fifo) {
+		if (msg->route != accept_route)
+			continue;
+		struct iproto_accept_msg *accept_msg =
+			(struct iproto_accept_msg *) msg;
+		close(accept_msg->fd);
+		free(accept_msg);
+	}
+}
+
+/**
+ * Hand over a connection accepted by the first network thread
+ * to the next thread in round-robin order. Compared to making
+ * all threads watch the listening socket, this doesn't wake up
+ * every thread on each new connection.
+ */
+static void
+iproto_on_accept(struct evio_service *service, int fd,
+		 struct sockaddr *addr, socklen_t addrlen)
+{
+	(void) addr;
+	(void) addrlen;
+	struct iproto_thread *iproto_thread =
+		(struct iproto_thread *) service->on_accept_param;
+	assert(iproto_thread->id == 0);
+	int id = iproto_thread->next_accept_thread;
+	iproto_thread->next_accept_thread = (id + 1) % iproto_threads_count;
+	struct iproto_accept_msg *msg = NULL;
+	if (id != 0)
+		msg = (struct iproto_accept_msg *) malloc(sizeof(*msg));
+	if (msg == NULL) {
+		/* Serve the connection by this thread. */
+		iproto_thread_accept(iproto_thread, fd);
+		return;
+	}
+	cmsg_init(&msg->base, accept_route);
+	msg->iproto_thread = &iproto_threads[id];
+	msg->fd = fd;
+	cpipe_push(&iproto_thread->accept_pipes[id], &msg->base);
+}
+
+/**
+ * Create pipes for handing over accepted connections from
+ * the first network thread to the other ones. Blocks until
+ * all network threads have started.
+ */
+static void
+iproto_thread_create_accept_pipes(struct iproto_thread *iproto_thread)
+{
+	assert(iproto_thread->id == 0);
+	iproto_thread->accept_pipes = (struct cpipe *)
+		calloc(iproto_threads_count, sizeof(struct cpipe));
+	if (iproto_thread->accept_pipes == NULL) {
+		tnt_raise(OutOfMemory, iproto_threads_count *
+			  sizeof(struct cpipe), "calloc", "accept pipes");
+	}
+	for (int i = 1; i < iproto_threads_count; i++) {
+		cpipe_create(&iproto_thread->accept_pipes[i],
+			     iproto_threads[i].endpoint_name);
+	}
+}
+
+static void
+iproto_thread_destroy_accept_pipes(struct iproto_thread *iproto_thread)
+{
+	if (iproto_thread->accept_pipes == NULL)
+		return;
+	for (int i = 1; i < iproto_threads_count; i++)
+		cpipe_destroy(&iproto_thread->accept_pipes[i]);
+	free(iproto_thread->accept_pipes);
+	iproto_thread->accept_pipes = NULL;
+}
 
 /**
  * The network io thread main function:
  * begin serving the message bus.
  */
 static int
-net_cord_f(va_list /* ap */)
+net_cord_f(va_list ap)
 {
-	mempool_create(&iproto_msg_pool, &cord()->slabc,
+	struct iproto_thread *iproto_thread =
+		va_arg(ap, struct iproto_thread *);
+
+	mempool_create(&iproto_thread->iproto_msg_pool, &cord()->slabc,
 		       sizeof(struct iproto_msg));
-	mempool_create(&iproto_connection_pool, &cord()->slabc,
-		       sizeof(struct iproto_connection));
+	mempool_create(&iproto_thread->iproto_connection_pool,
+		       &cord()->slabc, sizeof(struct iproto_connection));
+	rlist_create(&iproto_thread->stopped_connections);
 
-	evio_service_init(loop(), &binary, "binary",
-			  iproto_on_accept, NULL);
+	evio_service_init(loop(), &iproto_thread->binary, "binary",
+			  iproto_on_accept, iproto_thread);
 
 
 	/* Init statistics counter */
-	rmean_net = rmean_new(rmean_net_strings, IPROTO_LAST);
+	iproto_thread->rmean = rmean_new(rmean_net_strings, IPROTO_LAST);
 
-	if (rmean_net == NULL) {
+	if (iproto_thread->rmean == NULL) {
 		tnt_raise(OutOfMemory, sizeof(struct rmean),
 			  "rmean", "struct rmean");
 	}
 
 	struct cbus_endpoint endpoint;
 	/* Create "net" endpoint. */
-	cbus_endpoint_create(&endpoint, "net", fiber_schedule_cb, fiber());
+	cbus_endpoint_create(&endpoint, iproto_thread->endpoint_name,
+			     fiber_schedule_cb, fiber());
 	/* Create a pipe to "tx" thread. */
-	cpipe_create(&tx_pipe, "tx");
-	cpipe_set_max_input(&tx_pipe, iproto_msg_max / 2);
+	cpipe_create(&iproto_thread->tx_pipe, "tx");
+	cpipe_set_max_input(&iproto_thread->tx_pipe,
+			    iproto_thread->msg_max / 2);
+	if (iproto_thread->id == 0)
+		iproto_thread_create_accept_pipes(iproto_thread);
 	/* Process incomming messages. */
 	cbus_loop(&endpoint);
+	iproto_thread_close_accepted(&endpoint);
 
-	cpipe_destroy(&tx_pipe);
+	cpipe_destroy(&iproto_thread->tx_pipe);
+	iproto_thread_destroy_accept_pipes(iproto_thread);
 	/*
 	 * Nothing to do in the fiber so far, the service
 	 * will take care of creating events for incoming
 	 * connections.
 	 */
-	if (evio_service_is_active(&binary))
-		evio_service_stop(&binary);
+	if (evio_service_is_active(&iproto_thread->binary))
+		evio_service_stop(&iproto_thread->binary);
 
-	rmean_delete(rmean_net);
+	rmean_delete(iproto_thread->rmean);
 	return 0;
 }
 
@@ -1905,11 +2022,11 @@ static void
 tx_begin_push(struct iproto_connection *con)
 {
 	assert(! con->tx.is_push_sent);
-	cmsg_init(&con->kharon.base, push_route);
+	cmsg_init(&con->kharon.base, con->iproto_thread->push_route);
 	iproto_wpos_create(&con->kharon.wpos, con->tx.p_obuf);
 	con->tx.is_push_pending = false;
 	con->tx.is_push_sent = true;
-	cpipe_push(&net_pipe, (struct cmsg *) &con->kharon);
+	cpipe_push(&con->iproto_thread->net_pipe, (struct cmsg *) &con->kharon);
 }
 
 static void
@@ -1957,18 +2074,113 @@ iproto_session_push(struct session *session, uint64_t sync, struct port *port)
 
 /** }}} */
 
-/** Initialize the iproto subsystem and start network io thread */
+/**
+ * Fill in message routes of a network thread. They can't be
+ * static, because each thread has its own pair of pipes.
+ */
+static void
+iproto_thread_init_routes(struct iproto_thread *iproto_thread)
+{
+	struct cpipe *net_pipe = &iproto_thread->net_pipe;
+
+	iproto_thread->disconnect_route[0] =
+		{ tx_process_disconnect, net_pipe };
+	iproto_thread->disconnect_route[1] =
+		{ net_finish_disconnect, NULL };
+	iproto_thread->push_route[0] =
+		{ iproto_process_push, &iproto_thread->tx_pipe };
+	iproto_thread->push_route[1] =
+		{ tx_end_push, NULL };
+	iproto_thread->misc_route[0] =
+		{ tx_process_misc, net_pipe };
+	iproto_thread->misc_route[1] =
+		{ net_send_msg, NULL };
+	iproto_thread->call_route[0] =
+		{ tx_process_call, net_pipe };
+	iproto_thread->call_route[1] =
+		{ net_send_msg, NULL };
+	iproto_thread->select_route[0] =
+		{ tx_process_select, net_pipe };
+	iproto_thread->select_route[1] =
+		{ net_send_msg, NULL };
+	iproto_thread->process1_route[0] =
+		{ tx_process1, net_pipe };
+	iproto_thread->process1_route[1] =
+		{ net_send_msg, NULL };
+	iproto_thread->sql_route[0] =
+		{ tx_process_sql, net_pipe };
+	iproto_thread->sql_route[1] =
+		{ net_send_msg, NULL };
+	iproto_thread->join_route[0] =
+		{ tx_process_join_subscribe, net_pipe };
+	iproto_thread->join_route[1] =
+		{ net_end_join, NULL };
+	iproto_thread->subscribe_route[0] =
+		{ tx_process_join_subscribe, net_pipe };
+	iproto_thread->subscribe_route[1] =
+		{ net_end_subscribe, NULL };
+	iproto_thread->error_route[0] =
+		{ tx_reply_iproto_error, net_pipe };
+	iproto_thread->error_route[1] =
+		{ net_send_error, NULL };
+	iproto_thread->connect_route[0] =
+		{ tx_process_connect, net_pipe };
+	iproto_thread->connect_route[1] =
+		{ net_send_greeting, NULL };
+
+	const struct cmsg_hop **dml_route = iproto_thread->dml_route;
+	memset(dml_route, 0, sizeof(iproto_thread->dml_route));
+	dml_route[IPROTO_SELECT] = iproto_thread->select_route;
+	dml_route[IPROTO_INSERT] = iproto_thread->process1_route;
+	dml_route[IPROTO_REPLACE] = iproto_thread->process1_route;
+	dml_route[IPROTO_UPDATE] = iproto_thread->process1_route;
+	dml_route[IPROTO_DELETE] = iproto_thread->process1_route;
+	dml_route[IPROTO_CALL_16] = iproto_thread->call_route;
+	dml_route[IPROTO_AUTH] = iproto_thread->misc_route;
+	dml_route[IPROTO_EVAL] = iproto_thread->call_route;
+	dml_route[IPROTO_UPSERT] = iproto_thread->process1_route;
+	dml_route[IPROTO_CALL] = iproto_thread->call_route;
+	dml_route[IPROTO_EXECUTE] = iproto_thread->sql_route;
+}
+
+/** Initialize the iproto subsystem and start network io threads */
 void
-iproto_init()
+iproto_init(int threads_count)
 {
+	assert(threads_count > 0 && threads_count <= IPROTO_THREADS_MAX);
 	slab_cache_create(&net_slabc, &runtime);
 
-	if (cord_costart(&net_cord, "iproto", net_cord_f, NULL))
-		panic("failed to initialize iproto thread");
-
-	/* Create a pipe to "net" thread. */
-	cpipe_create(&net_pipe, "net");
-	cpipe_set_max_input(&net_pipe, iproto_msg_max / 2);
+	iproto_threads = (struct iproto_thread *)
+		calloc(threads_count, sizeof(*iproto_threads));
+	if (iproto_threads == NULL)
+		panic("failed to allocate iproto threads");
+	iproto_threads_count = threads_count;
+
+	for (int i = 0; i < threads_count; i++) {
+		struct iproto_thread *iproto_thread = &iproto_threads[i];
+		iproto_thread->id = i;
+		iproto_thread->msg_max = iproto_msg_max;
+		iproto_thread_init_routes(iproto_thread);
+		/*
+		 * Keep the names of the first thread and its
+		 * endpoint as they were when there was only one
+		 * network thread.
+		 */
+		const char *cord_name = i == 0 ? "iproto" :
+					tt_sprintf("iproto%d", i);
+		snprintf(iproto_thread->endpoint_name,
+			 sizeof(iproto_thread->endpoint_name),
+			 i == 0 ? "net" : "net%d", i);
+		if (cord_costart(&iproto_thread->net_cord, cord_name,
+				 net_cord_f, iproto_thread))
+			panic("failed to initialize iproto thread");
+
+		/* Create a pipe to "net" thread. */
+		cpipe_create(&iproto_thread->net_pipe,
+			     iproto_thread->endpoint_name);
+		cpipe_set_max_input(&iproto_thread->net_pipe,
+				    iproto_msg_max / 2);
+	}
 	struct session_vtab iproto_session_vtab = {
 		/* .push = */ iproto_session_push,
 		/* .fd = */ iproto_session_fd,
@@ -1993,6 +2205,8 @@ struct iproto_cfg_msg: public cbus_call_msg
 {
 	/** Operation to execute in iproto thread. */
 	enum iproto_cfg_op op;
+	/** Network thread the message is sent to. */
+	struct iproto_thread *iproto_thread;
 	union {
 		/** New URI to bind to. */
 		const char *uri;
@@ -2013,23 +2227,27 @@ static int
 iproto_do_cfg_f(struct cbus_call_msg *m)
 {
 	struct iproto_cfg_msg *cfg_msg = (struct iproto_cfg_msg *) m;
-	int old;
+	struct iproto_thread *iproto_thread = cfg_msg->iproto_thread;
+	struct evio_service *binary = &iproto_thread->binary;
 	try {
 		switch (cfg_msg->op) {
 		case IPROTO_CFG_MSG_MAX:
-			cpipe_set_max_input(&tx_pipe,
-					    cfg_msg->iproto_msg_max / 2);
-			old = iproto_msg_max;
-			iproto_msg_max = cfg_msg->iproto_msg_max;
-			if (old < iproto_msg_max)
-				iproto_resume();
+			iproto_thread->msg_max = cfg_msg->iproto_msg_max;
+			cpipe_set_max_input(&iproto_thread->tx_pipe,
+					    iproto_thread->msg_max / 2);
+			/*
+			 * Resume connections in case the limit
+			 * has been increased.
+			 */
+			iproto_resume(iproto_thread);
 			break;
 		case IPROTO_CFG_LISTEN:
-			if (evio_service_is_active(&binary))
-				evio_service_stop(&binary);
+			assert(iproto_thread->id == 0);
+			if (evio_service_is_active(binary))
+				evio_service_stop(binary);
 			if (cfg_msg->uri != NULL) {
-				evio_service_bind(&binary, cfg_msg->uri);
-				evio_service_listen(&binary);
+				evio_service_bind(binary, cfg_msg->uri);
+				evio_service_listen(binary);
 			}
 			break;
 		default:
@@ -2042,10 +2260,12 @@ iproto_do_cfg_f(struct cbus_call_msg *m)
 }
 
 static inline void
-iproto_do_cfg(struct iproto_cfg_msg *msg)
+iproto_do_cfg(struct iproto_thread *iproto_thread,
+	      struct iproto_cfg_msg *msg)
 {
-	if (cbus_call(&net_pipe, &tx_pipe, msg, iproto_do_cfg_f,
-		      NULL, TIMEOUT_INFINITY) != 0)
+	msg->iproto_thread = iproto_thread;
+	if (cbus_call(&iproto_thread->net_pipe, &iproto_thread->tx_pipe, msg,
+		      iproto_do_cfg_f, NULL, TIMEOUT_INFINITY) != 0)
 		diag_raise();
 }
 
@@ -2053,21 +2273,57 @@ void
 iproto_listen(const char *uri)
 {
 	struct iproto_cfg_msg cfg_msg;
+	/* Only the first thread listens, see iproto_on_accept(). */
 	iproto_cfg_msg_create(&cfg_msg, IPROTO_CFG_LISTEN);
 	cfg_msg.uri = uri;
-	iproto_do_cfg(&cfg_msg);
+	iproto_do_cfg(&iproto_threads[0], &cfg_msg);
 }
 
 size_t
 iproto_mem_used(void)
 {
-	return slab_cache_used(&net_cord.slabc) + slab_cache_used(&net_slabc);
+	size_t mem = slab_cache_used(&net_slabc);
+	for (int i = 0; i < iproto_threads_count; i++)
+		mem += slab_cache_used(&iproto_threads[i].net_cord.slabc);
+	return mem;
 }
 
 void
 iproto_reset_stat(void)
 {
-	rmean_cleanup(rmean_net);
+	for (int i = 0; i < iproto_threads_count; i++)
+		rmean_cleanup(iproto_threads[i].rmean);
+}
+
+int
+iproto_rmean_foreach(rmean_cb cb, void *cb_ctx)
+{
+	for (int name = 0; name < IPROTO_LAST; name++) {
+		int64_t rps = 0;
+		int64_t total = 0;
+		for (int i = 0; i < iproto_threads_count; i++) {
+			struct rmean *rmean = iproto_threads[i].rmean;
+			rps += rmean_mean(rmean, name);
+			total += rmean_total(rmean, name);
+		}
+		int rc = cb(rmean_net_strings[name], rps, total, cb_ctx);
+		if (rc != 0)
+			return rc;
+	}
+	return 0;
+}
+
+int
+iproto_thread_count(void)
+{
+	return iproto_threads_count;
+}
+
+int
+iproto_thread_rmean_foreach(int thread_id, rmean_cb cb, void *cb_ctx)
+{
+	assert(thread_id >= 0 && thread_id < iproto_threads_count);
+	return rmean_foreach(iproto_threads[thread_id].rmean, cb, cb_ctx);
 }
 
 void
@@ -2078,9 +2334,13 @@ iproto_set_msg_max(int new_iproto_msg_max)
 			  tt_sprintf("minimal value is %d",
 				     IPROTO_MSG_MAX_MIN));
 	}
-	struct iproto_cfg_msg cfg_msg;
-	iproto_cfg_msg_create(&cfg_msg, IPROTO_CFG_MSG_MAX);
-	cfg_msg.iproto_msg_max = new_iproto_msg_max;
-	iproto_do_cfg(&cfg_msg);
-	cpipe_set_max_input(&net_pipe, new_iproto_msg_max / 2);
+	iproto_msg_max = new_iproto_msg_max;
+	for (int i = 0; i < iproto_threads_count; i++) {
+		struct iproto_cfg_msg cfg_msg;
+		iproto_cfg_msg_create(&cfg_msg, IPROTO_CFG_MSG_MAX);
+		cfg_msg.iproto_msg_max = new_iproto_msg_max;
+		iproto_do_cfg(&iproto_threads[i], &cfg_msg);
+		cpipe_set_max_input(&iproto_threads[i].net_pipe,
+				    new_iproto_msg_max / 2);
+	}
 }
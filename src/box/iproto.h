@@ -32,6 +32,7 @@
  */
 
 #include <stddef.h>
+#include "rmean.h"
 
 #if defined(__cplusplus)
 extern "C" {
@@ -52,6 +53,8 @@ enum {
 	 * processing stops until some new fibers are freed up.
 	 */
 	IPROTO_FIBER_POOL_SIZE_FACTOR = 5,
+	/** The maximal number of network threads. */
+	IPROTO_THREADS_MAX = 1000,
 };
 
 extern unsigned iproto_readahead;
@@ -68,11 +71,33 @@ iproto_mem_used(void);
 void
 iproto_reset_stat(void);
 
+/**
+ * Iterate over network statistics summed up over all
+ * network threads.
+ */
+int
+iproto_rmean_foreach(rmean_cb cb, void *cb_ctx);
+
+/** Return the number of network threads. */
+int
+iproto_thread_count(void);
+
+/**
+ * Iterate over network statistics of the network thread
+ * with the given id, 0 <= thread_id < iproto_thread_count().
+ */
+int
+iproto_thread_rmean_foreach(int thread_id, rmean_cb cb, void *cb_ctx);
+
 #if defined(__cplusplus)
 } /* extern "C" */
 
+/**
+ * Initialize the iproto subsystem and start
+ * @a threads_count network threads.
+ */
 void
-iproto_init();
+iproto_init(int threads_count);
 
 void
 iproto_listen(const char *uri);
@@ -109,6 +109,25 @@ key_part_is_nullable(const struct key_part *part)
 	return part->nullable_action == ON_CONFLICT_ACTION_NONE;
 }
 
+/**
+ * Tuple comparison hint. It is computed from the first key part
+ * so that for any tuples or keys a and b
+ *
+ *   hint(a) < hint(b) => a < b
+ *
+ * i.e. comparing hints is enough unless they are equal. Hints
+ * are stored along with tuple pointers in ordered indexes to
+ * avoid dereferencing tuples and decoding fields on comparison.
+ * See tuple_compare_hinted().
+ */
+typedef uint64_t hint_t;
+
+/**
+ * Hint value meaning that the hint is unavailable and tuples
+ * must be compared by key fields.
+ */
+#define HINT_NONE ((hint_t)UINT64_MAX)
+
 /** @copydoc tuple_compare_with_key() */
 typedef int (*tuple_compare_with_key_t)(const struct tuple *tuple_a,
 					const char *key,
@@ -133,6 +152,12 @@ typedef uint32_t (*tuple_hash_t)(const struct tuple *tuple,
 /** @copydoc key_hash() */
 typedef uint32_t (*key_hash_t)(const char *key,
 				struct key_def *key_def);
+/** @copydoc tuple_hint() */
+typedef hint_t (*tuple_hint_t)(const struct tuple *tuple,
+			       struct key_def *key_def);
+/** @copydoc key_hint() */
+typedef hint_t (*key_hint_t)(const char *key, uint32_t part_count,
+			     struct key_def *key_def);
 
 /* Definition of a multipart key. */
 struct key_def {
@@ -148,6 +173,14 @@ struct key_def {
 	tuple_hash_t tuple_hash;
 	/** @see key_hash() */
 	key_hash_t key_hash;
+	/** @see tuple_hash_stable() */
+	tuple_hash_t tuple_hash_stable;
+	/** @see key_hash_stable() */
+	key_hash_t key_hash_stable;
+	/** @see tuple_hint() */
+	tuple_hint_t tuple_hint;
+	/** @see key_hint() */
+	key_hint_t key_hint;
 	/**
 	 * Minimal part count which always is unique. For example,
 	 * if a secondary index is unique, then
@@ -520,6 +553,81 @@ tuple_compare_with_key(const struct tuple *tuple, const char *key,
 	return key_def->tuple_compare_with_key(tuple, key, part_count, key_def);
 }
 
+/**
+ * Compute a comparison hint for a tuple.
+ * @param tuple tuple
+ * @param key_def key definition
+ * @return hint of the tuple or HINT_NONE
+ */
+static inline hint_t
+tuple_hint(const struct tuple *tuple, struct key_def *key_def)
+{
+	return key_def->tuple_hint(tuple, key_def);
+}
+
+/**
+ * Compute a comparison hint for a key.
+ * @param key key parts without MessagePack array header
+ * @param part_count the number of parts in @a key
+ * @param key_def key definition
+ * @return hint of the key or HINT_NONE
+ */
+static inline hint_t
+key_hint(const char *key, uint32_t part_count, struct key_def *key_def)
+{
+	return key_def->key_hint(key, part_count, key_def);
+}
+
+/**
+ * Compare tuples using the key definition and comparison hints.
+ * Falls back on tuple_compare() only if the hints are equal or
+ * unavailable.
+ * @param tuple_a first tuple
+ * @param tuple_a_hint comparison hint of @a tuple_a
+ * @param tuple_b second tuple
+ * @param tuple_b_hint comparison hint of @a tuple_b
+ * @param key_def key definition
+ * @retval 0  if key_fields(tuple_a) == key_fields(tuple_b)
+ * @retval <0 if key_fields(tuple_a) < key_fields(tuple_b)
+ * @retval >0 if key_fields(tuple_a) > key_fields(tuple_b)
+ */
+static inline int
+tuple_compare_hinted(const struct tuple *tuple_a, hint_t tuple_a_hint,
+		     const struct tuple *tuple_b, hint_t tuple_b_hint,
+		     struct key_def *key_def)
+{
+	if (tuple_a_hint != tuple_b_hint &&
+	    tuple_a_hint != HINT_NONE && tuple_b_hint != HINT_NONE)
+		return tuple_a_hint < tuple_b_hint ? -1 : 1;
+	return tuple_compare(tuple_a, tuple_b, key_def);
+}
+
+/**
+ * Compare tuple with key using the key definition and
+ * comparison hints. Falls back on tuple_compare_with_key()
+ * only if the hints are equal or unavailable.
+ * @param tuple tuple
+ * @param tuple_hint comparison hint of @a tuple
+ * @param key key parts without MessagePack array header
+ * @param part_count the number of parts in @a key
+ * @param key_hint comparison hint of @a key
+ * @param key_def key definition
+ *
+ * @retval 0  if key_fields(tuple) == parts(key)
+ * @retval <0 if key_fields(tuple) < parts(key)
+ * @retval >0 if key_fields(tuple) > parts(key)
+ */
+static inline int
+tuple_compare_with_key_hinted(const struct tuple *tuple, hint_t tuple_hint,
+			      const char *key, uint32_t part_count,
+			      hint_t key_hint, struct key_def *key_def)
+{
+	if (tuple_hint != key_hint &&
+	    tuple_hint != HINT_NONE && key_hint != HINT_NONE)
+		return tuple_hint < key_hint ? -1 : 1;
+	return tuple_compare_with_key(tuple, key, part_count, key_def);
+}
+
 #if defined(__cplusplus)
 } /* extern "C" */
 #endif /* defined(__cplusplus) */
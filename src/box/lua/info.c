@@ -49,8 +49,10 @@
 #include "box/gc.h"
 #include "box/checkpoint.h"
 #include "box/engine.h"
+#include "box/memtx_engine.h"
 #include "box/vinyl.h"
 #include "main.h"
+#include "rmean.h"
 #include "version.h"
 #include "box/box.h"
 #include "lua/utils.h"
@@ -107,6 +109,23 @@ lbox_pushapplier(lua_State *L, struct applier *applier)
 		lua_pushlstring(L, name, total);
 		lua_settable(L, -3);
 
+		int64_t rows = rmean_total(applier->rmean, APPLIER_STAT_ROWS);
+		int64_t txns = rmean_total(applier->rmean, APPLIER_STAT_TXNS);
+		lua_pushstring(L, "apply");
+		lua_createtable(L, 0, 3);
+		lua_pushstring(L, "rps");
+		lua_pushnumber(L, rmean_mean(applier->rmean,
+					     APPLIER_STAT_ROWS));
+		lua_settable(L, -3);
+		/* Average number of rows committed at once. */
+		lua_pushstring(L, "batch_size");
+		lua_pushnumber(L, txns > 0 ? (double)rows / txns : 0);
+		lua_settable(L, -3);
+		lua_pushstring(L, "total");
+		luaL_pushuint64(L, rows);
+		lua_settable(L, -3);
+		lua_settable(L, -3);
+
 		struct error *e = diag_last_error(&applier->reader->diag);
 		if (e != NULL) {
 			lua_pushstring(L, "message");
@@ -528,6 +547,34 @@ lbox_info_vinyl(struct lua_State *L)
 	return 1;
 }
 
+static int
+lbox_info_memtx_call(struct lua_State *L)
+{
+	struct info_handler h;
+	luaT_info_handler_create(&h, L);
+	struct memtx_engine *memtx;
+	memtx = (struct memtx_engine *)engine_by_name("memtx");
+	assert(memtx != NULL);
+	memtx_engine_stat(memtx, &h);
+	return 1;
+}
+
+static int
+lbox_info_memtx(struct lua_State *L)
+{
+	lua_newtable(L);
+
+	lua_newtable(L); /* metatable */
+
+	lua_pushstring(L, "__call");
+	lua_pushcfunction(L, lbox_info_memtx_call);
+	lua_settable(L, -3);
+
+	lua_setmetatable(L, -2);
+
+	return 1;
+}
+
 static const struct luaL_Reg lbox_info_dynamic_meta[] = {
 	{"id", lbox_info_id},
 	{"uuid", lbox_info_uuid},
@@ -543,6 +590,7 @@ static const struct luaL_Reg lbox_info_dynamic_meta[] = {
 	{"memory", lbox_info_memory},
 	{"gc", lbox_info_gc},
 	{"vinyl", lbox_info_vinyl},
+	{"memtx", lbox_info_memtx},
 	{NULL, NULL}
 };
 
@@ -27,6 +27,8 @@ local default_cfg = {
     memtx_memory        = 256 * 1024 *1024,
     memtx_min_tuple_size = 16,
     memtx_max_tuple_size = 1024 * 1024,
+    memtx_snap_threads  = 1,
+    memtx_sort_threads  = 0,
     slab_alloc_factor   = 1.05,
     work_dir            = nil,
     memtx_dir           = ".",
@@ -35,9 +37,14 @@ local default_cfg = {
     vinyl_dir           = '.',
     vinyl_memory        = 128 * 1024 * 1024,
     vinyl_cache         = 128 * 1024 * 1024,
+    vinyl_page_cache    = 0,
+    vinyl_run_index_cache = 0,
     vinyl_max_tuple_size = 1024 * 1024,
     vinyl_read_threads  = 1,
     vinyl_write_threads = 4,
+    vinyl_max_subcompactions = 1,
+    vinyl_readahead     = 0,
+    vinyl_direct_io     = false,
     vinyl_timeout       = 60,
     vinyl_run_count_per_level = 2,
     vinyl_run_size_ratio      = 3.5,
@@ -50,11 +57,17 @@ local default_cfg = {
     log_format          = "plain",
     io_collect_interval = nil,
     readahead           = 16320,
+    iproto_threads      = 1,
     snap_io_rate_limit  = nil, -- no limit
     too_long_threshold  = 0.5,
     wal_mode            = "write",
     rows_per_wal        = 500000,
     wal_max_size        = 256 * 1024 * 1024,
+    wal_cache           = 16 * 1024 * 1024,
+    wal_group_commit_timeout = 0,
+    wal_group_commit_bytes = 1024 * 1024,
+    wal_stripe_dirs     = nil,
+    io_uring            = false,
     wal_dir_rescan_delay= 2,
     force_recovery      = false,
     replication         = nil,
@@ -76,6 +89,7 @@ local default_cfg = {
     replication_connect_timeout = 30,
     replication_connect_quorum = nil, -- connect all
     replication_skip_conflict = false,
+    replication_wal_pipeline = 1,
     feedback_enabled      = true,
     feedback_host         = "https://feedback.tarantool.io",
     feedback_interval     = 3600,
@@ -89,6 +103,8 @@ local template_cfg = {
     memtx_memory        = 'number',
     memtx_min_tuple_size  = 'number',
     memtx_max_tuple_size  = 'number',
+    memtx_snap_threads  = 'number',
+    memtx_sort_threads  = 'number',
     slab_alloc_factor   = 'number',
     work_dir            = 'string',
     memtx_dir            = 'string',
@@ -96,9 +112,14 @@ local template_cfg = {
     vinyl_dir           = 'string',
     vinyl_memory        = 'number',
     vinyl_cache               = 'number',
+    vinyl_page_cache          = 'number',
+    vinyl_run_index_cache     = 'number',
     vinyl_max_tuple_size      = 'number',
     vinyl_read_threads        = 'number',
     vinyl_write_threads       = 'number',
+    vinyl_max_subcompactions  = 'number',
+    vinyl_readahead           = 'number',
+    vinyl_direct_io           = 'boolean',
     vinyl_timeout             = 'number',
     vinyl_run_count_per_level = 'number',
     vinyl_run_size_ratio      = 'number',
@@ -112,11 +133,17 @@ local template_cfg = {
     log_format          = 'string',
     io_collect_interval = 'number',
     readahead           = 'number',
+    iproto_threads      = 'number',
     snap_io_rate_limit  = 'number',
     too_long_threshold  = 'number',
     wal_mode            = 'string',
     rows_per_wal        = 'number',
     wal_max_size        = 'number',
+    wal_cache           = 'number',
+    wal_group_commit_timeout = 'number',
+    wal_group_commit_bytes = 'number',
+    wal_stripe_dirs     = 'string, table',
+    io_uring            = 'boolean',
     wal_dir_rescan_delay= 'number',
     force_recovery      = 'boolean',
     replication         = 'string, number, table',
@@ -138,6 +165,7 @@ local template_cfg = {
     replication_connect_timeout = 'number',
     replication_connect_quorum = 'number',
     replication_skip_conflict = 'boolean',
+    replication_wal_pipeline = 'number',
     feedback_enabled      = 'boolean',
     feedback_host         = 'string',
     feedback_interval     = 'number',
@@ -210,11 +238,20 @@ local dynamic_cfg = {
     read_only               = private.cfg_set_read_only,
     memtx_memory            = private.cfg_set_memtx_memory,
     memtx_max_tuple_size    = private.cfg_set_memtx_max_tuple_size,
+    memtx_snap_threads      = private.cfg_set_memtx_snap_threads,
+    memtx_sort_threads      = private.cfg_set_memtx_sort_threads,
     vinyl_memory            = private.cfg_set_vinyl_memory,
     vinyl_max_tuple_size    = private.cfg_set_vinyl_max_tuple_size,
     vinyl_cache             = private.cfg_set_vinyl_cache,
+    vinyl_page_cache        = private.cfg_set_vinyl_page_cache,
+    vinyl_run_index_cache   = private.cfg_set_vinyl_run_index_cache,
+    vinyl_max_subcompactions = private.cfg_set_vinyl_max_subcompactions,
+    vinyl_readahead         = private.cfg_set_vinyl_readahead,
     vinyl_timeout           = private.cfg_set_vinyl_timeout,
     checkpoint_count        = private.cfg_set_checkpoint_count,
+    wal_cache               = private.cfg_set_wal_cache,
+    wal_group_commit_timeout = private.cfg_set_wal_group_commit,
+    wal_group_commit_bytes  = private.cfg_set_wal_group_commit,
     checkpoint_interval     = private.checkpoint_daemon.set_checkpoint_interval,
     worker_pool_threads     = private.cfg_set_worker_pool_threads,
     feedback_enabled        = private.feedback_daemon.set_feedback_params,
@@ -232,6 +269,7 @@ local dynamic_cfg = {
     replication_sync_lag    = private.cfg_set_replication_sync_lag,
     replication_sync_timeout = private.cfg_set_replication_sync_timeout,
     replication_skip_conflict = private.cfg_set_replication_skip_conflict,
+    replication_wal_pipeline = private.cfg_set_replication_wal_pipeline,
     instance_uuid           = check_instance_uuid,
     replicaset_uuid         = check_replicaset_uuid,
     net_msg_max             = private.cfg_set_net_msg_max,
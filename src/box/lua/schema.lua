@@ -431,6 +431,8 @@ box.schema.space.create = function(name, options)
         format = 'table',
         is_local = 'boolean',
         temporary = 'boolean',
+        compact_field_map = 'boolean',
+        field_map_step = 'number',
     }
     local options_defaults = {
         engine = 'memtx',
@@ -475,6 +477,8 @@ box.schema.space.create = function(name, options)
     local space_options = setmap({
         group_id = options.is_local and 1 or nil,
         temporary = options.temporary and true or nil,
+        compact_field_map = options.compact_field_map and true or nil,
+        field_map_step = options.field_map_step,
     })
     _space:insert{id, uid, name, options.engine, options.field_count,
         space_options, format}
@@ -699,6 +703,10 @@ local index_options = {
     range_size = 'number',
     page_size = 'number',
     bloom_fpr = 'number',
+    bloom_type = 'string',
+    compaction = 'string',
+    expire_field = 'number',
+    blob_threshold = 'number',
 }
 
 --
@@ -804,6 +812,10 @@ box.schema.index.create = function(space_id, name, options)
             run_count_per_level = options.run_count_per_level,
             run_size_ratio = options.run_size_ratio,
             bloom_fpr = options.bloom_fpr,
+            bloom_type = options.bloom_type,
+            compaction = options.compaction,
+            expire_field = options.expire_field,
+            blob_threshold = options.blob_threshold,
     }
     local field_type_aliases = {
         num = 'unsigned'; -- Deprecated since 1.7.2
@@ -167,6 +167,19 @@ lbox_slab_info(struct lua_State *L)
 	lua_pushstring(L, ratio_buf);
 	lua_settable(L, -3);
 
+	/** Number of tuples stored with a tiny header. */
+	lua_pushstring(L, "tiny_tuples");
+	luaL_pushuint64(L, memtx->tiny_tuple_count);
+	lua_settable(L, -3);
+
+	/**
+	 * How much memory tiny tuple headers saved compared
+	 * to the regular tuple header.
+	 */
+	lua_pushstring(L, "tiny_tuples_saved");
+	luaL_pushuint64(L, memtx->tiny_tuple_saved);
+	lua_settable(L, -3);
+
 	/** How much address space has been already touched
 	 * (tuples and indexes) */
 	lua_pushstring(L, "arena_size");
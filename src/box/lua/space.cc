@@ -349,6 +349,24 @@ lbox_fillspace(struct lua_State *L, struct space *space, int i)
 			lua_pushnumber(L, index_opts->bloom_fpr);
 			lua_setfield(L, -2, "bloom_fpr");
 
+			lua_pushstring(L,
+				bloom_type_strs[index_opts->bloom_type]);
+			lua_setfield(L, -2, "bloom_type");
+
+			lua_pushstring(L,
+				compaction_policy_strs[index_opts->compaction]);
+			lua_setfield(L, -2, "compaction");
+
+			if (index_opts->expire_field > 0) {
+				lua_pushnumber(L, index_opts->expire_field);
+				lua_setfield(L, -2, "expire_field");
+			}
+
+			if (index_opts->blob_threshold > 0) {
+				lua_pushnumber(L, index_opts->blob_threshold);
+				lua_setfield(L, -2, "blob_threshold");
+			}
+
 			lua_settable(L, -3);
 		}
 		lua_setfield(L, -2, index_def->name);
@@ -42,14 +42,13 @@
 #include "box/iproto.h"
 #include "box/engine.h"
 #include "box/vinyl.h"
+#include "box/wal.h"
 #include "box/info.h"
 #include "box/lua/info.h"
 #include "lua/utils.h"
 
 extern struct rmean *rmean_box;
 extern struct rmean *rmean_error;
-/** network statistics (iproto & cbus) */
-extern struct rmean *rmean_net;
 extern struct rmean *rmean_tx_wal_bus;
 
 static void
@@ -127,12 +126,22 @@ lbox_stat_vinyl(struct lua_State *L)
 	return 1;
 }
 
+static int
+lbox_stat_wal(struct lua_State *L)
+{
+	struct info_handler h;
+	luaT_info_handler_create(&h, L);
+	wal_stat(&h);
+	return 1;
+}
+
 static int
 lbox_stat_reset(struct lua_State *L)
 {
 	(void)L;
 	box_reset_stat();
 	iproto_reset_stat();
+	wal_reset_stat();
 	return 0;
 }
 
@@ -140,14 +149,31 @@ static int
 lbox_stat_net_index(struct lua_State *L)
 {
 	luaL_checkstring(L, -1);
-	return rmean_foreach(rmean_net, seek_stat_item, L);
+	return iproto_rmean_foreach(seek_stat_item, L);
 }
 
 static int
 lbox_stat_net_call(struct lua_State *L)
 {
 	lua_newtable(L);
-	rmean_foreach(rmean_net, set_stat_item, L);
+	iproto_rmean_foreach(set_stat_item, L);
+	return 1;
+}
+
+/**
+ * Return an array of network statistics of each network thread,
+ * see box.cfg.iproto_threads.
+ */
+static int
+lbox_stat_net_thread(struct lua_State *L)
+{
+	int count = iproto_thread_count();
+	lua_createtable(L, count, 0);
+	for (int i = 0; i < count; i++) {
+		lua_newtable(L);
+		iproto_thread_rmean_foreach(i, set_stat_item, L);
+		lua_rawseti(L, -2, i + 1);
+	}
 	return 1;
 }
 
@@ -169,6 +195,7 @@ box_lua_stat_init(struct lua_State *L)
 {
 	static const struct luaL_Reg statlib [] = {
 		{"vinyl", lbox_stat_vinyl},
+		{"wal", lbox_stat_wal},
 		{"reset", lbox_stat_reset},
 		{NULL, NULL}
 	};
@@ -181,6 +208,7 @@ box_lua_stat_init(struct lua_State *L)
 	lua_pop(L, 1); /* stat module */
 
 	static const struct luaL_Reg netstatlib [] = {
+		{"thread", lbox_stat_net_thread},
 		{NULL, NULL}
 	};
 
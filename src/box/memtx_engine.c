@@ -34,6 +34,7 @@
 #include <small/quota.h>
 #include <small/small.h>
 #include <small/mempool.h>
+#include <unistd.h>
 
 #include "fiber.h"
 #include "errinj.h"
@@ -48,6 +49,9 @@
 #include "replication.h"
 #include "schema.h"
 #include "gc.h"
+#include "tt_pthread.h"
+#include "fiber_cond.h"
+#include "info.h"
 
 /*
  * Memtx yield-in-transaction trigger: roll back the effects
@@ -116,6 +120,23 @@ struct memtx_tuple {
 	struct tuple base;
 };
 
+/**
+ * Size of a memtx tuple allocation.
+ * @param is_tiny Set if the tuple has a tiny header,
+ *        see tuple_create_tiny().
+ * @param meta_size Size of the tuple meta.
+ * @param bsize Length of the MessagePack data.
+ */
+static inline size_t
+memtx_tuple_size(bool is_tiny, size_t meta_size, size_t bsize)
+{
+	if (is_tiny) {
+		return offsetof(struct memtx_tuple, base) +
+		       TUPLE_TINY_HEADER_SIZE + meta_size + bsize;
+	}
+	return sizeof(struct memtx_tuple) + meta_size + bsize;
+}
+
 enum {
 	OBJSIZE_MIN = 16,
 	SLAB_SIZE = 16 * 1024 * 1024,
@@ -135,6 +156,150 @@ memtx_end_build_primary_key(struct space *space, void *param)
 	return 0;
 }
 
+enum {
+	/**
+	 * Secondary keys of spaces with fewer tuples are built
+	 * by the tx thread, it isn't worth starting threads.
+	 */
+	MEMTX_BUILD_PARALLEL_MIN_TUPLES = 10000,
+};
+
+/**
+ * State of a parallel build of secondary keys of a space.
+ * The tuples of the primary key are collected in tx, then
+ * each secondary index is built by one of worker threads.
+ */
+struct memtx_build_ctx {
+	/** Tuples of the primary key. */
+	struct tuple **tuples;
+	/** Number of tuples. */
+	ssize_t tuple_count;
+	/** Indexes to build. */
+	struct index **indexes;
+	/** Number of indexes. */
+	uint32_t index_count;
+	/** Next index to be taken by a worker. */
+	uint32_t next_index;
+	/** Set if a worker failed, makes others stop. */
+	bool is_failed;
+	/** Protects next_index and is_failed. */
+	pthread_mutex_t mutex;
+};
+
+/** Build a secondary index given the tuples of the primary key. */
+static int
+memtx_build_index(struct index *index, struct tuple **tuples,
+		  ssize_t tuple_count)
+{
+	index_begin_build(index);
+	if (index_reserve(index, tuple_count * 1.2) < 0)
+		return -1;
+	say_info("Adding %zd keys to %s index '%s' ...",
+		 tuple_count, index_type_strs[index->def->type],
+		 index->def->name);
+	for (ssize_t i = 0; i < tuple_count; i++) {
+		if (index_build_next(index, tuples[i]) != 0)
+			return -1;
+	}
+	index_end_build(index);
+	return 0;
+}
+
+static int
+memtx_build_worker_f(va_list ap)
+{
+	struct memtx_build_ctx *ctx = va_arg(ap, struct memtx_build_ctx *);
+	while (true) {
+		struct index *index = NULL;
+		tt_pthread_mutex_lock(&ctx->mutex);
+		if (!ctx->is_failed && ctx->next_index < ctx->index_count)
+			index = ctx->indexes[ctx->next_index++];
+		tt_pthread_mutex_unlock(&ctx->mutex);
+		if (index == NULL)
+			break;
+		if (memtx_build_index(index, ctx->tuples,
+				      ctx->tuple_count) != 0) {
+			tt_pthread_mutex_lock(&ctx->mutex);
+			ctx->is_failed = true;
+			tt_pthread_mutex_unlock(&ctx->mutex);
+			return -1;
+		}
+	}
+	return 0;
+}
+
+/**
+ * Build secondary keys of a space in worker threads,
+ * one index per thread at a time.
+ */
+static int
+memtx_build_secondary_keys_parallel(struct space *space, int threads)
+{
+	struct index *pk = space->index[0];
+	struct memtx_build_ctx ctx;
+	ctx.tuple_count = index_size(pk);
+	ctx.indexes = space->index + 1;
+	ctx.index_count = space->index_count - 1;
+	ctx.next_index = 0;
+	ctx.is_failed = false;
+	ctx.tuples = malloc(ctx.tuple_count * sizeof(*ctx.tuples));
+	if (ctx.tuples == NULL) {
+		diag_set(OutOfMemory, ctx.tuple_count * sizeof(*ctx.tuples),
+			 "malloc", "memtx_build_ctx");
+		return -1;
+	}
+	struct iterator *it = index_create_iterator(pk, ITER_ALL, NULL, 0);
+	if (it == NULL) {
+		free(ctx.tuples);
+		return -1;
+	}
+	ssize_t count = 0;
+	struct tuple *tuple;
+	int rc;
+	while ((rc = iterator_next(it, &tuple)) == 0 && tuple != NULL) {
+		assert(count < ctx.tuple_count);
+		ctx.tuples[count++] = tuple;
+	}
+	iterator_delete(it);
+	if (rc != 0) {
+		free(ctx.tuples);
+		return -1;
+	}
+	assert(count == ctx.tuple_count);
+
+	if ((uint32_t)threads > ctx.index_count)
+		threads = ctx.index_count;
+	struct cord *workers = calloc(threads, sizeof(*workers));
+	if (workers == NULL) {
+		diag_set(OutOfMemory, threads * sizeof(*workers),
+			 "calloc", "memtx build workers");
+		free(ctx.tuples);
+		return -1;
+	}
+	tt_pthread_mutex_init(&ctx.mutex, NULL);
+	int started;
+	for (started = 0; started < threads; started++) {
+		char name[FIBER_NAME_MAX];
+		snprintf(name, sizeof(name), "build%d", started);
+		if (cord_costart(&workers[started], name,
+				 memtx_build_worker_f, &ctx) != 0) {
+			tt_pthread_mutex_lock(&ctx.mutex);
+			ctx.is_failed = true;
+			tt_pthread_mutex_unlock(&ctx.mutex);
+			rc = -1;
+			break;
+		}
+	}
+	for (int i = 0; i < started; i++) {
+		if (cord_cojoin(&workers[i]) != 0)
+			rc = -1;
+	}
+	tt_pthread_mutex_destroy(&ctx.mutex);
+	free(workers);
+	free(ctx.tuples);
+	return rc;
+}
+
 /**
  * Secondary indexes are built in bulk after all data is
  * recovered. This function enables secondary keys on a space.
@@ -144,6 +309,7 @@ memtx_end_build_primary_key(struct space *space, void *param)
 static int
 memtx_build_secondary_keys(struct space *space, void *param)
 {
+	struct memtx_engine *memtx = (struct memtx_engine *)param;
 	struct memtx_space *memtx_space = (struct memtx_space *)space;
 	if (space->engine != param || space_index(space, 0) == NULL ||
 	    memtx_space->replace == memtx_space_replace_all_keys)
@@ -159,9 +325,19 @@ memtx_build_secondary_keys(struct space *space, void *param)
 				 space_name(space));
 		}
 
-		for (uint32_t j = 1; j < space->index_count; j++) {
-			if (index_build(space->index[j], pk) < 0)
+		if (memtx->snap_threads > 1 && space->index_count > 2 &&
+		    n_tuples >= MEMTX_BUILD_PARALLEL_MIN_TUPLES) {
+			if (memtx_build_secondary_keys_parallel(space,
+						memtx->snap_threads) != 0)
 				return -1;
+			memtx->recovery_stat.index_done +=
+				space->index_count - 1;
+		} else {
+			for (uint32_t j = 1; j < space->index_count; j++) {
+				if (index_build(space->index[j], pk) < 0)
+					return -1;
+				memtx->recovery_stat.index_done++;
+			}
 		}
 
 		if (n_tuples > 0) {
@@ -172,6 +348,28 @@ memtx_build_secondary_keys(struct space *space, void *param)
 	return 0;
 }
 
+/** Count secondary keys to build, for recovery progress. */
+static int
+memtx_count_secondary_keys(struct space *space, void *param)
+{
+	struct memtx_engine *memtx = (struct memtx_engine *)param;
+	struct memtx_space *memtx_space = (struct memtx_space *)space;
+	if (space->engine != param || space_index(space, 0) == NULL ||
+	    memtx_space->replace == memtx_space_replace_all_keys)
+		return 0;
+	memtx->recovery_stat.index_total += space->index_count - 1;
+	return 0;
+}
+
+static int
+memtx_engine_build_secondary_keys(struct memtx_engine *memtx)
+{
+	memtx->recovery_stat.index_total = 0;
+	memtx->recovery_stat.index_done = 0;
+	space_foreach(memtx_count_secondary_keys, memtx);
+	return space_foreach(memtx_build_secondary_keys, memtx);
+}
+
 static void
 memtx_engine_shutdown(struct engine *engine)
 {
@@ -184,7 +382,10 @@ memtx_engine_shutdown(struct engine *engine)
 		mempool_destroy(&memtx->hash_iterator_pool);
 	if (mempool_is_initialized(&memtx->bitset_iterator_pool))
 		mempool_destroy(&memtx->bitset_iterator_pool);
+	/* The slab cache may have been last used by a build thread. */
+	slab_cache_set_thread(&memtx->index_slab_cache);
 	mempool_destroy(&memtx->index_extent_pool);
+	tt_pthread_mutex_destroy(&memtx->index_extent_mutex);
 	slab_cache_destroy(&memtx->index_slab_cache);
 	small_alloc_destroy(&memtx->alloc);
 	slab_cache_destroy(&memtx->slab_cache);
@@ -197,6 +398,290 @@ static int
 memtx_engine_recover_snapshot_row(struct memtx_engine *memtx,
 				  struct xrow_header *row);
 
+enum {
+	/** Number of rows passed by the snapshot reader at once. */
+	SNAP_READ_BATCH_ROWS = 1024,
+	/** Max number of row batches the snapshot reader reads ahead. */
+	SNAP_READ_QUEUE_DEPTH = 16,
+	/** Initial size of a row batch body buffer. */
+	SNAP_READ_BATCH_DATA_SIZE = 64 * 1024,
+};
+
+/** Rows read and decoded by the snapshot reader thread. */
+struct snap_read_batch {
+	/** Link in snap_reader::batches. */
+	struct stailq_entry in_batches;
+	/** Number of rows in the batch. */
+	int row_count;
+	/** Row bodies, referenced by rows. */
+	char *data;
+	/** Size of row bodies. */
+	size_t data_size;
+	/** Size of the data buffer. */
+	size_t data_capacity;
+	/** Row headers. */
+	struct xrow_header rows[SNAP_READ_BATCH_ROWS];
+};
+
+static struct snap_read_batch *
+snap_read_batch_new(void)
+{
+	struct snap_read_batch *batch = malloc(sizeof(*batch));
+	if (batch == NULL) {
+		diag_set(OutOfMemory, sizeof(*batch),
+			 "malloc", "struct snap_read_batch");
+		return NULL;
+	}
+	batch->row_count = 0;
+	batch->data = NULL;
+	batch->data_size = 0;
+	batch->data_capacity = 0;
+	return batch;
+}
+
+static void
+snap_read_batch_delete(struct snap_read_batch *batch)
+{
+	free(batch->data);
+	free(batch);
+}
+
+/**
+ * Append a copy of a row to a batch. Since the data buffer
+ * may be reallocated, row bodies are referenced by offsets
+ * until snap_read_batch_seal() is called.
+ */
+static int
+snap_read_batch_add(struct snap_read_batch *batch,
+		    const struct xrow_header *row)
+{
+	assert(batch->row_count < SNAP_READ_BATCH_ROWS);
+	assert(row->bodycnt <= 1);
+	size_t len = row->bodycnt > 0 ? row->body[0].iov_len : 0;
+	if (batch->data_size + len > batch->data_capacity) {
+		size_t capacity = MAX(batch->data_capacity * 2,
+				      (size_t)SNAP_READ_BATCH_DATA_SIZE);
+		while (capacity < batch->data_size + len)
+			capacity *= 2;
+		char *data = realloc(batch->data, capacity);
+		if (data == NULL) {
+			diag_set(OutOfMemory, capacity,
+				 "realloc", "snapshot row batch");
+			return -1;
+		}
+		batch->data = data;
+		batch->data_capacity = capacity;
+	}
+	struct xrow_header *copy = &batch->rows[batch->row_count++];
+	*copy = *row;
+	if (len > 0) {
+		memcpy(batch->data + batch->data_size,
+		       row->body[0].iov_base, len);
+		copy->body[0].iov_base = (void *)(uintptr_t)batch->data_size;
+		batch->data_size += len;
+	}
+	return 0;
+}
+
+/** Turn row body offsets into pointers. */
+static void
+snap_read_batch_seal(struct snap_read_batch *batch)
+{
+	for (int i = 0; i < batch->row_count; i++) {
+		struct xrow_header *row = &batch->rows[i];
+		if (row->bodycnt > 0) {
+			row->body[0].iov_base = batch->data +
+				(uintptr_t)row->body[0].iov_base;
+		}
+	}
+}
+
+/**
+ * Snapshot reader. Reading, decompressing and decoding the
+ * snapshot is done in a separate thread, while the tx thread
+ * only applies the decoded rows.
+ */
+struct snap_reader {
+	/** Reader thread. */
+	struct cord cord;
+	/** Snapshot file name. */
+	const char *filename;
+	/** Skip invalid snapshot records. */
+	bool force_recovery;
+	/** Batches ready to be applied, linked by in_batches. */
+	struct stailq batches;
+	/** Length of the batches queue. */
+	int batch_count;
+	/** Set when the reader thread is done. */
+	bool is_done;
+	/** Set by tx to make the reader thread stop. */
+	bool is_stopped;
+	/** Set if the snapshot has the EOF marker. */
+	bool is_eof;
+	/** Protects the fields above shared by threads. */
+	pthread_mutex_t mutex;
+	/** Signalled when tx takes a batch from the queue. */
+	pthread_cond_t cond;
+	/** Event loop of the tx thread. */
+	struct ev_loop *tx_loop;
+	/** Wakes up tx when a batch is queued. */
+	struct ev_async async;
+	/** Tx waits on it for a batch to be queued. */
+	struct fiber_cond tx_cond;
+};
+
+static void
+snap_reader_async_cb(struct ev_loop *loop, struct ev_async *ev, int revents)
+{
+	(void)loop;
+	(void)revents;
+	struct snap_reader *reader = (struct snap_reader *)ev->data;
+	fiber_cond_broadcast(&reader->tx_cond);
+}
+
+static void
+snap_reader_create(struct snap_reader *reader, const char *filename,
+		   bool force_recovery)
+{
+	reader->filename = filename;
+	reader->force_recovery = force_recovery;
+	stailq_create(&reader->batches);
+	reader->batch_count = 0;
+	reader->is_done = false;
+	reader->is_stopped = false;
+	reader->is_eof = false;
+	tt_pthread_mutex_init(&reader->mutex, NULL);
+	tt_pthread_cond_init(&reader->cond, NULL);
+	reader->tx_loop = loop();
+	ev_async_init(&reader->async, snap_reader_async_cb);
+	reader->async.data = reader;
+	ev_async_start(reader->tx_loop, &reader->async);
+	fiber_cond_create(&reader->tx_cond);
+}
+
+static void
+snap_reader_destroy(struct snap_reader *reader)
+{
+	struct snap_read_batch *batch, *tmp;
+	stailq_foreach_entry_safe(batch, tmp, &reader->batches, in_batches)
+		snap_read_batch_delete(batch);
+	ev_async_stop(reader->tx_loop, &reader->async);
+	fiber_cond_destroy(&reader->tx_cond);
+	tt_pthread_mutex_destroy(&reader->mutex);
+	tt_pthread_cond_destroy(&reader->cond);
+}
+
+/**
+ * Queue a batch for tx. Waits if there are too many
+ * batches queued. Returns false if tx asked to stop,
+ * in which case the batch is deleted.
+ */
+static bool
+snap_reader_push(struct snap_reader *reader, struct snap_read_batch *batch)
+{
+	snap_read_batch_seal(batch);
+	tt_pthread_mutex_lock(&reader->mutex);
+	while (!reader->is_stopped &&
+	       reader->batch_count >= SNAP_READ_QUEUE_DEPTH)
+		tt_pthread_cond_wait(&reader->cond, &reader->mutex);
+	bool is_stopped = reader->is_stopped;
+	if (!is_stopped) {
+		stailq_add_tail_entry(&reader->batches, batch, in_batches);
+		reader->batch_count++;
+	}
+	tt_pthread_mutex_unlock(&reader->mutex);
+	if (is_stopped) {
+		snap_read_batch_delete(batch);
+		return false;
+	}
+	ev_async_send(reader->tx_loop, &reader->async);
+	return true;
+}
+
+/**
+ * Take the next batch from the queue, waiting for the
+ * reader thread if necessary. Returns NULL when there are
+ * no more rows.
+ */
+static struct snap_read_batch *
+snap_reader_pop(struct snap_reader *reader)
+{
+	tt_pthread_mutex_lock(&reader->mutex);
+	while (stailq_empty(&reader->batches) && !reader->is_done) {
+		tt_pthread_mutex_unlock(&reader->mutex);
+		fiber_cond_wait(&reader->tx_cond);
+		tt_pthread_mutex_lock(&reader->mutex);
+	}
+	struct snap_read_batch *batch = NULL;
+	if (!stailq_empty(&reader->batches)) {
+		batch = stailq_shift_entry(&reader->batches,
+					   struct snap_read_batch, in_batches);
+		reader->batch_count--;
+		tt_pthread_cond_signal(&reader->cond);
+	}
+	tt_pthread_mutex_unlock(&reader->mutex);
+	return batch;
+}
+
+/** Make the reader thread stop. */
+static void
+snap_reader_stop(struct snap_reader *reader)
+{
+	tt_pthread_mutex_lock(&reader->mutex);
+	reader->is_stopped = true;
+	tt_pthread_cond_signal(&reader->cond);
+	tt_pthread_mutex_unlock(&reader->mutex);
+}
+
+static int
+snap_reader_f(va_list ap)
+{
+	struct snap_reader *reader = va_arg(ap, struct snap_reader *);
+	struct snap_read_batch *batch = NULL;
+	struct xlog_cursor cursor;
+	bool is_eof = false;
+	int rc = xlog_cursor_open(&cursor, reader->filename);
+	if (rc == 0) {
+		struct xrow_header row;
+		while ((rc = xlog_cursor_next(&cursor, &row,
+					      reader->force_recovery)) == 0) {
+			if (batch == NULL &&
+			    (batch = snap_read_batch_new()) == NULL) {
+				rc = -1;
+				break;
+			}
+			if (snap_read_batch_add(batch, &row) != 0) {
+				rc = -1;
+				break;
+			}
+			if (batch->row_count < SNAP_READ_BATCH_ROWS)
+				continue;
+			bool is_stopped = !snap_reader_push(reader, batch);
+			batch = NULL;
+			if (is_stopped)
+				break;
+		}
+		is_eof = xlog_cursor_is_eof(&cursor);
+		xlog_cursor_close(&cursor, false);
+	}
+	if (rc > 0) {
+		/* End of file. */
+		rc = 0;
+		if (batch != NULL)
+			snap_reader_push(reader, batch);
+		batch = NULL;
+	}
+	if (batch != NULL)
+		snap_read_batch_delete(batch);
+
+	tt_pthread_mutex_lock(&reader->mutex);
+	reader->is_eof = is_eof;
+	reader->is_done = true;
+	tt_pthread_mutex_unlock(&reader->mutex);
+	ev_async_send(reader->tx_loop, &reader->async);
+	return rc < 0 ? -1 : 0;
+}
+
 int
 memtx_engine_recover_snapshot(struct memtx_engine *memtx,
 			      const struct vclock *vclock)
@@ -208,31 +693,45 @@ memtx_engine_recover_snapshot(struct memtx_engine *memtx,
 						    signature, NONE);
 
 	say_info("recovering from `%s'", filename);
-	struct xlog_cursor cursor;
-	if (xlog_cursor_open(&cursor, filename) < 0)
+	struct snap_reader reader;
+	snap_reader_create(&reader, filename, memtx->force_recovery);
+	if (cord_costart(&reader.cord, "snap_reader",
+			 snap_reader_f, &reader) != 0) {
+		snap_reader_destroy(&reader);
 		return -1;
+	}
 
-	int rc;
-	struct xrow_header row;
+	int rc = 0;
 	uint64_t row_count = 0;
-	while ((rc = xlog_cursor_next(&cursor, &row,
-				      memtx->force_recovery)) == 0) {
-		row.lsn = signature;
-		rc = memtx_engine_recover_snapshot_row(memtx, &row);
-		if (rc < 0) {
-			if (!memtx->force_recovery)
-				break;
-			say_error("can't apply row: ");
-			diag_log();
-		}
-		++row_count;
-		if (row_count % 100000 == 0) {
-			say_info("%.1fM rows processed",
-				 row_count / 1000000.);
-			fiber_yield_timeout(0);
+	struct snap_read_batch *batch;
+	while (rc == 0 && (batch = snap_reader_pop(&reader)) != NULL) {
+		for (int i = 0; i < batch->row_count; i++) {
+			struct xrow_header *row = &batch->rows[i];
+			row->lsn = signature;
+			rc = memtx_engine_recover_snapshot_row(memtx, row);
+			if (rc < 0) {
+				if (!memtx->force_recovery)
+					break;
+				say_error("can't apply row: ");
+				diag_log();
+				rc = 0;
+			}
+			++row_count;
+			memtx->recovery_stat.snap_rows = row_count;
+			if (row_count % 100000 == 0) {
+				say_info("%.1fM rows processed",
+					 row_count / 1000000.);
+				fiber_yield_timeout(0);
+			}
 		}
+		snap_read_batch_delete(batch);
 	}
-	xlog_cursor_close(&cursor, false);
+	if (rc < 0)
+		snap_reader_stop(&reader);
+	if (cord_cojoin(&reader.cord) != 0)
+		rc = -1;
+	bool is_eof = reader.is_eof;
+	snap_reader_destroy(&reader);
 	if (rc < 0)
 		return -1;
 
@@ -241,7 +740,7 @@ memtx_engine_recover_snapshot(struct memtx_engine *memtx,
 	 * marker - such snapshots are very likely corrupted and
 	 * should not be trusted.
 	 */
-	if (!xlog_cursor_is_eof(&cursor))
+	if (!is_eof)
 		panic("snapshot `%s' has no EOF marker", filename);
 
 	return 0;
@@ -330,7 +829,7 @@ memtx_engine_begin_final_recovery(struct engine *engine)
 		 * unique keys.
 		 */
 		memtx->state = MEMTX_OK;
-		if (space_foreach(memtx_build_secondary_keys, memtx) != 0)
+		if (memtx_engine_build_secondary_keys(memtx) != 0)
 			return -1;
 	}
 	return 0;
@@ -349,7 +848,7 @@ memtx_engine_end_recovery(struct engine *engine)
 	if (memtx->state != MEMTX_OK) {
 		assert(memtx->state == MEMTX_FINAL_RECOVERY);
 		memtx->state = MEMTX_OK;
-		if (space_foreach(memtx_build_secondary_keys, memtx) != 0)
+		if (memtx_engine_build_secondary_keys(memtx) != 0)
 			return -1;
 	}
 	xdir_collect_inprogress(&memtx->snap_dir);
@@ -534,7 +1033,11 @@ checkpoint_write_row(struct xlog *l, struct xrow_header *row)
 	if (written < 0)
 		return -1;
 
-	if ((l->rows + l->tx_rows) % 100000 == 0)
+	/*
+	 * Progress of a parallel checkpoint is reported by
+	 * the snapshot thread, see checkpoint_write_blocks().
+	 */
+	if (xlog_is_open(l) && (l->rows + l->tx_rows) % 100000 == 0)
 		say_crit("%.1fM rows written", (l->rows + l->tx_rows) / 1000000.0);
 	return 0;
 
@@ -570,6 +1073,35 @@ struct checkpoint_entry {
 	struct rlist link;
 };
 
+enum {
+	/**
+	 * Size of rows encoded by a checkpoint worker thread
+	 * before it is formatted into a tx block and passed
+	 * to the snapshot thread.
+	 */
+	CHECKPOINT_BLOCK_SIZE = 128 * 1024,
+	/**
+	 * Max number of formatted tx blocks waiting to be
+	 * written to the snapshot file, per worker thread.
+	 */
+	CHECKPOINT_QUEUE_DEPTH = 4,
+};
+
+/**
+ * A tx block formatted by a checkpoint worker thread and
+ * waiting to be appended to the snapshot file.
+ */
+struct checkpoint_block {
+	/** Link in checkpoint::blocks. */
+	struct stailq_entry in_blocks;
+	/** The block, as returned by xlog_tx_encode(). */
+	char *data;
+	/** Size of the block. */
+	size_t size;
+	/** Number of rows in the block. */
+	int64_t rows;
+};
+
 struct checkpoint {
 	/**
 	 * List of MemTX spaces to snapshot, with consistent
@@ -587,11 +1119,41 @@ struct checkpoint {
 	 * checkpoint already exists.
 	 */
 	bool touch;
+	/**
+	 * Number of threads encoding rows of user spaces,
+	 * box.cfg.memtx_snap_threads. If it is 1, the snapshot
+	 * thread writes all spaces itself.
+	 */
+	int threads;
+	/** Worker threads, see checkpoint_worker_f(). */
+	struct cord *workers;
+	/** Number of worker threads that haven't finished yet. */
+	int workers_running;
+	/**
+	 * The next space to be taken by a worker thread,
+	 * NULL if all spaces have been taken.
+	 */
+	struct checkpoint_entry *next_entry;
+	/** Blocks formatted by workers, linked by in_blocks. */
+	struct stailq blocks;
+	/** Length of the blocks queue. */
+	int block_count;
+	/**
+	 * Set if either a worker or the snapshot thread failed.
+	 * Makes all threads stop.
+	 */
+	bool is_failed;
+	/** Protects the fields shared by the workers. */
+	pthread_mutex_t mutex;
+	/** Signalled when a block is queued or a worker exits. */
+	pthread_cond_t queue_cond;
+	/** Signalled when a block is taken from the queue. */
+	pthread_cond_t space_cond;
 };
 
 static int
 checkpoint_init(struct checkpoint *ckpt, const char *snap_dirname,
-		uint64_t snap_io_rate_limit)
+		uint64_t snap_io_rate_limit, int threads)
 {
 	rlist_create(&ckpt->entries);
 	ckpt->waiting_for_snap_thread = false;
@@ -599,6 +1161,16 @@ checkpoint_init(struct checkpoint *ckpt, const char *snap_dirname,
 	ckpt->snap_io_rate_limit = snap_io_rate_limit;
 	vclock_create(&ckpt->vclock);
 	ckpt->touch = false;
+	ckpt->threads = threads;
+	ckpt->workers = NULL;
+	ckpt->workers_running = 0;
+	ckpt->next_entry = NULL;
+	stailq_create(&ckpt->blocks);
+	ckpt->block_count = 0;
+	ckpt->is_failed = false;
+	tt_pthread_mutex_init(&ckpt->mutex, NULL);
+	tt_pthread_cond_init(&ckpt->queue_cond, NULL);
+	tt_pthread_cond_init(&ckpt->space_cond, NULL);
 	return 0;
 }
 
@@ -611,6 +1183,9 @@ checkpoint_destroy(struct checkpoint *ckpt)
 	}
 	rlist_create(&ckpt->entries);
 	xdir_destroy(&ckpt->dir);
+	tt_pthread_mutex_destroy(&ckpt->mutex);
+	tt_pthread_cond_destroy(&ckpt->queue_cond);
+	tt_pthread_cond_destroy(&ckpt->space_cond);
 }
 
 
@@ -642,6 +1217,254 @@ checkpoint_add_space(struct space *sp, void *data)
 	return 0;
 };
 
+/** Write all tuples of a space to a snapshot file or buffer. */
+static int
+checkpoint_write_space(struct xlog *l, struct checkpoint_entry *entry)
+{
+	uint32_t size;
+	const char *data;
+	struct snapshot_iterator *it = entry->iterator;
+	for (data = it->next(it, &size); data != NULL;
+	     data = it->next(it, &size)) {
+		if (checkpoint_write_tuple(l, entry->space, data, size) != 0)
+			return -1;
+	}
+	return 0;
+}
+
+/**
+ * Advance checkpoint::next_entry to the next user space.
+ * System spaces are written by the snapshot thread before
+ * workers are started. Must be called under checkpoint::mutex.
+ */
+static void
+checkpoint_advance_entry(struct checkpoint *ckpt)
+{
+	struct checkpoint_entry *entry = ckpt->next_entry;
+	do {
+		if (rlist_next(&entry->link) == &ckpt->entries) {
+			entry = NULL;
+			break;
+		}
+		entry = rlist_next_entry(entry, link);
+	} while (space_is_system(entry->space));
+	ckpt->next_entry = entry;
+}
+
+/**
+ * Format rows buffered by a worker thread into a tx block
+ * and queue it for the snapshot thread. Waits if the queue
+ * is full.
+ *
+ * @retval 0 success
+ * @retval 1 the checkpoint has been aborted
+ * @retval -1 error
+ */
+static int
+checkpoint_push_block(struct checkpoint *ckpt, struct xlog *buf)
+{
+	int64_t rows = buf->tx_rows;
+	char *data;
+	ssize_t size = xlog_tx_encode(buf, &data);
+	if (size <= 0)
+		return size;
+	struct checkpoint_block *block = malloc(sizeof(*block));
+	if (block == NULL) {
+		diag_set(OutOfMemory, sizeof(*block),
+			 "malloc", "struct checkpoint_block");
+		free(data);
+		return -1;
+	}
+	block->data = data;
+	block->size = size;
+	block->rows = rows;
+	tt_pthread_mutex_lock(&ckpt->mutex);
+	while (!ckpt->is_failed &&
+	       ckpt->block_count >= CHECKPOINT_QUEUE_DEPTH * ckpt->threads)
+		tt_pthread_cond_wait(&ckpt->space_cond, &ckpt->mutex);
+	if (ckpt->is_failed) {
+		tt_pthread_mutex_unlock(&ckpt->mutex);
+		free(block->data);
+		free(block);
+		return 1;
+	}
+	stailq_add_tail_entry(&ckpt->blocks, block, in_blocks);
+	ckpt->block_count++;
+	tt_pthread_cond_signal(&ckpt->queue_cond);
+	tt_pthread_mutex_unlock(&ckpt->mutex);
+	return 0;
+}
+
+/**
+ * A checkpoint worker thread. Takes user spaces one by one,
+ * encodes and compresses their tuples into xlog tx blocks
+ * and passes the blocks to the snapshot thread, which
+ * appends them to the snapshot file.
+ */
+static int
+checkpoint_worker_f(va_list ap)
+{
+	struct checkpoint *ckpt = va_arg(ap, struct checkpoint *);
+	struct xlog buf;
+	if (xlog_create_buffer(&buf) != 0) {
+		tt_pthread_mutex_lock(&ckpt->mutex);
+		ckpt->is_failed = true;
+		ckpt->workers_running--;
+		tt_pthread_cond_broadcast(&ckpt->queue_cond);
+		tt_pthread_cond_broadcast(&ckpt->space_cond);
+		tt_pthread_mutex_unlock(&ckpt->mutex);
+		return -1;
+	}
+	int rc = 0;
+	while (rc == 0) {
+		tt_pthread_mutex_lock(&ckpt->mutex);
+		struct checkpoint_entry *entry = NULL;
+		if (!ckpt->is_failed && ckpt->next_entry != NULL) {
+			entry = ckpt->next_entry;
+			checkpoint_advance_entry(ckpt);
+		}
+		tt_pthread_mutex_unlock(&ckpt->mutex);
+		if (entry == NULL)
+			break;
+		uint32_t size;
+		const char *data;
+		struct snapshot_iterator *it = entry->iterator;
+		for (data = it->next(it, &size); data != NULL;
+		     data = it->next(it, &size)) {
+			if (checkpoint_write_tuple(&buf, entry->space,
+						   data, size) != 0) {
+				rc = -1;
+				break;
+			}
+			if (obuf_size(&buf.obuf) >= CHECKPOINT_BLOCK_SIZE &&
+			    (rc = checkpoint_push_block(ckpt, &buf)) != 0)
+				break;
+		}
+	}
+	if (rc == 0)
+		rc = checkpoint_push_block(ckpt, &buf);
+	xlog_destroy_buffer(&buf);
+
+	tt_pthread_mutex_lock(&ckpt->mutex);
+	if (rc < 0)
+		ckpt->is_failed = true;
+	ckpt->workers_running--;
+	tt_pthread_cond_broadcast(&ckpt->queue_cond);
+	tt_pthread_cond_broadcast(&ckpt->space_cond);
+	tt_pthread_mutex_unlock(&ckpt->mutex);
+	return rc < 0 ? -1 : 0;
+}
+
+/**
+ * Write a snapshot using checkpoint::threads worker threads.
+ * System spaces are written first by the snapshot thread
+ * itself, because recovery needs them before any user data.
+ * Then workers encode user spaces in parallel, and the
+ * snapshot thread appends the blocks they produce to
+ * the file, in the order they are ready. The snapshot
+ * format is the same as the one written by a single thread,
+ * except that tuples of different spaces may interleave.
+ */
+static int
+checkpoint_write_parallel(struct checkpoint *ckpt, struct xlog *snap)
+{
+	struct checkpoint_entry *entry;
+	rlist_foreach_entry(entry, &ckpt->entries, link) {
+		if (!space_is_system(entry->space)) {
+			if (ckpt->next_entry == NULL)
+				ckpt->next_entry = entry;
+			continue;
+		}
+		if (checkpoint_write_space(snap, entry) != 0)
+			return -1;
+	}
+	if (ckpt->next_entry == NULL)
+		return 0;
+	if (xlog_flush(snap) < 0)
+		return -1;
+
+	ckpt->workers = calloc(ckpt->threads, sizeof(*ckpt->workers));
+	if (ckpt->workers == NULL) {
+		diag_set(OutOfMemory, ckpt->threads * sizeof(*ckpt->workers),
+			 "calloc", "checkpoint workers");
+		return -1;
+	}
+	int rc = 0;
+	int started;
+	for (started = 0; started < ckpt->threads; started++) {
+		char name[FIBER_NAME_MAX];
+		snprintf(name, sizeof(name), "snapshot%d", started);
+		tt_pthread_mutex_lock(&ckpt->mutex);
+		ckpt->workers_running++;
+		tt_pthread_mutex_unlock(&ckpt->mutex);
+		if (cord_costart(&ckpt->workers[started], name,
+				 checkpoint_worker_f, ckpt) != 0) {
+			tt_pthread_mutex_lock(&ckpt->mutex);
+			ckpt->workers_running--;
+			ckpt->is_failed = true;
+			tt_pthread_cond_broadcast(&ckpt->space_cond);
+			tt_pthread_mutex_unlock(&ckpt->mutex);
+			rc = -1;
+			break;
+		}
+	}
+
+	int64_t rows_reported = snap->rows;
+	tt_pthread_mutex_lock(&ckpt->mutex);
+	while (true) {
+		while (!ckpt->is_failed && stailq_empty(&ckpt->blocks) &&
+		       ckpt->workers_running > 0)
+			tt_pthread_cond_wait(&ckpt->queue_cond, &ckpt->mutex);
+		if (ckpt->is_failed || stailq_empty(&ckpt->blocks))
+			break;
+		struct checkpoint_block *block;
+		block = stailq_shift_entry(&ckpt->blocks,
+					   struct checkpoint_block, in_blocks);
+		ckpt->block_count--;
+		tt_pthread_cond_signal(&ckpt->space_cond);
+		tt_pthread_mutex_unlock(&ckpt->mutex);
+
+		ssize_t written = xlog_write_tx_block(snap, block->data,
+						      block->size, block->rows);
+		free(block->data);
+		free(block);
+
+		tt_pthread_mutex_lock(&ckpt->mutex);
+		if (written < 0) {
+			rc = -1;
+			ckpt->is_failed = true;
+			tt_pthread_cond_broadcast(&ckpt->space_cond);
+			break;
+		}
+		if (snap->rows / 100000 != rows_reported / 100000)
+			say_crit("%.1fM rows written", snap->rows / 1000000.0);
+		rows_reported = snap->rows;
+	}
+	if (ckpt->is_failed)
+		rc = -1;
+	tt_pthread_mutex_unlock(&ckpt->mutex);
+
+	/*
+	 * A worker which failed returns the error, the others
+	 * just stop, so the first error is preserved.
+	 */
+	for (int i = 0; i < started; i++) {
+		if (cord_join(&ckpt->workers[i]) != 0)
+			rc = -1;
+	}
+	free(ckpt->workers);
+	ckpt->workers = NULL;
+
+	struct checkpoint_block *block, *tmp;
+	stailq_foreach_entry_safe(block, tmp, &ckpt->blocks, in_blocks) {
+		free(block->data);
+		free(block);
+	}
+	stailq_create(&ckpt->blocks);
+	ckpt->block_count = 0;
+	return rc;
+}
+
 static int
 checkpoint_f(va_list ap)
 {
@@ -664,15 +1487,15 @@ checkpoint_f(va_list ap)
 	snap.rate_limit = ckpt->snap_io_rate_limit;
 
 	say_info("saving snapshot `%s'", snap.filename);
-	struct checkpoint_entry *entry;
-	rlist_foreach_entry(entry, &ckpt->entries, link) {
-		uint32_t size;
-		const char *data;
-		struct snapshot_iterator *it = entry->iterator;
-		for (data = it->next(it, &size); data != NULL;
-		     data = it->next(it, &size)) {
-			if (checkpoint_write_tuple(&snap, entry->space,
-					data, size) != 0) {
+	if (ckpt->threads > 1) {
+		if (checkpoint_write_parallel(ckpt, &snap) != 0) {
+			xlog_close(&snap, false);
+			return -1;
+		}
+	} else {
+		struct checkpoint_entry *entry;
+		rlist_foreach_entry(entry, &ckpt->entries, link) {
+			if (checkpoint_write_space(&snap, entry) != 0) {
 				xlog_close(&snap, false);
 				return -1;
 			}
@@ -701,7 +1524,8 @@ memtx_engine_begin_checkpoint(struct engine *engine)
 	}
 
 	if (checkpoint_init(memtx->checkpoint, memtx->snap_dir.dirname,
-			    memtx->snap_io_rate_limit) != 0)
+			    memtx->snap_io_rate_limit,
+			    memtx->snap_threads) != 0)
 		return -1;
 
 	if (space_foreach(checkpoint_add_space, memtx->checkpoint) != 0) {
@@ -1067,11 +1891,14 @@ memtx_engine_new(const char *snap_dirname, bool force_recovery,
 	slab_cache_create(&memtx->index_slab_cache, &memtx->arena);
 	mempool_create(&memtx->index_extent_pool, &memtx->index_slab_cache,
 		       MEMTX_EXTENT_SIZE);
+	tt_pthread_mutex_init(&memtx->index_extent_mutex, NULL);
 	memtx->num_reserved_extents = 0;
 	memtx->reserved_extents = NULL;
 
 	memtx->state = MEMTX_INITIALIZED;
 	memtx->max_tuple_size = MAX_TUPLE_SIZE;
+	memtx->snap_threads = 1;
+	memtx->sort_threads = 1;
 	memtx->force_recovery = force_recovery;
 
 	memtx->base.vtab = &memtx_engine_vtab;
@@ -1099,6 +1926,36 @@ memtx_engine_set_snap_io_rate_limit(struct memtx_engine *memtx, double limit)
 	memtx->snap_io_rate_limit = limit * 1024 * 1024;
 }
 
+void
+memtx_engine_set_snap_threads(struct memtx_engine *memtx, int threads)
+{
+	memtx->snap_threads = threads;
+}
+
+void
+memtx_engine_set_sort_threads(struct memtx_engine *memtx, int threads)
+{
+	if (threads == 0) {
+		long cpu_count = sysconf(_SC_NPROCESSORS_ONLN);
+		threads = cpu_count > 0 ? MIN(cpu_count,
+					      MEMTX_SORT_THREADS_MAX) : 1;
+	}
+	memtx->sort_threads = threads;
+}
+
+void
+memtx_engine_stat(struct memtx_engine *memtx, struct info_handler *h)
+{
+	struct memtx_recovery_stat *stat = &memtx->recovery_stat;
+	info_begin(h);
+	info_table_begin(h, "recovery");
+	info_append_int(h, "snap_rows", stat->snap_rows);
+	info_append_int(h, "index_total", stat->index_total);
+	info_append_int(h, "index_done", stat->index_done);
+	info_table_end(h);
+	info_end(h);
+}
+
 int
 memtx_engine_set_memory(struct memtx_engine *memtx, size_t size)
 {
@@ -1124,7 +1981,12 @@ memtx_tuple_new(struct tuple_format *format, const char *data, const char *end)
 	assert(mp_typeof(*data) == MP_ARRAY);
 	size_t tuple_len = end - data;
 	size_t meta_size = tuple_format_meta_size(format);
-	size_t total = sizeof(struct memtx_tuple) + meta_size + tuple_len;
+	/*
+	 * Small tuples use a truncated header to reduce
+	 * the per-tuple memory overhead.
+	 */
+	bool is_tiny = tuple_fits_tiny(tuple_len, meta_size);
+	size_t total = memtx_tuple_size(is_tiny, meta_size, tuple_len);
 
 	ERROR_INJECT(ERRINJ_TUPLE_ALLOC, {
 		diag_set(OutOfMemory, total, "slab allocator", "memtx_tuple");
@@ -1148,19 +2010,25 @@ memtx_tuple_new(struct tuple_format *format, const char *data, const char *end)
 		return NULL;
 	}
 	struct tuple *tuple = &memtx_tuple->base;
-	tuple->refs = 0;
 	memtx_tuple->version = memtx->snapshot_version;
 	assert(tuple_len <= UINT32_MAX); /* bsize is UINT32_MAX */
-	tuple->bsize = tuple_len;
-	tuple->format_id = tuple_format_id(format);
-	tuple_format_ref(format);
 	/*
 	 * Data offset is calculated from the begin of the struct
 	 * tuple base, not from memtx_tuple, because the struct
 	 * tuple is not the first field of the memtx_tuple.
 	 */
-	tuple->data_offset = sizeof(struct tuple) + meta_size;
-	char *raw = (char *) tuple + tuple->data_offset;
+	if (is_tiny) {
+		tuple_create_tiny(tuple, tuple_format_id(format),
+				  tuple_len, meta_size);
+		memtx->tiny_tuple_count++;
+		memtx->tiny_tuple_saved += memtx_tuple_size(false, meta_size,
+							    tuple_len) - total;
+	} else {
+		tuple_create(tuple, tuple_format_id(format),
+			     tuple_len, meta_size);
+	}
+	tuple_format_ref(format);
+	char *raw = (char *) tuple_data(tuple);
 	uint32_t *field_map = (uint32_t *) raw;
 	memcpy(raw, data, tuple_len);
 	if (tuple_init_field_map(format, field_map, raw)) {
@@ -1177,8 +2045,15 @@ memtx_tuple_delete(struct tuple_format *format, struct tuple *tuple)
 	struct memtx_engine *memtx = (struct memtx_engine *)format->engine;
 	say_debug("%s(%p)", __func__, tuple);
 	assert(tuple->refs == 0);
-	size_t total = sizeof(struct memtx_tuple) +
-		       tuple_format_meta_size(format) + tuple->bsize;
+	size_t meta_size = tuple_format_meta_size(format);
+	size_t bsize = tuple_bsize(tuple);
+	size_t total = memtx_tuple_size(tuple->is_tiny, meta_size, bsize);
+	if (tuple->is_tiny) {
+		assert(memtx->tiny_tuple_count > 0);
+		memtx->tiny_tuple_count--;
+		memtx->tiny_tuple_saved -= memtx_tuple_size(false, meta_size,
+							    bsize) - total;
+	}
 	tuple_format_unref(format);
 	struct memtx_tuple *memtx_tuple =
 		container_of(tuple, struct memtx_tuple, base);
@@ -1198,30 +2073,69 @@ struct tuple_format_vtab memtx_tuple_format_vtab = {
 /**
  * Allocate a block of size MEMTX_EXTENT_SIZE for memtx index
  */
+/**
+ * Lock the index extent allocator. The slab cache is
+ * owned by the tx thread, but during recovery it may also
+ * be used by threads building secondary keys.
+ */
+static inline void
+memtx_index_extent_lock(struct memtx_engine *memtx)
+{
+	tt_pthread_mutex_lock(&memtx->index_extent_mutex);
+	slab_cache_set_thread(&memtx->index_slab_cache);
+}
+
+static inline void
+memtx_index_extent_unlock(struct memtx_engine *memtx)
+{
+	tt_pthread_mutex_unlock(&memtx->index_extent_mutex);
+}
+
+/**
+ * Allocate an extent from the pool, running garbage
+ * collection if there's not enough memory. Garbage is
+ * only collected in the tx thread. Must be called with
+ * the allocator locked.
+ */
+static void *
+memtx_index_extent_alloc_locked(struct memtx_engine *memtx)
+{
+	void *ret;
+	while ((ret = mempool_alloc(&memtx->index_extent_pool)) == NULL) {
+		if (!cord_is_main())
+			break;
+		bool stop;
+		memtx_index_extent_unlock(memtx);
+		memtx_engine_run_gc(memtx, &stop);
+		memtx_index_extent_lock(memtx);
+		if (stop)
+			break;
+	}
+	return ret;
+}
+
 void *
 memtx_index_extent_alloc(void *ctx)
 {
 	struct memtx_engine *memtx = (struct memtx_engine *)ctx;
+	memtx_index_extent_lock(memtx);
 	if (memtx->reserved_extents) {
 		assert(memtx->num_reserved_extents > 0);
 		memtx->num_reserved_extents--;
 		void *result = memtx->reserved_extents;
 		memtx->reserved_extents = *(void **)memtx->reserved_extents;
+		memtx_index_extent_unlock(memtx);
 		return result;
 	}
 	ERROR_INJECT(ERRINJ_INDEX_ALLOC, {
+		memtx_index_extent_unlock(memtx);
 		/* same error as in mempool_alloc */
 		diag_set(OutOfMemory, MEMTX_EXTENT_SIZE,
 			 "mempool", "new slab");
 		return NULL;
 	});
-	void *ret;
-	while ((ret = mempool_alloc(&memtx->index_extent_pool)) == NULL) {
-		bool stop;
-		memtx_engine_run_gc(memtx, &stop);
-		if (stop)
-			break;
-	}
+	void *ret = memtx_index_extent_alloc_locked(memtx);
+	memtx_index_extent_unlock(memtx);
 	if (ret == NULL)
 		diag_set(OutOfMemory, MEMTX_EXTENT_SIZE,
 			 "mempool", "new slab");
@@ -1235,7 +2149,9 @@ void
 memtx_index_extent_free(void *ctx, void *extent)
 {
 	struct memtx_engine *memtx = (struct memtx_engine *)ctx;
-	return mempool_free(&memtx->index_extent_pool, extent);
+	memtx_index_extent_lock(memtx);
+	mempool_free(&memtx->index_extent_pool, extent);
+	memtx_index_extent_unlock(memtx);
 }
 
 /**
@@ -1251,16 +2167,11 @@ memtx_index_extent_reserve(struct memtx_engine *memtx, int num)
 			 "mempool", "new slab");
 		return -1;
 	});
-	struct mempool *pool = &memtx->index_extent_pool;
+	memtx_index_extent_lock(memtx);
 	while (memtx->num_reserved_extents < num) {
-		void *ext;
-		while ((ext = mempool_alloc(pool)) == NULL) {
-			bool stop;
-			memtx_engine_run_gc(memtx, &stop);
-			if (stop)
-				break;
-		}
+		void *ext = memtx_index_extent_alloc_locked(memtx);
 		if (ext == NULL) {
+			memtx_index_extent_unlock(memtx);
 			diag_set(OutOfMemory, MEMTX_EXTENT_SIZE,
 				 "mempool", "new slab");
 			return -1;
@@ -1269,6 +2180,7 @@ memtx_index_extent_reserve(struct memtx_engine *memtx, int num)
 		memtx->reserved_extents = ext;
 		memtx->num_reserved_extents++;
 	}
+	memtx_index_extent_unlock(memtx);
 	return 0;
 }
 
@@ -1311,5 +2223,19 @@ memtx_index_def_change_requires_rebuild(struct index *index,
 		if (old_part->coll != new_part->coll)
 			return true;
 	}
+	/*
+	 * Tree indexes store comparison hints computed from
+	 * the first key part. Hints depend on the field type
+	 * and nullability so they need to be recomputed if
+	 * any of them changes.
+	 */
+	if (old_def->type == TREE) {
+		const struct key_part *old_part = &old_cmp_def->parts[0];
+		const struct key_part *new_part = &new_cmp_def->parts[0];
+		if (old_part->type != new_part->type ||
+		    key_part_is_nullable(old_part) !=
+		    key_part_is_nullable(new_part))
+			return true;
+	}
 	return false;
 }
@@ -33,6 +33,7 @@
 #include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
+#include <pthread.h>
 #include <small/quota.h>
 #include <small/small.h>
 #include <small/mempool.h>
@@ -49,6 +50,7 @@ struct index;
 struct fiber;
 struct tuple;
 struct tuple_format;
+struct info_handler;
 
 /**
  * The state of memtx recovery process.
@@ -87,6 +89,23 @@ enum memtx_recovery_state {
 /** Memtx extents pool, available to statistics. */
 extern struct mempool memtx_index_extent_pool;
 
+enum {
+	/** Max value of box.cfg.memtx_snap_threads. */
+	MEMTX_SNAP_THREADS_MAX = 64,
+	/** Max value of box.cfg.memtx_sort_threads. */
+	MEMTX_SORT_THREADS_MAX = 256,
+};
+
+/** Progress of memtx recovery, reported by box.info.memtx(). */
+struct memtx_recovery_stat {
+	/** Number of rows recovered from the snapshot. */
+	int64_t snap_rows;
+	/** Number of secondary indexes to build after recovery. */
+	int64_t index_total;
+	/** Number of secondary indexes built so far. */
+	int64_t index_done;
+};
+
 struct memtx_engine {
 	struct engine base;
 	/** Engine recovery state. */
@@ -97,6 +116,19 @@ struct memtx_engine {
 	struct xdir snap_dir;
 	/** Limit disk usage of checkpointing (bytes per second). */
 	uint64_t snap_io_rate_limit;
+	/**
+	 * Number of threads encoding and compressing rows
+	 * while writing a snapshot and building secondary keys
+	 * on recovery, box.cfg.memtx_snap_threads.
+	 */
+	int snap_threads;
+	/** Recovery progress. */
+	struct memtx_recovery_stat recovery_stat;
+	/**
+	 * Number of threads used to sort and build tree
+	 * indexes, box.cfg.memtx_sort_threads.
+	 */
+	int sort_threads;
 	/** Skip invalid snapshot records if this flag is set. */
 	bool force_recovery;
 	/** Common quota for tuples and indexes. */
@@ -116,6 +148,12 @@ struct memtx_engine {
 	struct slab_cache index_slab_cache;
 	/** Index extent allocator. */
 	struct mempool index_extent_pool;
+	/**
+	 * Protects index_extent_pool and reserved extents.
+	 * Secondary keys may be built in worker threads on
+	 * recovery, see memtx_engine_build_secondary_keys().
+	 */
+	pthread_mutex_t index_extent_mutex;
 	/**
 	 * To ensure proper statement-level rollback in case
 	 * of out of memory conditions, we maintain a number
@@ -129,6 +167,10 @@ struct memtx_engine {
 	size_t max_tuple_size;
 	/** Incremented with each next snapshot. */
 	uint32_t snapshot_version;
+	/** Number of tuples allocated with a tiny header. */
+	uint64_t tiny_tuple_count;
+	/** Memory saved by tiny tuple headers, in bytes. */
+	uint64_t tiny_tuple_saved;
 	/** Memory pool for tree index iterator. */
 	struct mempool tree_iterator_pool;
 	/** Memory pool for rtree index iterator. */
@@ -190,6 +232,20 @@ memtx_engine_recover_snapshot(struct memtx_engine *memtx,
 void
 memtx_engine_set_snap_io_rate_limit(struct memtx_engine *memtx, double limit);
 
+void
+memtx_engine_set_snap_threads(struct memtx_engine *memtx, int threads);
+
+/**
+ * Set the number of threads used to sort and build tree
+ * indexes. Zero means the number of online CPUs.
+ */
+void
+memtx_engine_set_sort_threads(struct memtx_engine *memtx, int threads);
+
+/** Report memtx statistics, box.info.memtx(). */
+void
+memtx_engine_stat(struct memtx_engine *memtx, struct info_handler *h);
+
 int
 memtx_engine_set_memory(struct memtx_engine *memtx, size_t size);
 
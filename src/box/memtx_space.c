@@ -981,6 +981,8 @@ memtx_space_new(struct memtx_engine *memtx,
 
 	struct tuple_format *format =
 		tuple_format_new(&memtx_tuple_format_vtab, keys, key_count, 0,
+				 def->opts.field_map_step,
+				 def->opts.compact_field_map,
 				 def->fields, def->field_count, def->dict);
 	if (format == NULL) {
 		free(memtx_space);
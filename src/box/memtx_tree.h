@@ -51,12 +51,42 @@ struct memtx_tree_key_data
 	const char *key;
 	/** Number of msgpacked search fields */
 	uint32_t part_count;
+	/** Comparison hint, see key_hint(). */
+	hint_t hint;
 };
 
+/**
+ * Struct that is used as an element in BPS tree definition.
+ * The comparison hint lets the tree compare most elements
+ * without dereferencing the tuple.
+ */
+struct memtx_tree_data {
+	/** Tuple stored in the tree. */
+	struct tuple *tuple;
+	/** Comparison hint, see tuple_hint(). */
+	hint_t hint;
+};
+
+/**
+ * BPS tree element comparator.
+ * @param a - first element.
+ * @param b - second element.
+ * @param def - key definition.
+ * @retval 0  if a == b in terms of def.
+ * @retval <0 if a < b in terms of def.
+ * @retval >0 if a > b in terms of def.
+ */
+static inline int
+memtx_tree_compare(const struct memtx_tree_data *a,
+		   const struct memtx_tree_data *b, struct key_def *def)
+{
+	return tuple_compare_hinted(a->tuple, a->hint, b->tuple, b->hint, def);
+}
+
 /**
  * BPS tree element vs key comparator.
  * Defined in header in order to allow compiler to inline it.
- * @param tuple - tuple to compare.
+ * @param element - tree element to compare.
  * @param key_data - key to compare with.
  * @param def - key definition.
  * @retval 0  if tuple == key in terms of def.
@@ -64,22 +94,25 @@ struct memtx_tree_key_data
  * @retval >0 if tuple > key in terms of def.
  */
 static inline int
-memtx_tree_compare_key(const struct tuple *tuple,
+memtx_tree_compare_key(const struct memtx_tree_data *element,
 		       const struct memtx_tree_key_data *key_data,
 		       struct key_def *def)
 {
-	return tuple_compare_with_key(tuple, key_data->key,
-				      key_data->part_count, def);
+	return tuple_compare_with_key_hinted(element->tuple, element->hint,
+					     key_data->key,
+					     key_data->part_count,
+					     key_data->hint, def);
 }
 
 #define BPS_TREE_NAME memtx_tree
 #define BPS_TREE_BLOCK_SIZE (512)
 #define BPS_TREE_EXTENT_SIZE MEMTX_EXTENT_SIZE
-#define BPS_TREE_COMPARE(a, b, arg) tuple_compare(a, b, arg)
-#define BPS_TREE_COMPARE_KEY(a, b, arg) memtx_tree_compare_key(a, b, arg)
-#define bps_tree_elem_t struct tuple *
+#define BPS_TREE_COMPARE(a, b, arg) memtx_tree_compare(&(a), &(b), arg)
+#define BPS_TREE_COMPARE_KEY(a, b, arg) memtx_tree_compare_key(&(a), b, arg)
+#define bps_tree_elem_t struct memtx_tree_data
 #define bps_tree_key_t struct memtx_tree_key_data *
 #define bps_tree_arg_t struct key_def *
+#define BPS_TREE_NO_DEBUG
 
 #include "salad/bps_tree.h"
 
@@ -91,11 +124,12 @@ memtx_tree_compare_key(const struct tuple *tuple,
 #undef bps_tree_elem_t
 #undef bps_tree_key_t
 #undef bps_tree_arg_t
+#undef BPS_TREE_NO_DEBUG
 
 struct memtx_tree_index {
 	struct index base;
 	struct memtx_tree tree;
-	struct tuple **build_array;
+	struct memtx_tree_data *build_array;
 	size_t build_array_size, build_array_alloc_size;
 	struct memtx_gc_task gc_task;
 	struct memtx_tree_iterator gc_iterator;
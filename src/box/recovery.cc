@@ -80,9 +80,10 @@
  * Throws an exception in  case of error.
  */
 struct recovery *
-recovery_new(const char *wal_dirname, bool force_recovery,
-	     const struct vclock *vclock)
+recovery_new(const char **wal_dirs, int wal_dir_count,
+	     bool force_recovery, const struct vclock *vclock)
 {
+	assert(wal_dir_count > 0);
 	struct recovery *r = (struct recovery *)
 			calloc(1, sizeof(*r));
 
@@ -95,23 +96,41 @@ recovery_new(const char *wal_dirname, bool force_recovery,
 		free(r);
 	});
 
-	xdir_create(&r->wal_dir, wal_dirname, XLOG, &INSTANCE_UUID);
-	r->wal_dir.force_recovery = force_recovery;
+	size_t size = sizeof(*r->stripes) * wal_dir_count;
+	r->stripes = (struct recovery_stripe *) calloc(1, size);
+	if (r->stripes == NULL) {
+		tnt_raise(OutOfMemory, size, "malloc",
+			  "struct recovery_stripe");
+	}
+	auto stripes_guard = make_scoped_guard([=]{
+		for (int i = 0; i < r->stripe_count; i++)
+			xdir_destroy(&r->stripes[i].wal_dir);
+		free(r->stripes);
+	});
 
-	vclock_copy(&r->vclock, vclock);
+	for (int i = 0; i < wal_dir_count; i++) {
+		struct recovery_stripe *s = &r->stripes[i];
+		xdir_create(&s->wal_dir, wal_dirs[i], XLOG, &INSTANCE_UUID);
+		s->wal_dir.force_recovery = force_recovery;
+		vclock_copy(&s->vclock, vclock);
+		r->stripe_count++;
+		/**
+		 * Avoid scanning WAL dir before we recovered
+		 * the snapshot and know instance UUID - this will
+		 * make sure the scan skips files with wrong
+		 * UUID, see replication/cluster.test for
+		 * details.
+		 */
+		xdir_check_xc(&s->wal_dir);
+	}
 
-	/**
-	 * Avoid scanning WAL dir before we recovered
-	 * the snapshot and know instance UUID - this will
-	 * make sure the scan skips files with wrong
-	 * UUID, see replication/cluster.test for
-	 * details.
-	 */
-	xdir_check_xc(&r->wal_dir);
+	vclock_copy(&r->vclock, vclock);
 
 	r->watcher = NULL;
+	r->is_following = false;
 	rlist_create(&r->on_close_log);
 
+	stripes_guard.is_active = false;
 	guard.is_active = false;
 	return r;
 }
@@ -119,51 +138,59 @@ recovery_new(const char *wal_dirname, bool force_recovery,
 void
 recovery_scan(struct recovery *r, struct vclock *end_vclock)
 {
-	xdir_scan_xc(&r->wal_dir);
+	vclock_copy(end_vclock, &r->vclock);
+	for (int i = 0; i < r->stripe_count; i++) {
+		struct recovery_stripe *s = &r->stripes[i];
+		xdir_scan_xc(&s->wal_dir);
+
+		struct vclock *vclock = vclockset_last(&s->wal_dir.index);
+		if (vclock == NULL || vclock_compare(vclock, &r->vclock) < 0) {
+			/* No xlogs after last checkpoint. */
+			continue;
+		}
 
-	struct vclock *vclock = vclockset_last(&r->wal_dir.index);
-	if (vclock == NULL || vclock_compare(vclock, &r->vclock) < 0) {
-		/* No xlogs after last checkpoint. */
-		vclock_copy(end_vclock, &r->vclock);
-		return;
+		/* Scan the last xlog to find end vclock. */
+		struct vclock last;
+		vclock_copy(&last, vclock);
+		struct xlog_cursor cursor;
+		if (xdir_open_cursor(&s->wal_dir, vclock_sum(vclock),
+				     &cursor) == 0) {
+			struct xrow_header row;
+			while (xlog_cursor_next(&cursor, &row, true) == 0)
+				vclock_follow_xrow(&last, &row);
+			xlog_cursor_close(&cursor, false);
+		}
+		vclock_merge_max(end_vclock, &last);
 	}
-
-	/* Scan the last xlog to find end vclock. */
-	vclock_copy(end_vclock, vclock);
-	struct xlog_cursor cursor;
-	if (xdir_open_cursor(&r->wal_dir, vclock_sum(vclock), &cursor) != 0)
-		return;
-	struct xrow_header row;
-	while (xlog_cursor_next(&cursor, &row, true) == 0)
-		vclock_follow_xrow(end_vclock, &row);
-	xlog_cursor_close(&cursor, false);
 }
 
 static inline void
-recovery_close_log(struct recovery *r)
+recovery_close_log(struct recovery *r, struct recovery_stripe *s)
 {
-	if (!xlog_cursor_is_open(&r->cursor))
+	if (!xlog_cursor_is_open(&s->cursor))
 		return;
-	if (xlog_cursor_is_eof(&r->cursor)) {
-		say_info("done `%s'", r->cursor.name);
+	if (xlog_cursor_is_eof(&s->cursor)) {
+		say_info("done `%s'", s->cursor.name);
 	} else {
 		say_warn("file `%s` wasn't correctly closed",
-			 r->cursor.name);
+			 s->cursor.name);
 	}
-	xlog_cursor_close(&r->cursor, false);
+	xlog_cursor_close(&s->cursor, false);
 	trigger_run_xc(&r->on_close_log, NULL);
 }
 
 static void
-recovery_open_log(struct recovery *r, const struct vclock *vclock)
+recovery_open_log(struct recovery *r, struct recovery_stripe *s,
+		  const struct vclock *vclock)
 {
 	XlogGapError *e;
-	struct xlog_meta meta = r->cursor.meta;
-	enum xlog_cursor_state state = r->cursor.state;
+	struct xlog_meta meta = s->cursor.meta;
+	enum xlog_cursor_state state = s->cursor.state;
 
-	recovery_close_log(r);
+	recovery_close_log(r, s);
 
-	xdir_open_cursor_xc(&r->wal_dir, vclock_sum(vclock), &r->cursor);
+	xdir_open_cursor_xc(&s->wal_dir, vclock_sum(vclock), &s->cursor);
+	vclock_merge_max(&s->vclock, vclock);
 
 	if (state == XLOG_CURSOR_NEW &&
 	    vclock_compare(vclock, &r->vclock) > 0) {
@@ -177,8 +204,8 @@ recovery_open_log(struct recovery *r, const struct vclock *vclock)
 	}
 
 	if (state != XLOG_CURSOR_NEW &&
-	    vclock_is_set(&r->cursor.meta.prev_vclock) &&
-	    vclock_compare(&r->cursor.meta.prev_vclock, &meta.vclock) != 0) {
+	    vclock_is_set(&s->cursor.meta.prev_vclock) &&
+	    vclock_compare(&s->cursor.meta.prev_vclock, &meta.vclock) != 0) {
 		/*
 		 * WALs are missing between the last scanned WAL
 		 * and the next one.
@@ -193,14 +220,19 @@ out:
 	 * one has an LSN gap at the end (due to a write error),
 	 * we will create the next WAL between two existing ones,
 	 * thus breaking the file order.
+	 *
+	 * Don't do that if the WAL is striped: an xlog of
+	 * a stripe may start after rows of other stripes that
+	 * haven't been applied yet. The WAL is started after
+	 * the rows found by recovery_scan() then.
 	 */
-	if (vclock_compare(&r->vclock, vclock) < 0)
+	if (r->stripe_count == 1 && vclock_compare(&r->vclock, vclock) < 0)
 		vclock_copy(&r->vclock, vclock);
 	return;
 
 gap_error:
 	e = tnt_error(XlogGapError, &r->vclock, vclock);
-	if (!r->wal_dir.force_recovery)
+	if (!s->wal_dir.force_recovery)
 		throw e;
 	/* Ignore missing WALs if force_recovery is set. */
 	e->log();
@@ -208,86 +240,181 @@ gap_error:
 	goto out;
 }
 
+void
+recovery_reset_log(struct recovery *r)
+{
+	for (int i = 0; i < r->stripe_count; i++) {
+		struct recovery_stripe *s = &r->stripes[i];
+		if (xlog_cursor_is_open(&s->cursor))
+			xlog_cursor_close(&s->cursor, false);
+		s->cursor.state = XLOG_CURSOR_NEW;
+		/* The row will be read again by the vclock. */
+		s->has_row = false;
+	}
+}
+
 void
 recovery_delete(struct recovery *r)
 {
 	recovery_stop_local(r);
 
 	trigger_destroy(&r->on_close_log);
-	xdir_destroy(&r->wal_dir);
-	if (xlog_cursor_is_open(&r->cursor)) {
-		/*
-		 * Possible if shutting down a replication
-		 * relay or if error during startup.
-		 */
-		xlog_cursor_close(&r->cursor, false);
+	for (int i = 0; i < r->stripe_count; i++) {
+		struct recovery_stripe *s = &r->stripes[i];
+		xdir_destroy(&s->wal_dir);
+		if (xlog_cursor_is_open(&s->cursor)) {
+			/*
+			 * Possible if shutting down a replication
+			 * relay or if error during startup.
+			 */
+			xlog_cursor_close(&s->cursor, false);
+		}
 	}
+	free(r->stripes);
 	free(r);
 }
 
 /**
- * Read all rows in a file starting from the last position.
- * Advance the position. If end of file is reached,
- * set l.eof_read.
- * The reading will be stopped on reaching stop_vclock.
- * Use NULL for boundless recover
+ * Advance the vclock of a stripe with a row read from it.
  */
-static void
-recover_xlog(struct recovery *r, struct xstream *stream,
-	     const struct vclock *stop_vclock)
+static inline void
+recovery_stripe_follow(struct recovery_stripe *s,
+		       const struct xrow_header *row)
 {
-	struct xrow_header row;
-	uint64_t row_count = 0;
-	while (xlog_cursor_next_xc(&r->cursor, &row,
-				   r->wal_dir.force_recovery) == 0) {
-		/*
-		 * Read the next row from xlog file.
-		 *
-		 * xlog_cursor_next_xc() returns 1 when
-		 * it can not read more rows. This doesn't mean
-		 * the file is fully read: it's fully read only
-		 * when EOF marker has been read, see i.eof_read
-		 */
-		if (stop_vclock != NULL &&
-		    r->vclock.signature >= stop_vclock->signature)
-			return;
-		int64_t current_lsn = vclock_get(&r->vclock, row.replica_id);
-		if (row.lsn <= current_lsn)
-			continue; /* already applied, skip */
+	if (row->lsn > vclock_get(&s->vclock, row->replica_id))
+		vclock_follow(&s->vclock, row->replica_id, row->lsn);
+}
 
-		/*
-		 * All rows in xlog files have an assigned
-		 * replica id.
-		 */
-		assert(row.replica_id != 0);
-		/*
-		 * We can promote the vclock either before or
-		 * after xstream_write(): it only makes any impact
-		 * in case of forced recovery, when we skip the
-		 * failed row anyway.
-		 */
-		vclock_follow_xrow(&r->vclock, &row);
-		if (xstream_write(stream, &row) == 0) {
-			++row_count;
-			if (row_count % 100000 == 0)
-				say_info("%.1fM rows processed",
-					 row_count / 1000000.);
+/**
+ * Read the next row to recover from a stripe into s->row
+ * unless there's one already. When the current xlog is read
+ * up, switch to the next xlog of the stripe, but not to the
+ * ones starting at or after stop_vclock. Use NULL for
+ * boundless recover.
+ *
+ * Returns false if there are no more rows in the stripe.
+ */
+static bool
+recovery_stripe_read_row(struct recovery *r, struct recovery_stripe *s,
+			 const struct vclock *stop_vclock)
+{
+	while (!s->has_row) {
+		if (xlog_cursor_is_open(&s->cursor) &&
+		    !xlog_cursor_is_eof(&s->cursor) &&
+		    xlog_cursor_next_xc(&s->cursor, &s->row,
+					s->wal_dir.force_recovery) == 0) {
+			/*
+			 * xlog_cursor_next_xc() returns 1 when
+			 * it can not read more rows. This doesn't mean
+			 * the file is fully read: it's fully read only
+			 * when EOF marker has been read, see i.eof_read
+			 */
+			int64_t current_lsn = vclock_get(&r->vclock,
+							 s->row.replica_id);
+			if (s->row.lsn <= current_lsn) {
+				/* already applied, skip */
+				recovery_stripe_follow(s, &s->row);
+				continue;
+			}
+			/*
+			 * All rows in xlog files have an assigned
+			 * replica id.
+			 */
+			assert(s->row.replica_id != 0);
+			s->has_row = true;
+			break;
+		}
+
+		struct vclock *clock;
+		if (s->clock != NULL) {
+			clock = vclockset_next(&s->wal_dir.index, s->clock);
 		} else {
-			say_error("can't apply row: ");
-			diag_log();
-			if (!r->wal_dir.force_recovery)
-				diag_raise();
+			clock = vclockset_match(&s->wal_dir.index,
+						&r->vclock);
 		}
+		while (clock != NULL && xlog_cursor_is_eof(&s->cursor) &&
+		       vclock_sum(&s->cursor.meta.vclock) >= vclock_sum(clock)) {
+			/*
+			 * If we reached EOF while reading last xlog,
+			 * we don't need to rescan it.
+			 */
+			clock = vclockset_next(&s->wal_dir.index, clock);
+		}
+		if (clock == NULL)
+			return false;
+		if (stop_vclock != NULL) {
+			/*
+			 * A stripe doesn't write all rows, so its
+			 * xlogs may not contain rows preceding
+			 * stop_vclock only if it's not greater than
+			 * the xlog vclock in any component.
+			 */
+			int cmp = vclock_compare(clock, stop_vclock);
+			if (cmp == 0 || cmp == 1)
+				return false;
+		}
+
+		recovery_open_log(r, s, clock);
+		s->clock = clock;
+
+		say_info("recover from `%s'", s->cursor.name);
 	}
+	return true;
+}
+
+/**
+ * Return true if rows of the given replica may be written
+ * to the given stripe. Local rows are spread over all
+ * stripes, rows of other replicas go to one stripe, see
+ * wal_stripe().
+ */
+static bool
+recovery_stripe_has_replica(struct recovery *r, struct recovery_stripe *s,
+			    uint32_t replica_id)
+{
+	return replica_id == instance_id ||
+	       (int)(replica_id % r->stripe_count) == s - r->stripes;
+}
+
+/**
+ * Return true if a row of the same replica preceding the
+ * row read from stripe @s may still be read from another
+ * stripe. Stripes marked in @done won't return more rows.
+ */
+static bool
+recovery_stripe_is_blocked(struct recovery *r, struct recovery_stripe *s,
+			   unsigned done)
+{
+	const struct xrow_header *row = &s->row;
+	for (int i = 0; i < r->stripe_count; i++) {
+		struct recovery_stripe *other = &r->stripes[i];
+		if (other == s ||
+		    !recovery_stripe_has_replica(r, other, row->replica_id))
+			continue;
+		if (other->has_row && (done & (1U << i)) == 0) {
+			/*
+			 * A row of another replica may be followed
+			 * by the row we're missing.
+			 */
+			if (other->row.replica_id != row->replica_id ||
+			    other->row.lsn < row->lsn)
+				return true;
+		} else if (r->is_following &&
+			   vclock_get(&other->vclock,
+				      row->replica_id) < row->lsn - 1) {
+			/* The missing row may not be written yet. */
+			return true;
+		}
+	}
+	return false;
 }
 
 /**
  * Find out if there are new .xlog files since the current
  * LSN, and read them all up.
  *
- * Reading will be stopped on reaching recovery
- * vclock signature > to_checkpoint (after playing to_checkpoint record)
- * use NULL for boundless recover
+ * Reading will be stopped on reaching stop_vclock.
+ * Use NULL for boundless recover
  *
  * This function will not close r->current_wal if
  * recovery was successful.
@@ -296,53 +423,126 @@ void
 recover_remaining_wals(struct recovery *r, struct xstream *stream,
 		       const struct vclock *stop_vclock, bool scan_dir)
 {
-	struct vclock *clock;
-
-	if (scan_dir)
-		xdir_scan_xc(&r->wal_dir);
-
-	if (xlog_cursor_is_open(&r->cursor)) {
-		/* If there's a WAL open, recover from it first. */
-		assert(!xlog_cursor_is_eof(&r->cursor));
-		clock = vclockset_search(&r->wal_dir.index,
-					 &r->cursor.meta.vclock);
-		if (clock != NULL)
-			goto recover_current_wal;
-		/*
-		 * The current WAL has disappeared under our feet -
-		 * assume anything can happen in production and go on.
-		 */
-		say_error("file `%s' was deleted under our feet",
-			  r->cursor.name);
+	for (int i = 0; i < r->stripe_count; i++) {
+		struct recovery_stripe *s = &r->stripes[i];
+		if (scan_dir)
+			xdir_scan_xc(&s->wal_dir);
+
+		s->clock = NULL;
+		if (xlog_cursor_is_open(&s->cursor)) {
+			/* If there's a WAL open, recover from it first. */
+			assert(!xlog_cursor_is_eof(&s->cursor));
+			s->clock = vclockset_search(&s->wal_dir.index,
+						    &s->cursor.meta.vclock);
+			if (s->clock != NULL)
+				continue;
+			/*
+			 * The current WAL has disappeared under our
+			 * feet - assume anything can happen in
+			 * production and go on.
+			 */
+			say_error("file `%s' was deleted under our feet",
+				  s->cursor.name);
+		}
 	}
 
-	for (clock = vclockset_match(&r->wal_dir.index, &r->vclock);
-	     clock != NULL;
-	     clock = vclockset_next(&r->wal_dir.index, clock)) {
-		if (stop_vclock != NULL &&
-		    clock->signature >= stop_vclock->signature) {
-			break;
+	uint64_t row_count = 0;
+	/* Stripes which don't have more rows to recover. */
+	unsigned done = 0;
+	while (true) {
+		/*
+		 * Rows of a replica may be spread over several
+		 * stripes, so apply the row that follows the
+		 * recovery vclock if there's one. Otherwise
+		 * there's a gap in LSNs, and we have to make
+		 * sure the missing rows can't be read from other
+		 * stripes before jumping over it.
+		 */
+		struct recovery_stripe *nearest = NULL;
+		int64_t nearest_gap = INT64_MAX;
+		for (int i = 0; i < r->stripe_count; i++) {
+			struct recovery_stripe *s = &r->stripes[i];
+			if ((done & (1U << i)) != 0)
+				continue;
+			if (!recovery_stripe_read_row(r, s, stop_vclock) ||
+			    (stop_vclock != NULL &&
+			     s->row.lsn > vclock_get(stop_vclock,
+						     s->row.replica_id))) {
+				done |= 1U << i;
+				continue;
+			}
+			int64_t gap = s->row.lsn -
+				vclock_get(&r->vclock, s->row.replica_id);
+			if (gap < nearest_gap) {
+				nearest = s;
+				nearest_gap = gap;
+			}
 		}
+		if (nearest == NULL)
+			break;
 
-		if (xlog_cursor_is_eof(&r->cursor) &&
-		    vclock_sum(&r->cursor.meta.vclock) >= vclock_sum(clock)) {
+		struct recovery_stripe *next = nearest;
+		if (nearest_gap > 1) {
+			next = NULL;
+			for (int i = 0; i < r->stripe_count; i++) {
+				struct recovery_stripe *s = &r->stripes[i];
+				if ((done & (1U << i)) == 0 &&
+				    !recovery_stripe_is_blocked(r, s, done)) {
+					next = s;
+					break;
+				}
+			}
+		}
+		if (next == NULL) {
 			/*
-			 * If we reached EOF while reading last xlog,
-			 * we don't need to rescan it.
+			 * Wait for the missing rows to be written.
+			 * If the WAL isn't being written, they were
+			 * lost, so go on with the nearest row only
+			 * if force_recovery is set.
 			 */
-			continue;
+			if (r->is_following)
+				break;
+			struct vclock vclock;
+			vclock_copy(&vclock, &r->vclock);
+			vclock_follow_xrow(&vclock, &nearest->row);
+			XlogGapError *e = tnt_error(XlogGapError,
+						    &r->vclock, &vclock);
+			if (!nearest->wal_dir.force_recovery)
+				throw e;
+			e->log();
+			say_warn("ignoring a gap in LSN");
+			next = nearest;
 		}
 
-		recovery_open_log(r, clock);
-
-		say_info("recover from `%s'", r->cursor.name);
-
-recover_current_wal:
-		recover_xlog(r, stream, stop_vclock);
+		struct xrow_header *row = &next->row;
+		next->has_row = false;
+		recovery_stripe_follow(next, row);
+		/*
+		 * We can promote the vclock either before or
+		 * after xstream_write(): it only makes any impact
+		 * in case of forced recovery, when we skip the
+		 * failed row anyway.
+		 */
+		vclock_follow_xrow(&r->vclock, row);
+		if (xstream_write(stream, row) == 0) {
+			++row_count;
+			if (row_count % 100000 == 0)
+				say_info("%.1fM rows processed",
+					 row_count / 1000000.);
+		} else {
+			say_error("can't apply row: ");
+			diag_log();
+			if (!next->wal_dir.force_recovery)
+				diag_raise();
+		}
 	}
 
-	if (xlog_cursor_is_eof(&r->cursor))
-		recovery_close_log(r);
+	for (int i = 0; i < r->stripe_count; i++) {
+		struct recovery_stripe *s = &r->stripes[i];
+		if (xlog_cursor_is_eof(&s->cursor))
+			recovery_close_log(r, s);
+		s->clock = NULL;
+	}
 
 	if (stop_vclock != NULL && vclock_compare(&r->vclock, stop_vclock) != 0)
 		tnt_raise(XlogGapError, &r->vclock, stop_vclock);
@@ -353,7 +553,8 @@ recover_current_wal:
 void
 recovery_finalize(struct recovery *r)
 {
-	recovery_close_log(r);
+	for (int i = 0; i < r->stripe_count; i++)
+		recovery_close_log(r, &r->stripes[i]);
 }
 
 
@@ -455,7 +656,10 @@ hot_standby_f(va_list ap)
 	ev_tstamp wal_dir_rescan_delay = va_arg(ap, ev_tstamp);
 	fiber_set_user(fiber(), &admin_credentials);
 
-	WalSubscription subscription(r->wal_dir.dirname);
+	/* Hot standby isn't supported with WAL stripes. */
+	assert(r->stripe_count == 1);
+	struct recovery_stripe *stripe = &r->stripes[0];
+	WalSubscription subscription(stripe->wal_dir.dirname);
 
 	while (! fiber_is_cancelled()) {
 
@@ -480,10 +684,10 @@ hot_standby_f(va_list ap)
 			 * Sic: end * is < start (is 0) if someone deleted all logs
 			 * on the filesystem.
 			 */
-		} while (end > start && !xlog_cursor_is_open(&r->cursor));
+		} while (end > start && !xlog_cursor_is_open(&stripe->cursor));
 
-		subscription.set_log_path(xlog_cursor_is_open(&r->cursor) ?
-					  r->cursor.name : NULL);
+		subscription.set_log_path(xlog_cursor_is_open(&stripe->cursor) ?
+					  stripe->cursor.name : NULL);
 
 		bool timed_out = false;
 		if (subscription.events == 0) {
@@ -36,6 +36,7 @@
 #include "xlog.h"
 #include "vclock.h"
 #include "tt_uuid.h"
+#include "xrow.h"
 
 #if defined(__cplusplus)
 extern "C" {
@@ -43,14 +44,47 @@ extern "C" {
 
 extern const struct type_info type_XlogGapError;
 
-struct xrow_header;
 struct xstream;
 
-struct recovery {
-	struct vclock vclock;
-	/** The WAL cursor we're currently reading/writing from/to. */
+/** A WAL directory written by its own WAL thread. */
+struct recovery_stripe {
+	/** The WAL cursor we're currently reading from. */
 	struct xlog_cursor cursor;
 	struct xdir wal_dir;
+	/**
+	 * Index entry of the xlog the cursor was opened for,
+	 * valid only while recover_remaining_wals() runs.
+	 */
+	struct vclock *clock;
+	/** The next row to recover, read ahead from the cursor. */
+	struct xrow_header row;
+	/** Set if @row holds a row which hasn't been applied. */
+	bool has_row;
+	/**
+	 * Rows read from the stripe from now on are greater
+	 * than this vclock. Made of the vclocks of the rows
+	 * consumed so far and of the current xlog.
+	 */
+	struct vclock vclock;
+};
+
+struct recovery {
+	struct vclock vclock;
+	/**
+	 * WAL directories, one per each WAL stripe. Rows of
+	 * different stripes are merged by vclock, see
+	 * recover_remaining_wals().
+	 */
+	struct recovery_stripe *stripes;
+	int stripe_count;
+	/**
+	 * Set if the WAL is written while it's recovered, like
+	 * it is when a relay follows it. Then a stripe that has
+	 * no more rows may get them later, and a row can't be
+	 * applied until there's no stripe which may still get
+	 * a row of the same replica preceding it.
+	 */
+	bool is_following;
 	/**
 	 * This fiber is used in local hot standby mode.
 	 * It looks for changes in the wal_dir and applies
@@ -62,16 +96,17 @@ struct recovery {
 };
 
 struct recovery *
-recovery_new(const char *wal_dirname, bool force_recovery,
-	     const struct vclock *vclock);
+recovery_new(const char **wal_dirs, int wal_dir_count,
+	     bool force_recovery, const struct vclock *vclock);
 
 void
 recovery_delete(struct recovery *r);
 
 /**
- * Scan the WAL directory, build an index of all found
- * WAL files, then scan the most recent WAL file to find
- * the vclock of the last record (returned in @end_vclock).
+ * Scan the WAL directories, build an index of all found
+ * WAL files, then scan the most recent WAL file of each
+ * directory to find the vclock of the last record
+ * (returned in @end_vclock).
  */
 void
 recovery_scan(struct recovery *r, struct vclock *end_vclock);
@@ -86,13 +121,25 @@ recovery_stop_local(struct recovery *r);
 void
 recovery_finalize(struct recovery *r);
 
+/**
+ * Close the current WALs without running on_close_log triggers
+ * and forget about it, as if recovery was just started at the
+ * current vclock. Used when rows are taken from another source
+ * for a while, so that the next recover_remaining_wals() looks
+ * up the WAL to continue from by the recovery vclock.
+ */
+void
+recovery_reset_log(struct recovery *r);
+
 #if defined(__cplusplus)
 } /* extern "C" */
 #endif /* defined(__cplusplus) */
 
 /**
  * Find out if there are new .xlog files since the current
- * vclock, and read them all up.
+ * vclock, and read them all up. Rows of different WAL
+ * stripes are merged so that rows of each replica are
+ * applied in LSN order.
  *
  * Reading will be stopped on reaching stop_vclock.
  * Use NULL for boundless recover
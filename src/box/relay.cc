@@ -32,6 +32,7 @@
 
 #include "trivia/config.h"
 #include "trivia/util.h"
+#include "box.h"
 #include "cbus.h"
 #include "cfg.h"
 #include "errinj.h"
@@ -49,10 +50,21 @@
 #include "vclock.h"
 #include "version.h"
 #include "xrow.h"
+#include "xrow_buf.h"
 #include "xrow_io.h"
 #include "xstream.h"
 #include "wal.h"
 
+#include <small/ibuf.h>
+
+enum {
+	/**
+	 * Amount of data a relay copies from the WAL cache
+	 * at once.
+	 */
+	RELAY_WAL_CACHE_READ_MAX = 256 * 1024,
+};
+
 /**
  * Cbus message to send status updates from relay to tx thread.
  */
@@ -100,6 +112,15 @@ struct relay {
 	struct replica *replica;
 	/** WAL event watcher. */
 	struct wal_watcher wal_watcher;
+	/**
+	 * Set if the relay follows the WAL closely enough to
+	 * take rows from the WAL cache instead of xlog files.
+	 */
+	bool is_wal_cache_used;
+	/** Position of the relay in the WAL cache. */
+	struct xrow_buf_cursor wal_cursor;
+	/** Rows copied from the WAL cache. */
+	struct ibuf wal_cache_buf;
 	/** Relay reader cond. */
 	struct fiber_cond reader_cond;
 	/** Relay diagnostics. */
@@ -289,7 +310,9 @@ relay_final_join(struct replica *replica, int fd, uint64_t sync,
 {
 	struct relay *relay = replica->relay;
 	relay_start(relay, fd, sync, relay_send_row);
-	relay->r = recovery_new(cfg_gets("wal_dir"),
+	const char *wal_dirs[WAL_STRIPE_MAX];
+	int wal_dir_count = box_wal_dirs(wal_dirs);
+	relay->r = recovery_new(wal_dirs, wal_dir_count,
 			       cfg_geti("force_recovery"),
 			       start_vclock);
 	vclock_copy(&relay->stop_vclock, stop_vclock);
@@ -349,13 +372,16 @@ tx_gc_advance(struct cmsg *msg)
 	free(m);
 }
 
+/**
+ * Queue a garbage collection request for xlogs preceding
+ * the current relay position.
+ */
 static void
-relay_on_close_log_f(struct trigger *trigger, void * /* event */)
+relay_add_pending_gc(struct relay *relay)
 {
 	static const struct cmsg_hop route[] = {
 		{tx_gc_advance, NULL}
 	};
-	struct relay *relay = (struct relay *)trigger->data;
 	struct relay_gc_msg *m = (struct relay_gc_msg *)malloc(sizeof(*m));
 	if (m == NULL) {
 		say_warn("failed to allocate relay gc message");
@@ -372,6 +398,13 @@ relay_on_close_log_f(struct trigger *trigger, void * /* event */)
 	stailq_add_tail_entry(&relay->pending_gc, m, in_pending);
 }
 
+static void
+relay_on_close_log_f(struct trigger *trigger, void * /* event */)
+{
+	struct relay *relay = (struct relay *)trigger->data;
+	relay_add_pending_gc(relay);
+}
+
 /**
  * Invoke pending garbage collection requests.
  *
@@ -395,6 +428,66 @@ relay_schedule_pending_gc(struct relay *relay, const struct vclock *vclock)
 		cpipe_push(&relay->tx_pipe, &gc_msg->msg);
 }
 
+/**
+ * Send rows written to WAL since the last call taking them
+ * from the WAL cache. Returns false if the relay is too far
+ * behind and must read rows from xlog files instead.
+ * Throws on error.
+ */
+static bool
+relay_send_from_wal_cache(struct relay *relay, unsigned events)
+{
+	struct recovery *r = relay->r;
+	if (!relay->is_wal_cache_used) {
+		if (wal_cache_cursor_create(&relay->wal_cursor,
+					    &r->vclock) != 0)
+			return false;
+		/*
+		 * Stop reading the current xlog. Should the relay
+		 * fall behind again, it will look up the xlog to
+		 * continue from by its vclock.
+		 */
+		recovery_reset_log(r);
+		relay->is_wal_cache_used = true;
+		say_info("reading rows from the WAL cache");
+	}
+	struct ibuf *ibuf = &relay->wal_cache_buf;
+	while (true) {
+		ibuf_reset(ibuf);
+		int rc = wal_cache_cursor_read(&relay->wal_cursor, ibuf,
+					       RELAY_WAL_CACHE_READ_MAX);
+		if (rc < 0)
+			diag_raise();
+		if (rc > 0) {
+			say_info("fell behind the WAL cache, "
+				 "reading rows from xlogs");
+			relay->is_wal_cache_used = false;
+			return false;
+		}
+		if (ibuf_used(ibuf) == 0)
+			break;
+		const char *pos = ibuf->rpos;
+		const char *end = ibuf->wpos;
+		while (pos < end) {
+			struct xrow_header row;
+			if (xrow_buf_decode(&row, &pos, end) != 0)
+				diag_raise();
+			/* Skip rows the replica already has. */
+			if (row.lsn <= vclock_get(&r->vclock, row.replica_id))
+				continue;
+			vclock_follow_xrow(&r->vclock, &row);
+			xstream_write_xc(&relay->stream, &row);
+		}
+	}
+	/*
+	 * No xlog is closed while rows are taken from memory,
+	 * so collect garbage on WAL rotation instead.
+	 */
+	if ((events & WAL_EVENT_ROTATE) != 0)
+		relay_add_pending_gc(relay);
+	return true;
+}
+
 static void
 relay_process_wal_event(struct wal_watcher *watcher, unsigned events)
 {
@@ -407,7 +500,17 @@ relay_process_wal_event(struct wal_watcher *watcher, unsigned events)
 		return;
 	}
 	try {
+		bool is_wal_cache_used = relay->is_wal_cache_used;
+		if (relay_send_from_wal_cache(relay, events))
+			return;
+		/*
+		 * Rescan the WAL directory if the relay has just
+		 * fallen behind the cache, because the directory
+		 * index isn't updated while rows are read from
+		 * memory.
+		 */
 		recover_remaining_wals(relay->r, &relay->stream, NULL,
+				       is_wal_cache_used ||
 				       (events & WAL_EVENT_ROTATE) != 0);
 	} catch (Exception *e) {
 		e->log();
@@ -493,6 +596,9 @@ relay_subscribe_f(va_list ap)
 		RLIST_LINK_INITIALIZER, relay_on_close_log_f, relay, NULL
 	};
 	trigger_add(&r->on_close_log, &on_close_log);
+	relay->is_wal_cache_used = false;
+	ibuf_create(&relay->wal_cache_buf, &cord()->slabc,
+		    RELAY_WAL_CACHE_READ_MAX);
 	wal_set_watcher(&relay->wal_watcher, cord_name(cord()),
 			relay_process_wal_event, cbus_process);
 
@@ -559,6 +665,7 @@ relay_subscribe_f(va_list ap)
 	say_crit("exiting the relay loop");
 	trigger_clear(&on_close_log);
 	wal_clear_watcher(&relay->wal_watcher, cbus_process);
+	ibuf_destroy(&relay->wal_cache_buf);
 	if (!fiber_is_dead(reader))
 		fiber_cancel(reader);
 	fiber_join(reader);
@@ -601,9 +708,12 @@ relay_subscribe(struct replica *replica, int fd, uint64_t sync,
 
 	relay_start(relay, fd, sync, relay_send_row);
 	vclock_copy(&relay->local_vclock_at_subscribe, &replicaset.vclock);
-	relay->r = recovery_new(cfg_gets("wal_dir"),
+	const char *wal_dirs[WAL_STRIPE_MAX];
+	int wal_dir_count = box_wal_dirs(wal_dirs);
+	relay->r = recovery_new(wal_dirs, wal_dir_count,
 			        cfg_geti("force_recovery"),
 			        replica_clock);
+	relay->r->is_following = true;
 	vclock_copy(&relay->tx.vclock, replica_clock);
 	relay->version_id = replica_version_id;
 
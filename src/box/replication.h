@@ -137,6 +137,15 @@ extern double replication_sync_timeout;
  */
 extern bool replication_skip_conflict;
 
+/**
+ * Max number of rows received from the master that an applier
+ * may have in WAL at once. The rows are still executed one by
+ * one in the order of their LSNs, only their WAL writes overlap,
+ * see applier_apply_pipelined(). Takes effect on the next
+ * subscribe.
+ */
+extern int replication_wal_pipeline;
+
 /**
  * Wait for the given period of time before trying to reconnect
  * to a master.
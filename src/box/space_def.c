@@ -54,6 +54,8 @@ const struct space_opts space_opts_default = {
 	/* .group_id = */ 0,
 	/* .is_temporary = */ false,
 	/* .view = */ false,
+	/* .compact_field_map = */ false,
+	/* .field_map_step = */ 0,
 	/* .sql        = */ NULL,
 	/* .checks     = */ NULL,
 };
@@ -62,6 +64,10 @@ const struct opt_def space_opts_reg[] = {
 	OPT_DEF("group_id", OPT_UINT32, struct space_opts, group_id),
 	OPT_DEF("temporary", OPT_BOOL, struct space_opts, is_temporary),
 	OPT_DEF("view", OPT_BOOL, struct space_opts, is_view),
+	OPT_DEF("compact_field_map", OPT_BOOL, struct space_opts,
+		compact_field_map),
+	OPT_DEF("field_map_step", OPT_UINT32, struct space_opts,
+		field_map_step),
 	OPT_DEF("sql", OPT_STRPTR, struct space_opts, sql),
 	OPT_DEF_ARRAY("checks", struct space_opts, checks,
 		      checks_array_decode),
@@ -64,6 +64,20 @@ struct space_opts {
 	 * this flag can't be changed after space creation.
 	 */
 	bool is_view;
+	/**
+	 * Store tuple field offsets as 16-bit integers to
+	 * save memory on small tuples. Tuples whose indexed
+	 * fields start beyond 64KB can't be inserted into
+	 * such a space. Can't be changed after space creation.
+	 */
+	bool compact_field_map;
+	/**
+	 * If not 0, offsets of every field_map_step-th field
+	 * defined by the space format are stored in the field
+	 * map so that a field of a wide tuple can be found
+	 * without decoding all preceding fields.
+	 */
+	uint32_t field_map_step;
 	/** SQL statement that produced this space. */
 	char *sql;
 	/** SQL Checks expressions list. */
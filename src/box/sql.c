@@ -201,6 +201,8 @@ tarantoolSqlite3TupleColumnFast(BtCursor *pCur, u32 fieldno, u32 *field_size)
 	if (format->fields[fieldno].offset_slot == TUPLE_OFFSET_SLOT_NIL)
 		return NULL;
 	const char *field = tuple_field(pCur->last_tuple, fieldno);
+	if (field == NULL)
+		return NULL;
 	const char *end = field;
 	mp_next(&end);
 	*field_size = end - field;
@@ -789,13 +791,13 @@ sql_rename_table(uint32_t space_id, const char *new_name, char **sql_stmt)
 	 * there is no need to decode/encode other fields of tuple,
 	 * just memcpy constant parts.
 	 */
-	char *new_tuple = (char*)region_alloc(&fiber()->gc, tuple->bsize +
+	char *new_tuple = (char*)region_alloc(&fiber()->gc, tuple_bsize(tuple) +
 					      mp_sizeof_str(sql_stmt_len));
 	if (new_tuple == NULL) {
 		free(*sql_stmt);
 		*sql_stmt = NULL;
 		diag_set(OutOfMemory,
-			 tuple->bsize + mp_sizeof_str(sql_stmt_len),
+			 tuple_bsize(tuple) + mp_sizeof_str(sql_stmt_len),
 			 "region_alloc", "new_tuple");
 		return SQL_TARANTOOL_ERROR;
 	}
@@ -964,9 +966,9 @@ tarantoolSqlite3IdxKeyCompare(struct BtCursor *cursor,
 				while (j++ != fieldno)
 					mp_next(&p);
 			} else {
-				p = base + field_map[
-					format->fields[fieldno].offset_slot
-					];
+				p = base + tuple_field_map_get(format,
+					field_map,
+					format->fields[fieldno].offset_slot);
 			}
 		}
 		next_fieldno = fieldno + 1;
@@ -38,6 +38,7 @@
 #include "small/small.h"
 
 #include "tuple_update.h"
+#include "tuple_hash.h"
 #include "coll_id_cache.h"
 
 static struct mempool tuple_iterator_pool;
@@ -52,12 +53,12 @@ enum {
  * Container for big reference counters. Contains array of big
  * reference counters, size of this array and number of non-zero
  * big reference counters. When reference counter of tuple becomes
- * more than 32767, field refs of this tuple becomes index of big
+ * more than 16383, field refs of this tuple becomes index of big
  * reference counter in big reference counter array and field
  * is_bigref is set true. The moment big reference becomes equal
- * 32767 it is set to 0, refs of the tuple becomes 32767 and
+ * 16383 it is set to 0, refs of the tuple becomes 16383 and
  * is_bigref becomes false. Big reference counter can be equal to
- * 0 or be more than 32767.
+ * 0 or be more than 16383.
  */
 static struct bigref_list {
 	/** Free-list of big reference counters. */
@@ -107,11 +108,8 @@ runtime_tuple_new(struct tuple_format *format, const char *data, const char *end
 		return NULL;
 	}
 
-	tuple->refs = 0;
-	tuple->bsize = data_len;
-	tuple->format_id = tuple_format_id(format);
+	tuple_create(tuple, tuple_format_id(format), data_len, meta_size);
 	tuple_format_ref(format);
-	tuple->data_offset = sizeof(struct tuple) + meta_size;
 	char *raw = (char *) tuple + tuple->data_offset;
 	uint32_t *field_map = (uint32_t *) raw;
 	memcpy(raw, data, data_len);
@@ -219,11 +217,13 @@ int
 tuple_init(field_name_hash_f hash)
 {
 	field_name_hash = hash;
+	tuple_hash_init();
 	/*
 	 * Create a format for runtime tuples
 	 */
 	tuple_format_runtime = tuple_format_new(&tuple_format_runtime_vtab,
-						NULL, 0, 0, NULL, 0, NULL);
+						NULL, 0, 0, 0, false,
+						NULL, 0, NULL);
 	if (tuple_format_runtime == NULL)
 		return -1;
 
@@ -278,10 +278,10 @@ enum {
 	BIGREF_MAX = UINT32_MAX,
 	BIGREF_MIN_CAPACITY = 16,
 	/**
-	 * Only 15 bits are available for bigref list index in
+	 * Only 14 bits are available for bigref list index in
 	 * struct tuple.
 	 */
-	BIGREF_MAX_CAPACITY = UINT16_MAX >> 1
+	BIGREF_MAX_CAPACITY = UINT16_MAX >> 2
 };
 
 /** Destroy big references and free memory that was allocated. */
@@ -395,7 +395,7 @@ box_tuple_format_new(struct key_def **keys, uint16_t key_count)
 {
 	box_tuple_format_t *format =
 		tuple_format_new(&tuple_format_runtime_vtab,
-				 keys, key_count, 0, NULL, 0, NULL);
+				 keys, key_count, 0, 0, false, NULL, 0, NULL);
 	if (format != NULL)
 		tuple_format_ref(format);
 	return format;
@@ -427,7 +427,7 @@ size_t
 box_tuple_bsize(const box_tuple_t *tuple)
 {
 	assert(tuple != NULL);
-	return tuple->bsize;
+	return tuple_bsize(tuple);
 }
 
 ssize_t
@@ -302,31 +302,57 @@ box_tuple_upsert(const box_tuple_t *tuple, const char *expr, const
  *   +----------------------+-----------------------+
  *    @sa tuple_format_new()   uint32  ...  uint32
  *
- * Each 'off_i' is the offset to the i-th indexed field.
+ * Each 'off_i' is the offset to the i-th indexed field or
+ * to every field_map_step-th field of the space format.
+ * Offsets are uint16 if format->is_field_map_compact is set.
+ *
+ * If is_tiny is set, the tuple header is truncated to
+ * TUPLE_TINY_HEADER_SIZE bytes and bsize and data_offset
+ * are stored in one byte each, see tuple_create_tiny().
+ * Use tuple_bsize() and tuple_data_offset() to access them.
  */
 struct PACKED tuple
 {
 	union {
-		/** Reference counter. */
-		uint16_t refs;
+		struct {
+			/**
+			 * Reference counter. Includes is_bigref
+			 * so that a big reference counter is never
+			 * less than TUPLE_REF_MAX.
+			 */
+			uint16_t refs : 15;
+		};
 		struct {
 			/** Index of big reference counter. */
-			uint16_t ref_index : 15;
+			uint16_t ref_index : 14;
 			/** Big reference flag. */
 			bool is_bigref : 1;
+			/** Tiny header flag. */
+			bool is_tiny : 1;
 		};
 	};
 	/** Format identifier. */
 	uint16_t format_id;
-	/**
-	 * Length of the MessagePack data in raw part of the
-	 * tuple.
-	 */
-	uint32_t bsize;
-	/**
-	 * Offset to the MessagePack from the begin of the tuple.
-	 */
-	uint16_t data_offset;
+	union {
+		struct PACKED {
+			/**
+			 * Length of the MessagePack data in raw
+			 * part of the tuple.
+			 */
+			uint32_t bsize;
+			/**
+			 * Offset to the MessagePack from the begin
+			 * of the tuple.
+			 */
+			uint16_t data_offset;
+		};
+		struct {
+			/** bsize of a tiny tuple. */
+			uint8_t tiny_bsize;
+			/** data_offset of a tiny tuple. */
+			uint8_t tiny_data_offset;
+		};
+	};
 	/**
 	 * Engine specific fields and offsets array concatenated
 	 * with MessagePack fields array.
@@ -334,12 +360,81 @@ struct PACKED tuple
 	 */
 };
 
+enum {
+	/** Size of the header of a tuple with is_tiny set. */
+	TUPLE_TINY_HEADER_SIZE = 6,
+	/** Max bsize and data_offset of a tuple with is_tiny set. */
+	TUPLE_TINY_SIZE_MAX = UINT8_MAX,
+};
+
+/**
+ * Initialize the header of a tuple.
+ * @param tuple Tuple.
+ * @param format_id Format identifier.
+ * @param bsize Length of the MessagePack data.
+ * @param meta_size Size of the tuple meta, i.e. engine
+ *        specific fields and field map.
+ */
+static inline void
+tuple_create(struct tuple *tuple, uint16_t format_id, uint32_t bsize,
+	     uint32_t meta_size)
+{
+	tuple->refs = 0;
+	tuple->is_tiny = false;
+	tuple->format_id = format_id;
+	tuple->bsize = bsize;
+	tuple->data_offset = sizeof(struct tuple) + meta_size;
+}
+
+/**
+ * Check if a tuple with the given sizes fits in a tiny header.
+ * @sa tuple_create_tiny()
+ */
+static inline bool
+tuple_fits_tiny(uint32_t bsize, uint32_t meta_size)
+{
+	return bsize <= TUPLE_TINY_SIZE_MAX &&
+	       TUPLE_TINY_HEADER_SIZE + meta_size <= TUPLE_TINY_SIZE_MAX;
+}
+
+/**
+ * Initialize the tiny header of a tuple. The tuple data
+ * follows the header, which takes TUPLE_TINY_HEADER_SIZE
+ * instead of sizeof(struct tuple) bytes.
+ * @pre tuple_fits_tiny(bsize, meta_size)
+ */
+static inline void
+tuple_create_tiny(struct tuple *tuple, uint16_t format_id, uint32_t bsize,
+		  uint32_t meta_size)
+{
+	assert(tuple_fits_tiny(bsize, meta_size));
+	tuple->refs = 0;
+	tuple->is_tiny = true;
+	tuple->format_id = format_id;
+	tuple->tiny_bsize = bsize;
+	tuple->tiny_data_offset = TUPLE_TINY_HEADER_SIZE + meta_size;
+}
+
+/** Length of the MessagePack data of the tuple. */
+static inline uint32_t
+tuple_bsize(const struct tuple *tuple)
+{
+	return tuple->is_tiny ? tuple->tiny_bsize : tuple->bsize;
+}
+
+/** Offset to the MessagePack data from the begin of the tuple. */
+static inline uint16_t
+tuple_data_offset(const struct tuple *tuple)
+{
+	return tuple->is_tiny ? tuple->tiny_data_offset : tuple->data_offset;
+}
+
 /** Size of the tuple including size of struct tuple. */
 static inline size_t
 tuple_size(const struct tuple *tuple)
 {
 	/* data_offset includes sizeof(struct tuple). */
-	return tuple->data_offset + tuple->bsize;
+	return tuple_data_offset(tuple) + tuple_bsize(tuple);
 }
 
 /**
@@ -350,7 +445,7 @@ tuple_size(const struct tuple *tuple)
 static inline const char *
 tuple_data(const struct tuple *tuple)
 {
-	return (const char *) tuple + tuple->data_offset;
+	return (const char *) tuple + tuple_data_offset(tuple);
 }
 
 /**
@@ -371,8 +466,8 @@ tuple_data_or_null(const struct tuple *tuple)
 static inline const char *
 tuple_data_range(const struct tuple *tuple, uint32_t *p_size)
 {
-	*p_size = tuple->bsize;
-	return (const char *) tuple + tuple->data_offset;
+	*p_size = tuple_bsize(tuple);
+	return tuple_data(tuple);
 }
 
 /**
@@ -501,7 +596,7 @@ tuple_validate(struct tuple_format *format, struct tuple *tuple)
 static inline const uint32_t *
 tuple_field_map(const struct tuple *tuple)
 {
-	return (const uint32_t *) ((const char *) tuple + tuple->data_offset);
+	return (const uint32_t *) tuple_data(tuple);
 }
 
 /**
@@ -852,7 +947,7 @@ tuple_field_uuid(const struct tuple *tuple, int fieldno,
 	return 0;
 }
 
-enum { TUPLE_REF_MAX = UINT16_MAX >> 1 };
+enum { TUPLE_REF_MAX = UINT16_MAX >> 2 };
 
 /**
  * Increase tuple big reference counter.
@@ -44,11 +44,14 @@
 #include "tuple.h"
 #include "tuple_hash.h"
 #include "salad/bloom.h"
+#include "salad/xor_filter.h"
 #include "trivia/util.h"
 #include "third_party/PMurHash.h"
 
 enum { HASH_SEED = 13U };
 
+const char *bloom_type_strs[] = { "bloom", "xor" };
+
 struct tuple_bloom_builder *
 tuple_bloom_builder_new(uint32_t part_count)
 {
@@ -114,11 +117,12 @@ tuple_bloom_builder_add(struct tuple_bloom_builder *builder,
 }
 
 struct tuple_bloom *
-tuple_bloom_new(struct tuple_bloom_builder *builder, double fpr)
+tuple_bloom_new(struct tuple_bloom_builder *builder,
+		enum bloom_type type, double fpr)
 {
 	uint32_t part_count = builder->part_count;
 	size_t size = sizeof(struct tuple_bloom) +
-			part_count * sizeof(struct bloom);
+			part_count * sizeof(union tuple_bloom_part);
 	struct tuple_bloom *bloom = malloc(size);
 	if (bloom == NULL) {
 		diag_set(OutOfMemory, size, "malloc", "tuple bloom");
@@ -126,11 +130,24 @@ tuple_bloom_new(struct tuple_bloom_builder *builder, double fpr)
 	}
 
 	bloom->is_legacy = false;
+	bloom->type = type;
 	bloom->part_count = 0;
 
 	for (uint32_t i = 0; i < part_count; i++) {
 		struct tuple_hash_array *hash_arr = &builder->parts[i];
 		uint32_t count = hash_arr->count;
+		if (type == BLOOM_TYPE_XOR) {
+			if (xor_filter_create(&bloom->parts[i].xorf,
+					      hash_arr->values, count,
+					      runtime.quota) != 0) {
+				diag_set(OutOfMemory, 0, "xor_filter_create",
+					 "tuple bloom part");
+				tuple_bloom_delete(bloom);
+				return NULL;
+			}
+			bloom->part_count++;
+			continue;
+		}
 		/*
 		 * When we check if a key is stored in a bloom
 		 * filter, we check all its sub keys as well,
@@ -141,9 +158,9 @@ tuple_bloom_new(struct tuple_bloom_builder *builder, double fpr)
 		 */
 		double part_fpr = fpr;
 		for (uint32_t j = 0; j < i; j++)
-			part_fpr /= bloom_fpr(&bloom->parts[j], count);
+			part_fpr /= bloom_fpr(&bloom->parts[j].bloom, count);
 		part_fpr = MIN(part_fpr, 0.5);
-		if (bloom_create(&bloom->parts[i], count,
+		if (bloom_create(&bloom->parts[i].bloom, count,
 				 part_fpr, runtime.quota) != 0) {
 			diag_set(OutOfMemory, 0, "bloom_create",
 				 "tuple bloom part");
@@ -152,7 +169,7 @@ tuple_bloom_new(struct tuple_bloom_builder *builder, double fpr)
 		}
 		bloom->part_count++;
 		for (uint32_t k = 0; k < count; k++)
-			bloom_add(&bloom->parts[i], hash_arr->values[k]);
+			bloom_add(&bloom->parts[i].bloom, hash_arr->values[k]);
 	}
 	return bloom;
 }
@@ -160,18 +177,33 @@ tuple_bloom_new(struct tuple_bloom_builder *builder, double fpr)
 void
 tuple_bloom_delete(struct tuple_bloom *bloom)
 {
-	for (uint32_t i = 0; i < bloom->part_count; i++)
-		bloom_destroy(&bloom->parts[i], runtime.quota);
+	for (uint32_t i = 0; i < bloom->part_count; i++) {
+		if (bloom->type == BLOOM_TYPE_XOR)
+			xor_filter_destroy(&bloom->parts[i].xorf,
+					   runtime.quota);
+		else
+			bloom_destroy(&bloom->parts[i].bloom, runtime.quota);
+	}
 	free(bloom);
 }
 
+/** Check if a partial key hash may be stored in a tuple bloom. */
+static inline bool
+tuple_bloom_part_maybe_has(const struct tuple_bloom *bloom,
+			   uint32_t part, uint32_t hash)
+{
+	if (bloom->type == BLOOM_TYPE_XOR)
+		return xor_filter_maybe_has(&bloom->parts[part].xorf, hash);
+	return bloom_maybe_has(&bloom->parts[part].bloom, hash);
+}
+
 bool
 tuple_bloom_maybe_has(const struct tuple_bloom *bloom,
 		      const struct tuple *tuple, struct key_def *key_def)
 {
 	if (bloom->is_legacy) {
-		return bloom_maybe_has(&bloom->parts[0],
-				       tuple_hash(tuple, key_def));
+		return bloom_maybe_has(&bloom->parts[0].bloom,
+				       tuple_hash_stable(tuple, key_def));
 	}
 
 	assert(bloom->part_count == key_def->part_count);
@@ -184,7 +216,7 @@ tuple_bloom_maybe_has(const struct tuple_bloom *bloom,
 		total_size += tuple_hash_key_part(&h, &carry, tuple,
 						  &key_def->parts[i]);
 		uint32_t hash = PMurHash32_Result(h, carry, total_size);
-		if (!bloom_maybe_has(&bloom->parts[i], hash))
+		if (!tuple_bloom_part_maybe_has(bloom, i, hash))
 			return false;
 	}
 	return true;
@@ -198,8 +230,8 @@ tuple_bloom_maybe_has_key(const struct tuple_bloom *bloom,
 	if (bloom->is_legacy) {
 		if (part_count < key_def->part_count)
 			return true;
-		return bloom_maybe_has(&bloom->parts[0],
-				       key_hash(key, key_def));
+		return bloom_maybe_has(&bloom->parts[0].bloom,
+				       key_hash_stable(key, key_def));
 	}
 
 	assert(part_count <= key_def->part_count);
@@ -213,17 +245,34 @@ tuple_bloom_maybe_has_key(const struct tuple_bloom *bloom,
 		total_size += tuple_hash_field(&h, &carry, &key,
 					       key_def->parts[i].coll);
 		uint32_t hash = PMurHash32_Result(h, carry, total_size);
-		if (!bloom_maybe_has(&bloom->parts[i], hash))
+		if (!tuple_bloom_part_maybe_has(bloom, i, hash))
 			return false;
 	}
 	return true;
 }
 
+/*
+ * A bloom filter part is encoded as
+ *
+ *   [table_size, hash_count, table]
+ *
+ * while a xor filter part is encoded as
+ *
+ *   [seed, segment_length, segment_count, table]
+ *
+ * so the type of a tuple bloom is told by the length of the
+ * arrays storing its parts.
+ */
+enum {
+	TUPLE_BLOOM_PART_LEN = 3,
+	TUPLE_XOR_FILTER_PART_LEN = 4,
+};
+
 static size_t
 tuple_bloom_sizeof_part(const struct bloom *part)
 {
 	size_t size = 0;
-	size += mp_sizeof_array(3);
+	size += mp_sizeof_array(TUPLE_BLOOM_PART_LEN);
 	size += mp_sizeof_uint(part->table_size);
 	size += mp_sizeof_uint(part->hash_count);
 	size += mp_sizeof_bin(bloom_store_size(part));
@@ -233,7 +282,7 @@ tuple_bloom_sizeof_part(const struct bloom *part)
 static char *
 tuple_bloom_encode_part(const struct bloom *part, char *buf)
 {
-	buf = mp_encode_array(buf, 3);
+	buf = mp_encode_array(buf, TUPLE_BLOOM_PART_LEN);
 	buf = mp_encode_uint(buf, part->table_size);
 	buf = mp_encode_uint(buf, part->hash_count);
 	buf = mp_encode_binl(buf, bloom_store_size(part));
@@ -245,8 +294,6 @@ static int
 tuple_bloom_decode_part(struct bloom *part, const char **data)
 {
 	memset(part, 0, sizeof(*part));
-	if (mp_decode_array(data) != 3)
-		unreachable();
 	part->table_size = mp_decode_uint(data);
 	part->hash_count = mp_decode_uint(data);
 	size_t store_size = mp_decode_binl(data);
@@ -260,13 +307,61 @@ tuple_bloom_decode_part(struct bloom *part, const char **data)
 	return 0;
 }
 
+static size_t
+tuple_xor_filter_sizeof_part(const struct xor_filter *part)
+{
+	size_t size = 0;
+	size += mp_sizeof_array(TUPLE_XOR_FILTER_PART_LEN);
+	size += mp_sizeof_uint(part->seed);
+	size += mp_sizeof_uint(part->segment_length);
+	size += mp_sizeof_uint(part->segment_count);
+	size += mp_sizeof_bin(xor_filter_store_size(part));
+	return size;
+}
+
+static char *
+tuple_xor_filter_encode_part(const struct xor_filter *part, char *buf)
+{
+	buf = mp_encode_array(buf, TUPLE_XOR_FILTER_PART_LEN);
+	buf = mp_encode_uint(buf, part->seed);
+	buf = mp_encode_uint(buf, part->segment_length);
+	buf = mp_encode_uint(buf, part->segment_count);
+	buf = mp_encode_binl(buf, xor_filter_store_size(part));
+	buf = xor_filter_store(part, buf);
+	return buf;
+}
+
+static int
+tuple_xor_filter_decode_part(struct xor_filter *part, const char **data)
+{
+	memset(part, 0, sizeof(*part));
+	part->seed = mp_decode_uint(data);
+	part->segment_length = mp_decode_uint(data);
+	part->segment_count = mp_decode_uint(data);
+	size_t store_size = mp_decode_binl(data);
+	if (xor_filter_load_table(part, *data, runtime.quota) != 0) {
+		diag_set(OutOfMemory, store_size, "xor_filter_load_table",
+			 "tuple bloom part");
+		return -1;
+	}
+	assert(store_size == xor_filter_store_size(part));
+	*data += store_size;
+	return 0;
+}
+
 size_t
 tuple_bloom_size(const struct tuple_bloom *bloom)
 {
 	size_t size = 0;
 	size += mp_sizeof_array(bloom->part_count);
-	for (uint32_t i = 0; i < bloom->part_count; i++)
-		size += tuple_bloom_sizeof_part(&bloom->parts[i]);
+	for (uint32_t i = 0; i < bloom->part_count; i++) {
+		if (bloom->type == BLOOM_TYPE_XOR)
+			size += tuple_xor_filter_sizeof_part(
+						&bloom->parts[i].xorf);
+		else
+			size += tuple_bloom_sizeof_part(
+						&bloom->parts[i].bloom);
+	}
 	return size;
 }
 
@@ -274,8 +369,14 @@ char *
 tuple_bloom_encode(const struct tuple_bloom *bloom, char *buf)
 {
 	buf = mp_encode_array(buf, bloom->part_count);
-	for (uint32_t i = 0; i < bloom->part_count; i++)
-		buf = tuple_bloom_encode_part(&bloom->parts[i], buf);
+	for (uint32_t i = 0; i < bloom->part_count; i++) {
+		if (bloom->type == BLOOM_TYPE_XOR)
+			buf = tuple_xor_filter_encode_part(
+						&bloom->parts[i].xorf, buf);
+		else
+			buf = tuple_bloom_encode_part(
+						&bloom->parts[i].bloom, buf);
+	}
 	return buf;
 }
 
@@ -293,10 +394,27 @@ tuple_bloom_decode(const char **data)
 	}
 
 	bloom->is_legacy = false;
+	bloom->type = BLOOM_TYPE_BLOOM;
 	bloom->part_count = 0;
 
 	for (uint32_t i = 0; i < part_count; i++) {
-		if (tuple_bloom_decode_part(&bloom->parts[i], data) != 0) {
+		uint32_t len = mp_decode_array(data);
+		enum bloom_type type;
+		int rc;
+		if (len == TUPLE_XOR_FILTER_PART_LEN) {
+			type = BLOOM_TYPE_XOR;
+			rc = tuple_xor_filter_decode_part(&bloom->parts[i].xorf,
+							  data);
+		} else {
+			assert(len == TUPLE_BLOOM_PART_LEN);
+			type = BLOOM_TYPE_BLOOM;
+			rc = tuple_bloom_decode_part(&bloom->parts[i].bloom,
+						     data);
+		}
+		if (i == 0)
+			bloom->type = type;
+		assert(bloom->type == type);
+		if (rc != 0) {
 			tuple_bloom_delete(bloom);
 			return NULL;
 		}
@@ -317,6 +435,7 @@ tuple_bloom_decode_legacy(const char **data)
 	}
 
 	bloom->is_legacy = true;
+	bloom->type = BLOOM_TYPE_BLOOM;
 	bloom->part_count = 1;
 
 	if (mp_decode_array(data) != 4)
@@ -324,12 +443,13 @@ tuple_bloom_decode_legacy(const char **data)
 	if (mp_decode_uint(data) != 0) /* version */
 		unreachable();
 
-	bloom->parts[0].table_size = mp_decode_uint(data);
-	bloom->parts[0].hash_count = mp_decode_uint(data);
+	bloom->parts[0].bloom.table_size = mp_decode_uint(data);
+	bloom->parts[0].bloom.hash_count = mp_decode_uint(data);
 
 	size_t store_size = mp_decode_binl(data);
-	assert(store_size == bloom_store_size(&bloom->parts[0]));
-	if (bloom_load_table(&bloom->parts[0], *data, runtime.quota) != 0) {
+	assert(store_size == bloom_store_size(&bloom->parts[0].bloom));
+	if (bloom_load_table(&bloom->parts[0].bloom, *data,
+			     runtime.quota) != 0) {
 		diag_set(OutOfMemory, store_size, "bloom_load_table",
 			 "tuple bloom part");
 		free(bloom);
@@ -35,6 +35,7 @@
 #include <stddef.h>
 #include <stdint.h>
 #include "salad/bloom.h"
+#include "salad/xor_filter.h"
 
 #if defined(__cplusplus)
 extern "C" {
@@ -43,6 +44,29 @@ extern "C" {
 struct tuple;
 struct key_def;
 
+/** Type of filters used by a tuple bloom filter. */
+enum bloom_type {
+	/** Classic bloom filter, see salad/bloom.h. */
+	BLOOM_TYPE_BLOOM,
+	/**
+	 * Binary fuse filter, see salad/xor_filter.h. Needs less
+	 * memory per key for low false positive rates, but its
+	 * false positive rate is fixed at 1/256.
+	 */
+	BLOOM_TYPE_XOR,
+	bloom_type_MAX
+};
+
+extern const char *bloom_type_strs[];
+
+/** Filter storing hashes of a partial key. */
+union tuple_bloom_part {
+	/** Used if the tuple bloom type is BLOOM_TYPE_BLOOM. */
+	struct bloom bloom;
+	/** Used if the tuple bloom type is BLOOM_TYPE_XOR. */
+	struct xor_filter xorf;
+};
+
 /**
  * Tuple bloom filter.
  *
@@ -58,10 +82,12 @@ struct tuple_bloom {
 	 * (see tuple_bloom_decode_legacy).
 	 */
 	bool is_legacy;
+	/** Type of the filters stored in parts. */
+	enum bloom_type type;
 	/** Number of key parts. */
 	uint32_t part_count;
-	/** Array of bloom filters, one per each partial key. */
-	struct bloom parts[0];
+	/** Array of filters, one per each partial key. */
+	union tuple_bloom_part parts[0];
 };
 
 /**
@@ -123,11 +149,17 @@ tuple_bloom_builder_add(struct tuple_bloom_builder *builder,
 /**
  * Create a new tuple bloom filter.
  * @param builder - bloom filter builder
- * @param fpr - desired false positive rate
+ * @param type - type of filters to build
+ * @param fpr - desired false positive rate, ignored by
+ *  BLOOM_TYPE_XOR filters, which have the fixed rate
  * @return bloom filter on success or NULL on OOM
+ *
+ * Note, building a BLOOM_TYPE_XOR filter reorders hashes
+ * stored in the builder.
  */
 struct tuple_bloom *
-tuple_bloom_new(struct tuple_bloom_builder *builder, double fpr);
+tuple_bloom_new(struct tuple_bloom_builder *builder,
+		enum bloom_type type, double fpr);
 
 /**
  * Delete a tuple bloom filter.
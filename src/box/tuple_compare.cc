@@ -735,7 +735,7 @@ tuple_compare_with_key_sequential(const struct tuple *tuple, const char *key,
 		 * Key's and tuple's first field_count fields are
 		 * equal, and their bsize too.
 		 */
-		key += tuple->bsize - mp_sizeof_array(field_count);
+		key += tuple_bsize(tuple) - mp_sizeof_array(field_count);
 		for (uint32_t i = field_count; i < part_count;
 		     ++i, mp_next(&key)) {
 			if (mp_typeof(*key) != MP_NIL)
@@ -1011,10 +1011,222 @@ static const comparator_signature cmp_arr[] = {
 
 #undef COMPARATOR
 
+/*
+ * Comparators specialized by part types.
+ *
+ * The precalculated comparators above are bound to particular
+ * field numbers and cover only unsigned and string parts. The
+ * ones below are generated for every combination of unsigned,
+ * string, integer, number and scalar parts for keys of up to
+ * TYPED_CMP_MAX_PARTS parts. Field numbers, collations and
+ * nullability are taken from the key definition at run time,
+ * which costs a few well predicted branches, while the type
+ * switch of the slow path is resolved at compile time.
+ */
+
+/** Max number of parts of a key handled by typed comparators. */
+enum { TYPED_CMP_MAX_PARTS = 3 };
+
+/**
+ * Compare two non-NULL fields of the given type.
+ */
+template <int TYPE>
+static inline int
+field_compare_by_type(const char *field_a, enum mp_type a_type,
+		      const char *field_b, enum mp_type b_type,
+		      struct coll *coll)
+{
+	switch (TYPE) {
+	case FIELD_TYPE_UNSIGNED:
+		return mp_compare_uint(field_a, field_b);
+	case FIELD_TYPE_STRING:
+		return coll != NULL ?
+		       mp_compare_str_coll(field_a, field_b, coll) :
+		       mp_compare_str(field_a, field_b);
+	case FIELD_TYPE_INTEGER:
+		return mp_compare_integer_with_hint(field_a, a_type,
+						    field_b, b_type);
+	case FIELD_TYPE_NUMBER:
+		return mp_compare_number_with_hint(field_a, a_type,
+						   field_b, b_type);
+	case FIELD_TYPE_SCALAR:
+		return coll != NULL ?
+		       mp_compare_scalar_coll(field_a, field_b, coll) :
+		       mp_compare_scalar_with_hint(field_a, a_type,
+						   field_b, b_type);
+	default:
+		unreachable();
+		return 0;
+	}
+}
+
+/**
+ * Compare two fields of the given type, either of which may be
+ * NULL if the part is nullable. Absent optional fields are
+ * passed as NULL pointers and compared as NULL values.
+ * @param[out] was_null_met Set if both fields are NULL.
+ */
+template <int TYPE>
+static inline int
+key_part_compare_by_type(const char *field_a, const char *field_b,
+			 struct key_part *part, bool *was_null_met)
+{
+	if (!key_part_is_nullable(part)) {
+		assert(field_a != NULL && field_b != NULL);
+		return field_compare_by_type<TYPE>(field_a, mp_typeof(*field_a),
+						   field_b, mp_typeof(*field_b),
+						   part->coll);
+	}
+	enum mp_type a_type = field_a != NULL ? mp_typeof(*field_a) : MP_NIL;
+	enum mp_type b_type = field_b != NULL ? mp_typeof(*field_b) : MP_NIL;
+	if (a_type == MP_NIL) {
+		if (b_type != MP_NIL)
+			return -1;
+		*was_null_met = true;
+		return 0;
+	} else if (b_type == MP_NIL) {
+		return 1;
+	}
+	return field_compare_by_type<TYPE>(field_a, a_type, field_b, b_type,
+					   part->coll);
+}
+
+namespace /* local symbols */ {
+
+template <int ...TYPES> struct PartCompareByType { };
+
+template <int TYPE, int ...MORE_TYPES>
+struct PartCompareByType<TYPE, MORE_TYPES...>
+{
+	inline static int compare(const struct tuple *tuple_a,
+				  const struct tuple *tuple_b,
+				  struct key_part *part,
+				  struct key_part *unique_end,
+				  bool *was_null_met)
+	{
+		/*
+		 * Secondary keys of a unique nullable index are
+		 * compared by primary parts only if they contain
+		 * NULLs, see tuple_compare_slowpath().
+		 */
+		if (part == unique_end && !*was_null_met)
+			return 0;
+		const char *field_a, *field_b;
+		field_a = tuple_field_by_part_raw(tuple_format(tuple_a),
+						  tuple_data(tuple_a),
+						  tuple_field_map(tuple_a),
+						  part);
+		field_b = tuple_field_by_part_raw(tuple_format(tuple_b),
+						  tuple_data(tuple_b),
+						  tuple_field_map(tuple_b),
+						  part);
+		int rc = key_part_compare_by_type<TYPE>(field_a, field_b,
+							part, was_null_met);
+		if (rc != 0)
+			return rc;
+		return PartCompareByType<MORE_TYPES...>::
+			compare(tuple_a, tuple_b, part + 1, unique_end,
+				was_null_met);
+	}
+};
+
+template <>
+struct PartCompareByType<>
+{
+	inline static int compare(const struct tuple *,
+				  const struct tuple *,
+				  struct key_part *,
+				  struct key_part *,
+				  bool *)
+	{
+		return 0;
+	}
+};
+
+template <int ...TYPES>
+struct TupleCompareByType
+{
+	static int compare(const struct tuple *tuple_a,
+			   const struct tuple *tuple_b,
+			   struct key_def *key_def)
+	{
+		assert(key_def->part_count == sizeof...(TYPES));
+		struct key_part *unique_end = key_def->parts +
+			(key_def->is_nullable ? key_def->unique_part_count :
+						key_def->part_count);
+		bool was_null_met = false;
+		return PartCompareByType<TYPES...>::
+			compare(tuple_a, tuple_b, key_def->parts, unique_end,
+				&was_null_met);
+	}
+};
+
+/**
+ * Pick the instance of CMP matching part types of a key
+ * definition. Instances are generated for all combinations
+ * of up to DEPTH more types, so the whole tree is expanded
+ * at compile time.
+ */
+template <template <int...> class CMP, int DEPTH, int ...TYPES>
+struct CompareByTypeSelector
+{
+	static decltype(&CMP<>::compare) select(const struct key_def *def)
+	{
+		uint32_t i = sizeof...(TYPES);
+		if (i == def->part_count)
+			return CMP<TYPES...>::compare;
+		switch (def->parts[i].type) {
+#define TYPED_CMP_CASE(type)						\
+		case type:						\
+			return CompareByTypeSelector<CMP, DEPTH - 1,	\
+						     TYPES..., type>::	\
+				select(def);
+		TYPED_CMP_CASE(FIELD_TYPE_UNSIGNED)
+		TYPED_CMP_CASE(FIELD_TYPE_STRING)
+		TYPED_CMP_CASE(FIELD_TYPE_INTEGER)
+		TYPED_CMP_CASE(FIELD_TYPE_NUMBER)
+		TYPED_CMP_CASE(FIELD_TYPE_SCALAR)
+#undef TYPED_CMP_CASE
+		default:
+			return NULL;
+		}
+	}
+};
+
+template <template <int...> class CMP, int ...TYPES>
+struct CompareByTypeSelector<CMP, 0, TYPES...>
+{
+	static decltype(&CMP<>::compare) select(const struct key_def *def)
+	{
+		if (sizeof...(TYPES) == def->part_count)
+			return CMP<TYPES...>::compare;
+		return NULL;
+	}
+};
+
+} /* end of anonymous namespace */
+
+/**
+ * Return a comparator specialized by part types of a key
+ * definition or NULL if there's no suitable one.
+ */
+template <template <int...> class CMP>
+static inline decltype(&CMP<>::compare)
+compare_by_type_create(const struct key_def *def)
+{
+	if (def->part_count == 0 || def->part_count > TYPED_CMP_MAX_PARTS)
+		return NULL;
+	return CompareByTypeSelector<CMP, TYPED_CMP_MAX_PARTS>::select(def);
+}
+
 tuple_compare_t
 tuple_compare_create(const struct key_def *def)
 {
+	tuple_compare_t cmp;
 	if (def->is_nullable) {
+		cmp = compare_by_type_create<TupleCompareByType>(def);
+		if (cmp != NULL)
+			return cmp;
 		if (key_def_is_sequential(def)) {
 			if (def->has_optional_parts)
 				return tuple_compare_sequential<true, true>;
@@ -1043,6 +1255,9 @@ tuple_compare_create(const struct key_def *def)
 				return cmp_arr[k].f;
 		}
 	}
+	cmp = compare_by_type_create<TupleCompareByType>(def);
+	if (cmp != NULL)
+		return cmp;
 	if (key_def_is_sequential(def))
 		return tuple_compare_sequential<false, false>;
 	else
@@ -1228,10 +1443,67 @@ static const comparator_with_key_signature cmp_wk_arr[] = {
 
 #undef KEY_COMPARATOR
 
+namespace /* local symbols */ {
+
+template <int ...TYPES> struct PartCompareWithKeyByType { };
+
+template <int TYPE, int ...MORE_TYPES>
+struct PartCompareWithKeyByType<TYPE, MORE_TYPES...>
+{
+	inline static int compare(const struct tuple *tuple, const char *key,
+				  uint32_t part_count, struct key_part *part)
+	{
+		if (part_count == 0)
+			return 0;
+		const char *field;
+		field = tuple_field_by_part_raw(tuple_format(tuple),
+						tuple_data(tuple),
+						tuple_field_map(tuple), part);
+		bool was_null_met;
+		int rc = key_part_compare_by_type<TYPE>(field, key, part,
+							&was_null_met);
+		if (rc != 0 || part_count == 1)
+			return rc;
+		mp_next(&key);
+		return PartCompareWithKeyByType<MORE_TYPES...>::
+			compare(tuple, key, part_count - 1, part + 1);
+	}
+};
+
+template <>
+struct PartCompareWithKeyByType<>
+{
+	inline static int compare(const struct tuple *, const char *,
+				  uint32_t, struct key_part *)
+	{
+		return 0;
+	}
+};
+
+template <int ...TYPES>
+struct TupleCompareWithKeyByType
+{
+	static int compare(const struct tuple *tuple, const char *key,
+			   uint32_t part_count, struct key_def *key_def)
+	{
+		assert(key_def->part_count == sizeof...(TYPES));
+		assert(key != NULL || part_count == 0);
+		assert(part_count <= key_def->part_count);
+		return PartCompareWithKeyByType<TYPES...>::
+			compare(tuple, key, part_count, key_def->parts);
+	}
+};
+
+} /* end of anonymous namespace */
+
 tuple_compare_with_key_t
 tuple_compare_with_key_create(const struct key_def *def)
 {
+	tuple_compare_with_key_t cmp;
 	if (def->is_nullable) {
+		cmp = compare_by_type_create<TupleCompareWithKeyByType>(def);
+		if (cmp != NULL)
+			return cmp;
 		if (key_def_is_sequential(def)) {
 			if (def->has_optional_parts) {
 				return tuple_compare_with_key_sequential<true,
@@ -1266,6 +1538,9 @@ tuple_compare_with_key_create(const struct key_def *def)
 				return cmp_wk_arr[k].f;
 		}
 	}
+	cmp = compare_by_type_create<TupleCompareWithKeyByType>(def);
+	if (cmp != NULL)
+		return cmp;
 	if (key_def_is_sequential(def))
 		return tuple_compare_with_key_sequential<false, false>;
 	else
@@ -1273,3 +1548,268 @@ tuple_compare_with_key_create(const struct key_def *def)
 }
 
 /* }}} tuple_compare_with_key */
+
+/* {{{ tuple_hint */
+
+/**
+ * Max hint value. HINT_NONE is reserved for missing hints.
+ *
+ * A hint function must be monotonic, i.e. a < b must imply
+ * hint(a) <= hint(b). Values that are too big to be encoded
+ * are clamped to HINT_MAX, which is fine, because equal hints
+ * make the caller fall back on comparing fields.
+ *
+ * Nullable fields reserve hint 0 for NULL, which is less than
+ * any other value.
+ */
+static const hint_t HINT_MAX = HINT_NONE - 1;
+
+/** Offset of non-negative values in hints of integers. */
+static const hint_t HINT_INT_BIAS = (hint_t)1 << 63;
+
+static inline hint_t
+field_hint_unsigned(const char *field)
+{
+	assert(mp_typeof(*field) == MP_UINT);
+	uint64_t val = mp_decode_uint(&field);
+	return MIN(val, HINT_MAX);
+}
+
+static inline hint_t
+field_hint_integer(const char *field)
+{
+	uint64_t val;
+	switch (mp_typeof(*field)) {
+	case MP_INT: {
+		int64_t ival = mp_decode_int(&field);
+		if (ival < 0)
+			return (hint_t)ival + HINT_INT_BIAS;
+		val = ival;
+		break;
+	}
+	case MP_UINT:
+		val = mp_decode_uint(&field);
+		break;
+	default:
+		unreachable();
+		return HINT_NONE;
+	}
+	return val < HINT_MAX - HINT_INT_BIAS ?
+	       val + HINT_INT_BIAS : HINT_MAX;
+}
+
+/**
+ * Numbers are converted to double and mapped to integers
+ * so that the order is preserved. Converting an integer to
+ * double may round it, but rounding is monotonic so it can
+ * only make hints of different values equal.
+ */
+static inline hint_t
+field_hint_number(const char *field)
+{
+	double val;
+	switch (mp_typeof(*field)) {
+	case MP_UINT:
+		val = mp_decode_uint(&field);
+		break;
+	case MP_INT:
+		val = mp_decode_int(&field);
+		break;
+	case MP_FLOAT:
+		val = mp_decode_float(&field);
+		break;
+	case MP_DOUBLE:
+		val = mp_decode_double(&field);
+		break;
+	default:
+		unreachable();
+		return HINT_NONE;
+	}
+	/* NaN is less than any number, see mp_compare_number(). */
+	if (isnan(val))
+		return 0;
+	/* -0.0 and 0.0 are equal, but have different encodings. */
+	if (val == 0)
+		val = 0;
+	uint64_t bits;
+	memcpy(&bits, &val, sizeof(bits));
+	/*
+	 * Flip the sign bit of non-negative numbers so that they
+	 * are greater than negative ones and all bits of negative
+	 * numbers so that greater absolute values go first.
+	 * This never yields 0 or HINT_NONE, because the result
+	 * lies between the encodings of -inf and +inf.
+	 */
+	return (bits & HINT_INT_BIAS) != 0 ? ~bits : bits | HINT_INT_BIAS;
+}
+
+/** Strings are hinted with their first 8 bytes, big-endian. */
+static inline hint_t
+field_hint_string(const char *field)
+{
+	assert(mp_typeof(*field) == MP_STR);
+	uint32_t len;
+	const char *str = mp_decode_str(&field, &len);
+	hint_t hint = 0;
+	for (uint32_t i = 0; i < sizeof(hint); i++) {
+		hint <<= CHAR_BIT;
+		if (i < len)
+			hint |= (unsigned char)str[i];
+	}
+	return MIN(hint, HINT_MAX);
+}
+
+static inline hint_t
+field_hint_boolean(const char *field)
+{
+	assert(mp_typeof(*field) == MP_BOOL);
+	return mp_decode_bool(&field) ? 1 : 0;
+}
+
+template <enum field_type type, bool is_nullable>
+static inline hint_t
+field_hint(const char *field)
+{
+	if (is_nullable) {
+		if (field == NULL || mp_typeof(*field) == MP_NIL)
+			return 0;
+	}
+	hint_t hint;
+	switch (type) {
+	case FIELD_TYPE_UNSIGNED:
+		hint = field_hint_unsigned(field);
+		break;
+	case FIELD_TYPE_INTEGER:
+		hint = field_hint_integer(field);
+		break;
+	case FIELD_TYPE_NUMBER:
+		hint = field_hint_number(field);
+		break;
+	case FIELD_TYPE_STRING:
+		hint = field_hint_string(field);
+		break;
+	case FIELD_TYPE_BOOLEAN:
+		hint = field_hint_boolean(field);
+		break;
+	default:
+		unreachable();
+		return HINT_NONE;
+	}
+	/* Make room for NULL, see HINT_MAX. */
+	if (is_nullable && hint == 0)
+		hint = 1;
+	return hint;
+}
+
+template <enum field_type type, bool is_nullable>
+static hint_t
+tuple_hint_by_type(const struct tuple *tuple, struct key_def *key_def)
+{
+	const char *field = tuple_field_by_part(tuple, key_def->parts);
+	return field_hint<type, is_nullable>(field);
+}
+
+template <enum field_type type, bool is_nullable>
+static hint_t
+key_hint_by_type(const char *key, uint32_t part_count,
+		 struct key_def *key_def)
+{
+	(void)key_def;
+	if (part_count == 0)
+		return HINT_NONE;
+	return field_hint<type, is_nullable>(key);
+}
+
+static hint_t
+tuple_hint_none(const struct tuple *tuple, struct key_def *key_def)
+{
+	(void)tuple;
+	(void)key_def;
+	return HINT_NONE;
+}
+
+static hint_t
+key_hint_none(const char *key, uint32_t part_count, struct key_def *key_def)
+{
+	(void)key;
+	(void)part_count;
+	(void)key_def;
+	return HINT_NONE;
+}
+
+/**
+ * Return true if the first part of the key definition can be
+ * hinted. Strings with a collation aren't, because hints are
+ * built from raw bytes. Scalar fields aren't either, because
+ * they can store values of different types.
+ */
+static bool
+key_def_is_hinted(const struct key_def *def)
+{
+	if (def->part_count == 0)
+		return false;
+	const struct key_part *part = &def->parts[0];
+	switch (part->type) {
+	case FIELD_TYPE_UNSIGNED:
+	case FIELD_TYPE_INTEGER:
+	case FIELD_TYPE_NUMBER:
+	case FIELD_TYPE_BOOLEAN:
+		return true;
+	case FIELD_TYPE_STRING:
+		return part->coll == NULL;
+	default:
+		return false;
+	}
+}
+
+#define HINT_FUNC(func, type, def)					\
+	(key_part_is_nullable(&(def)->parts[0]) ?			\
+	 func<type, true> : func<type, false>)
+
+tuple_hint_t
+tuple_hint_create(const struct key_def *def)
+{
+	if (!key_def_is_hinted(def))
+		return tuple_hint_none;
+	switch (def->parts[0].type) {
+	case FIELD_TYPE_UNSIGNED:
+		return HINT_FUNC(tuple_hint_by_type, FIELD_TYPE_UNSIGNED, def);
+	case FIELD_TYPE_INTEGER:
+		return HINT_FUNC(tuple_hint_by_type, FIELD_TYPE_INTEGER, def);
+	case FIELD_TYPE_NUMBER:
+		return HINT_FUNC(tuple_hint_by_type, FIELD_TYPE_NUMBER, def);
+	case FIELD_TYPE_STRING:
+		return HINT_FUNC(tuple_hint_by_type, FIELD_TYPE_STRING, def);
+	case FIELD_TYPE_BOOLEAN:
+		return HINT_FUNC(tuple_hint_by_type, FIELD_TYPE_BOOLEAN, def);
+	default:
+		unreachable();
+		return tuple_hint_none;
+	}
+}
+
+key_hint_t
+key_hint_create(const struct key_def *def)
+{
+	if (!key_def_is_hinted(def))
+		return key_hint_none;
+	switch (def->parts[0].type) {
+	case FIELD_TYPE_UNSIGNED:
+		return HINT_FUNC(key_hint_by_type, FIELD_TYPE_UNSIGNED, def);
+	case FIELD_TYPE_INTEGER:
+		return HINT_FUNC(key_hint_by_type, FIELD_TYPE_INTEGER, def);
+	case FIELD_TYPE_NUMBER:
+		return HINT_FUNC(key_hint_by_type, FIELD_TYPE_NUMBER, def);
+	case FIELD_TYPE_STRING:
+		return HINT_FUNC(key_hint_by_type, FIELD_TYPE_STRING, def);
+	case FIELD_TYPE_BOOLEAN:
+		return HINT_FUNC(key_hint_by_type, FIELD_TYPE_BOOLEAN, def);
+	default:
+		unreachable();
+		return key_hint_none;
+	}
+}
+
+#undef HINT_FUNC
+
+/* }}} tuple_hint */
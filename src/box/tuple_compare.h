@@ -67,6 +67,22 @@ tuple_compare_create(const struct key_def *key_def);
 tuple_compare_with_key_t
 tuple_compare_with_key_create(const struct key_def *key_def);
 
+/**
+ * Create a function computing comparison hints of tuples
+ * for the key_def, see tuple_hint().
+ *
+ * @param key_def key_definition
+ * @returns a hint function
+ */
+tuple_hint_t
+tuple_hint_create(const struct key_def *key_def);
+
+/**
+ * @copydoc tuple_hint_create()
+ */
+key_hint_t
+key_hint_create(const struct key_def *key_def);
+
 #if defined(__cplusplus)
 } /* extern "C" */
 #endif /* defined(__cplusplus) */
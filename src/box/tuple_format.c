@@ -168,8 +168,23 @@ tuple_format_create(struct tuple_format *format, struct key_def * const *keys,
 		}
 	}
 
+	/*
+	 * Store offsets of every field_map_step-th field so
+	 * that fields of wide tuples can be accessed without
+	 * decoding all preceding fields.
+	 */
+	uint32_t step = format->field_map_step;
+	for (uint32_t i = step; step > 0 && i < format->field_count;
+	     i += step) {
+		struct tuple_field *field = &format->fields[i];
+		if (field->offset_slot == TUPLE_OFFSET_SLOT_NIL)
+			field->offset_slot = --current_slot;
+	}
+
 	assert(format->fields[0].offset_slot == TUPLE_OFFSET_SLOT_NIL);
-	size_t field_map_size = -current_slot * sizeof(uint32_t);
+	size_t field_map_size = -current_slot *
+		(format->is_field_map_compact ? sizeof(uint16_t) :
+						sizeof(uint32_t));
 	if (field_map_size + format->extra_size > UINT16_MAX) {
 		/** tuple->data_offset is 16 bits */
 		diag_set(ClientError, ER_INDEX_FIELD_COUNT_LIMIT,
@@ -289,6 +304,7 @@ tuple_format_delete(struct tuple_format *format)
 struct tuple_format *
 tuple_format_new(struct tuple_format_vtab *vtab, struct key_def * const *keys,
 		 uint16_t key_count, uint16_t extra_size,
+		 uint32_t field_map_step, bool is_field_map_compact,
 		 const struct field_def *space_fields,
 		 uint32_t space_field_count, struct tuple_dictionary *dict)
 {
@@ -299,6 +315,8 @@ tuple_format_new(struct tuple_format_vtab *vtab, struct key_def * const *keys,
 	format->vtab = *vtab;
 	format->engine = NULL;
 	format->extra_size = extra_size;
+	format->field_map_step = field_map_step;
+	format->is_field_map_compact = is_field_map_compact;
 	format->is_temporary = false;
 	if (tuple_format_register(format) < 0) {
 		tuple_format_destroy(format);
@@ -414,7 +432,8 @@ tuple_init_field_map(const struct tuple_format *format, uint32_t *field_map,
 	++field;
 	uint32_t i = 1;
 	uint32_t defined_field_count = MIN(field_count, format->field_count);
-	if (field_count < format->index_field_count) {
+	if (field_count < format->index_field_count ||
+	    (format->field_map_step > 0 && field_count < format->field_count)) {
 		/*
 		 * Nullify field map to be able to detect by 0,
 		 * which key fields are absent in tuple_field().
@@ -429,8 +448,15 @@ tuple_init_field_map(const struct tuple_format *format, uint32_t *field_map,
 					 tuple_field_is_nullable(field)))
 			return -1;
 		if (field->offset_slot != TUPLE_OFFSET_SLOT_NIL) {
-			field_map[field->offset_slot] =
-				(uint32_t) (pos - tuple);
+			uint32_t offset = pos - tuple;
+			if (format->is_field_map_compact &&
+			    offset > UINT16_MAX) {
+				diag_set(ClientError, ER_FIELD_MAP_OFFSET_LIMIT,
+					 i + TUPLE_INDEX_BASE, offset);
+				return -1;
+			}
+			tuple_field_map_set(format, field_map,
+					    field->offset_slot, offset);
 		}
 		mp_next(&pos);
 	}
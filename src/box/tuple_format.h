@@ -99,6 +99,7 @@ struct tuple_field {
 	 * fields without parsing entire mspack. This member
 	 * stores position in the field map of tuple for current
 	 * field. If the field does not participate in indexes
+	 * and isn't picked by tuple_format::field_map_step,
 	 * then it has no offset in field map and INT_MAX is
 	 * stored in this member. Due to specific field map in
 	 * tuple (it is stored before tuple), the positions in
@@ -157,6 +158,18 @@ struct tuple_format {
 	 * \sa struct tuple
 	 */
 	uint16_t field_map_size;
+	/**
+	 * If set, the field map stores 16-bit offsets instead of
+	 * 32-bit ones, so tuples can't be larger than 64 KB.
+	 */
+	bool is_field_map_compact;
+	/**
+	 * If not 0, the field map also stores the offset of each
+	 * field_map_step-th field, so that any field known to the
+	 * format is found by skipping less than field_map_step
+	 * fields, see tuple_field_raw().
+	 */
+	uint32_t field_map_step;
 	/**
 	 * If not set (== 0), any tuple in the space can have any number of
 	 * fields. If set, each tuple must have exactly this number of fields.
@@ -222,6 +235,9 @@ tuple_format_unref(struct tuple_format *format)
  * @param keys Array of key_defs of a space.
  * @param key_count The number of keys in @a keys array.
  * @param extra_size Extra bytes to reserve in tuples metadata.
+ * @param field_map_step Store an offset of each field_map_step-th
+ *                       field in the field map, 0 to disable.
+ * @param is_field_map_compact Store 16-bit offsets in the field map.
  * @param space_fields Array of fields, defined in a space format.
  * @param space_field_count Length of @a space_fields.
  *
@@ -231,6 +247,7 @@ tuple_format_unref(struct tuple_format *format)
 struct tuple_format *
 tuple_format_new(struct tuple_format_vtab *vtab, struct key_def * const *keys,
 		 uint16_t key_count, uint16_t extra_size,
+		 uint32_t field_map_step, bool is_field_map_compact,
 		 const struct field_def *space_fields,
 		 uint32_t space_field_count, struct tuple_dictionary *dict);
 
@@ -340,6 +357,76 @@ int
 tuple_init_field_map(const struct tuple_format *format, uint32_t *field_map,
 		     const char *tuple);
 
+/**
+ * Get the offset stored in a field map slot.
+ * @param format tuple format
+ * @param field_map a pointer to the LAST element of field map
+ * @param offset_slot slot of the field, see tuple_field
+ *
+ * @returns offset of the field from the beginning of MessagePack
+ *          data or 0 if the tuple doesn't have the field.
+ */
+static inline uint32_t
+tuple_field_map_get(const struct tuple_format *format,
+		    const uint32_t *field_map, int32_t offset_slot)
+{
+	assert(offset_slot < 0);
+	if (format->is_field_map_compact)
+		return ((const uint16_t *)field_map)[offset_slot];
+	return field_map[offset_slot];
+}
+
+/**
+ * Store an offset in a field map slot.
+ * @param format tuple format
+ * @param field_map a pointer to the LAST element of field map
+ * @param offset_slot slot of the field, see tuple_field
+ * @param offset offset of the field from the beginning of
+ *               MessagePack data
+ */
+static inline void
+tuple_field_map_set(const struct tuple_format *format, uint32_t *field_map,
+		    int32_t offset_slot, uint32_t offset)
+{
+	assert(offset_slot < 0);
+	if (format->is_field_map_compact) {
+		assert(offset <= UINT16_MAX);
+		((uint16_t *)field_map)[offset_slot] = offset;
+	} else {
+		field_map[offset_slot] = offset;
+	}
+}
+
+/**
+ * Get a field, which doesn't have an offset slot, by skipping
+ * fields starting from the closest preceding field, which has
+ * an offset slot due to format->field_map_step.
+ * @sa tuple_field_raw()
+ */
+static inline const char *
+tuple_field_raw_by_step(const struct tuple_format *format, const char *tuple,
+			const uint32_t *field_map, uint32_t field_no)
+{
+	assert(format->field_map_step != 0);
+	assert(field_no < format->field_count);
+	const char *field = tuple;
+	uint32_t field_count = mp_decode_array(&field);
+	if (unlikely(field_no >= field_count))
+		return NULL;
+	uint32_t anchor = field_no - field_no % format->field_map_step;
+	if (anchor > 0) {
+		int32_t offset_slot = format->fields[anchor].offset_slot;
+		assert(offset_slot != TUPLE_OFFSET_SLOT_NIL);
+		uint32_t offset = tuple_field_map_get(format, field_map,
+						      offset_slot);
+		assert(offset != 0);
+		field = tuple + offset;
+	}
+	for (uint32_t k = anchor; k < field_no; k++)
+		mp_next(&field);
+	return field;
+}
+
 /**
  * Get a field at the specific position in this MessagePack array.
  * Returns a pointer to MessagePack data.
@@ -355,8 +442,8 @@ static inline const char *
 tuple_field_raw(const struct tuple_format *format, const char *tuple,
 		const uint32_t *field_map, uint32_t field_no)
 {
-	if (likely(field_no < format->index_field_count)) {
-		/* Indexed field */
+	if (likely(field_no < format->field_count)) {
+		/* Field known to the format */
 
 		if (field_no == 0) {
 			mp_decode_array(&tuple);
@@ -365,11 +452,18 @@ tuple_field_raw(const struct tuple_format *format, const char *tuple,
 
 		int32_t offset_slot = format->fields[field_no].offset_slot;
 		if (offset_slot != TUPLE_OFFSET_SLOT_NIL) {
-			if (field_map[offset_slot] != 0)
-				return tuple + field_map[offset_slot];
+			uint32_t offset = tuple_field_map_get(format, field_map,
+							      offset_slot);
+			if (offset != 0)
+				return tuple + offset;
 			else
 				return NULL;
 		}
+		if (format->field_map_step != 0) {
+			ERROR_INJECT(ERRINJ_TUPLE_FIELD, return NULL);
+			return tuple_field_raw_by_step(format, tuple,
+						       field_map, field_no);
+		}
 	}
 	ERROR_INJECT(ERRINJ_TUPLE_FIELD, return NULL);
 	uint32_t field_count = mp_decode_array(&tuple);
@@ -32,6 +32,12 @@
 #include "tuple_hash.h"
 #include "third_party/PMurHash.h"
 #include "coll.h"
+#include "trivia/config.h"
+#include <cpu_feature.h>
+
+#if defined(HAVE_CPUID) && (defined (__x86_64__) || defined (__i386__))
+#define TUPLE_HASH_HW 1
+#endif
 
 /* Tuple and key hasher */
 namespace {
@@ -40,9 +46,64 @@ enum {
 	HASH_SEED = 13U
 };
 
-template <int TYPE>
-static inline uint32_t
-field_hash(uint32_t *ph, uint32_t *pcarry, const char **field)
+/**
+ * Incremental MurmurHash3 hasher. Its results don't depend
+ * on the CPU, so it is used for hashes stored on disk.
+ */
+struct MurHasher {
+	uint32_t h;
+	uint32_t carry;
+	uint32_t total_size;
+
+	MurHasher() : h(HASH_SEED), carry(0), total_size(0) {}
+
+	inline void process(const char *data, uint32_t size)
+	{
+		PMurHash32_Process(&h, &carry, data, size);
+		total_size += size;
+	}
+
+	inline uint32_t result()
+	{
+		return PMurHash32_Result(h, carry, total_size);
+	}
+};
+
+#if defined(TUPLE_HASH_HW)
+/**
+ * Hasher computing CRC32C with SSE 4.2 instructions, which
+ * process 8 bytes per instruction. CRC is a linear function,
+ * so the result is finalized with MurmurHash3 avalanche mix
+ * to make all bits depend on the input.
+ */
+struct Crc32Hasher {
+	uint32_t crc;
+	uint32_t total_size;
+
+	Crc32Hasher() : crc(HASH_SEED), total_size(0) {}
+
+	inline void process(const char *data, uint32_t size)
+	{
+		crc = crc32c_hw(crc, data, size);
+		total_size += size;
+	}
+
+	inline uint32_t result()
+	{
+		uint32_t h = crc ^ total_size;
+		h ^= h >> 16;
+		h *= 0x85ebca6b;
+		h ^= h >> 13;
+		h *= 0xc2b2ae35;
+		h ^= h >> 16;
+		return h;
+	}
+};
+#endif /* defined(TUPLE_HASH_HW) */
+
+template <class HASHER, int TYPE>
+static inline void
+field_hash(HASHER *hasher, const char **field)
 {
 	/*
 	* (!) All fields, except TYPE_STRING hashed **including** MsgPack format
@@ -54,140 +115,116 @@ field_hash(uint32_t *ph, uint32_t *pcarry, const char **field)
 	*/
 	const char *f = *field;
 	uint32_t size;
-	mp_next(field);
-	size = *field - f;  /* calculate the size of field */
-	assert(size < INT32_MAX);
-	PMurHash32_Process(ph, pcarry, f, size);
-	return size;
-}
-
-template <>
-inline uint32_t
-field_hash<FIELD_TYPE_STRING>(uint32_t *ph, uint32_t *pcarry,
-			      const char **pfield)
-{
-	/*
-	* (!) MP_STR fields hashed **excluding** MsgPack format
-	* indentifier. We have to do that to keep compatibility
-	* with old third-party MsgPack (spec-old.md) implementations.
-	* \sa https://github.com/tarantool/tarantool/issues/522
-	*/
-	uint32_t size;
-	const char *f = mp_decode_str(pfield, &size);
+	if (TYPE == FIELD_TYPE_STRING) {
+		/*
+		* (!) MP_STR fields hashed **excluding** MsgPack format
+		* indentifier. We have to do that to keep compatibility
+		* with old third-party MsgPack (spec-old.md) implementations.
+		* \sa https://github.com/tarantool/tarantool/issues/522
+		*/
+		f = mp_decode_str(field, &size);
+	} else {
+		mp_next(field);
+		size = *field - f;  /* calculate the size of field */
+	}
 	assert(size < INT32_MAX);
-	PMurHash32_Process(ph, pcarry, f, size);
-	return size;
+	hasher->process(f, size);
 }
 
-template <int TYPE, int ...MORE_TYPES> struct KeyFieldHash {};
+template <class HASHER, int TYPE, int ...MORE_TYPES> struct KeyFieldHash {};
 
-template <int TYPE, int TYPE2, int ...MORE_TYPES>
-struct KeyFieldHash<TYPE, TYPE2, MORE_TYPES...> {
-	static void hash(uint32_t *ph, uint32_t *pcarry,
-			 const char **pfield, uint32_t *ptotal_size)
+template <class HASHER, int TYPE, int TYPE2, int ...MORE_TYPES>
+struct KeyFieldHash<HASHER, TYPE, TYPE2, MORE_TYPES...> {
+	static void hash(HASHER *hasher, const char **pfield)
 	{
-		*ptotal_size += field_hash<TYPE>(ph, pcarry, pfield);
-		KeyFieldHash<TYPE2, MORE_TYPES...>::
-			hash(ph, pcarry, pfield, ptotal_size);
+		field_hash<HASHER, TYPE>(hasher, pfield);
+		KeyFieldHash<HASHER, TYPE2, MORE_TYPES...>::
+			hash(hasher, pfield);
 	}
 };
 
-template <int TYPE>
-struct KeyFieldHash<TYPE> {
-	static void hash(uint32_t *ph, uint32_t *pcarry,
-			 const char **pfield, uint32_t *ptotal_size)
+template <class HASHER, int TYPE>
+struct KeyFieldHash<HASHER, TYPE> {
+	static void hash(HASHER *hasher, const char **pfield)
 	{
-		*ptotal_size += field_hash<TYPE>(ph, pcarry, pfield);
+		field_hash<HASHER, TYPE>(hasher, pfield);
 	}
 };
 
-template <int TYPE, int ...MORE_TYPES>
+static inline uint32_t
+unsigned_hash(uint64_t val)
+{
+	if (likely(val <= UINT32_MAX))
+		return val;
+	return ((uint32_t)((val)>>33^(val)^(val)<<11));
+}
+
+template <class HASHER, int TYPE, int ...MORE_TYPES>
 struct KeyHash {
 	static uint32_t hash(const char *key, struct key_def *)
 	{
-		uint32_t h = HASH_SEED;
-		uint32_t carry = 0;
-		uint32_t total_size = 0;
-		KeyFieldHash<TYPE, MORE_TYPES...>::hash(&h, &carry, &key,
-							&total_size);
-		return PMurHash32_Result(h, carry, total_size);
+		HASHER hasher;
+		KeyFieldHash<HASHER, TYPE, MORE_TYPES...>::hash(&hasher, &key);
+		return hasher.result();
 	}
 };
 
-template <>
-struct KeyHash<FIELD_TYPE_UNSIGNED> {
+template <class HASHER>
+struct KeyHash<HASHER, FIELD_TYPE_UNSIGNED> {
 	static uint32_t hash(const char *key, struct key_def *key_def)
 	{
-		uint64_t val = mp_decode_uint(&key);
 		(void) key_def;
-		if (likely(val <= UINT32_MAX))
-			return val;
-		return ((uint32_t)((val)>>33^(val)^(val)<<11));
+		return unsigned_hash(mp_decode_uint(&key));
 	}
 };
 
-template <int TYPE, int ...MORE_TYPES> struct TupleFieldHash { };
-
-template <int TYPE, int TYPE2, int ...MORE_TYPES>
-struct TupleFieldHash<TYPE, TYPE2, MORE_TYPES...> {
-	static void hash(const char **pfield, uint32_t *ph, uint32_t *pcarry,
-			 uint32_t *ptotal_size)
-	{
-		*ptotal_size += field_hash<TYPE>(ph, pcarry, pfield);
-		TupleFieldHash<TYPE2, MORE_TYPES...>::
-			hash(pfield, ph, pcarry, ptotal_size);
-	}
-};
-
-template <int TYPE>
-struct TupleFieldHash<TYPE> {
-	static void hash(const char **pfield, uint32_t *ph, uint32_t *pcarry,
-			 uint32_t *ptotal_size)
-	{
-		*ptotal_size += field_hash<TYPE>(ph, pcarry, pfield);
-	}
-};
-
-template <int TYPE, int ...MORE_TYPES>
+template <class HASHER, int TYPE, int ...MORE_TYPES>
 struct TupleHash
 {
 	static uint32_t hash(const struct tuple *tuple,
 			     struct key_def *key_def)
 	{
-		uint32_t h = HASH_SEED;
-		uint32_t carry = 0;
-		uint32_t total_size = 0;
+		HASHER hasher;
 		const char *field =
 			tuple_field_by_part(tuple, key_def->parts);
-		TupleFieldHash<TYPE, MORE_TYPES...>::
-			hash(&field, &h, &carry, &total_size);
-		return PMurHash32_Result(h, carry, total_size);
+		KeyFieldHash<HASHER, TYPE, MORE_TYPES...>::
+			hash(&hasher, &field);
+		return hasher.result();
 	}
 };
 
-template <>
-struct TupleHash<FIELD_TYPE_UNSIGNED> {
+template <class HASHER>
+struct TupleHash<HASHER, FIELD_TYPE_UNSIGNED> {
 	static uint32_t	hash(const struct tuple *tuple,
 			     struct key_def *key_def)
 	{
 		const char *field =
 			tuple_field_by_part(tuple, key_def->parts);
-		uint64_t val = mp_decode_uint(&field);
-		if (likely(val <= UINT32_MAX))
-			return val;
-		return ((uint32_t)((val)>>33^(val)^(val)<<11));
+		return unsigned_hash(mp_decode_uint(&field));
 	}
 };
 
 }; /* namespace { */
 
 #define HASHER(...) \
-	{ KeyHash<__VA_ARGS__>::hash, TupleHash<__VA_ARGS__>::hash, \
-		{ __VA_ARGS__, UINT32_MAX } },
+	{ KeyHash<MurHasher, __VA_ARGS__>::hash, \
+	  TupleHash<MurHasher, __VA_ARGS__>::hash, \
+	  HASHER_HW(__VA_ARGS__) { __VA_ARGS__, UINT32_MAX } },
+
+#if defined(TUPLE_HASH_HW)
+#define HASHER_HW(...) \
+	KeyHash<Crc32Hasher, __VA_ARGS__>::hash, \
+	TupleHash<Crc32Hasher, __VA_ARGS__>::hash,
+#else
+#define HASHER_HW(...) NULL, NULL,
+#endif
 
 struct hasher_signature {
 	key_hash_t kf;
 	tuple_hash_t tf;
+	/** Hardware accelerated hashers or NULL. */
+	key_hash_t kf_hw;
+	tuple_hash_t tf_hw;
 	uint32_t p[64];
 };
 
@@ -211,8 +248,23 @@ static const hasher_signature hash_arr[] = {
 	HASHER(FIELD_TYPE_STRING  , FIELD_TYPE_STRING  , FIELD_TYPE_STRING)
 };
 
+#undef HASHER_HW
 #undef HASHER
 
+/**
+ * Set if hashers computing CRC32C in hardware are used,
+ * see tuple_hash_init().
+ */
+static bool tuple_hash_hw_enabled = false;
+
+void
+tuple_hash_init(void)
+{
+#if defined(TUPLE_HASH_HW)
+	tuple_hash_hw_enabled = sse42_enabled_cpu();
+#endif
+}
+
 template <bool has_optional_parts>
 uint32_t
 tuple_hash_slowpath(const struct tuple *tuple, struct key_def *key_def);
@@ -249,8 +301,15 @@ tuple_hash_func_set(struct key_def *key_def) {
 			}
 		}
 		if (i == key_def->part_count && hash_arr[k].p[i] == UINT32_MAX){
-			key_def->tuple_hash = hash_arr[k].tf;
-			key_def->key_hash = hash_arr[k].kf;
+			key_def->tuple_hash_stable = hash_arr[k].tf;
+			key_def->key_hash_stable = hash_arr[k].kf;
+			if (tuple_hash_hw_enabled) {
+				key_def->tuple_hash = hash_arr[k].tf_hw;
+				key_def->key_hash = hash_arr[k].kf_hw;
+			} else {
+				key_def->tuple_hash = hash_arr[k].tf;
+				key_def->key_hash = hash_arr[k].kf;
+			}
 			return;
 		}
 	}
@@ -261,6 +320,8 @@ slowpath:
 	else
 		key_def->tuple_hash = tuple_hash_slowpath<false>;
 	key_def->key_hash = key_hash_slowpath;
+	key_def->tuple_hash_stable = key_def->tuple_hash;
+	key_def->key_hash_stable = key_def->key_hash;
 }
 
 uint32_t
@@ -37,6 +37,13 @@
 extern "C" {
 #endif /* defined(__cplusplus) */
 
+/**
+ * Select hash functions suitable for the CPU. Must be called
+ * before any key definition is created.
+ */
+void
+tuple_hash_init(void);
+
 /**
  * Initialize tuple_hash() and key_hash() function for the key_def
  * @param key_def key definition
@@ -97,6 +104,33 @@ key_hash(const char *key, struct key_def *key_def)
 	return key_def->key_hash(key, key_def);
 }
 
+/**
+ * Calculate a hash value for a tuple, which doesn't depend on
+ * the CPU the code runs on, unlike tuple_hash(), which may use
+ * hardware accelerated hashing. Use it for hashes stored on disk.
+ * @param tuple - a tuple
+ * @param key_def - key_def for field description
+ * @return - hash value
+ */
+static inline uint32_t
+tuple_hash_stable(const struct tuple *tuple, struct key_def *key_def)
+{
+	return key_def->tuple_hash_stable(tuple, key_def);
+}
+
+/**
+ * Calculate a hash value for a key, which doesn't depend on
+ * the CPU, see tuple_hash_stable().
+ * @param key - full key (msgpack fields w/o array marker)
+ * @param key_def - key_def for field description
+ * @return - hash value
+ */
+static inline uint32_t
+key_hash_stable(const char *key, struct key_def *key_def)
+{
+	return key_def->key_hash_stable(key, key_def);
+}
+
 #if defined(__cplusplus)
 } /* extern "C" */
 #endif /* defined(__cplusplus) */
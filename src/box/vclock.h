@@ -170,6 +170,23 @@ vclock_inc(struct vclock *vclock, uint32_t replica_id)
 	return ++vclock->lsn[replica_id];
 }
 
+/**
+ * Set the LSN of the given replica, which may be less
+ * than the current one.
+ */
+static inline void
+vclock_reset(struct vclock *vclock, uint32_t replica_id, int64_t lsn)
+{
+	assert(lsn >= 0);
+	assert(replica_id < VCLOCK_MAX);
+	vclock->signature += lsn - vclock->lsn[replica_id];
+	if (lsn == 0)
+		vclock->map &= ~(1 << replica_id);
+	else
+		vclock->map |= 1 << replica_id;
+	vclock->lsn[replica_id] = lsn;
+}
+
 static inline void
 vclock_copy(struct vclock *dst, const struct vclock *src)
 {
@@ -267,6 +284,21 @@ vclock_compare(const struct vclock *a, const struct vclock *b)
 	return 0;
 }
 
+/**
+ * Advance each component of \a dst to the corresponding
+ * component of \a src if the latter is greater.
+ */
+static inline void
+vclock_merge_max(struct vclock *dst, const struct vclock *src)
+{
+	struct vclock_iterator it;
+	vclock_iterator_init(&it, src);
+	vclock_foreach(&it, replica) {
+		if (replica.lsn > vclock_get(dst, replica.id))
+			vclock_follow(dst, replica.id, replica.lsn);
+	}
+}
+
 /**
  * @brief vclockset - a set of vclocks
  */
@@ -72,7 +72,7 @@
 #include "trigger.h"
 #include "checkpoint.h"
 #include "session.h"
-#include "wal.h" /* wal_mode() */
+#include "wal.h" /* wal_mode(), wal_stripe_count() */
 
 /**
  * Yield after iterating over this many objects (e.g. ranges).
@@ -254,6 +254,12 @@ vy_info_append_regulator(struct vy_env *env, struct info_handler *h)
 	info_append_int(h, "write_rate", r->write_rate);
 	info_append_int(h, "dump_bandwidth", r->dump_bandwidth);
 	info_append_int(h, "dump_watermark", r->dump_watermark);
+	info_append_int(h, "compaction_rate", r->compaction_rate);
+	info_append_int(h, "compaction_debt", r->compaction_debt);
+	/* 0 means that transactions aren't throttled. */
+	info_append_int(h, "rate_limit",
+			r->rate_limit != SIZE_MAX ? r->rate_limit : 0);
+	info_append_double(h, "throttle_time", env->quota.throttle_time);
 	info_table_end(h); /* regulator */
 }
 
@@ -281,6 +287,22 @@ vy_info_append_tx(struct vy_env *env, struct info_handler *h)
 	info_table_end(h); /* tx */
 }
 
+/** Size of memory used by page indexes of all runs. */
+static size_t
+vy_env_page_index_mem_used(struct vy_env *env)
+{
+	return env->lsm_env.page_index_size -
+	       env->run_env.index_cache.page_index_evicted;
+}
+
+/** Size of memory used by bloom filters of all runs. */
+static size_t
+vy_env_bloom_mem_used(struct vy_env *env)
+{
+	return env->lsm_env.bloom_size -
+	       env->run_env.index_cache.bloom_evicted;
+}
+
 static void
 vy_info_append_memory(struct vy_env *env, struct info_handler *h)
 {
@@ -288,11 +310,35 @@ vy_info_append_memory(struct vy_env *env, struct info_handler *h)
 	info_append_int(h, "tx", tx_manager_mem_used(env->xm));
 	info_append_int(h, "level0", lsregion_used(&env->mem_env.allocator));
 	info_append_int(h, "tuple_cache", env->cache_env.mem_used);
-	info_append_int(h, "page_index", env->lsm_env.page_index_size);
-	info_append_int(h, "bloom_filter", env->lsm_env.bloom_size);
+	info_append_int(h, "page_cache", env->run_env.page_cache.mem_used);
+	info_append_int(h, "page_index", vy_env_page_index_mem_used(env));
+	info_append_int(h, "bloom_filter", vy_env_bloom_mem_used(env));
 	info_table_end(h); /* memory */
 }
 
+static void
+vy_info_append_page_cache(struct vy_env *env, struct info_handler *h)
+{
+	struct vy_page_cache *cache = &env->run_env.page_cache;
+
+	info_table_begin(h, "page_cache");
+	info_append_int(h, "hit", cache->hit);
+	info_append_int(h, "miss", cache->miss);
+	info_append_int(h, "evict", cache->evict);
+	info_table_end(h); /* page_cache */
+}
+
+static void
+vy_info_append_run_index(struct vy_env *env, struct info_handler *h)
+{
+	struct vy_run_index_cache *cache = &env->run_env.index_cache;
+
+	info_table_begin(h, "run_index");
+	info_append_int(h, "load", cache->load);
+	info_append_int(h, "evict", cache->evict);
+	info_table_end(h); /* run_index */
+}
+
 static void
 vy_info_append_disk(struct vy_env *env, struct info_handler *h)
 {
@@ -326,6 +372,8 @@ vinyl_engine_stat(struct vinyl_engine *vinyl, struct info_handler *h)
 	vy_info_append_tx(env, h);
 	vy_info_append_memory(env, h);
 	vy_info_append_disk(env, h);
+	vy_info_append_page_cache(env, h);
+	vy_info_append_run_index(env, h);
 	vy_info_append_regulator(env, h);
 	info_end(h);
 }
@@ -406,6 +454,10 @@ vinyl_index_stat(struct index *index, struct info_handler *h)
 	info_append_int(h, "hit", stat->disk.iterator.bloom_hit);
 	info_append_int(h, "miss", stat->disk.iterator.bloom_miss);
 	info_table_end(h); /* bloom */
+	info_table_begin(h, "readahead");
+	info_append_int(h, "useful", stat->disk.iterator.readahead.useful);
+	info_append_int(h, "wasted", stat->disk.iterator.readahead.wasted);
+	info_table_end(h); /* readahead */
 	info_table_end(h); /* iterator */
 	info_table_begin(h, "dump");
 	info_append_int(h, "count", stat->disk.dump.count);
@@ -420,6 +472,19 @@ vinyl_index_stat(struct index *index, struct info_handler *h)
 	info_table_end(h); /* compact */
 	info_append_int(h, "index_size", lsm->page_index_size);
 	info_append_int(h, "bloom_size", lsm->bloom_size);
+	int blob_count = 0;
+	uint64_t blob_bytes = 0, blob_garbage = 0;
+	struct vy_blob *blob;
+	rlist_foreach_entry(blob, &lsm->blobs, in_lsm) {
+		blob_count++;
+		blob_bytes += blob->size;
+		blob_garbage += vy_blob_garbage(blob);
+	}
+	info_table_begin(h, "blob");
+	info_append_int(h, "count", blob_count);
+	info_append_int(h, "bytes", blob_bytes);
+	info_append_int(h, "garbage", blob_garbage);
+	info_table_end(h); /* blob */
 	info_table_end(h); /* disk */
 
 	info_table_begin(h, "cache");
@@ -447,6 +512,12 @@ vinyl_index_stat(struct index *index, struct info_handler *h)
 	histogram_snprint(buf, sizeof(buf), lsm->run_hist);
 	info_append_str(h, "run_histogram", buf);
 
+	info_table_begin(h, "amplification");
+	info_append_double(h, "write", vy_lsm_write_amplification(lsm));
+	info_append_double(h, "read", vy_lsm_read_amplification(lsm));
+	info_append_double(h, "space", vy_lsm_space_amplification(lsm));
+	info_table_end(h); /* amplification */
+
 	info_end(h);
 }
 
@@ -495,9 +566,10 @@ vinyl_engine_memory_stat(struct engine *engine, struct engine_memory_stat *stat)
 	stat->data += lsregion_used(&env->mem_env.allocator) -
 				env->mem_env.tree_extent_size;
 	stat->index += env->mem_env.tree_extent_size;
-	stat->index += env->lsm_env.bloom_size;
-	stat->index += env->lsm_env.page_index_size;
+	stat->index += vy_env_bloom_mem_used(env);
+	stat->index += vy_env_page_index_mem_used(env);
 	stat->cache += env->cache_env.mem_used;
+	stat->cache += env->run_env.page_cache.mem_used;
 	stat->tx += tx_manager_mem_used(env->xm);
 }
 
@@ -514,6 +586,12 @@ vinyl_engine_reset_stat(struct engine *engine)
 	disk_stat->dump.out = 0;
 	disk_stat->compact.in = 0;
 	disk_stat->compact.out = 0;
+
+	struct vy_page_cache *page_cache = &env->run_env.page_cache;
+	page_cache->hit = page_cache->miss = page_cache->evict = 0;
+
+	struct vy_run_index_cache *index_cache = &env->run_env.index_cache;
+	index_cache->load = index_cache->evict = 0;
 }
 
 /** }}} Introspection */
@@ -574,6 +652,11 @@ vinyl_engine_check_space_def(struct space_def *def)
 			 def->name, "engine does not support temporary flag");
 		return -1;
 	}
+	if (def->opts.compact_field_map) {
+		diag_set(ClientError, ER_ALTER_SPACE, def->name,
+			 "engine does not support compact_field_map");
+		return -1;
+	}
 	return 0;
 }
 
@@ -581,6 +664,16 @@ static struct space *
 vinyl_engine_create_space(struct engine *engine, struct space_def *def,
 			  struct rlist *key_list)
 {
+	/*
+	 * Vinyl relies on the transaction signature being
+	 * monotonic, which isn't true if transactions are
+	 * written by several WAL threads.
+	 */
+	if (wal_stripe_count() > 1) {
+		diag_set(ClientError, ER_UNSUPPORTED, "Vinyl",
+			 "striped WAL");
+		return NULL;
+	}
 	struct space *space = malloc(sizeof(*space));
 	if (space == NULL) {
 		diag_set(OutOfMemory, sizeof(*space),
@@ -605,6 +698,7 @@ vinyl_engine_create_space(struct engine *engine, struct space_def *def,
 
 	struct tuple_format *format =
 		tuple_format_new(&vy_tuple_format_vtab, keys, key_count, 0,
+				 def->opts.field_map_step, false,
 				 def->fields, def->field_count, def->dict);
 	if (format == NULL) {
 		free(space);
@@ -676,6 +770,26 @@ vinyl_space_check_index_def(struct space *space, struct index_def *index_def)
 			return -1;
 		}
 	}
+	if (index_def->opts.expire_field > 0 && index_def->iid != 0) {
+		diag_set(ClientError, ER_MODIFY_INDEX,
+			 index_def->name, space_name(space),
+			 "expire_field is only supported by the primary index");
+		return -1;
+	}
+	if (index_def->opts.blob_threshold > 0 && index_def->iid != 0) {
+		diag_set(ClientError, ER_MODIFY_INDEX,
+			 index_def->name, space_name(space),
+			 "blob_threshold is only supported by the primary index");
+		return -1;
+	}
+	if (index_def->opts.blob_threshold > 0 &&
+	    index_def->opts.blob_threshold < VY_BLOB_REF_SIZE) {
+		diag_set(ClientError, ER_MODIFY_INDEX,
+			 index_def->name, space_name(space),
+			 tt_sprintf("blob_threshold must be at least %d",
+				    VY_BLOB_REF_SIZE));
+		return -1;
+	}
 	return 0;
 }
 
@@ -1049,6 +1163,33 @@ vy_check_format_on_replace(struct trigger *trigger, void *event)
 	}
 }
 
+/**
+ * Values of fields of type 'any' may be replaced with references
+ * to blob files on disk (see vy_blob.h), which don't conform to
+ * any other type. So if the primary index has blob files, a new
+ * format must not assign a type to a field of type 'any'.
+ */
+static int
+vy_check_blob_fields(struct space *space, struct tuple_format *format)
+{
+	struct vy_lsm *pk = vy_lsm(space->index[0]);
+	if (rlist_empty(&pk->blobs))
+		return 0;
+	struct tuple_format *old_format = pk->mem_format;
+	for (uint32_t i = 0; i < format->field_count; i++) {
+		if (format->fields[i].type == FIELD_TYPE_ANY)
+			continue;
+		if (i < old_format->field_count &&
+		    old_format->fields[i].type != FIELD_TYPE_ANY)
+			continue;
+		diag_set(ClientError, ER_ALTER_SPACE, space_name(space),
+			 tt_sprintf("field %u may store values in blob "
+				    "files and can't be typed", i + 1));
+		return -1;
+	}
+	return 0;
+}
+
 static int
 vinyl_space_check_format(struct space *space, struct tuple_format *format)
 {
@@ -1065,6 +1206,9 @@ vinyl_space_check_format(struct space *space, struct tuple_format *format)
 	if (space->index_count == 0)
 		return 0; /* space is empty, nothing to do */
 
+	if (vy_check_blob_fields(space, format) != 0)
+		return -1;
+
 	/*
 	 * Iterate over all tuples stored in the given space and
 	 * check each of them for conformity to the new format.
@@ -2511,7 +2655,7 @@ vy_env_new(const char *path, size_t memory,
 
 	vy_quota_create(&e->quota, memory, vy_env_quota_exceeded_cb);
 	vy_regulator_create(&e->regulator, &e->quota,
-			    vy_env_trigger_dump_cb);
+			    &e->lsm_env.disk_stat, vy_env_trigger_dump_cb);
 
 	struct slab_cache *slab_cache = cord_slab_cache();
 	mempool_create(&e->iterator_pool, slab_cache,
@@ -2604,6 +2748,18 @@ vinyl_engine_set_cache(struct vinyl_engine *vinyl, size_t quota)
 	vy_cache_env_set_quota(&vinyl->env->cache_env, quota);
 }
 
+void
+vinyl_engine_set_page_cache(struct vinyl_engine *vinyl, size_t quota)
+{
+	vy_run_env_set_page_cache_quota(&vinyl->env->run_env, quota);
+}
+
+void
+vinyl_engine_set_run_index_cache(struct vinyl_engine *vinyl, size_t quota)
+{
+	vy_run_env_set_index_cache_quota(&vinyl->env->run_env, quota);
+}
+
 int
 vinyl_engine_set_memory(struct vinyl_engine *vinyl, size_t size)
 {
@@ -2623,6 +2779,18 @@ vinyl_engine_set_max_tuple_size(struct vinyl_engine *vinyl, size_t max_size)
 	vy_max_tuple_size = max_size;
 }
 
+void
+vinyl_engine_set_max_subcompactions(struct vinyl_engine *vinyl, int count)
+{
+	vinyl->env->scheduler.max_subcompactions = count;
+}
+
+void
+vinyl_engine_set_readahead(struct vinyl_engine *vinyl, uint32_t pages)
+{
+	vinyl->env->run_env.readahead = pages;
+}
+
 void
 vinyl_engine_set_timeout(struct vinyl_engine *vinyl, double timeout)
 {
@@ -2646,6 +2814,18 @@ vinyl_engine_set_snap_io_rate_limit(struct vinyl_engine *vinyl, double limit)
 					  limit_in_bytes);
 }
 
+void
+vinyl_engine_set_io_uring(struct vinyl_engine *vinyl, bool enable)
+{
+	vinyl->env->run_env.use_io_uring = enable;
+}
+
+void
+vinyl_engine_set_direct_io(struct vinyl_engine *vinyl, bool enable)
+{
+	vinyl->env->run_env.direct_io = enable;
+}
+
 /** }}} Environment */
 
 /* {{{ Checkpoint */
@@ -2861,6 +3041,15 @@ struct vy_join_ctx {
 	 * is to the head of the list.
 	 */
 	struct rlist slices;
+	/**
+	 * Blob files of the LSM tree currently being relayed,
+	 * linked by vy_blob::in_lsm.
+	 */
+	struct rlist blobs;
+	/** The same blob files, sorted by ID. */
+	struct vy_blob **blob_array;
+	/** Number of entries in @blob_array. */
+	uint32_t blob_count;
 };
 
 /**
@@ -2881,6 +3070,8 @@ vy_prepare_send_slice(struct vy_join_ctx *ctx,
 		goto out;
 	if (vy_run_recover(run, ctx->env->path, ctx->space_id, 0) != 0)
 		goto out;
+	if (vy_run_bind_blobs(run, &ctx->blobs, NULL) != 0)
+		goto out;
 
 	if (slice_info->begin != NULL) {
 		begin = vy_key_from_msgpack(ctx->env->lsm_env.key_format,
@@ -2923,9 +3114,21 @@ vy_send_range_f(struct cbus_call_msg *cmsg)
 		goto err;
 	while ((rc = ctx->wi->iface->next(ctx->wi, &stmt)) == 0 &&
 	       stmt != NULL) {
+		struct tuple *resolved = NULL;
+		if ((vy_stmt_flags(stmt) & VY_STMT_BLOB_REF) != 0) {
+			resolved = vy_blob_resolve(stmt, ctx->blob_array,
+						   ctx->blob_count, false);
+			if (resolved == NULL) {
+				rc = -1;
+				break;
+			}
+			stmt = resolved;
+		}
 		struct xrow_header xrow;
 		rc = vy_stmt_encode_primary(stmt, ctx->key_def,
 					    ctx->space_id, &xrow);
+		if (resolved != NULL)
+			tuple_unref(resolved);
 		if (rc != 0)
 			break;
 		/*
@@ -2967,7 +3170,8 @@ vy_send_range(struct vy_join_ctx *ctx,
 	struct rlist fake_read_views;
 	rlist_create(&fake_read_views);
 	ctx->wi = vy_write_iterator_new(ctx->key_def, ctx->format,
-					true, true, &fake_read_views, NULL);
+					true, true, &fake_read_views, NULL,
+					NULL);
 	if (ctx->wi == NULL) {
 		rc = -1;
 		goto out;
@@ -2995,6 +3199,63 @@ out:
 	return rc;
 }
 
+static int
+vy_join_blob_cmp(const void *a, const void *b)
+{
+	const struct vy_blob *blob_a = *(const struct vy_blob **)a;
+	const struct vy_blob *blob_b = *(const struct vy_blob **)b;
+	return blob_a->id < blob_b->id ? -1 : blob_a->id > blob_b->id;
+}
+
+/** Open blob files of the LSM tree to relay. */
+static int
+vy_join_open_blobs(struct vy_join_ctx *ctx,
+		   struct vy_lsm_recovery_info *lsm_info)
+{
+	uint32_t count = 0;
+	struct vy_blob_recovery_info *blob_info;
+	rlist_foreach_entry(blob_info, &lsm_info->blobs, in_lsm) {
+		if (!blob_info->is_dropped)
+			count++;
+	}
+	if (count == 0)
+		return 0;
+	ctx->blob_array = calloc(count, sizeof(*ctx->blob_array));
+	if (ctx->blob_array == NULL) {
+		diag_set(OutOfMemory, count * sizeof(*ctx->blob_array),
+			 "malloc", "struct vy_blob");
+		return -1;
+	}
+	rlist_foreach_entry(blob_info, &lsm_info->blobs, in_lsm) {
+		if (blob_info->is_dropped)
+			continue;
+		struct vy_blob *blob = vy_blob_open(blob_info->id,
+				ctx->env->path, lsm_info->space_id,
+				lsm_info->index_id);
+		if (blob == NULL)
+			return -1;
+		rlist_add_tail_entry(&ctx->blobs, blob, in_lsm);
+		ctx->blob_array[ctx->blob_count++] = blob;
+	}
+	qsort(ctx->blob_array, ctx->blob_count, sizeof(*ctx->blob_array),
+	      vy_join_blob_cmp);
+	return 0;
+}
+
+/** Close blob files opened by vy_join_open_blobs(). */
+static void
+vy_join_close_blobs(struct vy_join_ctx *ctx)
+{
+	struct vy_blob *blob, *tmp;
+	rlist_foreach_entry_safe(blob, &ctx->blobs, in_lsm, tmp) {
+		rlist_del_entry(blob, in_lsm);
+		vy_blob_unref(blob);
+	}
+	free(ctx->blob_array);
+	ctx->blob_array = NULL;
+	ctx->blob_count = 0;
+}
+
 /** Send all tuples stored in the given LSM tree. */
 static int
 vy_send_lsm(struct vy_join_ctx *ctx, struct vy_lsm_recovery_info *lsm_info)
@@ -3025,19 +3286,21 @@ vy_send_lsm(struct vy_join_ctx *ctx, struct vy_lsm_recovery_info *lsm_info)
 	if (ctx->key_def == NULL)
 		goto out;
 	ctx->format = tuple_format_new(&vy_tuple_format_vtab, &ctx->key_def,
-				       1, 0, NULL, 0, NULL);
+				       1, 0, 0, false, NULL, 0, NULL);
 	if (ctx->format == NULL)
 		goto out_free_key_def;
 	tuple_format_ref(ctx->format);
 
 	/* Send ranges. */
+	rc = vy_join_open_blobs(ctx, lsm_info);
 	struct vy_range_recovery_info *range_info;
 	assert(!rlist_empty(&lsm_info->ranges));
 	rlist_foreach_entry(range_info, &lsm_info->ranges, in_lsm) {
-		rc = vy_send_range(ctx, range_info);
 		if (rc != 0)
 			break;
+		rc = vy_send_range(ctx, range_info);
 	}
+	vy_join_close_blobs(ctx);
 
 	tuple_format_unref(ctx->format);
 	ctx->format = NULL;
@@ -3086,6 +3349,7 @@ vinyl_engine_join(struct engine *engine, const struct vclock *vclock,
 	ctx->env = env;
 	ctx->stream = stream;
 	rlist_create(&ctx->slices);
+	rlist_create(&ctx->blobs);
 
 	/* Start the relay cord. */
 	char name[FIBER_NAME_MAX];
@@ -3194,6 +3458,18 @@ vinyl_space_apply_initial_join_row(struct space *space, struct request *request)
 
 /* {{{ Garbage collection */
 
+/** Check if a blob file with the given ID was logged. */
+static bool
+vy_gc_blob_is_logged(struct vy_lsm_recovery_info *lsm_info, int64_t id)
+{
+	struct vy_blob_recovery_info *blob_info;
+	rlist_foreach_entry(blob_info, &lsm_info->blobs, in_lsm) {
+		if (blob_info->id == id)
+			return true;
+	}
+	return false;
+}
+
 /**
  * Given a record encoding information about a vinyl run, try to
  * delete the corresponding files. On success, write a "forget" record
@@ -3209,6 +3485,17 @@ vy_gc_run(struct vy_env *env,
 	if (vy_run_remove_files(env->path, lsm_info->space_id,
 				lsm_info->index_id, run_info->id) != 0)
 		return;
+	/*
+	 * A blob file written along with the run is logged
+	 * in the same transaction as the run. If it wasn't,
+	 * the run was discarded and the file is garbage.
+	 * Otherwise it is deleted by vy_gc_blob() when all
+	 * runs referring to it are dropped.
+	 */
+	if (!vy_gc_blob_is_logged(lsm_info, run_info->id) &&
+	    vy_blob_remove_file(env->path, lsm_info->space_id,
+				lsm_info->index_id, run_info->id) != 0)
+		return;
 
 	/* Forget the run on success. */
 	vy_log_tx_begin();
@@ -3222,6 +3509,23 @@ vy_gc_run(struct vy_env *env,
 	vy_log_tx_try_commit();
 }
 
+/**
+ * Delete a dropped blob file and forget it on success.
+ */
+static void
+vy_gc_blob(struct vy_env *env,
+	   struct vy_lsm_recovery_info *lsm_info,
+	   struct vy_blob_recovery_info *blob_info)
+{
+	if (vy_blob_remove_file(env->path, lsm_info->space_id,
+				lsm_info->index_id, blob_info->id) != 0)
+		return;
+
+	vy_log_tx_begin();
+	vy_log_forget_blob(blob_info->id);
+	vy_log_tx_try_commit();
+}
+
 /**
  * Given a dropped or not fully built LSM tree, delete all its
  * ranges and slices and mark all its runs as dropped. Forget
@@ -3253,8 +3557,17 @@ vy_gc_lsm(struct vy_lsm_recovery_info *lsm_info)
 			vy_log_drop_run(run_info->id, run_info->gc_lsn);
 		}
 	}
+	struct vy_blob_recovery_info *blob_info;
+	rlist_foreach_entry(blob_info, &lsm_info->blobs, in_lsm) {
+		if (!blob_info->is_dropped) {
+			blob_info->is_dropped = true;
+			blob_info->gc_lsn = lsm_info->drop_lsn;
+			vy_log_drop_blob(blob_info->id, blob_info->gc_lsn);
+		}
+	}
 	if (rlist_empty(&lsm_info->ranges) &&
-	    rlist_empty(&lsm_info->runs))
+	    rlist_empty(&lsm_info->runs) &&
+	    rlist_empty(&lsm_info->blobs))
 		vy_log_forget_lsm(lsm_info->id);
 	vy_log_tx_try_commit();
 }
@@ -3291,6 +3604,16 @@ vy_gc(struct vy_env *env, struct vy_recovery *recovery,
 			if (loops % VY_YIELD_LOOPS == 0)
 				fiber_sleep(0);
 		}
+
+		struct vy_blob_recovery_info *blob_info;
+		rlist_foreach_entry(blob_info, &lsm_info->blobs, in_lsm) {
+			if (blob_info->is_dropped &&
+			    ((blob_info->gc_lsn < gc_lsn &&
+			      (gc_mask & VY_GC_DROPPED) != 0) ||
+			     (lsm_info->create_lsn < 0 &&
+			      (gc_mask & VY_GC_INCOMPLETE) != 0)))
+				vy_gc_blob(env, lsm_info, blob_info);
+		}
 	}
 }
 
@@ -3368,6 +3691,19 @@ vinyl_engine_backup(struct engine *engine, const struct vclock *vclock,
 			if (loops % VY_YIELD_LOOPS == 0)
 				fiber_sleep(0);
 		}
+		struct vy_blob_recovery_info *blob_info;
+		rlist_foreach_entry(blob_info, &lsm_info->blobs, in_lsm) {
+			if (blob_info->is_dropped)
+				continue;
+			char path[PATH_MAX];
+			vy_blob_snprint_path(path, sizeof(path), env->path,
+					     lsm_info->space_id,
+					     lsm_info->index_id,
+					     blob_info->id);
+			rc = cb(path, cb_arg);
+			if (rc != 0)
+				goto out;
+		}
 	}
 out:
 	vy_recovery_delete(recovery);
@@ -4127,6 +4463,11 @@ vinyl_space_build_index(struct space *src_space, struct index *new_index,
 		return -1;
 	}
 
+	if (env->status != VINYL_INITIAL_RECOVERY_LOCAL &&
+	    env->status != VINYL_FINAL_RECOVERY_LOCAL &&
+	    vy_check_blob_fields(src_space, new_format) != 0)
+		return -1;
+
 	if (vinyl_index_open(new_index) != 0)
 		return -1;
 
@@ -4308,6 +4649,14 @@ vy_deferred_delete_on_replace(struct trigger *trigger, void *event)
 		diag_raise();
 	const char *delete_data_end = delete_data;
 	mp_next(&delete_data_end);
+	/*
+	 * The row may also store flags of the DELETE statement,
+	 * see vy_deferred_delete_process_one().
+	 */
+	uint32_t flags = 0;
+	if (it.fieldno < tuple_field_count(stmt->new_tuple) &&
+	    tuple_next_u32(&it, &flags) != 0)
+		diag_raise();
 
 	/* Look up the space. */
 	struct space *space = space_cache_find(space_id);
@@ -4346,7 +4695,8 @@ vy_deferred_delete_on_replace(struct trigger *trigger, void *event)
 	 * flag, which makes the read iterator ignore them.
 	 */
 	vy_stmt_set_lsn(delete, lsn);
-	vy_stmt_set_flags(delete, VY_STMT_SKIP_READ);
+	vy_stmt_set_flags(delete, VY_STMT_SKIP_READ |
+			  (flags & VY_STMT_EXPIRED));
 
 	/* Insert the deferred DELETE into secondary indexes. */
 	int rc = 0;
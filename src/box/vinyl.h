@@ -57,6 +57,18 @@ vinyl_engine_stat(struct vinyl_engine *vinyl, struct info_handler *handler);
 void
 vinyl_engine_set_cache(struct vinyl_engine *vinyl, size_t quota);
 
+/**
+ * Update vinyl page cache size.
+ */
+void
+vinyl_engine_set_page_cache(struct vinyl_engine *vinyl, size_t quota);
+
+/**
+ * Update memory limit for run bloom filters and page indexes.
+ */
+void
+vinyl_engine_set_run_index_cache(struct vinyl_engine *vinyl, size_t quota);
+
 /**
  * Update vinyl memory size.
  */
@@ -69,6 +81,18 @@ vinyl_engine_set_memory(struct vinyl_engine *vinyl, size_t size);
 void
 vinyl_engine_set_max_tuple_size(struct vinyl_engine *vinyl, size_t max_size);
 
+/**
+ * Update the max number of parts a compaction task may be split in.
+ */
+void
+vinyl_engine_set_max_subcompactions(struct vinyl_engine *vinyl, int count);
+
+/**
+ * Update the max number of pages read ahead on sequential scans.
+ */
+void
+vinyl_engine_set_readahead(struct vinyl_engine *vinyl, uint32_t pages);
+
 /**
  * Update query timeout.
  */
@@ -88,6 +112,20 @@ vinyl_engine_set_too_long_threshold(struct vinyl_engine *vinyl,
 void
 vinyl_engine_set_snap_io_rate_limit(struct vinyl_engine *vinyl, double limit);
 
+/**
+ * Read run files with io_uring if available. Must be called
+ * before recovery is complete.
+ */
+void
+vinyl_engine_set_io_uring(struct vinyl_engine *vinyl, bool enable);
+
+/**
+ * Read run files with O_DIRECT, bypassing the page cache.
+ * Must be called before recovery is started.
+ */
+void
+vinyl_engine_set_direct_io(struct vinyl_engine *vinyl, bool enable);
+
 #ifdef __cplusplus
 } /* extern "C" */
 
@@ -0,0 +1,532 @@
+/*
+ * Copyright 2010-2018, Tarantool AUTHORS, please see AUTHORS file.
+ *
+ * Redistribution and use in source and binary forms, with or
+ * without modification, are permitted provided that the following
+ * conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above
+ *    copyright notice, this list of conditions and the
+ *    following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials
+ *    provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY AUTHORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * AUTHORS OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+#include "vy_history.h"
+
+#include "vy_blob.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <msgpuck/msgpuck.h>
+#include <small/region.h>
+
+#include "coio_file.h"
+#include "diag.h"
+#include "error.h"
+#include "fiber.h"
+#include "fio.h"
+#include "iproto_constants.h"
+#include "say.h"
+#include "trivia/util.h"
+#include "tuple.h"
+#include "tuple_format.h"
+#include "vy_stmt.h"
+
+enum {
+	/** Size of the buffer used by a blob writer. */
+	VY_BLOB_WRITER_BUF_SIZE = 1024 * 1024,
+};
+
+bool
+vy_blob_ref_decode(const char *data, struct vy_blob_ref *ref)
+{
+	const unsigned char *p = (const unsigned char *)data;
+	if (p[0] != 0xc7 || p[1] != VY_BLOB_REF_DATA_SIZE ||
+	    p[2] != VY_BLOB_REF_EXT_TYPE)
+		return false;
+	data += 3;
+	ref->blob_id = mp_load_u64(&data);
+	ref->offset = mp_load_u64(&data);
+	ref->size = mp_load_u32(&data);
+	return true;
+}
+
+char *
+vy_blob_ref_encode(char *data, const struct vy_blob_ref *ref)
+{
+	*data++ = (char)0xc7;
+	*data++ = VY_BLOB_REF_DATA_SIZE;
+	*data++ = VY_BLOB_REF_EXT_TYPE;
+	data = mp_store_u64(data, ref->blob_id);
+	data = mp_store_u64(data, ref->offset);
+	data = mp_store_u32(data, ref->size);
+	return data;
+}
+
+struct vy_blob *
+vy_blob_open(int64_t id, const char *dir, uint32_t space_id, uint32_t iid)
+{
+	char path[PATH_MAX];
+	vy_blob_snprint_path(path, sizeof(path), dir, space_id, iid, id);
+	struct vy_blob *blob = malloc(sizeof(*blob));
+	if (blob == NULL) {
+		diag_set(OutOfMemory, sizeof(*blob), "malloc",
+			 "struct vy_blob");
+		return NULL;
+	}
+	blob->fd = open(path, O_RDONLY);
+	if (blob->fd < 0) {
+		diag_set(SystemError, "failed to open file '%s'", path);
+		free(blob);
+		return NULL;
+	}
+	struct stat st;
+	if (fstat(blob->fd, &st) < 0) {
+		diag_set(SystemError, "failed to stat file '%s'", path);
+		close(blob->fd);
+		free(blob);
+		return NULL;
+	}
+	blob->id = id;
+	blob->size = st.st_size;
+	blob->used = 0;
+	blob->run_count = 0;
+	blob->refs = 1;
+	rlist_create(&blob->in_lsm);
+	return blob;
+}
+
+void
+vy_blob_unref(struct vy_blob *blob)
+{
+	assert(blob->refs > 0);
+	if (--blob->refs > 0)
+		return;
+	if (close(blob->fd) < 0)
+		say_syserror("close failed");
+	free(blob);
+}
+
+int
+vy_blob_remove_file(const char *dir, uint32_t space_id,
+		    uint32_t iid, int64_t blob_id)
+{
+	char path[PATH_MAX];
+	vy_blob_snprint_path(path, sizeof(path), dir, space_id, iid, blob_id);
+	if (coio_unlink(path) < 0 && errno != ENOENT) {
+		say_syserror("error while removing %s", path);
+		return -1;
+	}
+	return 0;
+}
+
+struct vy_blob *
+vy_blob_find(struct vy_blob **blobs, uint32_t blob_count, int64_t id)
+{
+	uint32_t begin = 0, end = blob_count;
+	while (begin < end) {
+		uint32_t mid = begin + (end - begin) / 2;
+		if (blobs[mid]->id < id)
+			begin = mid + 1;
+		else
+			end = mid;
+	}
+	if (begin < blob_count && blobs[begin]->id == id)
+		return blobs[begin];
+	return NULL;
+}
+
+/**
+ * Read a value referenced by a blob reference to @buf.
+ * Return 0 on success, -1 on failure.
+ */
+static int
+vy_blob_read(struct vy_blob *blob, const struct vy_blob_ref *ref,
+	     char *buf, bool can_yield)
+{
+	ssize_t rc;
+	if (can_yield)
+		rc = coio_preadn(blob->fd, buf, ref->size, ref->offset);
+	else
+		rc = fio_pread(blob->fd, buf, ref->size, ref->offset);
+	if (rc < 0) {
+		diag_set(SystemError, "failed to read from blob file %lld",
+			 (long long)blob->id);
+		return -1;
+	}
+	if (rc != (ssize_t)ref->size) {
+		diag_set(ClientError, ER_INVALID_RUN_FILE,
+			 tt_sprintf("Unexpected end of blob file %lld",
+				    (long long)blob->id));
+		return -1;
+	}
+	return 0;
+}
+
+/** Create a REPLACE or INSERT statement like @stmt from MsgPack. */
+static struct tuple *
+vy_blob_new_stmt(struct tuple *stmt, const char *data, const char *data_end,
+		 bool has_refs)
+{
+	struct tuple_format *format = tuple_format(stmt);
+	struct tuple *new_stmt;
+	if (vy_stmt_type(stmt) == IPROTO_REPLACE)
+		new_stmt = vy_stmt_new_replace(format, data, data_end);
+	else
+		new_stmt = vy_stmt_new_insert(format, data, data_end);
+	if (new_stmt == NULL)
+		return NULL;
+	vy_stmt_set_lsn(new_stmt, vy_stmt_lsn(stmt));
+	uint8_t flags = vy_stmt_flags(stmt);
+	if (has_refs)
+		flags |= VY_STMT_BLOB_REF;
+	else
+		flags &= ~VY_STMT_BLOB_REF;
+	vy_stmt_set_flags(new_stmt, flags);
+	return new_stmt;
+}
+
+struct tuple *
+vy_blob_resolve(struct tuple *stmt, struct vy_blob **blobs,
+		uint32_t blob_count, bool can_yield)
+{
+	assert((vy_stmt_flags(stmt) & VY_STMT_BLOB_REF) != 0);
+	assert(vy_stmt_type(stmt) == IPROTO_REPLACE ||
+	       vy_stmt_type(stmt) == IPROTO_INSERT);
+
+	uint32_t bsize;
+	const char *data = tuple_data_range(stmt, &bsize);
+	const char *field = data;
+	uint32_t field_count = mp_decode_array(&field);
+	const char *fields = field;
+
+	/* Calculate the size of the resolved statement. */
+	size_t size = mp_sizeof_array(field_count);
+	for (uint32_t i = 0; i < field_count; i++) {
+		const char *field_end = field;
+		mp_next(&field_end);
+		struct vy_blob_ref ref;
+		if (vy_blob_ref_decode(field, &ref))
+			size += ref.size;
+		else
+			size += field_end - field;
+		field = field_end;
+	}
+
+	struct region *region = &fiber()->gc;
+	size_t region_svp = region_used(region);
+	char *buf = region_alloc(region, size);
+	if (buf == NULL) {
+		diag_set(OutOfMemory, size, "region", "tuple");
+		return NULL;
+	}
+	char *pos = mp_encode_array(buf, field_count);
+	field = fields;
+	for (uint32_t i = 0; i < field_count; i++) {
+		const char *field_end = field;
+		mp_next(&field_end);
+		struct vy_blob_ref ref;
+		if (!vy_blob_ref_decode(field, &ref)) {
+			memcpy(pos, field, field_end - field);
+			pos += field_end - field;
+			field = field_end;
+			continue;
+		}
+		struct vy_blob *blob = vy_blob_find(blobs, blob_count,
+						    ref.blob_id);
+		if (blob == NULL) {
+			diag_set(ClientError, ER_INVALID_RUN_FILE,
+				 tt_sprintf("Missing blob file %lld",
+					    (long long)ref.blob_id));
+			goto fail;
+		}
+		if (vy_blob_read(blob, &ref, pos, can_yield) != 0)
+			goto fail;
+		pos += ref.size;
+		field = field_end;
+	}
+	assert(pos == buf + size);
+	struct tuple *new_stmt = vy_blob_new_stmt(stmt, buf, pos, false);
+	region_truncate(region, region_svp);
+	return new_stmt;
+fail:
+	region_truncate(region, region_svp);
+	return NULL;
+}
+
+void
+vy_blob_writer_create(struct vy_blob_writer *writer, const char *dir,
+		      uint32_t space_id, uint32_t iid, int64_t id,
+		      uint32_t threshold, struct vy_blob **relocate,
+		      uint32_t relocate_count)
+{
+	vy_blob_snprint_path(writer->path, sizeof(writer->path),
+			     dir, space_id, iid, id);
+	writer->id = id;
+	writer->threshold = threshold;
+	writer->relocate = relocate;
+	writer->relocate_count = relocate_count;
+	writer->fd = -1;
+	writer->size = 0;
+	writer->buf = NULL;
+	writer->buf_used = 0;
+	writer->buf_capacity = 0;
+	writer->blobs = NULL;
+	writer->blob_count = 0;
+	writer->blob_capacity = 0;
+}
+
+/** Write buffered values to the blob file. */
+static int
+vy_blob_writer_flush(struct vy_blob_writer *writer)
+{
+	if (writer->buf_used == 0)
+		return 0;
+	if (fio_writen(writer->fd, writer->buf, writer->buf_used) != 0) {
+		diag_set(SystemError, "failed to write file '%s'",
+			 writer->path);
+		return -1;
+	}
+	writer->buf_used = 0;
+	return 0;
+}
+
+/**
+ * Reserve space for a value of the given size at the end of
+ * the blob file, creating the file if necessary. Return a pointer
+ * to the buffer the value should be copied to and store its
+ * offset in the blob file in @offset. Return NULL on failure.
+ */
+static char *
+vy_blob_writer_reserve(struct vy_blob_writer *writer, size_t size,
+		       uint64_t *offset)
+{
+	if (writer->fd < 0) {
+		writer->fd = open(writer->path,
+				  O_WRONLY | O_CREAT | O_TRUNC, 0644);
+		if (writer->fd < 0) {
+			diag_set(SystemError, "failed to create file '%s'",
+				 writer->path);
+			return NULL;
+		}
+	}
+	if (writer->buf_used + size > writer->buf_capacity) {
+		if (vy_blob_writer_flush(writer) != 0)
+			return NULL;
+	}
+	if (size > writer->buf_capacity) {
+		size_t capacity = MAX(size, (size_t)VY_BLOB_WRITER_BUF_SIZE);
+		char *buf = realloc(writer->buf, capacity);
+		if (buf == NULL) {
+			diag_set(OutOfMemory, capacity, "realloc",
+				 "blob writer buffer");
+			return NULL;
+		}
+		writer->buf = buf;
+		writer->buf_capacity = capacity;
+	}
+	char *pos = writer->buf + writer->buf_used;
+	writer->buf_used += size;
+	*offset = writer->size;
+	writer->size += size;
+	return pos;
+}
+
+/**
+ * Account a value referenced by a written statement in the array
+ * of blob files the run refers to.
+ */
+static int
+vy_blob_writer_account(struct vy_blob_writer *writer,
+		       const struct vy_blob_ref *ref)
+{
+	uint32_t begin = 0, end = writer->blob_count;
+	while (begin < end) {
+		uint32_t mid = begin + (end - begin) / 2;
+		if (writer->blobs[mid].id < ref->blob_id)
+			begin = mid + 1;
+		else
+			end = mid;
+	}
+	if (begin < writer->blob_count &&
+	    writer->blobs[begin].id == ref->blob_id) {
+		writer->blobs[begin].size += ref->size;
+		return 0;
+	}
+	if (writer->blob_count == writer->blob_capacity) {
+		uint32_t capacity = MAX(writer->blob_capacity * 2, 8U);
+		size_t size = capacity * sizeof(*writer->blobs);
+		struct vy_run_blob_info *blobs = realloc(writer->blobs, size);
+		if (blobs == NULL) {
+			diag_set(OutOfMemory, size, "realloc",
+				 "struct vy_run_blob_info");
+			return -1;
+		}
+		writer->blobs = blobs;
+		writer->blob_capacity = capacity;
+	}
+	memmove(writer->blobs + begin + 1, writer->blobs + begin,
+		(writer->blob_count - begin) * sizeof(*writer->blobs));
+	writer->blobs[begin].id = ref->blob_id;
+	writer->blobs[begin].size = ref->size;
+	writer->blob_count++;
+	return 0;
+}
+
+struct tuple *
+vy_blob_writer_process(struct vy_blob_writer *writer, struct tuple *stmt)
+{
+	enum iproto_type type = vy_stmt_type(stmt);
+	if (type != IPROTO_REPLACE && type != IPROTO_INSERT)
+		return stmt;
+	bool has_refs = (vy_stmt_flags(stmt) & VY_STMT_BLOB_REF) != 0;
+	if (!has_refs && writer->threshold == 0)
+		return stmt;
+
+	struct tuple_format *format = tuple_format(stmt);
+	uint32_t bsize;
+	const char *data = tuple_data_range(stmt, &bsize);
+
+	/*
+	 * References are never longer than separated values
+	 * so the new statement fits in the old one's size.
+	 */
+	struct region *region = &fiber()->gc;
+	size_t region_svp = region_used(region);
+	char *buf = region_alloc(region, bsize);
+	if (buf == NULL) {
+		diag_set(OutOfMemory, bsize, "region", "tuple");
+		return NULL;
+	}
+	const char *field = data;
+	uint32_t field_count = mp_decode_array(&field);
+	char *pos = mp_encode_array(buf, field_count);
+	bool is_changed = false;
+	bool has_new_refs = false;
+	for (uint32_t i = 0; i < field_count; i++) {
+		const char *field_end = field;
+		mp_next(&field_end);
+		uint32_t size = field_end - field;
+		/* Only fields of type 'any' may store references. */
+		bool is_separable = (i >= format->field_count ||
+				     format->fields[i].type == FIELD_TYPE_ANY);
+		struct vy_blob_ref ref;
+		bool is_ref = is_separable && vy_blob_ref_decode(field, &ref);
+		if (is_ref && has_refs) {
+			struct vy_blob *blob = vy_blob_find(writer->relocate,
+							    writer->relocate_count,
+							    ref.blob_id);
+			if (blob != NULL) {
+				/* Copy the value to the new blob file. */
+				uint64_t offset;
+				char *value = vy_blob_writer_reserve(writer,
+							ref.size, &offset);
+				if (value == NULL ||
+				    vy_blob_read(blob, &ref, value, false) != 0)
+					goto fail;
+				ref.blob_id = writer->id;
+				ref.offset = offset;
+				is_changed = true;
+			}
+		} else if (is_separable && writer->threshold > 0 &&
+			   (size >= writer->threshold || is_ref)) {
+			/*
+			 * Move the value to the blob file. A user
+			 * value that looks like a reference is moved
+			 * regardless of its size, otherwise it would
+			 * be taken for a reference.
+			 */
+			char *value = vy_blob_writer_reserve(writer, size,
+							     &ref.offset);
+			if (value == NULL)
+				goto fail;
+			memcpy(value, field, size);
+			ref.blob_id = writer->id;
+			ref.size = size;
+			is_ref = true;
+			is_changed = true;
+		} else {
+			is_ref = false;
+		}
+		if (is_ref) {
+			if (vy_blob_writer_account(writer, &ref) != 0)
+				goto fail;
+			pos = vy_blob_ref_encode(pos, &ref);
+			has_new_refs = true;
+		} else {
+			memcpy(pos, field, size);
+			pos += size;
+		}
+		field = field_end;
+	}
+	assert(pos <= buf + bsize);
+	struct tuple *new_stmt = stmt;
+	if (is_changed || has_refs != has_new_refs)
+		new_stmt = vy_blob_new_stmt(stmt, buf, pos, has_new_refs);
+	region_truncate(region, region_svp);
+	return new_stmt;
+fail:
+	region_truncate(region, region_svp);
+	return NULL;
+}
+
+int
+vy_blob_writer_commit(struct vy_blob_writer *writer,
+		      struct vy_run_blob_info **blobs, uint32_t *blob_count)
+{
+	if (writer->fd >= 0) {
+		if (vy_blob_writer_flush(writer) != 0)
+			return -1;
+		if (fsync(writer->fd) < 0) {
+			diag_set(SystemError, "failed to sync file '%s'",
+				 writer->path);
+			return -1;
+		}
+		if (close(writer->fd) < 0)
+			say_syserror("close failed");
+		writer->fd = -1;
+	}
+	free(writer->buf);
+	writer->buf = NULL;
+	writer->buf_used = writer->buf_capacity = 0;
+	*blobs = writer->blobs;
+	*blob_count = writer->blob_count;
+	writer->blobs = NULL;
+	writer->blob_count = writer->blob_capacity = 0;
+	return 0;
+}
+
+void
+vy_blob_writer_abort(struct vy_blob_writer *writer)
+{
+	if (writer->fd >= 0 && close(writer->fd) < 0)
+		say_syserror("close failed");
+	writer->fd = -1;
+	if (writer->size > 0 && unlink(writer->path) < 0 && errno != ENOENT)
+		say_syserror("failed to unlink file '%s'", writer->path);
+	free(writer->buf);
+	writer->buf = NULL;
+	free(writer->blobs);
+	writer->blobs = NULL;
+}
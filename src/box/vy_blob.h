@@ -0,0 +1,281 @@
+#ifndef INCLUDES_TARANTOOL_BOX_VY_BLOB_H
+#define INCLUDES_TARANTOOL_BOX_VY_BLOB_H
+/*
+ * Copyright 2010-2018, Tarantool AUTHORS, please see AUTHORS file.
+ *
+ * Redistribution and use in source and binary forms, with or
+ * without modification, are permitted provided that the following
+ * conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above
+ *    copyright notice, this list of conditions and the
+ *    following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials
+ *    provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY AUTHORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * AUTHORS OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include <assert.h>
+#include <limits.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <small/rlist.h>
+
+#if defined(__cplusplus)
+extern "C" {
+#endif /* defined(__cplusplus) */
+
+/**
+ * Key-value separation.
+ *
+ * If an LSM tree has index_opts::blob_threshold set, values of
+ * fields of type 'any' that are at least blob_threshold bytes
+ * long are moved out of REPLACE and INSERT statements when the
+ * statements are written to disk. Such a value is appended to
+ * a blob file, and the statement stores a short reference to it
+ * instead (vy_blob_ref). As a result, compaction only copies
+ * references and doesn't rewrite big values over and over again.
+ *
+ * A blob file is written by a dump or compaction task along with
+ * its output run and has the same ID. It is never modified after
+ * it was written. A run stores sizes of values it refers to in
+ * each blob file in its index file (vy_run_info::blobs). A blob
+ * file is dropped as soon as no run of the LSM tree refers to it,
+ * see VY_LOG_DROP_BLOB. To reclaim space occupied by values that
+ * are not referenced any more, compaction copies values stored in
+ * blob files that are mostly garbage to its own blob file.
+ *
+ * Fields of type 'any' can't be indexed so key parts are never
+ * separated. A statement that has references is marked with
+ * VY_STMT_BLOB_REF. All readers replace references with values
+ * (vy_blob_resolve()) before returning statements to the user.
+ */
+
+struct tuple;
+struct tuple_format;
+
+enum {
+	/** MsgPack extension type used for encoding blob references. */
+	VY_BLOB_REF_EXT_TYPE = 127,
+	/** Size of a blob reference payload: blob id, offset, size. */
+	VY_BLOB_REF_DATA_SIZE = 8 + 8 + 4,
+	/** Size of a MsgPack-encoded blob reference (ext 8). */
+	VY_BLOB_REF_SIZE = 3 + VY_BLOB_REF_DATA_SIZE,
+};
+
+/** Reference to a field value stored in a blob file. */
+struct vy_blob_ref {
+	/** ID of the blob file. */
+	int64_t blob_id;
+	/** Offset of the value in the blob file. */
+	uint64_t offset;
+	/** Size of the value. */
+	uint32_t size;
+};
+
+/**
+ * Decode a blob reference. Return true and fill @ref if @data
+ * points to a MsgPack value that looks like a blob reference,
+ * false otherwise.
+ */
+bool
+vy_blob_ref_decode(const char *data, struct vy_blob_ref *ref);
+
+/**
+ * Encode a blob reference. @data must have at least
+ * VY_BLOB_REF_SIZE bytes. Return a pointer to the end
+ * of the encoded reference.
+ */
+char *
+vy_blob_ref_encode(char *data, const struct vy_blob_ref *ref);
+
+/** Total size of values a run refers to in a blob file. */
+struct vy_run_blob_info {
+	/** ID of the blob file. */
+	int64_t id;
+	/** Size of referenced values, in bytes. */
+	uint64_t size;
+};
+
+/** Blob file of an LSM tree. */
+struct vy_blob {
+	/** Unique ID of this blob file, same as the ID of its run. */
+	int64_t id;
+	/** Blob file descriptor, open for reading. */
+	int fd;
+	/** Size of the blob file. */
+	uint64_t size;
+	/** Size of values referenced by runs of the LSM tree. */
+	uint64_t used;
+	/** Number of runs of the LSM tree referring to this file. */
+	int run_count;
+	/**
+	 * Reference counter. A blob file is referenced by each
+	 * run that refers to it (vy_run::blobs) and by the LSM
+	 * tree while it is in use. It is closed once the counter
+	 * hits 0.
+	 */
+	int refs;
+	/** Link in vy_lsm::blobs. */
+	struct rlist in_lsm;
+};
+
+static inline int
+vy_blob_snprint_path(char *buf, int size, const char *dir,
+		     uint32_t space_id, uint32_t iid, int64_t blob_id)
+{
+	return snprintf(buf, size, "%s/%u/%u/%020lld.blob",
+			dir, (unsigned)space_id, (unsigned)iid,
+			(long long)blob_id);
+}
+
+/**
+ * Open a blob file for reading.
+ * Return the new blob file object with the reference counter
+ * set to 1 on success, NULL on failure.
+ */
+struct vy_blob *
+vy_blob_open(int64_t id, const char *dir, uint32_t space_id, uint32_t iid);
+
+static inline void
+vy_blob_ref(struct vy_blob *blob)
+{
+	assert(blob->refs > 0);
+	blob->refs++;
+}
+
+/** Drop a reference, close the blob file if it was the last one. */
+void
+vy_blob_unref(struct vy_blob *blob);
+
+/** Return the size of values stored in a blob file that are unused. */
+static inline uint64_t
+vy_blob_garbage(struct vy_blob *blob)
+{
+	return blob->size > blob->used ? blob->size - blob->used : 0;
+}
+
+/**
+ * Remove a blob file. Return 0 on success or if the file doesn't
+ * exist, -1 if unlink() failed.
+ */
+int
+vy_blob_remove_file(const char *dir, uint32_t space_id,
+		    uint32_t iid, int64_t blob_id);
+
+/**
+ * Look up a blob file by ID in an array sorted by ID.
+ * Return NULL if not found.
+ */
+struct vy_blob *
+vy_blob_find(struct vy_blob **blobs, uint32_t blob_count, int64_t id);
+
+/**
+ * Replace blob references stored in a statement marked with
+ * VY_STMT_BLOB_REF with values read from blob files. @blobs
+ * must contain all blob files the statement refers to, sorted
+ * by ID. If @can_yield is set, the values are read by coio,
+ * otherwise in the calling thread.
+ *
+ * Return the new statement on success, NULL on failure.
+ */
+struct tuple *
+vy_blob_resolve(struct tuple *stmt, struct vy_blob **blobs,
+		uint32_t blob_count, bool can_yield);
+
+/**
+ * Writer of a blob file. Used by run writer to move big field
+ * values out of statements.
+ */
+struct vy_blob_writer {
+	/** Path to the blob file. */
+	char path[PATH_MAX];
+	/** ID of the blob file, same as the ID of the run. */
+	int64_t id;
+	/**
+	 * Values of fields of type 'any' that are at least that
+	 * big are moved to the blob file. 0 if separation is
+	 * disabled, in which case references are only accounted.
+	 */
+	uint32_t threshold;
+	/**
+	 * Blob files, sorted by ID, values referenced from which
+	 * should be copied to the new blob file, because they are
+	 * mostly garbage.
+	 */
+	struct vy_blob **relocate;
+	uint32_t relocate_count;
+	/** Blob file descriptor or -1 if it hasn't been created. */
+	int fd;
+	/** Size of data written to the blob file. */
+	uint64_t size;
+	/** Buffer for values that haven't been written yet. */
+	char *buf;
+	size_t buf_used;
+	size_t buf_capacity;
+	/**
+	 * Sizes of values referenced by the written statements
+	 * in each blob file, sorted by blob ID.
+	 */
+	struct vy_run_blob_info *blobs;
+	uint32_t blob_count;
+	uint32_t blob_capacity;
+};
+
+/**
+ * Create a blob writer. The blob file is created on the first
+ * separated value.
+ */
+void
+vy_blob_writer_create(struct vy_blob_writer *writer, const char *dir,
+		      uint32_t space_id, uint32_t iid, int64_t id,
+		      uint32_t threshold, struct vy_blob **relocate,
+		      uint32_t relocate_count);
+
+/**
+ * Prepare a statement for writing to disk: move big field values
+ * to the blob file, copy values that need to be relocated, and
+ * account references.
+ *
+ * Return @stmt if it doesn't need to be changed, a new statement
+ * with the reference counter set to 1 if it does, or NULL on
+ * failure.
+ */
+struct tuple *
+vy_blob_writer_process(struct vy_blob_writer *writer, struct tuple *stmt);
+
+/**
+ * Flush and sync the blob file and pass the array of blob files
+ * the written statements refer to to the caller.
+ */
+int
+vy_blob_writer_commit(struct vy_blob_writer *writer,
+		      struct vy_run_blob_info **blobs, uint32_t *blob_count);
+
+/** Free the writer and remove the blob file. */
+void
+vy_blob_writer_abort(struct vy_blob_writer *writer);
+
+#if defined(__cplusplus)
+} /* extern "C" */
+#endif /* defined(__cplusplus) */
+
+#endif /* INCLUDES_TARANTOOL_BOX_VY_BLOB_H */
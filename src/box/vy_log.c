@@ -84,6 +84,7 @@ enum vy_log_key {
 	VY_LOG_KEY_MODIFY_LSN		= 13,
 	VY_LOG_KEY_DROP_LSN		= 14,
 	VY_LOG_KEY_GROUP_ID		= 15,
+	VY_LOG_KEY_BLOB_ID		= 16,
 };
 
 /** vy_log_key -> human readable name. */
@@ -104,6 +105,7 @@ static const char *vy_log_key_name[] = {
 	[VY_LOG_KEY_MODIFY_LSN]		= "modify_lsn",
 	[VY_LOG_KEY_DROP_LSN]		= "drop_lsn",
 	[VY_LOG_KEY_GROUP_ID]		= "group_id",
+	[VY_LOG_KEY_BLOB_ID]		= "blob_id",
 };
 
 /** vy_log_type -> human readable name. */
@@ -126,6 +128,9 @@ static const char *vy_log_type_name[] = {
 	[VY_LOG_PREPARE_LSM]		= "prepare_lsm",
 	[VY_LOG_REBOOTSTRAP]		= "rebootstrap",
 	[VY_LOG_ABORT_REBOOTSTRAP]	= "abort_rebootstrap",
+	[VY_LOG_CREATE_BLOB]		= "create_blob",
+	[VY_LOG_DROP_BLOB]		= "drop_blob",
+	[VY_LOG_FORGET_BLOB]		= "forget_blob",
 };
 
 /** Metadata log object. */
@@ -271,6 +276,10 @@ vy_log_record_snprint(char *buf, int size, const struct vy_log_record *record)
 		SNPRINT(total, snprintf, buf, size, "%s=%"PRIi64", ",
 			vy_log_key_name[VY_LOG_KEY_SLICE_ID],
 			record->slice_id);
+	if (record->blob_id > 0)
+		SNPRINT(total, snprintf, buf, size, "%s=%"PRIi64", ",
+			vy_log_key_name[VY_LOG_KEY_BLOB_ID],
+			record->blob_id);
 	if (record->create_lsn > 0)
 		SNPRINT(total, snprintf, buf, size, "%s=%"PRIi64", ",
 			vy_log_key_name[VY_LOG_KEY_CREATE_LSN],
@@ -392,6 +401,11 @@ vy_log_record_encode(const struct vy_log_record *record,
 		size += mp_sizeof_uint(record->slice_id);
 		n_keys++;
 	}
+	if (record->blob_id > 0) {
+		size += mp_sizeof_uint(VY_LOG_KEY_BLOB_ID);
+		size += mp_sizeof_uint(record->blob_id);
+		n_keys++;
+	}
 	if (record->create_lsn > 0) {
 		size += mp_sizeof_uint(VY_LOG_KEY_CREATE_LSN);
 		size += mp_sizeof_uint(record->create_lsn);
@@ -479,6 +493,10 @@ vy_log_record_encode(const struct vy_log_record *record,
 		pos = mp_encode_uint(pos, VY_LOG_KEY_SLICE_ID);
 		pos = mp_encode_uint(pos, record->slice_id);
 	}
+	if (record->blob_id > 0) {
+		pos = mp_encode_uint(pos, VY_LOG_KEY_BLOB_ID);
+		pos = mp_encode_uint(pos, record->blob_id);
+	}
 	if (record->create_lsn > 0) {
 		pos = mp_encode_uint(pos, VY_LOG_KEY_CREATE_LSN);
 		pos = mp_encode_uint(pos, record->create_lsn);
@@ -611,6 +629,9 @@ vy_log_record_decode(struct vy_log_record *record,
 		case VY_LOG_KEY_SLICE_ID:
 			record->slice_id = mp_decode_uint(&pos);
 			break;
+		case VY_LOG_KEY_BLOB_ID:
+			record->blob_id = mp_decode_uint(&pos);
+			break;
 		case VY_LOG_KEY_CREATE_LSN:
 			record->create_lsn = mp_decode_uint(&pos);
 			break;
@@ -1260,6 +1281,17 @@ vy_recovery_lookup_run(struct vy_recovery *recovery, int64_t run_id)
 	return mh_i64ptr_node(h, k)->val;
 }
 
+/** Lookup a blob file in vy_recovery::blob_hash map. */
+static struct vy_blob_recovery_info *
+vy_recovery_lookup_blob(struct vy_recovery *recovery, int64_t blob_id)
+{
+	struct mh_i64ptr_t *h = recovery->blob_hash;
+	mh_int_t k = mh_i64ptr_find(h, blob_id, NULL);
+	if (k == mh_end(h))
+		return NULL;
+	return mh_i64ptr_node(h, k)->val;
+}
+
 /** Lookup a vinyl slice in vy_recovery::slice_hash map. */
 static struct vy_slice_recovery_info *
 vy_recovery_lookup_slice(struct vy_recovery *recovery, int64_t slice_id)
@@ -1326,6 +1358,7 @@ vy_recovery_do_create_lsm(struct vy_recovery *recovery, int64_t id,
 	lsm->prepared = NULL;
 	rlist_create(&lsm->ranges);
 	rlist_create(&lsm->runs);
+	rlist_create(&lsm->blobs);
 	/*
 	 * Keep newer LSM trees closer to the tail of the list
 	 * so that on log rotation we create/drop past incarnations
@@ -1502,10 +1535,11 @@ vy_recovery_forget_lsm(struct vy_recovery *recovery, int64_t id)
 		return -1;
 	}
 	struct vy_lsm_recovery_info *lsm = mh_i64ptr_node(h, k)->val;
-	if (!rlist_empty(&lsm->ranges) || !rlist_empty(&lsm->runs)) {
+	if (!rlist_empty(&lsm->ranges) || !rlist_empty(&lsm->runs) ||
+	    !rlist_empty(&lsm->blobs)) {
 		diag_set(ClientError, ER_INVALID_VYLOG_FILE,
-			 tt_sprintf("Forgotten LSM tree %lld has ranges/runs",
-				    (long long)id));
+			 tt_sprintf("Forgotten LSM tree %lld has "
+				    "ranges/runs/blobs", (long long)id));
 		return -1;
 	}
 	mh_i64ptr_del(h, k, NULL);
@@ -1699,6 +1733,109 @@ vy_recovery_forget_run(struct vy_recovery *recovery, int64_t run_id)
 	return 0;
 }
 
+/**
+ * Handle a VY_LOG_CREATE_BLOB log record.
+ * This function allocates a blob file with ID @blob_id, inserts
+ * it to the hash, and adds it to the list of blob files of the
+ * LSM tree with ID @lsm_id.
+ * Return 0 on success, -1 if blob file already exists, LSM tree
+ * not found, or OOM.
+ */
+static int
+vy_recovery_create_blob(struct vy_recovery *recovery, int64_t lsm_id,
+			int64_t blob_id)
+{
+	struct vy_lsm_recovery_info *lsm;
+	lsm = vy_recovery_lookup_lsm(recovery, lsm_id);
+	if (lsm == NULL) {
+		diag_set(ClientError, ER_INVALID_VYLOG_FILE,
+			 tt_sprintf("Blob %lld created for unregistered "
+				    "LSM tree %lld", (long long)blob_id,
+				    (long long)lsm_id));
+		return -1;
+	}
+	if (vy_recovery_lookup_blob(recovery, blob_id) != NULL) {
+		diag_set(ClientError, ER_INVALID_VYLOG_FILE,
+			 tt_sprintf("Duplicate blob id %lld",
+				    (long long)blob_id));
+		return -1;
+	}
+	struct vy_blob_recovery_info *blob = malloc(sizeof(*blob));
+	if (blob == NULL) {
+		diag_set(OutOfMemory, sizeof(*blob),
+			 "malloc", "struct vy_blob_recovery_info");
+		return -1;
+	}
+	struct mh_i64ptr_t *h = recovery->blob_hash;
+	struct mh_i64ptr_node_t node = { blob_id, blob };
+	if (mh_i64ptr_put(h, &node, NULL, NULL) == mh_end(h)) {
+		diag_set(OutOfMemory, 0, "mh_i64ptr_put", "mh_i64ptr_node_t");
+		free(blob);
+		return -1;
+	}
+	blob->id = blob_id;
+	blob->gc_lsn = -1;
+	blob->is_dropped = false;
+	rlist_add_entry(&lsm->blobs, blob, in_lsm);
+	if (recovery->max_id < blob_id)
+		recovery->max_id = blob_id;
+	return 0;
+}
+
+/**
+ * Handle a VY_LOG_DROP_BLOB log record.
+ * This function marks the blob file with ID @blob_id as deleted.
+ * The blob file stays in the recovery context until it is
+ * "forgotten", because it is needed for garbage collection.
+ * Return 0 on success, -1 if blob file not found or already
+ * deleted.
+ */
+static int
+vy_recovery_drop_blob(struct vy_recovery *recovery, int64_t blob_id,
+		      int64_t gc_lsn)
+{
+	struct vy_blob_recovery_info *blob;
+	blob = vy_recovery_lookup_blob(recovery, blob_id);
+	if (blob == NULL) {
+		diag_set(ClientError, ER_INVALID_VYLOG_FILE,
+			 tt_sprintf("Blob %lld deleted but not registered",
+				    (long long)blob_id));
+		return -1;
+	}
+	if (blob->is_dropped) {
+		diag_set(ClientError, ER_INVALID_VYLOG_FILE,
+			 tt_sprintf("Blob %lld deleted twice",
+				    (long long)blob_id));
+		return -1;
+	}
+	blob->is_dropped = true;
+	blob->gc_lsn = gc_lsn;
+	return 0;
+}
+
+/**
+ * Handle a VY_LOG_FORGET_BLOB log record.
+ * This function frees the blob file with ID @blob_id.
+ * Return 0 on success, -1 if blob file not found.
+ */
+static int
+vy_recovery_forget_blob(struct vy_recovery *recovery, int64_t blob_id)
+{
+	struct mh_i64ptr_t *h = recovery->blob_hash;
+	mh_int_t k = mh_i64ptr_find(h, blob_id, NULL);
+	if (k == mh_end(h)) {
+		diag_set(ClientError, ER_INVALID_VYLOG_FILE,
+			 tt_sprintf("Blob %lld forgotten but not registered",
+				    (long long)blob_id));
+		return -1;
+	}
+	struct vy_blob_recovery_info *blob = mh_i64ptr_node(h, k)->val;
+	mh_i64ptr_del(h, k, NULL);
+	rlist_del_entry(blob, in_lsm);
+	free(blob);
+	return 0;
+}
+
 /**
  * Handle a VY_LOG_INSERT_RANGE log record.
  * This function allocates a new vinyl range with ID @range_id,
@@ -2033,6 +2170,17 @@ vy_recovery_process_record(struct vy_recovery *recovery,
 	case VY_LOG_ABORT_REBOOTSTRAP:
 		vy_recovery_abort_rebootstrap(recovery);
 		break;
+	case VY_LOG_CREATE_BLOB:
+		rc = vy_recovery_create_blob(recovery, record->lsm_id,
+					     record->blob_id);
+		break;
+	case VY_LOG_DROP_BLOB:
+		rc = vy_recovery_drop_blob(recovery, record->blob_id,
+					   record->gc_lsn);
+		break;
+	case VY_LOG_FORGET_BLOB:
+		rc = vy_recovery_forget_blob(recovery, record->blob_id);
+		break;
 	default:
 		unreachable();
 	}
@@ -2152,6 +2300,7 @@ vy_recovery_new_f(va_list ap)
 	recovery->range_hash = NULL;
 	recovery->run_hash = NULL;
 	recovery->slice_hash = NULL;
+	recovery->blob_hash = NULL;
 	recovery->max_id = -1;
 	recovery->in_rebootstrap = false;
 
@@ -2160,11 +2309,13 @@ vy_recovery_new_f(va_list ap)
 	recovery->range_hash = mh_i64ptr_new();
 	recovery->run_hash = mh_i64ptr_new();
 	recovery->slice_hash = mh_i64ptr_new();
+	recovery->blob_hash = mh_i64ptr_new();
 	if (recovery->index_id_hash == NULL ||
 	    recovery->lsm_hash == NULL ||
 	    recovery->range_hash == NULL ||
 	    recovery->run_hash == NULL ||
-	    recovery->slice_hash == NULL) {
+	    recovery->slice_hash == NULL ||
+	    recovery->blob_hash == NULL) {
 		diag_set(OutOfMemory, 0, "mh_i64ptr_new", "mh_i64ptr_t");
 		goto fail_free;
 	}
@@ -2279,6 +2430,7 @@ vy_recovery_delete(struct vy_recovery *recovery)
 	struct vy_range_recovery_info *range, *next_range;
 	struct vy_slice_recovery_info *slice, *next_slice;
 	struct vy_run_recovery_info *run, *next_run;
+	struct vy_blob_recovery_info *blob, *next_blob;
 
 	rlist_foreach_entry_safe(lsm, &recovery->lsms, in_recovery, next_lsm) {
 		rlist_foreach_entry_safe(range, &lsm->ranges,
@@ -2290,6 +2442,8 @@ vy_recovery_delete(struct vy_recovery *recovery)
 		}
 		rlist_foreach_entry_safe(run, &lsm->runs, in_lsm, next_run)
 			free(run);
+		rlist_foreach_entry_safe(blob, &lsm->blobs, in_lsm, next_blob)
+			free(blob);
 		free(lsm->key_parts);
 		free(lsm);
 	}
@@ -2303,6 +2457,8 @@ vy_recovery_delete(struct vy_recovery *recovery)
 		mh_i64ptr_delete(recovery->run_hash);
 	if (recovery->slice_hash != NULL)
 		mh_i64ptr_delete(recovery->slice_hash);
+	if (recovery->blob_hash != NULL)
+		mh_i64ptr_delete(recovery->blob_hash);
 	TRASH(recovery);
 	free(recovery);
 }
@@ -2328,6 +2484,7 @@ vy_log_append_lsm(struct xlog *xlog, struct vy_lsm_recovery_info *lsm)
 	struct vy_range_recovery_info *range;
 	struct vy_slice_recovery_info *slice;
 	struct vy_run_recovery_info *run;
+	struct vy_blob_recovery_info *blob;
 	struct vy_log_record record;
 
 	vy_log_record_init(&record);
@@ -2369,6 +2526,25 @@ vy_log_append_lsm(struct xlog *xlog, struct vy_lsm_recovery_info *lsm)
 			return -1;
 	}
 
+	rlist_foreach_entry(blob, &lsm->blobs, in_lsm) {
+		vy_log_record_init(&record);
+		record.type = VY_LOG_CREATE_BLOB;
+		record.lsm_id = lsm->id;
+		record.blob_id = blob->id;
+		if (vy_log_append_record(xlog, &record) != 0)
+			return -1;
+
+		if (!blob->is_dropped)
+			continue;
+
+		vy_log_record_init(&record);
+		record.type = VY_LOG_DROP_BLOB;
+		record.blob_id = blob->id;
+		record.gc_lsn = blob->gc_lsn;
+		if (vy_log_append_record(xlog, &record) != 0)
+			return -1;
+	}
+
 	rlist_foreach_entry(range, &lsm->ranges, in_lsm) {
 		vy_log_record_init(&record);
 		record.type = VY_LOG_INSERT_RANGE;
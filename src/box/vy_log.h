@@ -217,6 +217,36 @@ enum vy_log_record_type {
 	 * See also VY_LOG_REBOOTSTRAP.
 	 */
 	VY_LOG_ABORT_REBOOTSTRAP	= 17,
+	/**
+	 * Commit a blob file creation.
+	 * Requires vy_log_record::lsm_id, blob_id.
+	 *
+	 * A blob file stores values of big fields separated from
+	 * statements of an LSM tree on dump or compaction, see
+	 * vy_blob.h. It is created along with the run written by
+	 * the same task and has the same ID, so an incomplete blob
+	 * file is removed together with the incomplete run. The
+	 * record is written in the same transaction as the run's
+	 * VY_LOG_CREATE_RUN.
+	 */
+	VY_LOG_CREATE_BLOB		= 18,
+	/**
+	 * Drop a blob file.
+	 * Requires vy_log_record::blob_id, gc_lsn.
+	 *
+	 * Written when the last run referring to the blob file
+	 * is dropped. Similarly to VY_LOG_DROP_RUN, this only
+	 * marks the blob file as deleted on recovery, because
+	 * checkpoints older than gc_lsn may still need it.
+	 */
+	VY_LOG_DROP_BLOB		= 19,
+	/**
+	 * Forget a blob file.
+	 * Requires vy_log_record::blob_id.
+	 *
+	 * Written after a dropped blob file has been removed.
+	 */
+	VY_LOG_FORGET_BLOB		= 20,
 
 	vy_log_record_type_MAX
 };
@@ -233,6 +263,8 @@ struct vy_log_record {
 	int64_t run_id;
 	/** Unique ID of the run slice. */
 	int64_t slice_id;
+	/** Unique ID of the blob file. */
+	int64_t blob_id;
 	/**
 	 * Msgpack key for start of the range/slice.
 	 * NULL if the range/slice starts from -inf.
@@ -292,6 +324,8 @@ struct vy_recovery {
 	struct mh_i64ptr_t *run_hash;
 	/** ID -> vy_slice_recovery_info. */
 	struct mh_i64ptr_t *slice_hash;
+	/** ID -> vy_blob_recovery_info. */
+	struct mh_i64ptr_t *blob_hash;
 	/**
 	 * Maximal vinyl object ID, according to the metadata log,
 	 * or -1 in case no vinyl objects were recovered.
@@ -348,6 +382,11 @@ struct vy_lsm_recovery_info {
 	 * vy_run_recovery_info::in_lsm.
 	 */
 	struct rlist runs;
+	/**
+	 * List of all blob files created for the LSM tree,
+	 * linked by vy_blob_recovery_info::in_lsm.
+	 */
+	struct rlist blobs;
 	/**
 	 * Pointer to an LSM tree that is going to replace
 	 * this one after successful ALTER.
@@ -407,6 +446,21 @@ struct vy_run_recovery_info {
 	void *data;
 };
 
+/** Blob file info stored in a recovery context. */
+struct vy_blob_recovery_info {
+	/** Link in vy_lsm_recovery_info::blobs. */
+	struct rlist in_lsm;
+	/** ID of the blob file. */
+	int64_t id;
+	/**
+	 * For deleted blob files: LSN of the last checkpoint
+	 * that uses this blob file.
+	 */
+	int64_t gc_lsn;
+	/** True if the blob file was dropped (VY_LOG_DROP_BLOB). */
+	bool is_dropped;
+};
+
 /** Slice info stored in a recovery context. */
 struct vy_slice_recovery_info {
 	/** Link in vy_range_recovery_info::slices. */
@@ -771,6 +825,41 @@ vy_log_delete_slice(int64_t slice_id)
 	vy_log_write(&record);
 }
 
+/** Helper to log a blob file creation. */
+static inline void
+vy_log_create_blob(int64_t lsm_id, int64_t blob_id)
+{
+	struct vy_log_record record;
+	vy_log_record_init(&record);
+	record.type = VY_LOG_CREATE_BLOB;
+	record.lsm_id = lsm_id;
+	record.blob_id = blob_id;
+	vy_log_write(&record);
+}
+
+/** Helper to log a blob file deletion. */
+static inline void
+vy_log_drop_blob(int64_t blob_id, int64_t gc_lsn)
+{
+	struct vy_log_record record;
+	vy_log_record_init(&record);
+	record.type = VY_LOG_DROP_BLOB;
+	record.blob_id = blob_id;
+	record.gc_lsn = gc_lsn;
+	vy_log_write(&record);
+}
+
+/** Helper to log a blob file cleanup. */
+static inline void
+vy_log_forget_blob(int64_t blob_id)
+{
+	struct vy_log_record record;
+	vy_log_record_init(&record);
+	record.type = VY_LOG_FORGET_BLOB;
+	record.blob_id = blob_id;
+	vy_log_write(&record);
+}
+
 /** Helper to log LSM tree dump. */
 static inline void
 vy_log_dump_lsm(int64_t id, int64_t dump_lsn)
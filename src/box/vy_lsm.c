@@ -61,7 +61,7 @@ vy_lsm_env_create(struct vy_lsm_env *env, const char *path,
 		  void *upsert_thresh_arg)
 {
 	env->key_format = tuple_format_new(&vy_tuple_format_vtab,
-					   NULL, 0, 0, NULL, 0, NULL);
+					   NULL, 0, 0, 0, false, NULL, 0, NULL);
 	if (env->key_format == NULL)
 		return -1;
 	tuple_format_ref(env->key_format);
@@ -154,8 +154,8 @@ vy_lsm_new(struct vy_lsm_env *lsm_env, struct vy_cache_env *cache_env,
 		lsm->disk_format = format;
 	} else {
 		lsm->disk_format = tuple_format_new(&vy_tuple_format_vtab,
-						    &cmp_def, 1, 0, NULL, 0,
-						    NULL);
+						    &cmp_def, 1, 0, 0, false,
+						    NULL, 0, NULL);
 		if (lsm->disk_format == NULL)
 			goto fail_format;
 	}
@@ -193,6 +193,7 @@ vy_lsm_new(struct vy_lsm_env *lsm_env, struct vy_cache_env *cache_env,
 	vy_range_tree_new(lsm->tree);
 	vy_range_heap_create(&lsm->range_heap);
 	rlist_create(&lsm->runs);
+	rlist_create(&lsm->blobs);
 	lsm->pk = pk;
 	if (pk != NULL)
 		vy_lsm_ref(pk);
@@ -267,6 +268,12 @@ vy_lsm_delete(struct vy_lsm *lsm)
 	rlist_foreach_entry_safe(run, &lsm->runs, in_lsm, next_run)
 		vy_lsm_remove_run(lsm, run);
 
+	struct vy_blob *blob, *next_blob;
+	rlist_foreach_entry_safe(blob, &lsm->blobs, in_lsm, next_blob) {
+		rlist_del_entry(blob, in_lsm);
+		vy_blob_unref(blob);
+	}
+
 	vy_range_tree_iter(lsm->tree, NULL, vy_range_tree_free_cb, NULL);
 	vy_range_heap_destroy(&lsm->range_heap);
 	tuple_format_unref(lsm->disk_format);
@@ -373,6 +380,10 @@ vy_lsm_recover_run(struct vy_lsm *lsm, struct vy_run_recovery_info *run_info,
 		vy_run_unref(run);
 		return NULL;
 	}
+	if (vy_run_bind_blobs(run, &lsm->blobs, NULL) != 0) {
+		vy_run_unref(run);
+		return NULL;
+	}
 	vy_lsm_add_run(lsm, run);
 
 	/*
@@ -596,6 +607,21 @@ vy_lsm_recover(struct vy_lsm *lsm, struct vy_recovery *recovery,
 	 */
 	lsm->dump_lsn = lsm_info->dump_lsn;
 
+	/*
+	 * Open blob files before loading runs, because
+	 * runs refer to them.
+	 */
+	struct vy_blob_recovery_info *blob_info;
+	rlist_foreach_entry(blob_info, &lsm_info->blobs, in_lsm) {
+		if (blob_info->is_dropped)
+			continue;
+		struct vy_blob *blob = vy_blob_open(blob_info->id,
+				lsm->env->path, lsm->space_id, lsm->index_id);
+		if (blob == NULL)
+			return -1;
+		rlist_add_tail_entry(&lsm->blobs, blob, in_lsm);
+	}
+
 	int rc = 0;
 	struct vy_range_recovery_info *range_info;
 	rlist_foreach_entry(range_info, &lsm_info->ranges, in_lsm) {
@@ -620,6 +646,20 @@ vy_lsm_recover(struct vy_lsm *lsm, struct vy_recovery *recovery,
 	if (rc != 0)
 		return -1;
 
+	/*
+	 * A blob file is dropped along with the last run
+	 * referring to it so all blob files must be in use.
+	 */
+	struct vy_blob *blob, *next_blob;
+	rlist_foreach_entry_safe(blob, &lsm->blobs, in_lsm, next_blob) {
+		if (blob->run_count > 0)
+			continue;
+		say_warn("%s: blob file %lld is not used by any run",
+			 vy_lsm_name(lsm), (long long)blob->id);
+		rlist_del_entry(blob, in_lsm);
+		vy_blob_unref(blob);
+	}
+
 	/*
 	 * Account ranges to the LSM tree and check that the range tree
 	 * does not have holes or overlaps.
@@ -684,6 +724,49 @@ vy_lsm_compact_priority(struct vy_lsm *lsm)
 	return range->compact_priority;
 }
 
+double
+vy_lsm_write_amplification(struct vy_lsm *lsm)
+{
+	int64_t dump_out = lsm->stat.disk.dump.out.bytes;
+	int64_t compact_out = lsm->stat.disk.compact.out.bytes;
+	if (dump_out == 0)
+		return 0;
+	return (double)(dump_out + compact_out) / dump_out;
+}
+
+double
+vy_lsm_read_amplification(struct vy_lsm *lsm)
+{
+	if (lsm->stat.lookup == 0)
+		return 0;
+	return (double)lsm->stat.disk.iterator.lookup / lsm->stat.lookup;
+}
+
+double
+vy_lsm_space_amplification(struct vy_lsm *lsm)
+{
+	int64_t last_level_bytes = 0;
+	struct vy_range *range;
+	struct vy_range_tree_iterator it;
+	vy_range_tree_ifirst(lsm->tree, &it);
+	while ((range = vy_range_tree_inext(&it)) != NULL) {
+		if (range->slice_count == 0)
+			continue;
+		uint32_t slice_count;
+		struct vy_disk_stmt_counter count;
+		struct vy_slice *slice = rlist_first_entry(&range->slices,
+						struct vy_slice, in_range);
+		do {
+			slice = vy_range_next_run(range, slice,
+						  &slice_count, &count);
+		} while (slice != NULL);
+		last_level_bytes += count.bytes;
+	}
+	if (last_level_bytes == 0)
+		return 0;
+	return (double)lsm->stat.disk.count.bytes / last_level_bytes;
+}
+
 void
 vy_lsm_add_run(struct vy_lsm *lsm, struct vy_run *run)
 {
@@ -709,6 +792,17 @@ vy_lsm_add_run(struct vy_lsm *lsm, struct vy_run *run)
 	env->disk_stat.index += bloom_size + page_index_size;
 	if (lsm->index_id > 0)
 		env->disk_stat.index += run->count.bytes;
+
+	for (uint32_t i = 0; i < run->info.blob_count; i++) {
+		struct vy_blob *blob = run->blobs[i];
+		if (blob->run_count++ == 0 && rlist_empty(&blob->in_lsm)) {
+			rlist_add_tail_entry(&lsm->blobs, blob, in_lsm);
+			vy_blob_ref(blob);
+		}
+		blob->used += run->info.blobs[i].size;
+	}
+
+	vy_run_index_cache_add(run);
 }
 
 void
@@ -737,6 +831,35 @@ vy_lsm_remove_run(struct vy_lsm *lsm, struct vy_run *run)
 	env->disk_stat.index -= bloom_size + page_index_size;
 	if (lsm->index_id > 0)
 		env->disk_stat.index -= run->count.bytes;
+
+	for (uint32_t i = 0; i < run->info.blob_count; i++) {
+		struct vy_blob *blob = run->blobs[i];
+		assert(blob->run_count > 0);
+		assert(blob->used >= run->info.blobs[i].size);
+		blob->used -= run->info.blobs[i].size;
+		if (--blob->run_count == 0) {
+			rlist_del_entry(blob, in_lsm);
+			vy_blob_unref(blob);
+		}
+	}
+
+	vy_run_index_cache_remove(run);
+}
+
+int
+vy_lsm_bind_run_blobs(struct vy_lsm *lsm, struct vy_run *run)
+{
+	struct vy_blob *new_blob = NULL;
+	if (vy_run_has_own_blob(run)) {
+		new_blob = vy_blob_open(run->id, lsm->env->path,
+					lsm->space_id, lsm->index_id);
+		if (new_blob == NULL)
+			return -1;
+	}
+	int rc = vy_run_bind_blobs(run, &lsm->blobs, new_blob);
+	if (new_blob != NULL)
+		vy_blob_unref(new_blob);
+	return rc;
 }
 
 void
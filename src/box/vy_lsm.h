@@ -238,6 +238,12 @@ struct vy_lsm {
 	struct rlist runs;
 	/** Number of entries in all ranges. */
 	int run_count;
+	/**
+	 * List of blob files referenced by runs of this LSM
+	 * tree, linked by vy_blob->in_lsm, see vy_blob.h.
+	 * Only a primary index may have blob files.
+	 */
+	struct rlist blobs;
 	/**
 	 * Histogram accounting how many ranges of the LSM tree
 	 * have a particular number of runs.
@@ -416,14 +422,50 @@ vy_lsm_generation(struct vy_lsm *lsm);
 int
 vy_lsm_compact_priority(struct vy_lsm *lsm);
 
+/**
+ * Return write amplification of an LSM tree, i.e. the ratio of
+ * the number of bytes written by dump and compaction to the number
+ * of bytes written by dump. Returns 0 if nothing has been dumped.
+ */
+double
+vy_lsm_write_amplification(struct vy_lsm *lsm);
+
+/**
+ * Return read amplification of an LSM tree, i.e. the average
+ * number of runs looked up per read, not counting runs skipped
+ * thanks to bloom filters.
+ */
+double
+vy_lsm_read_amplification(struct vy_lsm *lsm);
+
+/**
+ * Return space amplification of an LSM tree, i.e. the ratio of
+ * the total size of all runs to the total size of the oldest run
+ * of each range, which is where all statements end up eventually.
+ */
+double
+vy_lsm_space_amplification(struct vy_lsm *lsm);
+
 /** Add a run to the list of runs of an LSM tree. */
 void
 vy_lsm_add_run(struct vy_lsm *lsm, struct vy_run *run);
 
-/** Remove a run from the list of runs of an LSM tree. */
+/**
+ * Remove a run from the list of runs of an LSM tree.
+ * Blob files not referenced by any run any more are
+ * removed from the list of blob files of the LSM tree.
+ */
 void
 vy_lsm_remove_run(struct vy_lsm *lsm, struct vy_run *run);
 
+/**
+ * Bind a new run written by a dump or compaction task to blob
+ * files of an LSM tree. If the run has its own blob file, it is
+ * opened. Must be called before vy_lsm_add_run().
+ */
+int
+vy_lsm_bind_run_blobs(struct vy_lsm *lsm, struct vy_run *run);
+
 /**
  * Add a range to both the range tree and the range heap
  * of an LSM tree.
@@ -94,7 +94,17 @@ vy_mem_tree_cmp(const struct tuple *a, const struct tuple *b,
 	if (res)
 		return res;
 	int64_t a_lsn = vy_stmt_lsn(a), b_lsn = vy_stmt_lsn(b);
-	return a_lsn > b_lsn ? -1 : a_lsn < b_lsn;
+	if (a_lsn != b_lsn)
+		return a_lsn > b_lsn ? -1 : 1;
+	/*
+	 * A deferred DELETE may have the same key and LSN as
+	 * a DELETE generated for an expired tuple. Keep both,
+	 * the latter first, like the write iterator does, see
+	 * VY_STMT_EXPIRED.
+	 */
+	bool a_expired = (vy_stmt_flags(a) & VY_STMT_EXPIRED) != 0;
+	bool b_expired = (vy_stmt_flags(b) & VY_STMT_EXPIRED) != 0;
+	return (int)b_expired - (int)a_expired;
 }
 
 /**
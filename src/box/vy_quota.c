@@ -42,6 +42,12 @@
 #include "say.h"
 #include "trivia/util.h"
 
+/**
+ * Period of time between refilling the rate limit bucket,
+ * in seconds.
+ */
+static const double VY_QUOTA_TIMER_PERIOD = 0.1;
+
 /**
  * Return true if the requested amount of memory may be consumed
  * right now, false if consumers have to wait.
@@ -53,6 +59,8 @@ vy_quota_may_use(struct vy_quota *q, size_t size)
 		return true;
 	if (q->used + size > q->limit)
 		return false;
+	if (!vy_rate_limit_may_use(&q->rate_limit))
+		return false;
 	return true;
 }
 
@@ -63,6 +71,7 @@ static inline void
 vy_quota_do_use(struct vy_quota *q, size_t size)
 {
 	q->used += size;
+	vy_rate_limit_use(&q->rate_limit, size);
 }
 
 /**
@@ -74,6 +83,7 @@ vy_quota_do_unuse(struct vy_quota *q, size_t size)
 {
 	assert(q->used >= size);
 	q->used -= size;
+	vy_rate_limit_unuse(&q->rate_limit, size);
 }
 
 /**
@@ -106,6 +116,18 @@ vy_quota_signal(struct vy_quota *q)
 	}
 }
 
+static void
+vy_quota_timer_cb(ev_loop *loop, ev_timer *timer, int events)
+{
+	(void)loop;
+	(void)events;
+
+	struct vy_quota *q = timer->data;
+
+	vy_rate_limit_refill(&q->rate_limit, VY_QUOTA_TIMER_PERIOD);
+	vy_quota_signal(q);
+}
+
 void
 vy_quota_create(struct vy_quota *q, size_t limit,
 		vy_quota_exceeded_f quota_exceeded_cb)
@@ -115,7 +137,11 @@ vy_quota_create(struct vy_quota *q, size_t limit,
 	q->used = 0;
 	q->too_long_threshold = TIMEOUT_INFINITY;
 	q->quota_exceeded_cb = quota_exceeded_cb;
+	q->throttle_time = 0;
 	rlist_create(&q->wait_queue);
+	vy_rate_limit_create(&q->rate_limit);
+	ev_timer_init(&q->timer, vy_quota_timer_cb, 0, VY_QUOTA_TIMER_PERIOD);
+	q->timer.data = q;
 }
 
 void
@@ -123,13 +149,14 @@ vy_quota_enable(struct vy_quota *q)
 {
 	assert(!q->is_enabled);
 	q->is_enabled = true;
+	ev_timer_start(loop(), &q->timer);
 	vy_quota_check_limit(q);
 }
 
 void
 vy_quota_destroy(struct vy_quota *q)
 {
-	(void)q;
+	ev_timer_stop(loop(), &q->timer);
 }
 
 void
@@ -140,6 +167,12 @@ vy_quota_set_limit(struct vy_quota *q, size_t limit)
 	vy_quota_signal(q);
 }
 
+void
+vy_quota_set_rate_limit(struct vy_quota *q, size_t rate)
+{
+	vy_rate_limit_set(&q->rate_limit, rate);
+}
+
 void
 vy_quota_force_use(struct vy_quota *q, size_t size)
 {
@@ -150,7 +183,12 @@ vy_quota_force_use(struct vy_quota *q, size_t size)
 void
 vy_quota_release(struct vy_quota *q, size_t size)
 {
-	vy_quota_do_unuse(q, size);
+	/*
+	 * Memory is released by dump, which doesn't give the
+	 * consumed rate limit tokens back.
+	 */
+	assert(q->used >= size);
+	q->used -= size;
 	vy_quota_signal(q);
 }
 
@@ -196,6 +234,8 @@ vy_quota_use(struct vy_quota *q, size_t size, double timeout)
 
 		if (now >= deadline) {
 			rlist_del_entry(&wait_node, in_wait_queue);
+			q->throttle_time += ev_monotonic_now(loop()) -
+					     wait_start;
 			diag_set(ClientError, ER_VY_QUOTA_TIMEOUT);
 			return -1;
 		}
@@ -204,6 +244,7 @@ vy_quota_use(struct vy_quota *q, size_t size, double timeout)
 	rlist_del_entry(&wait_node, in_wait_queue);
 
 	double wait_time = ev_monotonic_now(loop()) - wait_start;
+	q->throttle_time += wait_time;
 	if (wait_time > q->too_long_threshold) {
 		say_warn("waited for %zu bytes of vinyl memory quota "
 			 "for too long: %.3f sec", size, wait_time);
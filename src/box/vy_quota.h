@@ -36,6 +36,8 @@
 #include <small/rlist.h>
 #include <tarantool_ev.h>
 
+#include "trivia/util.h"
+
 #if defined(__cplusplus)
 extern "C" {
 #endif /* defined(__cplusplus) */
@@ -46,6 +48,68 @@ struct vy_quota;
 typedef void
 (*vy_quota_exceeded_f)(struct vy_quota *quota);
 
+/**
+ * Token bucket used for limiting the rate at which transactions
+ * consume memory. Tokens are added by a timer at the configured
+ * rate and taken away by consumers. A consumer may proceed as
+ * long as there are tokens left in the bucket, even if it takes
+ * more than available, so the bucket level may be negative.
+ */
+struct vy_rate_limit {
+	/** Max allowed rate, in bytes per second. */
+	size_t rate;
+	/** Current bucket level, in bytes. */
+	double value;
+};
+
+/**
+ * The bucket may accumulate up to this many seconds worth of
+ * tokens so that short bursts of load aren't throttled.
+ */
+#define VY_RATE_LIMIT_BURST 2
+
+static inline void
+vy_rate_limit_create(struct vy_rate_limit *rl)
+{
+	rl->rate = SIZE_MAX;
+	rl->value = (double)SIZE_MAX * VY_RATE_LIMIT_BURST;
+}
+
+static inline void
+vy_rate_limit_set(struct vy_rate_limit *rl, size_t rate)
+{
+	rl->rate = rate;
+	rl->value = MIN(rl->value, (double)rate * VY_RATE_LIMIT_BURST);
+}
+
+static inline bool
+vy_rate_limit_may_use(struct vy_rate_limit *rl)
+{
+	return rl->value > 0;
+}
+
+static inline void
+vy_rate_limit_use(struct vy_rate_limit *rl, size_t size)
+{
+	rl->value -= size;
+}
+
+static inline void
+vy_rate_limit_unuse(struct vy_rate_limit *rl, size_t size)
+{
+	rl->value += size;
+}
+
+/**
+ * Add tokens accumulated over @time seconds to the bucket.
+ */
+static inline void
+vy_rate_limit_refill(struct vy_rate_limit *rl, double time)
+{
+	rl->value = MIN(rl->value + time * rl->rate,
+			(double)rl->rate * VY_RATE_LIMIT_BURST);
+}
+
 struct vy_quota_wait_node {
 	/** Link in vy_quota::wait_queue. */
 	struct rlist in_wait_queue;
@@ -74,6 +138,21 @@ struct vy_quota {
 	 * value, warn about it in the log.
 	 */
 	double too_long_threshold;
+	/**
+	 * Limit on the rate at which memory may be consumed.
+	 * Set by the regulator to pace transactions so that
+	 * dump and compaction keep up with the write load
+	 * instead of stalling all writers once the memory
+	 * limit is hit.
+	 */
+	struct vy_rate_limit rate_limit;
+	/** Timer refilling @rate_limit. */
+	ev_timer timer;
+	/**
+	 * Total time consumers spent waiting for quota,
+	 * in seconds.
+	 */
+	double throttle_time;
 	/**
 	 * Called if the limit is hit when quota is consumed.
 	 * It is supposed to trigger memory reclaim.
@@ -116,6 +195,13 @@ vy_quota_destroy(struct vy_quota *q);
 void
 vy_quota_set_limit(struct vy_quota *q, size_t limit);
 
+/**
+ * Set the rate at which memory may be consumed, in bytes
+ * per second. SIZE_MAX means no limit.
+ */
+void
+vy_quota_set_rate_limit(struct vy_quota *q, size_t rate);
+
 /**
  * Consume @size bytes of memory. In contrast to vy_quota_use()
  * this function does not throttle the caller.
@@ -131,8 +217,9 @@ vy_quota_release(struct vy_quota *q, size_t size);
 
 /**
  * Try to consume @size bytes of memory, throttle the caller
- * if the limit is exceeded. @timeout specifies the maximal
- * time to wait. Return 0 on success, -1 on timeout.
+ * if the limit is exceeded or the rate limit is depleted.
+ * @timeout specifies the maximal time to wait. Return 0 on
+ * success, -1 on timeout.
  *
  * Usage pattern:
  *
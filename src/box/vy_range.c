@@ -262,6 +262,32 @@ vy_range_remove_slice(struct vy_range *range, struct vy_slice *slice)
 	vy_disk_stmt_counter_sub(&range->count, &slice->count);
 }
 
+struct vy_slice *
+vy_range_next_run(struct vy_range *range, struct vy_slice *slice,
+		  uint32_t *slice_count, struct vy_disk_stmt_counter *count)
+{
+	*slice_count = 0;
+	vy_disk_stmt_counter_reset(count);
+	while (true) {
+		(*slice_count)++;
+		vy_disk_stmt_counter_add(count, &slice->count);
+		if (slice == rlist_last_entry(&range->slices,
+					      struct vy_slice, in_range))
+			return NULL;
+		struct vy_slice *next = rlist_next_entry(slice, in_range);
+		/*
+		 * Slices written by the same split compaction
+		 * follow each other in the key order and don't
+		 * overlap.
+		 */
+		if (slice->end == NULL || next->begin == NULL ||
+		    vy_key_compare(slice->end, next->begin,
+				   range->cmp_def) > 0)
+			return next;
+		slice = next;
+	}
+}
+
 /**
  * To reduce write amplification caused by compaction, we follow
  * the LSM tree design. Runs in each range are divided into groups
@@ -285,33 +311,17 @@ vy_range_remove_slice(struct vy_range *range, struct vy_slice *slice)
  * to be compacted and sets @compact_priority to the number of runs in
  * this level and all preceding levels.
  */
-void
-vy_range_update_compact_priority(struct vy_range *range,
-				 const struct index_opts *opts)
+static void
+vy_range_update_compact_priority_leveled(struct vy_range *range,
+					 const struct index_opts *opts)
 {
-	assert(opts->run_count_per_level > 0);
 	assert(opts->run_size_ratio > 1);
 
-	range->compact_priority = 0;
-	vy_disk_stmt_counter_reset(&range->compact_queue);
-
-	if (range->slice_count <= 1) {
-		/* Nothing to compact. */
-		range->needs_compaction = false;
-		return;
-	}
-
-	if (range->needs_compaction) {
-		range->compact_priority = range->slice_count;
-		range->compact_queue = range->count;
-		return;
-	}
-
 	/* Total number of statements in checked runs. */
 	struct vy_disk_stmt_counter total_stmt_count;
 	vy_disk_stmt_counter_reset(&total_stmt_count);
-	/* Total number of checked runs. */
-	uint32_t total_run_count = 0;
+	/* Total number of slices of checked runs. */
+	uint32_t total_slice_count = 0;
 	/* The total size of runs checked so far. */
 	uint64_t total_size = 0;
 	/* Estimated size of a compacted run, if compaction is scheduled. */
@@ -326,9 +336,13 @@ vy_range_update_compact_priority(struct vy_range *range,
 	 */
 	uint64_t target_run_size = 0;
 
-	struct vy_slice *slice;
-	rlist_foreach_entry(slice, &range->slices, in_range) {
-		uint64_t size = slice->count.bytes_compressed;
+	struct vy_slice *slice = rlist_first_entry(&range->slices,
+						   struct vy_slice, in_range);
+	while (slice != NULL) {
+		uint32_t slice_count;
+		struct vy_disk_stmt_counter count;
+		slice = vy_range_next_run(range, slice, &slice_count, &count);
+		uint64_t size = count.bytes_compressed;
 		/*
 		 * The size of the first level is defined by
 		 * the size of the most recent run.
@@ -337,8 +351,8 @@ vy_range_update_compact_priority(struct vy_range *range,
 			target_run_size = size;
 		total_size += size;
 		level_run_count++;
-		total_run_count++;
-		vy_disk_stmt_counter_add(&total_stmt_count, &slice->count);
+		total_slice_count += slice_count;
+		vy_disk_stmt_counter_add(&total_stmt_count, &count);
 		while (size > target_run_size) {
 			/*
 			 * The run size exceeds the threshold
@@ -375,13 +389,100 @@ vy_range_update_compact_priority(struct vy_range *range,
 			 * for compaction. We compact all runs at
 			 * this level and upper levels.
 			 */
-			range->compact_priority = total_run_count;
+			range->compact_priority = total_slice_count;
 			range->compact_queue = total_stmt_count;
 			est_new_run_size = total_size;
 		}
 	}
 }
 
+/**
+ * Tiered (aka universal) compaction trades read amplification for
+ * write amplification. A run is only merged with runs of a similar
+ * total size: starting from the newest run, we add older runs to
+ * the compaction candidate while each next run is not much bigger
+ * than all runs added so far taken together:
+ *
+ *   size(run_{k+1}) <= (size(run_1) + ... + size(run_k)) * slack
+ *
+ * If there are more than run_count_per_level runs in the candidate,
+ * we compact them. Unlike leveled compaction, a few small runs are
+ * never merged into a much bigger older run, so each statement is
+ * rewritten fewer times on its way to the last run. The price is
+ * that a range may have more runs, which slows down reads. Space
+ * amplification is bounded as well: once the newer runs grow as big
+ * as the oldest one, the oldest run is included in compaction, too.
+ */
+static void
+vy_range_update_compact_priority_tiered(struct vy_range *range,
+					const struct index_opts *opts)
+{
+	/*
+	 * Dumps triggered by the memory limit produce runs of
+	 * about the same size, which may differ by a few percent.
+	 * Allow for that so that such runs are merged together.
+	 */
+	const double slack = 1.1;
+
+	struct vy_disk_stmt_counter total_stmt_count;
+	vy_disk_stmt_counter_reset(&total_stmt_count);
+	uint32_t total_slice_count = 0;
+	uint32_t total_run_count = 0;
+	uint64_t total_size = 0;
+
+	struct vy_slice *slice = rlist_first_entry(&range->slices,
+						   struct vy_slice, in_range);
+	while (slice != NULL) {
+		uint32_t slice_count;
+		struct vy_disk_stmt_counter count;
+		slice = vy_range_next_run(range, slice, &slice_count, &count);
+		uint64_t size = count.bytes_compressed;
+		if (total_run_count > 0 && size > total_size * slack)
+			break;
+		total_size += size;
+		total_run_count++;
+		total_slice_count += slice_count;
+		vy_disk_stmt_counter_add(&total_stmt_count, &count);
+	}
+	if (total_run_count > opts->run_count_per_level) {
+		range->compact_priority = total_slice_count;
+		range->compact_queue = total_stmt_count;
+	}
+}
+
+void
+vy_range_update_compact_priority(struct vy_range *range,
+				 const struct index_opts *opts)
+{
+	assert(opts->run_count_per_level > 0);
+
+	range->compact_priority = 0;
+	vy_disk_stmt_counter_reset(&range->compact_queue);
+
+	if (range->slice_count <= 1) {
+		/* Nothing to compact. */
+		range->needs_compaction = false;
+		return;
+	}
+
+	if (range->needs_compaction) {
+		range->compact_priority = range->slice_count;
+		range->compact_queue = range->count;
+		return;
+	}
+
+	switch (opts->compaction) {
+	case COMPACTION_POLICY_LEVELED:
+		vy_range_update_compact_priority_leveled(range, opts);
+		break;
+	case COMPACTION_POLICY_TIERED:
+		vy_range_update_compact_priority_tiered(range, opts);
+		break;
+	default:
+		unreachable();
+	}
+}
+
 /**
  * Return true and set split_key accordingly if the range needs to be
  * split in two.
@@ -399,7 +500,7 @@ bool
 vy_range_needs_split(struct vy_range *range, const struct index_opts *opts,
 		     const char **p_split_key)
 {
-	struct vy_slice *slice;
+	struct vy_slice *slice, *next;
 
 	/* The range hasn't been merged yet - too early to split it. */
 	if (range->n_compactions < 1)
@@ -407,10 +508,36 @@ vy_range_needs_split(struct vy_range *range, const struct index_opts *opts,
 
 	/* Find the oldest run. */
 	assert(!rlist_empty(&range->slices));
-	slice = rlist_last_entry(&range->slices, struct vy_slice, in_range);
+	uint32_t slice_count;
+	struct vy_disk_stmt_counter count;
+	next = rlist_first_entry(&range->slices, struct vy_slice, in_range);
+	do {
+		slice = next;
+		next = vy_range_next_run(range, slice, &slice_count, &count);
+	} while (next != NULL);
 
 	/* The range is too small to be split. */
-	if (slice->count.bytes_compressed < opts->range_size * 4 / 3)
+	if (count.bytes_compressed < opts->range_size * 4 / 3)
+		return false;
+
+	/*
+	 * If the oldest run was written by a split compaction,
+	 * split the range by the boundary of the middle slice.
+	 */
+	if (slice_count > 1) {
+		for (uint32_t i = 0; i < slice_count / 2; i++)
+			slice = rlist_next_entry(slice, in_range);
+		assert(slice->begin != NULL);
+		*p_split_key = tuple_data(slice->begin);
+		return true;
+	}
+
+	/*
+	 * Don't load the page index just to check if the range
+	 * needs to be split. The check will be repeated after
+	 * the range is compacted.
+	 */
+	if (slice->run->index_evicted)
 		return false;
 
 	/* Find the median key in the oldest run (approximately). */
@@ -96,9 +96,11 @@ struct vy_range {
 	 * compacting L2, and both L1 and L2 are always included
 	 * when compacting L3.
 	 *
-	 * This variable contains the number of runs the next
-	 * compaction of this range will include. If it is 0,
-	 * the range doesn't need to be compacted.
+	 * This variable contains the number of slices the next
+	 * compaction of this range will include (a run written
+	 * by a split compaction consists of several slices, see
+	 * vy_range_next_run()). If it is 0, the range doesn't
+	 * need to be compacted.
 	 *
 	 * The lower the level is scheduled for compaction,
 	 * the bigger it tends to be because upper levels are
@@ -232,6 +234,25 @@ vy_range_add_slice_before(struct vy_range *range, struct vy_slice *slice,
 void
 vy_range_remove_slice(struct vy_range *range, struct vy_slice *slice);
 
+/**
+ * A compaction of a big range may be split into several key
+ * intervals processed in parallel, see vy_task_compact_new().
+ * The result is stored in several runs, one per interval, whose
+ * slices follow each other in the range in the key order. Since
+ * the slices don't overlap, a lookup reads at most one of them,
+ * so they are treated as a single run when choosing what to
+ * compact.
+ *
+ * Given the first slice of a run, this function returns the
+ * number of slices the run is stored in and their statement
+ * count in @slice_count and @count. The return value is the
+ * first slice of the next (older) run or NULL if @slice belongs
+ * to the oldest run.
+ */
+struct vy_slice *
+vy_range_next_run(struct vy_range *range, struct vy_slice *slice,
+		  uint32_t *slice_count, struct vy_disk_stmt_counter *count);
+
 /**
  * Update compaction priority of a range.
  *
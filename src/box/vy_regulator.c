@@ -41,6 +41,7 @@
 #include "trivia/util.h"
 
 #include "vy_quota.h"
+#include "vy_stat.h"
 
 /**
  * Regulator timer period, in seconds.
@@ -65,6 +66,27 @@ static const int VY_DUMP_BANDWIDTH_PCT = 10;
  */
 static const size_t VY_DUMP_BANDWIDTH_DEFAULT = 10 * 1024 * 1024;
 
+/**
+ * Time window over which the compaction rate is averaged,
+ * in seconds. Compaction statistics are only updated when
+ * a task completes, which may take a while, hence a much
+ * wider window than the one used for the write rate.
+ */
+static const double VY_COMPACTION_RATE_AVG_WIN = 60;
+
+/**
+ * Max amount of data that may await compaction before we
+ * start throttling transactions, as a multiple of the memory
+ * limit.
+ */
+static const double VY_COMPACTION_DEBT_MAX_RATIO = 4;
+
+/**
+ * Transactions are never throttled below this rate, in bytes
+ * per second, so that a misprediction can't stall them.
+ */
+static const size_t VY_RATE_LIMIT_MIN = 100 * 1024;
+
 static void
 vy_regulator_update_write_rate(struct vy_regulator *regulator)
 {
@@ -93,6 +115,92 @@ vy_regulator_update_write_rate(struct vy_regulator *regulator)
 	regulator->quota_used_last = used_curr;
 }
 
+static void
+vy_regulator_update_compaction_rate(struct vy_regulator *regulator)
+{
+	const struct vy_disk_stat *stat = regulator->disk_stat;
+	int64_t in_curr = stat->compact.in;
+	int64_t in_last = regulator->compaction_in_last;
+
+	regulator->compaction_debt = MAX(stat->compact.queue, 0);
+
+	/* The counter is reset by box.stat.reset(). */
+	if (in_curr < in_last) {
+		regulator->compaction_in_last = in_curr;
+		return;
+	}
+
+	size_t rate_avg = regulator->compaction_rate;
+	size_t rate_curr = (in_curr - in_last) / VY_REGULATOR_TIMER_PERIOD;
+
+	double weight = 1 - exp(-VY_REGULATOR_TIMER_PERIOD /
+				VY_COMPACTION_RATE_AVG_WIN);
+	rate_avg = (1 - weight) * rate_avg + weight * rate_curr;
+
+	regulator->compaction_rate = rate_avg;
+	regulator->compaction_in_last = in_curr;
+}
+
+static void
+vy_regulator_update_compaction_rate_limit(struct vy_regulator *regulator)
+{
+	double debt_max = (double)regulator->quota->limit *
+			  VY_COMPACTION_DEBT_MAX_RATIO;
+	if (regulator->compaction_debt <= debt_max ||
+	    regulator->compaction_rate == 0) {
+		regulator->compaction_rate_limit = SIZE_MAX;
+		return;
+	}
+	/*
+	 * Writing at the compaction rate keeps the debt at the
+	 * same level. Go slower in proportion to the excess so
+	 * that compaction can catch up.
+	 */
+	regulator->compaction_rate_limit = regulator->compaction_rate *
+				debt_max / regulator->compaction_debt;
+}
+
+/**
+ * Return the write rate limit required to avoid hitting
+ * the memory limit before the dump in progress completes.
+ */
+static size_t
+vy_regulator_dump_rate_limit(struct vy_regulator *regulator)
+{
+	struct vy_quota *quota = regulator->quota;
+
+	if (quota->used < regulator->dump_watermark || quota->used == 0)
+		return SIZE_MAX;
+	if (quota->used >= quota->limit)
+		return 0;
+	/*
+	 * Memory is freed only when dump completes so what is
+	 * left must suffice until then, i.e.
+	 *
+	 *   limit - used        used
+	 *   ------------ = --------------
+	 *    rate_limit    dump_bandwidth
+	 *
+	 * Note, at the watermark this gives exactly the current
+	 * write rate so transactions are slowed down smoothly.
+	 */
+	return (double)(quota->limit - quota->used) *
+		regulator->dump_bandwidth / quota->used;
+}
+
+static void
+vy_regulator_update_rate_limit(struct vy_regulator *regulator)
+{
+	size_t rate_limit = MIN(vy_regulator_dump_rate_limit(regulator),
+				regulator->compaction_rate_limit);
+	if (rate_limit != SIZE_MAX)
+		rate_limit = MAX(rate_limit, VY_RATE_LIMIT_MIN);
+	if (rate_limit != regulator->rate_limit) {
+		regulator->rate_limit = rate_limit;
+		vy_quota_set_rate_limit(regulator->quota, rate_limit);
+	}
+}
+
 static void
 vy_regulator_update_dump_watermark(struct vy_regulator *regulator)
 {
@@ -124,11 +232,14 @@ vy_regulator_timer_cb(ev_loop *loop, ev_timer *timer, int events)
 
 	vy_regulator_update_write_rate(regulator);
 	vy_regulator_update_dump_watermark(regulator);
+	vy_regulator_update_compaction_rate(regulator);
+	vy_regulator_update_compaction_rate_limit(regulator);
 	vy_regulator_check_dump_watermark(regulator);
 }
 
 void
 vy_regulator_create(struct vy_regulator *regulator, struct vy_quota *quota,
+		    const struct vy_disk_stat *disk_stat,
 		    vy_trigger_dump_f trigger_dump_cb)
 {
 	enum { KB = 1024, MB = KB * KB };
@@ -148,6 +259,7 @@ vy_regulator_create(struct vy_regulator *regulator, struct vy_quota *quota,
 		panic("failed to allocate dump bandwidth histogram");
 
 	regulator->quota = quota;
+	regulator->disk_stat = disk_stat;
 	regulator->trigger_dump_cb = trigger_dump_cb;
 	ev_timer_init(&regulator->timer, vy_regulator_timer_cb, 0,
 		      VY_REGULATOR_TIMER_PERIOD);
@@ -156,12 +268,18 @@ vy_regulator_create(struct vy_regulator *regulator, struct vy_quota *quota,
 	regulator->quota_used_last = 0;
 	regulator->dump_bandwidth = VY_DUMP_BANDWIDTH_DEFAULT;
 	regulator->dump_watermark = SIZE_MAX;
+	regulator->compaction_rate = 0;
+	regulator->compaction_in_last = 0;
+	regulator->compaction_debt = 0;
+	regulator->compaction_rate_limit = SIZE_MAX;
+	regulator->rate_limit = SIZE_MAX;
 }
 
 void
 vy_regulator_start(struct vy_regulator *regulator)
 {
 	regulator->quota_used_last = regulator->quota->used;
+	regulator->compaction_in_last = regulator->disk_stat->compact.in;
 	ev_timer_start(loop(), &regulator->timer);
 }
 
@@ -183,6 +301,7 @@ vy_regulator_check_dump_watermark(struct vy_regulator *regulator)
 {
 	if (regulator->quota->used >= regulator->dump_watermark)
 		regulator->trigger_dump_cb(regulator);
+	vy_regulator_update_rate_limit(regulator);
 }
 
 void
@@ -201,6 +320,8 @@ vy_regulator_dump_complete(struct vy_regulator *regulator,
 		regulator->dump_bandwidth = histogram_percentile_lower(
 			regulator->dump_bandwidth_hist, VY_DUMP_BANDWIDTH_PCT);
 	}
+	/* Memory was freed, lift the dump rate limit. */
+	vy_regulator_update_rate_limit(regulator);
 }
 
 void
@@ -39,6 +39,7 @@ extern "C" {
 #endif /* defined(__cplusplus) */
 
 struct histogram;
+struct vy_disk_stat;
 struct vy_quota;
 struct vy_regulator;
 
@@ -56,6 +57,11 @@ struct vy_regulator {
 	 * memory usage.
 	 */
 	struct vy_quota *quota;
+	/**
+	 * Global disk statistics, used for estimating
+	 * compaction progress.
+	 */
+	const struct vy_disk_stat *disk_stat;
 	/**
 	 * Called when the regulator detects that memory usage
 	 * exceeds the computed watermark. Supposed to trigger
@@ -100,10 +106,46 @@ struct vy_regulator {
 	 * background memory reclaim.
 	 */
 	size_t dump_watermark;
+	/**
+	 * Average rate at which compaction processes data,
+	 * in bytes per second.
+	 */
+	size_t compaction_rate;
+	/**
+	 * Amount of data compacted by the time the timer was
+	 * executed last time. Needed to update @compaction_rate.
+	 */
+	int64_t compaction_in_last;
+	/**
+	 * Amount of data awaiting compaction, in bytes, as of
+	 * the last timer invocation.
+	 */
+	size_t compaction_debt;
+	/**
+	 * Write rate limit imposed to let compaction catch up
+	 * once @compaction_debt exceeds the allowed maximum.
+	 * SIZE_MAX if compaction keeps up with the load.
+	 */
+	size_t compaction_rate_limit;
+	/**
+	 * Current transaction write rate limit, in bytes per
+	 * second, as set in the quota. SIZE_MAX if transactions
+	 * aren't throttled.
+	 *
+	 * Instead of letting transactions consume memory at full
+	 * speed until the limit is hit and then stalling them all
+	 * until dump completes, we slow them down gradually as
+	 * memory fills up so that the remaining memory lasts
+	 * until the dump in progress is over. Besides, we slow
+	 * transactions down when compaction falls behind so that
+	 * it doesn't pile up too much work.
+	 */
+	size_t rate_limit;
 };
 
 void
 vy_regulator_create(struct vy_regulator *regulator, struct vy_quota *quota,
+		    const struct vy_disk_stat *disk_stat,
 		    vy_trigger_dump_f trigger_dump_cb);
 
 void
@@ -114,7 +156,7 @@ vy_regulator_destroy(struct vy_regulator *regulator);
 
 /**
  * Check if memory usage is above the watermark and trigger
- * memory dump if so.
+ * memory dump if so. Update the write rate limit accordingly.
  */
 void
 vy_regulator_check_dump_watermark(struct vy_regulator *regulator);
@@ -30,14 +30,18 @@
  */
 #include "vy_run.h"
 
+#include <fcntl.h>
+#include <unistd.h>
 #include <zstd.h>
 
+#include "trivia/config.h"
 #include "fiber.h"
 #include "fiber_cond.h"
 #include "fio.h"
 #include "cbus.h"
 #include "memory.h"
 #include "coio_file.h"
+#include "io_ring.h"
 
 #include "replication.h"
 #include "tuple_bloom.h"
@@ -83,6 +87,16 @@ struct vy_run_reader {
 	struct cpipe reader_pipe;
 	/** Pipe from the reader thread to tx. */
 	struct cpipe tx_pipe;
+	/** Route of a page readahead request, see vy_page_prefetch. */
+	struct cmsg_hop prefetch_route[2];
+	/**
+	 * If io_uring is used, the thread submits reads of pages
+	 * requested with vy_page_prefetch to this ring, so that
+	 * it doesn't block on disk and may have many reads in
+	 * flight. Pages are decoded by the thread when the reads
+	 * complete.
+	 */
+	struct io_ring ring;
 };
 
 /** Cbus task for vinyl page read. */
@@ -97,6 +111,109 @@ struct vy_page_read_task {
 	struct vy_page *page;
 };
 
+/**
+ * Request to read a page ahead of time sent by a run iterator
+ * to a reader thread. Unlike vy_page_read_task, the iterator
+ * doesn't wait for the request to complete until it actually
+ * needs the page, see vy_run_iterator_readahead().
+ */
+struct vy_page_prefetch {
+	/** Message routed to the reader thread and back. */
+	struct cmsg base;
+	/** vy_run with fd - ref. counted */
+	struct vy_run *run;
+	/** vinyl page metadata */
+	struct vy_page_info page_info;
+	/** Page number in the run file. */
+	uint32_t page_no;
+	/** [out] resulting vinyl page */
+	struct vy_page *page;
+	/** Set if the reader thread failed to read the page. */
+	bool is_failed;
+	/** Set when the request returns to tx. */
+	bool is_done;
+	/**
+	 * Set if the iterator that sent the request doesn't
+	 * need the page anymore. The request is freed as soon
+	 * as it returns to tx then.
+	 */
+	bool is_abandoned;
+	/** Signaled when the request returns to tx. */
+	struct fiber_cond done_cond;
+	/** Next page read ahead by the same iterator. */
+	struct vy_page_prefetch *next;
+	/** Reader thread the request was sent to. */
+	struct vy_run_reader *reader;
+	/** Read request submitted to vy_run_reader::ring. */
+	struct io_ring_req req;
+	/** Buffer of the read request. */
+	void *buf;
+};
+
+static void
+vy_page_prefetch_read_f(struct cmsg *base);
+
+static void
+vy_page_prefetch_done_f(struct cmsg *base);
+
+static void
+vy_run_iterator_discard_prefetch(struct vy_run_iterator *itr);
+
+/** Max number of page reads in flight per reader thread. */
+enum { VY_RUN_RING_SIZE = 256 };
+
+/** Key of a page in the page cache. */
+struct vy_page_cache_key {
+	/** ID of the run the page belongs to. */
+	int64_t run_id;
+	/** Page number in the run file. */
+	uint32_t page_no;
+};
+
+static inline uint32_t
+vy_page_cache_hash(int64_t run_id, uint32_t page_no)
+{
+	uint64_t h = (uint64_t)run_id * 0x9E3779B97F4A7C15ULL ^ page_no;
+	return (uint32_t)(h ^ (h >> 32));
+}
+
+#define mh_name _vy_page_cache
+#define mh_key_t const struct vy_page_cache_key *
+#define mh_node_t struct vy_page *
+#define mh_arg_t void *
+#define mh_hash(a, arg) vy_page_cache_hash((*(a))->run_id, (*(a))->page_no)
+#define mh_hash_key(a, arg) vy_page_cache_hash((a)->run_id, (a)->page_no)
+#define mh_cmp(a, b, arg) ((*(a))->run_id != (*(b))->run_id || \
+			   (*(a))->page_no != (*(b))->page_no)
+#define mh_cmp_key(a, b, arg) ((a)->run_id != (*(b))->run_id || \
+			       (a)->page_no != (*(b))->page_no)
+#define MH_SOURCE 1
+#include "salad/mhash.h"
+
+static void
+vy_page_cache_create(struct vy_page_cache *cache);
+
+static void
+vy_page_cache_destroy(struct vy_page_cache *cache);
+
+static void
+vy_page_cache_evict_run(struct vy_page_cache *cache, struct vy_run *run);
+
+static void
+vy_run_index_cache_truncate(struct vy_run_env *env);
+
+/** Cbus task for loading a run index evicted from memory. */
+struct vy_run_index_load_task {
+	/** parent */
+	struct cbus_call_msg base;
+	/** vy_run to load index for - ref. counted */
+	struct vy_run *run;
+	/** [out] run info read from the index file */
+	struct vy_run_info info;
+	/** [out] page index read from the index file */
+	struct vy_page_info *page_info;
+};
+
 /** Destructor for env->zdctx_key thread-local variable */
 static void
 vy_free_zdctx(void *arg)
@@ -115,12 +232,44 @@ vy_run_reader_f(va_list ap)
 	cpipe_create(&reader->tx_pipe, "tx_prio");
 	cbus_endpoint_create(&endpoint, cord_name(cord()),
 			     fiber_schedule_cb, fiber());
+	if (io_ring_is_created(&reader->ring))
+		io_ring_start(&reader->ring);
 	cbus_loop(&endpoint);
+	if (io_ring_is_created(&reader->ring))
+		io_ring_stop(&reader->ring);
 	cbus_endpoint_destroy(&endpoint, cbus_process);
 	cpipe_destroy(&reader->tx_pipe);
 	return 0;
 }
 
+/**
+ * Create io_uring rings of reader threads. If one can't be
+ * created, no ring is used.
+ */
+static void
+vy_run_env_create_rings(struct vy_run_env *env)
+{
+	for (int i = 0; i < env->reader_pool_size; i++) {
+		struct vy_run_reader *reader = &env->reader_pool[i];
+		if (io_ring_create(&reader->ring, VY_RUN_RING_SIZE) == 0)
+			continue;
+		diag_log();
+		say_warn("io_uring is unavailable, "
+			 "falling back to blocking reads of runs");
+		while (--i >= 0)
+			io_ring_destroy(&env->reader_pool[i].ring);
+		return;
+	}
+}
+
+/** Return true if reader threads read pages with io_uring. */
+static inline bool
+vy_run_env_has_rings(struct vy_run_env *env)
+{
+	return env->reader_pool != NULL &&
+	       io_ring_is_created(&env->reader_pool[0].ring);
+}
+
 /** Start run reader threads. */
 static void
 vy_run_env_start_readers(struct vy_run_env *env)
@@ -133,6 +282,11 @@ vy_run_env_start_readers(struct vy_run_env *env)
 	if (env->reader_pool == NULL)
 		panic("failed to allocate vinyl reader thread pool");
 
+	for (int i = 0; i < env->reader_pool_size; i++)
+		env->reader_pool[i].ring.fd = -1;
+	if (env->use_io_uring)
+		vy_run_env_create_rings(env);
+
 	for (int i = 0; i < env->reader_pool_size; i++) {
 		struct vy_run_reader *reader = &env->reader_pool[i];
 		char name[FIBER_NAME_MAX];
@@ -142,6 +296,17 @@ vy_run_env_start_readers(struct vy_run_env *env)
 				 vy_run_reader_f, reader) != 0)
 			panic("failed to start vinyl reader thread");
 		cpipe_create(&reader->reader_pipe, name);
+
+		/*
+		 * The reader thread sends the request back to tx
+		 * by itself once the page is read, see
+		 * vy_page_prefetch_return().
+		 */
+		struct cmsg_hop *route = reader->prefetch_route;
+		route[0].f = vy_page_prefetch_read_f;
+		route[0].pipe = NULL;
+		route[1].f = vy_page_prefetch_done_f;
+		route[1].pipe = NULL;
 	}
 	env->next_reader = 0;
 }
@@ -157,6 +322,8 @@ vy_run_env_stop_readers(struct vy_run_env *env)
 		cpipe_destroy(&reader->reader_pipe);
 		if (cord_join(&reader->cord) != 0)
 			panic("failed to join vinyl reader thread");
+		if (io_ring_is_created(&reader->ring))
+			io_ring_destroy(&reader->ring);
 	}
 	free(env->reader_pool);
 }
@@ -172,6 +339,8 @@ vy_run_env_create(struct vy_run_env *env, int read_threads)
 	tt_pthread_key_create(&env->zdctx_key, vy_free_zdctx);
 	mempool_create(&env->read_task_pool, cord_slab_cache(),
 		       sizeof(struct vy_page_read_task));
+	vy_page_cache_create(&env->page_cache);
+	rlist_create(&env->index_cache.lru);
 }
 
 /**
@@ -182,6 +351,7 @@ vy_run_env_destroy(struct vy_run_env *env)
 {
 	if (env->reader_pool != NULL)
 		vy_run_env_stop_readers(env);
+	vy_page_cache_destroy(&env->page_cache);
 	mempool_destroy(&env->read_task_pool);
 	tt_pthread_key_delete(env->zdctx_key);
 }
@@ -195,6 +365,8 @@ vy_run_env_enable_coio(struct vy_run_env *env)
 	if (env->reader_pool != NULL)
 		return; /* already enabled */
 	vy_run_env_start_readers(env);
+	/* Run indexes aren't evicted during recovery. */
+	vy_run_index_cache_truncate(env);
 }
 
 /**
@@ -240,46 +412,156 @@ vy_run_new(struct vy_run_env *env, int64_t id)
 	run->refs = 1;
 	rlist_create(&run->in_lsm);
 	rlist_create(&run->in_unused);
+	rlist_create(&run->cached_pages);
+	rlist_create(&run->in_index_lru);
 	return run;
 }
 
+/** Free an array of page info structs. */
 static void
-vy_run_clear(struct vy_run *run)
+vy_page_info_array_delete(struct vy_page_info *page_info, uint32_t count)
+{
+	if (page_info == NULL)
+		return;
+	for (uint32_t page_no = 0; page_no < count; ++page_no)
+		vy_page_info_destroy(page_info + page_no);
+	free(page_info);
+}
+
+/** Free memory allocated for run info. */
+static void
+vy_run_info_destroy(struct vy_run_info *info)
 {
-	if (run->page_info != NULL) {
-		uint32_t page_no;
-		for (page_no = 0; page_no < run->info.page_count; ++page_no)
-			vy_page_info_destroy(run->page_info + page_no);
-		free(run->page_info);
+	if (info->bloom != NULL) {
+		tuple_bloom_delete(info->bloom);
+		info->bloom = NULL;
 	}
+	free(info->min_key);
+	info->min_key = NULL;
+	free(info->max_key);
+	info->max_key = NULL;
+	free(info->blobs);
+	info->blobs = NULL;
+	info->blob_count = 0;
+}
+
+static void
+vy_run_clear(struct vy_run *run)
+{
+	vy_page_info_array_delete(run->page_info, run->info.page_count);
 	run->page_info = NULL;
 	run->page_index_size = 0;
+	run->bloom_size = 0;
 	run->info.page_count = 0;
-	if (run->info.bloom != NULL) {
-		tuple_bloom_delete(run->info.bloom);
-		run->info.bloom = NULL;
-	}
-	free(run->info.min_key);
-	run->info.min_key = NULL;
-	free(run->info.max_key);
-	run->info.max_key = NULL;
+	vy_run_info_destroy(&run->info);
 }
 
 void
 vy_run_delete(struct vy_run *run)
 {
 	assert(run->refs == 0);
+	/*
+	 * Pages are only cached by tx so the list is empty
+	 * for runs created and deleted in other threads.
+	 */
+	if (!rlist_empty(&run->cached_pages))
+		vy_page_cache_evict_run(&run->env->page_cache, run);
+	if (run->in_index_cache)
+		vy_run_index_cache_remove(run);
 	if (run->fd >= 0 && close(run->fd) < 0)
 		say_syserror("close failed");
+	if (run->blobs != NULL) {
+		for (uint32_t i = 0; i < run->info.blob_count; i++)
+			vy_blob_unref(run->blobs[i]);
+		free(run->blobs);
+	}
 	vy_run_clear(run);
 	TRASH(run);
 	free(run);
 }
 
+int
+vy_run_bind_blobs(struct vy_run *run, struct rlist *lsm_blobs,
+		  struct vy_blob *new_blob)
+{
+	assert(run->blobs == NULL);
+	uint32_t count = run->info.blob_count;
+	if (count == 0)
+		return 0;
+	size_t size = count * sizeof(*run->blobs);
+	struct vy_blob **blobs = malloc(size);
+	if (blobs == NULL) {
+		diag_set(OutOfMemory, size, "malloc", "struct vy_blob");
+		return -1;
+	}
+	for (uint32_t i = 0; i < count; i++) {
+		int64_t id = run->info.blobs[i].id;
+		struct vy_blob *blob = NULL;
+		if (new_blob != NULL && new_blob->id == id) {
+			blob = new_blob;
+		} else {
+			struct vy_blob *b;
+			rlist_foreach_entry(b, lsm_blobs, in_lsm) {
+				if (b->id == id) {
+					blob = b;
+					break;
+				}
+			}
+		}
+		if (blob == NULL) {
+			diag_set(ClientError, ER_INVALID_RUN_FILE,
+				 tt_sprintf("Missing blob file %lld "
+					    "referenced by run %lld",
+					    (long long)id, (long long)run->id));
+			for (uint32_t j = 0; j < i; j++)
+				vy_blob_unref(blobs[j]);
+			free(blobs);
+			return -1;
+		}
+		vy_blob_ref(blob);
+		blobs[i] = blob;
+	}
+	run->blobs = blobs;
+	return 0;
+}
+
+/**
+ * Reopen the data file of a run with O_DIRECT if the run
+ * environment is configured to bypass the page cache. Called
+ * once the file descriptor is set. On failure, a warning is
+ * logged and the run goes on reading the file through the
+ * page cache.
+ */
+static void
+vy_run_open_direct(struct vy_run *run, const char *path)
+{
+	if (!run->env->direct_io)
+		return;
+#ifdef O_DIRECT
+	int fd = open(path, O_RDONLY | O_DIRECT);
+	if (fd < 0) {
+		say_syserror("failed to open `%s' with O_DIRECT, "
+			     "falling back on buffered reads", path);
+		return;
+	}
+#ifdef HAVE_POSIX_FADVISE
+	/* Drop pages cached while the file was written or checked. */
+	posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+#endif
+	if (close(run->fd) < 0)
+		say_syserror("close failed");
+	run->fd = fd;
+	run->is_direct = true;
+#else
+	say_warn("O_DIRECT is unsupported, `%s' is read "
+		 "through the page cache", path);
+#endif
+}
+
 size_t
 vy_run_bloom_size(struct vy_run *run)
 {
-	return run->info.bloom == NULL ? 0 : tuple_bloom_size(run->info.bloom);
+	return run->bloom_size;
 }
 
 /**
@@ -368,6 +650,18 @@ struct vy_slice *
 vy_slice_new(int64_t id, struct vy_run *run, struct tuple *begin,
 	     struct tuple *end, struct key_def *cmp_def)
 {
+	if (run->index_evicted) {
+		/*
+		 * The page index is needed to find the slice
+		 * boundaries. Since this function doesn't yield,
+		 * the index can't be evicted until it returns.
+		 * Callers running in tx are supposed to load it
+		 * in advance, see vy_task_compact_new().
+		 */
+		if (vy_run_pin_index(run, false) != 0)
+			return NULL;
+		vy_run_unpin_index(run);
+	}
 	struct vy_slice *slice = malloc(sizeof(*slice));
 	if (slice == NULL) {
 		diag_set(OutOfMemory, sizeof(*slice),
@@ -542,6 +836,31 @@ vy_page_info_decode(struct vy_page_info *page, const struct xrow_header *xrow,
 	return 0;
 }
 
+/** Decode the array of blob files referenced by a run. */
+static int
+vy_run_info_decode_blobs(struct vy_run_info *run_info, const char **pos)
+{
+	uint32_t count = mp_decode_array(pos);
+	size_t size = count * sizeof(*run_info->blobs);
+	struct vy_run_blob_info *blobs = malloc(size);
+	if (blobs == NULL) {
+		diag_set(OutOfMemory, size, "malloc",
+			 "struct vy_run_blob_info");
+		return -1;
+	}
+	for (uint32_t i = 0; i < count; i++) {
+		uint32_t n = mp_decode_array(pos);
+		assert(n == 2);
+		(void)n;
+		blobs[i].id = mp_decode_uint(pos);
+		blobs[i].size = mp_decode_uint(pos);
+	}
+	free(run_info->blobs);
+	run_info->blobs = blobs;
+	run_info->blob_count = count;
+	return 0;
+}
+
 /**
  * Decode the run metadata from xrow.
  *
@@ -603,6 +922,10 @@ vy_run_info_decode(struct vy_run_info *run_info,
 			if (run_info->bloom == NULL)
 				return -1;
 			break;
+		case VY_RUN_INFO_BLOBS:
+			if (vy_run_info_decode_blobs(run_info, &pos) != 0)
+				return -1;
+			break;
 		default:
 			diag_set(ClientError, ER_INVALID_INDEX_FILE, filename,
 				"Can't decode run info: unknown key %u",
@@ -632,6 +955,9 @@ vy_page_new(const struct vy_page_info *page_info)
 	}
 	page->unpacked_size = page_info->unpacked_size;
 	page->row_count = page_info->row_count;
+	page->refs = 1;
+	page->run_id = -1;
+	page->in_cache = false;
 	page->row_index = calloc(page_info->row_count, sizeof(uint32_t));
 	if (page->row_index == NULL) {
 		diag_set(OutOfMemory, page_info->row_count * sizeof(uint32_t),
@@ -666,6 +992,169 @@ vy_page_delete(struct vy_page *page)
 	free(page);
 }
 
+static inline void
+vy_page_ref(struct vy_page *page)
+{
+	assert(page->refs > 0);
+	page->refs++;
+}
+
+static inline void
+vy_page_unref(struct vy_page *page)
+{
+	assert(page->refs > 0);
+	if (--page->refs == 0)
+		vy_page_delete(page);
+}
+
+/** Size of memory occupied by a page. */
+static inline size_t
+vy_page_mem_size(const struct vy_page *page)
+{
+	return sizeof(*page) + page->unpacked_size +
+	       page->row_count * sizeof(*page->row_index);
+}
+
+static void
+vy_page_cache_create(struct vy_page_cache *cache)
+{
+	cache->hash = mh_vy_page_cache_new();
+	if (cache->hash == NULL)
+		panic("failed to allocate vinyl page cache");
+	rlist_create(&cache->lru);
+	cache->mem_used = 0;
+	cache->mem_quota = 0;
+	cache->hit = cache->miss = cache->evict = 0;
+}
+
+/** Remove a page from the cache and drop the cache reference. */
+static void
+vy_page_cache_evict(struct vy_page_cache *cache, struct vy_page *page)
+{
+	assert(page->in_cache);
+	struct vy_page_cache_key key = { page->run_id, page->page_no };
+	mh_int_t k = mh_vy_page_cache_find(cache->hash, &key, NULL);
+	assert(k != mh_end(cache->hash));
+	mh_vy_page_cache_del(cache->hash, k, NULL);
+	rlist_del_entry(page, in_lru);
+	rlist_del_entry(page, in_run);
+	page->in_cache = false;
+	assert(cache->mem_used >= vy_page_mem_size(page));
+	cache->mem_used -= vy_page_mem_size(page);
+	vy_page_unref(page);
+}
+
+static void
+vy_page_cache_destroy(struct vy_page_cache *cache)
+{
+	while (!rlist_empty(&cache->lru)) {
+		struct vy_page *page = rlist_first_entry(&cache->lru,
+						struct vy_page, in_lru);
+		vy_page_cache_evict(cache, page);
+	}
+	mh_vy_page_cache_delete(cache->hash);
+}
+
+/** Evict all pages of a run from the cache. */
+static void
+vy_page_cache_evict_run(struct vy_page_cache *cache, struct vy_run *run)
+{
+	while (!rlist_empty(&run->cached_pages)) {
+		struct vy_page *page = rlist_first_entry(&run->cached_pages,
+						struct vy_page, in_run);
+		vy_page_cache_evict(cache, page);
+	}
+}
+
+/** Evict the oldest pages until the cache fits in its limit. */
+static void
+vy_page_cache_truncate(struct vy_page_cache *cache)
+{
+	while (cache->mem_used > cache->mem_quota) {
+		assert(!rlist_empty(&cache->lru));
+		struct vy_page *page = rlist_last_entry(&cache->lru,
+						struct vy_page, in_lru);
+		vy_page_cache_evict(cache, page);
+		cache->evict++;
+	}
+}
+
+/**
+ * Look up a page in the cache. Return NULL if the page isn't
+ * cached or the cache is disabled. The returned page isn't
+ * referenced.
+ */
+static struct vy_page *
+vy_page_cache_lookup(struct vy_page_cache *cache, struct vy_run *run,
+		     uint32_t page_no)
+{
+	/* The cache isn't thread-safe, see vy_run_env::page_cache. */
+	if (cache->mem_quota == 0 || !cord_is_main())
+		return NULL;
+	struct vy_page_cache_key key = { run->id, page_no };
+	mh_int_t k = mh_vy_page_cache_find(cache->hash, &key, NULL);
+	if (k == mh_end(cache->hash)) {
+		cache->miss++;
+		return NULL;
+	}
+	struct vy_page *page = *mh_vy_page_cache_node(cache->hash, k);
+	rlist_move_entry(&cache->lru, page, in_lru);
+	cache->hit++;
+	return page;
+}
+
+/**
+ * Check if a page is stored in the cache. Unlike lookup, this
+ * function doesn't account the page access.
+ */
+static bool
+vy_page_cache_contains(struct vy_page_cache *cache, struct vy_run *run,
+		       uint32_t page_no)
+{
+	if (cache->mem_quota == 0 || !cord_is_main())
+		return false;
+	struct vy_page_cache_key key = { run->id, page_no };
+	return mh_vy_page_cache_find(cache->hash, &key,
+				     NULL) != mh_end(cache->hash);
+}
+
+/**
+ * Add a page read from disk to the cache. The page may already
+ * be there if it was loaded by another fiber while we were
+ * waiting for disk, in which case the function does nothing.
+ */
+static void
+vy_page_cache_put(struct vy_page_cache *cache, struct vy_run *run,
+		  struct vy_page *page)
+{
+	assert(!page->in_cache);
+	size_t size = vy_page_mem_size(page);
+	if (size > cache->mem_quota || !cord_is_main())
+		return;
+	page->run_id = run->id;
+	struct vy_page_cache_key key = { page->run_id, page->page_no };
+	if (mh_vy_page_cache_find(cache->hash, &key, NULL) !=
+	    mh_end(cache->hash))
+		return;
+	if (mh_vy_page_cache_put(cache->hash, &page, NULL,
+				 NULL) == mh_end(cache->hash))
+		return; /* out of memory, not critical */
+	vy_page_ref(page);
+	page->in_cache = true;
+	rlist_add_entry(&cache->lru, page, in_lru);
+	rlist_add_tail_entry(&run->cached_pages, page, in_run);
+	cache->mem_used += size;
+	vy_page_cache_truncate(cache);
+}
+
+void
+vy_run_env_set_page_cache_quota(struct vy_run_env *env, size_t quota)
+{
+	struct vy_page_cache *cache = &env->page_cache;
+	cache->mem_quota = quota;
+	vy_page_cache_truncate(cache);
+}
+
 static int
 vy_page_xrow(struct vy_page *page, uint32_t stmt_no,
 	     struct xrow_header *xrow)
@@ -713,11 +1202,14 @@ vy_run_iterator_stop(struct vy_run_iterator *itr)
 		itr->curr_stmt = NULL;
 	}
 	if (itr->curr_page != NULL) {
-		vy_page_delete(itr->curr_page);
+		vy_page_unref(itr->curr_page);
 		if (itr->prev_page != NULL)
-			vy_page_delete(itr->prev_page);
+			vy_page_unref(itr->prev_page);
 		itr->curr_page = itr->prev_page = NULL;
 	}
+	vy_run_iterator_discard_prefetch(itr);
+	itr->last_page_no = UINT32_MAX;
+	itr->seq_page_count = 0;
 	itr->search_ended = true;
 }
 
@@ -762,127 +1254,542 @@ vy_run_filename(struct vy_run *run)
 	return buf;
 }
 
+/** Log a page read error set in diag. */
+static void
+vy_page_read_error(struct vy_run *run, const struct vy_page_info *page_info)
+{
+	diag_log();
+	say_error("error reading %s@%llu:%u", vy_run_filename(run),
+		  (unsigned long long)page_info->offset,
+		  (unsigned)page_info->size);
+}
+
 /**
- * Read a page requests from vinyl xlog data file.
+ * Check the result of reading page data from disk.
  *
  * @retval 0 on success
  * @retval -1 on error, check diag
  */
 static int
-vy_page_read(struct vy_page *page, const struct vy_page_info *page_info,
-	     struct vy_run *run, ZSTD_DStream *zdctx)
+vy_page_check_read(const struct vy_page_info *page_info, ssize_t readen)
 {
-	/* read xlog tx from xlog file */
-	size_t region_svp = region_used(&fiber()->gc);
-	char *data = (char *)region_alloc(&fiber()->gc, page_info->size);
-	if (data == NULL) {
-		diag_set(OutOfMemory, page_info->size, "region gc", "page");
-		return -1;
-	}
-	ssize_t readen = fio_pread(run->fd, data, page_info->size,
-				   page_info->offset);
 	ERROR_INJECT(ERRINJ_VYRUN_DATA_READ, {
 		readen = -1;
 		errno = EIO;});
 	if (readen < 0) {
 		diag_set(SystemError, "failed to read from file");
-		goto error;
+		return -1;
 	}
 	if (readen != (ssize_t)page_info->size) {
 		diag_set(ClientError, ER_INVALID_RUN_FILE,
 			 "Unexpected end of file");
-		goto error;
+		return -1;
 	}
+	return 0;
+}
 
+/**
+ * Decode a page given its data read from disk.
+ *
+ * @retval 0 on success
+ * @retval -1 on error, check diag
+ */
+static int
+vy_page_decode(struct vy_page *page, const struct vy_page_info *page_info,
+	       const char *data, ZSTD_DStream *zdctx)
+{
 	struct errinj *inj = errinj(ERRINJ_VY_READ_PAGE_TIMEOUT, ERRINJ_DOUBLE);
 	if (inj != NULL && inj->dparam > 0)
 		usleep(inj->dparam * 1000000);
 
 	/* decode xlog tx */
 	const char *data_pos = data;
-	const char *data_end = data + readen;
+	const char *data_end = data + page_info->size;
 	char *rows = page->data;
 	char *rows_end = rows + page_info->unpacked_size;
 	if (xlog_tx_decode(data, data_end, rows, rows_end, zdctx) != 0)
-		goto error;
+		return -1;
 
 	struct xrow_header xrow;
 	data_pos = page->data + page_info->row_index_offset;
 	data_end = page->data + page_info->unpacked_size;
 	if (xrow_header_decode(&xrow, &data_pos, data_end) == -1)
-		goto error;
+		return -1;
 	if (xrow.type != VY_RUN_ROW_INDEX) {
 		diag_set(ClientError, ER_INVALID_RUN_FILE,
 			 tt_sprintf("Wrong row index type "
 				    "(expected %d, got %u)",
 				    VY_RUN_ROW_INDEX, (unsigned)xrow.type));
+		return -1;
+	}
+	if (vy_row_index_decode(page->row_index, page->row_count, &xrow) != 0)
+		return -1;
+	return 0;
+}
+
+/**
+ * Offset, size and memory address of a read from a file opened
+ * with O_DIRECT must be aligned by the logical block size of
+ * the underlying device. There's no portable way to find it,
+ * so use the page size, which is a multiple of any sane block
+ * size.
+ */
+enum { VY_RUN_DIRECT_IO_ALIGN = 4096 };
+
+/**
+ * Extend a page to the smallest file range suitable for
+ * a direct read, see VY_RUN_DIRECT_IO_ALIGN.
+ */
+static void
+vy_page_direct_range(const struct vy_page_info *page_info,
+		     off_t *offset, size_t *size)
+{
+	off_t align = VY_RUN_DIRECT_IO_ALIGN;
+	off_t begin = page_info->offset & ~(align - 1);
+	off_t end = page_info->offset + page_info->size;
+	end = (end + align - 1) & ~(align - 1);
+	*offset = begin;
+	*size = end - begin;
+}
+
+/**
+ * Given the number of bytes read from the file range returned
+ * by vy_page_direct_range(), return the number of bytes read
+ * from the page itself.
+ */
+static ssize_t
+vy_page_direct_readen(const struct vy_page_info *page_info,
+		      off_t offset, ssize_t readen)
+{
+	if (readen < 0)
+		return readen;
+	ssize_t skip = page_info->offset - offset;
+	if (readen <= skip)
+		return 0;
+	return MIN(readen - skip, (ssize_t)page_info->size);
+}
+
+/**
+ * pread() from a file opened with O_DIRECT. Unlike fio_pread(),
+ * it doesn't retry after a short read not multiple of the block
+ * size, because it only happens at the end of the file and
+ * reading from an unaligned offset would fail with EINVAL.
+ */
+static ssize_t
+vy_run_pread_direct(int fd, char *buf, size_t count, off_t offset)
+{
+	size_t pos = 0;
+	while (pos < count) {
+		ssize_t n = pread(fd, buf + pos, count - pos, offset + pos);
+		if (n < 0) {
+			if (errno == EINTR)
+				continue;
+			return -1;
+		}
+		if (n == 0)
+			break;
+		pos += n;
+		if (pos % VY_RUN_DIRECT_IO_ALIGN != 0)
+			break;
+	}
+	return pos;
+}
+
+/**
+ * Read a page requests from vinyl xlog data file.
+ *
+ * @retval 0 on success
+ * @retval -1 on error, check diag
+ */
+static int
+vy_page_read(struct vy_page *page, const struct vy_page_info *page_info,
+	     struct vy_run *run, ZSTD_DStream *zdctx)
+{
+	/* read xlog tx from xlog file */
+	size_t region_svp = region_used(&fiber()->gc);
+	off_t offset = page_info->offset;
+	size_t size = page_info->size;
+	if (run->is_direct)
+		vy_page_direct_range(page_info, &offset, &size);
+	size_t align = run->is_direct ? VY_RUN_DIRECT_IO_ALIGN : 1;
+	char *buf = (char *)region_aligned_alloc(&fiber()->gc, size, align);
+	if (buf == NULL) {
+		diag_set(OutOfMemory, size, "region gc", "page");
+		return -1;
+	}
+	ssize_t readen;
+	const char *data = buf;
+	if (run->is_direct) {
+		readen = vy_run_pread_direct(run->fd, buf, size, offset);
+		readen = vy_page_direct_readen(page_info, offset, readen);
+		data += page_info->offset - offset;
+	} else {
+		readen = fio_pread(run->fd, buf, size, offset);
+	}
+	if (vy_page_check_read(page_info, readen) != 0 ||
+	    vy_page_decode(page, page_info, data, zdctx) != 0)
 		goto error;
+	region_truncate(&fiber()->gc, region_svp);
+	ERROR_INJECT(ERRINJ_VY_READ_PAGE, {
+		diag_set(ClientError, ER_INJECTION, "vinyl page read");
+		return -1;});
+	return 0;
+error:
+	region_truncate(&fiber()->gc, region_svp);
+	vy_page_read_error(run, page_info);
+	return -1;
+}
+
+/**
+ * Get thread local zstd decompression context
+ */
+static ZSTD_DStream *
+vy_env_get_zdctx(struct vy_run_env *env)
+{
+	ZSTD_DStream *zdctx = tt_pthread_getspecific(env->zdctx_key);
+	if (zdctx == NULL) {
+		zdctx = ZSTD_createDStream();
+		if (zdctx == NULL) {
+			diag_set(OutOfMemory, sizeof(zdctx), "malloc",
+				 "zstd context");
+			return NULL;
+		}
+		tt_pthread_setspecific(env->zdctx_key, zdctx);
+	}
+	return zdctx;
+}
+
+/**
+ * vinyl read task callback
+ */
+static int
+vy_page_read_cb(struct cbus_call_msg *base)
+{
+	struct vy_page_read_task *task = (struct vy_page_read_task *)base;
+	ZSTD_DStream *zdctx = vy_env_get_zdctx(task->run->env);
+	if (zdctx == NULL)
+		return -1;
+	return vy_page_read(task->page, &task->page_info, task->run, zdctx);
+}
+
+/**
+ * vinyl read task cleanup callback
+ */
+static int
+vy_page_read_cb_free(struct cbus_call_msg *base)
+{
+	struct vy_page_read_task *task = (struct vy_page_read_task *)base;
+	struct vy_run_env *env = task->run->env;
+	vy_page_delete(task->page);
+	vy_run_unref(task->run);
+	mempool_free(&env->read_task_pool, task);
+	return 0;
+}
+
+/** Free a page readahead request. */
+static void
+vy_page_prefetch_delete(struct vy_page_prefetch *task)
+{
+	if (task->page != NULL)
+		vy_page_delete(task->page);
+	vy_run_unref(task->run);
+	fiber_cond_destroy(&task->done_cond);
+	free(task);
+}
+
+/**
+ * Send a page readahead request back to tx, executed by
+ * a reader thread once the page is read.
+ */
+static void
+vy_page_prefetch_return(struct vy_page_prefetch *task)
+{
+	if (task->is_failed) {
+		/*
+		 * The iterator will retry reading the page
+		 * synchronously and report the error then.
+		 */
+		diag_clear(diag_get());
+	}
+	task->base.hop++;
+	cpipe_push(&task->reader->tx_pipe, &task->base);
+}
+
+/** Decode a page read through vy_run_reader::ring. */
+static void
+vy_page_prefetch_read_complete(struct io_ring_req *req)
+{
+	struct vy_page_prefetch *task = req->arg;
+	struct vy_run *run = task->run;
+	const struct vy_page_info *page_info = &task->page_info;
+	ssize_t readen = req->res;
+	if (readen < 0) {
+		errno = -readen;
+		readen = -1;
+	}
+	const char *data = task->buf;
+	if (run->is_direct) {
+		off_t offset = page_info->offset;
+		size_t size = page_info->size;
+		vy_page_direct_range(page_info, &offset, &size);
+		readen = vy_page_direct_readen(page_info, offset, readen);
+		data += page_info->offset - offset;
+	}
+	ZSTD_DStream *zdctx = vy_env_get_zdctx(run->env);
+	if (zdctx == NULL || vy_page_check_read(page_info, readen) != 0 ||
+	    vy_page_decode(task->page, page_info, data, zdctx) != 0)
+		task->is_failed = true;
+	ERROR_INJECT(ERRINJ_VY_READ_PAGE, { task->is_failed = true; });
+	free(task->buf);
+	task->buf = NULL;
+	vy_page_prefetch_return(task);
+}
+
+/**
+ * Submit a read of a page requested with vy_page_prefetch
+ * to the ring of the reader thread. Returns -1 if the ring
+ * is full, in which case the page should be read directly.
+ */
+static int
+vy_page_prefetch_submit(struct vy_page_prefetch *task)
+{
+	struct vy_run *run = task->run;
+	off_t offset = task->page_info.offset;
+	size_t size = task->page_info.size;
+	if (run->is_direct)
+		vy_page_direct_range(&task->page_info, &offset, &size);
+	task->buf = NULL;
+	if (!run->is_direct)
+		task->buf = malloc(size);
+	else if (posix_memalign(&task->buf, VY_RUN_DIRECT_IO_ALIGN,
+				size) != 0)
+		task->buf = NULL;
+	if (task->buf == NULL)
+		return -1;
+	if (io_ring_pread(&task->reader->ring, &task->req, run->fd,
+			  task->buf, size, offset) != 0) {
+		free(task->buf);
+		task->buf = NULL;
+		return -1;
+	}
+	task->req.on_complete = vy_page_prefetch_read_complete;
+	task->req.arg = task;
+	return 0;
+}
+
+/** Page readahead request callback, executed by a reader thread. */
+static void
+vy_page_prefetch_read_f(struct cmsg *base)
+{
+	struct vy_page_prefetch *task = (struct vy_page_prefetch *)base;
+	if (io_ring_is_created(&task->reader->ring) &&
+	    vy_page_prefetch_submit(task) == 0)
+		return;
+	ZSTD_DStream *zdctx = vy_env_get_zdctx(task->run->env);
+	if (zdctx == NULL ||
+	    vy_page_read(task->page, &task->page_info,
+			 task->run, zdctx) != 0)
+		task->is_failed = true;
+	vy_page_prefetch_return(task);
+}
+
+/** Page readahead request callback, executed by tx on return. */
+static void
+vy_page_prefetch_done_f(struct cmsg *base)
+{
+	struct vy_page_prefetch *task = (struct vy_page_prefetch *)base;
+	task->is_done = true;
+	if (task->is_abandoned)
+		vy_page_prefetch_delete(task);
+	else
+		fiber_cond_signal(&task->done_cond);
+}
+
+/**
+ * Send a request to read a page to a reader thread without
+ * waiting for it to complete.
+ *
+ * @retval not NULL The request.
+ * @retval     NULL Memory error.
+ */
+static struct vy_page_prefetch *
+vy_page_prefetch_new(struct vy_run *run, uint32_t page_no)
+{
+	struct vy_run_env *env = run->env;
+	assert(env->reader_pool != NULL);
+	struct vy_page_prefetch *task = malloc(sizeof(*task));
+	if (task == NULL) {
+		diag_set(OutOfMemory, sizeof(*task), "malloc",
+			 "struct vy_page_prefetch");
+		return NULL;
+	}
+	struct vy_page_info *page_info = vy_run_page_info(run, page_no);
+	task->page = vy_page_new(page_info);
+	if (task->page == NULL) {
+		free(task);
+		return NULL;
+	}
+	task->page->page_no = page_no;
+	task->run = run;
+	vy_run_ref(run);
+	task->page_info = *page_info;
+	task->page_no = page_no;
+	task->is_failed = false;
+	task->is_done = false;
+	task->is_abandoned = false;
+	fiber_cond_create(&task->done_cond);
+	task->next = NULL;
+
+	/* Pick a reader thread. */
+	struct vy_run_reader *reader;
+	reader = &env->reader_pool[env->next_reader++];
+	env->next_reader %= env->reader_pool_size;
+	task->reader = reader;
+	task->buf = NULL;
+
+	cmsg_init(&task->base, reader->prefetch_route);
+	cpipe_push(&reader->reader_pipe, &task->base);
+	return task;
+}
+
+/**
+ * Drop all pages read ahead by an iterator, e.g. because
+ * it stopped or jumped to another position.
+ */
+static void
+vy_run_iterator_discard_prefetch(struct vy_run_iterator *itr)
+{
+	struct vy_page_prefetch *task = itr->prefetch;
+	while (task != NULL) {
+		struct vy_page_prefetch *next = task->next;
+		if (task->is_done)
+			vy_page_prefetch_delete(task);
+		else
+			task->is_abandoned = true;
+		itr->stat->readahead.wasted++;
+		task = next;
 	}
-	if (vy_row_index_decode(page->row_index, page->row_count, &xrow) != 0)
-		goto error;
-	region_truncate(&fiber()->gc, region_svp);
-	ERROR_INJECT(ERRINJ_VY_READ_PAGE, {
-		diag_set(ClientError, ER_INJECTION, "vinyl page read");
-		return -1;});
-	return 0;
-error:
-	region_truncate(&fiber()->gc, region_svp);
-	diag_log();
-	say_error("error reading %s@%llu:%u", vy_run_filename(run),
-		  (unsigned long long)page_info->offset,
-		  (unsigned)page_info->size);
-	return -1;
+	itr->prefetch = NULL;
 }
 
 /**
- * Get thread local zstd decompression context
+ * Take a page read ahead by an iterator, waiting for the read
+ * to complete if necessary. Returns NULL if the page wasn't
+ * read ahead or the read failed.
  */
-static ZSTD_DStream *
-vy_env_get_zdctx(struct vy_run_env *env)
+static struct vy_page *
+vy_run_iterator_take_prefetched(struct vy_run_iterator *itr,
+				uint32_t page_no)
 {
-	ZSTD_DStream *zdctx = tt_pthread_getspecific(env->zdctx_key);
-	if (zdctx == NULL) {
-		zdctx = ZSTD_createDStream();
-		if (zdctx == NULL) {
-			diag_set(OutOfMemory, sizeof(zdctx), "malloc",
-				 "zstd context");
-			return NULL;
-		}
-		tt_pthread_setspecific(env->zdctx_key, zdctx);
+	struct vy_page_prefetch **prev = &itr->prefetch;
+	struct vy_page_prefetch *task = itr->prefetch;
+	while (task != NULL && task->page_no != page_no) {
+		prev = &task->next;
+		task = task->next;
 	}
-	return zdctx;
+	if (task == NULL)
+		return NULL;
+	*prev = task->next;
+	while (!task->is_done)
+		fiber_cond_wait(&task->done_cond);
+	struct vy_page *page = NULL;
+	if (task->is_failed) {
+		itr->stat->readahead.wasted++;
+	} else {
+		itr->stat->readahead.useful++;
+		SWAP(page, task->page);
+	}
+	vy_page_prefetch_delete(task);
+	return page;
 }
 
 /**
- * vinyl read task callback
+ * Number of pages an iterator must load one after another
+ * for the scan to be considered sequential.
  */
-static int
-vy_page_read_cb(struct cbus_call_msg *base)
+enum { VY_RUN_READAHEAD_TRIGGER = 2 };
+
+/**
+ * Called after an iterator loaded a page. If the iterator has
+ * loaded enough pages one after another in the iteration
+ * direction, send requests to read the pages following the
+ * loaded one to reader threads so that they are ready by the
+ * time the iterator needs them. If the iterator jumped to
+ * another position, drop the pages read ahead so far.
+ */
+static void
+vy_run_iterator_readahead(struct vy_run_iterator *itr, uint32_t page_no)
 {
-	struct vy_page_read_task *task = (struct vy_page_read_task *)base;
-	ZSTD_DStream *zdctx = vy_env_get_zdctx(task->run->env);
-	if (zdctx == NULL)
-		return -1;
-	return vy_page_read(task->page, &task->page_info, task->run, zdctx);
+	struct vy_slice *slice = itr->slice;
+	struct vy_run_env *env = slice->run->env;
+	int dir = iterator_direction(itr->iterator_type);
+
+	if (itr->last_page_no != UINT32_MAX &&
+	    (int64_t)page_no == (int64_t)itr->last_page_no + dir) {
+		itr->seq_page_count++;
+	} else {
+		itr->seq_page_count = 1;
+		vy_run_iterator_discard_prefetch(itr);
+	}
+	itr->last_page_no = page_no;
+
+	if (env->readahead == 0 || env->reader_pool == NULL ||
+	    itr->seq_page_count < VY_RUN_READAHEAD_TRIGGER)
+		return;
+
+	/*
+	 * Request pages within the readahead window following
+	 * the loaded page, starting after the last page already
+	 * requested and skipping those found in the page cache.
+	 */
+	int64_t next_page_no = page_no;
+	struct vy_page_prefetch **tail = &itr->prefetch;
+	while (*tail != NULL) {
+		next_page_no = (*tail)->page_no;
+		tail = &(*tail)->next;
+	}
+	int64_t end_page_no = (int64_t)page_no + dir * (int64_t)env->readahead;
+	if (dir > 0)
+		end_page_no = MIN(end_page_no, (int64_t)slice->last_page_no);
+	else
+		end_page_no = MAX(end_page_no, (int64_t)slice->first_page_no);
+	for (next_page_no += dir; dir * (end_page_no - next_page_no) >= 0;
+	     next_page_no += dir) {
+		if (vy_page_cache_contains(&env->page_cache, slice->run,
+					   next_page_no))
+			continue;
+		struct vy_page_prefetch *task;
+		task = vy_page_prefetch_new(slice->run, next_page_no);
+		if (task == NULL) {
+			/* Readahead is optional, ignore the error. */
+			diag_clear(diag_get());
+			break;
+		}
+		*tail = task;
+		tail = &task->next;
+	}
 }
 
 /**
- * vinyl read task cleanup callback
+ * Make a page the current page of an iterator, moving the old
+ * current page to prev_page. Steals the page reference.
  */
-static int
-vy_page_read_cb_free(struct cbus_call_msg *base)
+static void
+vy_run_iterator_set_page(struct vy_run_iterator *itr, struct vy_page *page)
 {
-	struct vy_page_read_task *task = (struct vy_page_read_task *)base;
-	struct vy_run_env *env = task->run->env;
-	vy_page_delete(task->page);
-	vy_run_unref(task->run);
-	mempool_free(&env->read_task_pool, task);
-	return 0;
+	if (itr->prev_page != NULL)
+		vy_page_unref(itr->prev_page);
+	itr->prev_page = itr->curr_page;
+	itr->curr_page = page;
 }
 
 /**
  * Read a page from disk given its number.
  * The function caches two most recently read pages.
+ * Pages are also looked up in and added to the page
+ * cache shared by all iterators, see vy_run_env::page_cache.
+ * On sequential scans, the following pages are read ahead,
+ * see vy_run_iterator_readahead().
  *
  * @retval 0 success
  * @retval -1 critical error
@@ -908,9 +1815,43 @@ vy_run_iterator_load_page(struct vy_run_iterator *itr, uint32_t page_no,
 		}
 	}
 
-	/* Allocate buffers */
+	struct vy_page *page;
+	page = vy_page_cache_lookup(&env->page_cache, slice->run, page_no);
+	if (page != NULL) {
+		vy_page_ref(page);
+		vy_run_iterator_set_page(itr, page);
+		vy_run_iterator_readahead(itr, page_no);
+		*result = page;
+		return 0;
+	}
+
+	/* Check pages read ahead */
 	struct vy_page_info *page_info = vy_run_page_info(slice->run, page_no);
-	struct vy_page *page = vy_page_new(page_info);
+	page = vy_run_iterator_take_prefetched(itr, page_no);
+	if (page != NULL)
+		goto loaded;
+
+	/*
+	 * If reader threads read pages with io_uring, send them
+	 * a request as if reading the page ahead: it doesn't
+	 * occupy a reader thread while the page is being read.
+	 */
+	if (vy_run_env_has_rings(env)) {
+		struct vy_page_prefetch *task;
+		task = vy_page_prefetch_new(slice->run, page_no);
+		if (task == NULL)
+			return -1;
+		while (!task->is_done)
+			fiber_cond_wait(&task->done_cond);
+		if (!task->is_failed)
+			SWAP(page, task->page);
+		vy_page_prefetch_delete(task);
+		if (page != NULL)
+			goto loaded;
+	}
+
+	/* Allocate buffers */
+	page = vy_page_new(page_info);
 	if (page == NULL)
 		return -1;
 
@@ -968,12 +1909,11 @@ vy_run_iterator_load_page(struct vy_run_iterator *itr, uint32_t page_no,
 		}
 	}
 
-	/* Update cache */
-	if (itr->prev_page != NULL)
-		vy_page_delete(itr->prev_page);
-	itr->prev_page = itr->curr_page;
-	itr->curr_page = page;
 	page->page_no = page_no;
+loaded:
+	/* Update cache */
+	vy_page_cache_put(&env->page_cache, slice->run, page);
+	vy_run_iterator_set_page(itr, page);
 
 	/* Update read statistics. */
 	itr->stat->read.rows += page_info->row_count;
@@ -981,6 +1921,7 @@ vy_run_iterator_load_page(struct vy_run_iterator *itr, uint32_t page_no,
 	itr->stat->read.bytes_compressed += page_info->size;
 	itr->stat->read.pages++;
 
+	vy_run_iterator_readahead(itr, page_no);
 	*result = page;
 	return 0;
 }
@@ -1321,6 +2262,18 @@ vy_run_iterator_seek(struct vy_run_iterator *itr,
 	const struct tuple *check_eq_key = NULL;
 	int cmp;
 
+	if (itr->pinned_run == NULL) {
+		/*
+		 * Make sure the bloom filter and page index are
+		 * loaded and stay in memory while the iterator
+		 * is open.
+		 */
+		if (vy_run_pin_index(slice->run, true) != 0)
+			return -1;
+		itr->pinned_run = slice->run;
+		vy_run_ref(itr->pinned_run);
+	}
+
 	if (slice->begin != NULL &&
 	    (iterator_type == ITER_GT || iterator_type == ITER_GE ||
 	     iterator_type == ITER_EQ)) {
@@ -1409,6 +2362,10 @@ vy_run_iterator_open(struct vy_run_iterator *itr,
 	itr->curr_pos.page_no = slice->run->info.page_count;
 	itr->curr_page = NULL;
 	itr->prev_page = NULL;
+	itr->last_page_no = UINT32_MAX;
+	itr->seq_page_count = 0;
+	itr->prefetch = NULL;
+	itr->pinned_run = NULL;
 
 	itr->search_started = false;
 	itr->search_ended = false;
@@ -1503,6 +2460,27 @@ next:
 	return 0;
 }
 
+/**
+ * Append a statement read from a run to a history. Blob
+ * references are replaced with values so that the rest of
+ * the read path never sees them.
+ */
+static NODISCARD int
+vy_run_iterator_append_stmt(struct vy_run_iterator *itr,
+			    struct vy_history *history, struct tuple *stmt)
+{
+	if ((vy_stmt_flags(stmt) & VY_STMT_BLOB_REF) == 0)
+		return vy_history_append_stmt(history, stmt);
+	struct vy_run *run = itr->slice->run;
+	stmt = vy_blob_resolve(stmt, run->blobs, run->info.blob_count,
+			       run->env->reader_pool != NULL);
+	if (stmt == NULL)
+		return -1;
+	int rc = vy_history_append_stmt(history, stmt);
+	tuple_unref(stmt);
+	return rc;
+}
+
 NODISCARD int
 vy_run_iterator_next(struct vy_run_iterator *itr,
 		     struct vy_history *history)
@@ -1512,7 +2490,7 @@ vy_run_iterator_next(struct vy_run_iterator *itr,
 	if (vy_run_iterator_next_key(itr, &stmt) != 0)
 		return -1;
 	while (stmt != NULL) {
-		if (vy_history_append_stmt(history, stmt) != 0)
+		if (vy_run_iterator_append_stmt(itr, history, stmt) != 0)
 			return -1;
 		if (vy_history_is_terminal(history))
 			break;
@@ -1564,7 +2542,7 @@ vy_run_iterator_skip(struct vy_run_iterator *itr,
 	}
 
 	while (stmt != NULL) {
-		if (vy_history_append_stmt(history, stmt) != 0)
+		if (vy_run_iterator_append_stmt(itr, history, stmt) != 0)
 			return -1;
 		if (vy_history_is_terminal(history))
 			break;
@@ -1578,6 +2556,10 @@ void
 vy_run_iterator_close(struct vy_run_iterator *itr)
 {
 	vy_run_iterator_stop(itr);
+	if (itr->pinned_run != NULL) {
+		vy_run_unpin_index(itr->pinned_run);
+		vy_run_unref(itr->pinned_run);
+	}
 	TRASH(itr);
 }
 
@@ -1597,17 +2579,21 @@ vy_run_acct_page(struct vy_run *run, struct vy_page_info *page)
 	run->count.pages++;
 }
 
-int
-vy_run_recover(struct vy_run *run, const char *dir,
-	       uint32_t space_id, uint32_t iid)
+/**
+ * Read run info and page index from a run index file.
+ * On failure, everything allocated is freed.
+ *
+ * @retval 0 success
+ * @retval -1 error, check diag
+ */
+static int
+vy_run_read_index(const char *path, struct vy_run_info *info,
+		  struct vy_page_info **p_page_info)
 {
-	char path[PATH_MAX];
-	vy_run_snprint_path(path, sizeof(path), dir,
-			    space_id, iid, run->id, VY_FILE_INDEX);
-
+	struct vy_page_info *page_info = NULL;
 	struct xlog_cursor cursor;
 	if (xlog_cursor_open(&cursor, path))
-		goto fail;
+		return -1;
 
 	struct xlog_meta *meta = &cursor.meta;
 	if (strcmp(meta->filetype, XLOG_META_TYPE_INDEX) != 0) {
@@ -1648,20 +2634,19 @@ vy_run_recover(struct vy_run *run, const char *dir,
 		goto fail_close;
 	}
 
-	if (vy_run_info_decode(&run->info, &xrow, path) != 0)
+	if (vy_run_info_decode(info, &xrow, path) != 0)
 		goto fail_close;
 
 	/* Allocate buffer for page info. */
-	run->page_info = calloc(run->info.page_count,
-				      sizeof(struct vy_page_info));
-	if (run->page_info == NULL) {
+	page_info = calloc(info->page_count, sizeof(struct vy_page_info));
+	if (page_info == NULL) {
 		diag_set(OutOfMemory,
-			 run->info.page_count * sizeof(struct vy_page_info),
+			 info->page_count * sizeof(struct vy_page_info),
 			 "malloc", "struct vy_page_info");
 		goto fail_close;
 	}
 
-	for (uint32_t page_no = 0; page_no < run->info.page_count; page_no++) {
+	for (uint32_t page_no = 0; page_no < info->page_count; page_no++) {
 		int rc = xlog_cursor_next_row(&cursor, &xrow);
 		if (rc != 0) {
 			if (rc > 0) {
@@ -1673,7 +2658,7 @@ vy_run_recover(struct vy_run *run, const char *dir,
 			 * Limit the count of pages to
 			 * successfully created pages.
 			 */
-			run->info.page_count = page_no;
+			info->page_count = page_no;
 			goto fail_close;
 		}
 		if (xrow.type != VY_INDEX_PAGE_INFO) {
@@ -1682,22 +2667,59 @@ vy_run_recover(struct vy_run *run, const char *dir,
 					    "(expected %d, got %u)",
 					    VY_INDEX_PAGE_INFO,
 					    (unsigned)xrow.type));
+			info->page_count = page_no;
 			goto fail_close;
 		}
-		struct vy_page_info *page = run->page_info + page_no;
+		struct vy_page_info *page = page_info + page_no;
 		if (vy_page_info_decode(page, &xrow, path) < 0) {
 			/**
 			 * Limit the count of pages to successfully
 			 * created pages
 			 */
-			run->info.page_count = page_no;
+			info->page_count = page_no;
 			goto fail_close;
 		}
-		vy_run_acct_page(run, page);
 	}
 
 	/* We don't need to keep metadata file open any longer. */
 	xlog_cursor_close(&cursor, false);
+	*p_page_info = page_info;
+	return 0;
+
+fail_close:
+	xlog_cursor_close(&cursor, false);
+	vy_page_info_array_delete(page_info, info->page_count);
+	vy_run_info_destroy(info);
+	return -1;
+}
+
+/** Remember the location of the run index file. */
+static void
+vy_run_set_index_location(struct vy_run *run, const char *dir,
+			  uint32_t space_id, uint32_t iid)
+{
+	run->dir = dir;
+	run->space_id = space_id;
+	run->iid = iid;
+	run->bloom_size = run->info.bloom == NULL ? 0 :
+			  tuple_bloom_size(run->info.bloom);
+}
+
+int
+vy_run_recover(struct vy_run *run, const char *dir,
+	       uint32_t space_id, uint32_t iid)
+{
+	char path[PATH_MAX];
+	vy_run_snprint_path(path, sizeof(path), dir,
+			    space_id, iid, run->id, VY_FILE_INDEX);
+
+	struct xlog_cursor cursor;
+	struct xlog_meta *meta;
+	if (vy_run_read_index(path, &run->info, &run->page_info) != 0)
+		goto fail;
+	for (uint32_t page_no = 0; page_no < run->info.page_count; page_no++)
+		vy_run_acct_page(run, run->page_info + page_no);
+	vy_run_set_index_location(run, dir, space_id, iid);
 
 	/* Prepare data file for reading. */
 	vy_run_snprint_path(path, sizeof(path), dir,
@@ -1712,6 +2734,7 @@ vy_run_recover(struct vy_run *run, const char *dir,
 	}
 	run->fd = cursor.fd;
 	xlog_cursor_close(&cursor, true);
+	vy_run_open_direct(run, path);
 	return 0;
 
 fail_close:
@@ -1723,6 +2746,220 @@ fail:
 	return -1;
 }
 
+/** {{{ vy_run_index_cache */
+
+/** Size of memory used by the bloom filter and page index of a run. */
+static inline size_t
+vy_run_index_size(struct vy_run *run)
+{
+	return run->page_index_size + run->bloom_size;
+}
+
+/** Free the bloom filter and page index of a run. */
+static void
+vy_run_evict_index(struct vy_run *run)
+{
+	struct vy_run_index_cache *cache = &run->env->index_cache;
+	assert(run->in_index_cache);
+	assert(!run->index_evicted);
+	assert(run->index_pin_count == 0);
+	vy_page_info_array_delete(run->page_info, run->info.page_count);
+	run->page_info = NULL;
+	if (run->info.bloom != NULL) {
+		tuple_bloom_delete(run->info.bloom);
+		run->info.bloom = NULL;
+	}
+	run->index_evicted = true;
+	rlist_del_entry(run, in_index_lru);
+	cache->mem_used -= vy_run_index_size(run);
+	cache->page_index_evicted += run->page_index_size;
+	cache->bloom_evicted += run->bloom_size;
+	cache->evict++;
+}
+
+/**
+ * Evict run indexes in LRU order until the cache fits in its
+ * limit. Pinned run indexes are skipped. The most recently used
+ * run index is never evicted, because it's about to be used.
+ * Nothing is evicted until reader threads are started, because
+ * recovery needs page indexes of all runs to create slices.
+ */
+static void
+vy_run_index_cache_truncate(struct vy_run_env *env)
+{
+	struct vy_run_index_cache *cache = &env->index_cache;
+	if (cache->mem_quota == 0 || env->reader_pool == NULL)
+		return;
+	struct vy_run *run = rlist_last_entry(&cache->lru, struct vy_run,
+					      in_index_lru);
+	while (cache->mem_used > cache->mem_quota &&
+	       &run->in_index_lru != &cache->lru &&
+	       &run->in_index_lru != rlist_first(&cache->lru)) {
+		struct vy_run *prev = rlist_prev_entry(run, in_index_lru);
+		if (run->index_pin_count == 0)
+			vy_run_evict_index(run);
+		run = prev;
+	}
+}
+
+void
+vy_run_env_set_index_cache_quota(struct vy_run_env *env, size_t quota)
+{
+	env->index_cache.mem_quota = quota;
+	vy_run_index_cache_truncate(env);
+}
+
+void
+vy_run_index_cache_add(struct vy_run *run)
+{
+	struct vy_run_env *env = run->env;
+	struct vy_run_index_cache *cache = &env->index_cache;
+	assert(!run->in_index_cache);
+	run->in_index_cache = true;
+	if (run->index_evicted) {
+		cache->page_index_evicted += run->page_index_size;
+		cache->bloom_evicted += run->bloom_size;
+		return;
+	}
+	rlist_add_entry(&cache->lru, run, in_index_lru);
+	cache->mem_used += vy_run_index_size(run);
+	vy_run_index_cache_truncate(env);
+}
+
+void
+vy_run_index_cache_remove(struct vy_run *run)
+{
+	struct vy_run_index_cache *cache = &run->env->index_cache;
+	assert(run->in_index_cache);
+	run->in_index_cache = false;
+	if (run->index_evicted) {
+		assert(cache->page_index_evicted >= run->page_index_size);
+		assert(cache->bloom_evicted >= run->bloom_size);
+		cache->page_index_evicted -= run->page_index_size;
+		cache->bloom_evicted -= run->bloom_size;
+		return;
+	}
+	rlist_del_entry(run, in_index_lru);
+	assert(cache->mem_used >= vy_run_index_size(run));
+	cache->mem_used -= vy_run_index_size(run);
+}
+
+static int
+vy_run_index_load_cb(struct cbus_call_msg *base)
+{
+	struct vy_run_index_load_task *task =
+		(struct vy_run_index_load_task *)base;
+	struct vy_run *run = task->run;
+	char path[PATH_MAX];
+	vy_run_snprint_path(path, sizeof(path), run->dir, run->space_id,
+			    run->iid, run->id, VY_FILE_INDEX);
+	return vy_run_read_index(path, &task->info, &task->page_info);
+}
+
+static int
+vy_run_index_load_cb_free(struct cbus_call_msg *base)
+{
+	struct vy_run_index_load_task *task =
+		(struct vy_run_index_load_task *)base;
+	vy_page_info_array_delete(task->page_info, task->info.page_count);
+	vy_run_info_destroy(&task->info);
+	vy_run_unref(task->run);
+	free(task);
+	return 0;
+}
+
+/**
+ * Load the bloom filter and page index of a run evicted from
+ * memory. If @can_yield is set and reader threads are running,
+ * the index file is read by a reader thread, otherwise it is
+ * read in the calling thread.
+ */
+static int
+vy_run_load_index(struct vy_run *run, bool can_yield)
+{
+	struct vy_run_env *env = run->env;
+	struct vy_run_index_cache *cache = &env->index_cache;
+	assert(run->index_evicted);
+
+	struct vy_run_index_load_task *task = calloc(1, sizeof(*task));
+	if (task == NULL) {
+		diag_set(OutOfMemory, sizeof(*task), "malloc",
+			 "struct vy_run_index_load_task");
+		return -1;
+	}
+	task->run = run;
+	vy_run_ref(run);
+	int rc;
+	if (can_yield && env->reader_pool != NULL) {
+		struct vy_run_reader *reader;
+		reader = &env->reader_pool[env->next_reader++];
+		env->next_reader %= env->reader_pool_size;
+		rc = cbus_call(&reader->reader_pipe, &reader->tx_pipe,
+			       &task->base, vy_run_index_load_cb,
+			       vy_run_index_load_cb_free, TIMEOUT_INFINITY);
+		if (!task->base.complete)
+			return -1; /* timed out or cancelled */
+	} else {
+		rc = vy_run_index_load_cb(&task->base);
+	}
+	if (rc != 0) {
+		diag_log();
+		say_error("failed to load index of run %lld",
+			  (long long)run->id);
+		goto out;
+	}
+	if (!run->index_evicted) {
+		/* Loaded by another fiber while we were waiting. */
+		goto out;
+	}
+	if (task->info.page_count != run->info.page_count) {
+		diag_set(ClientError, ER_INVALID_RUN_FILE,
+			 tt_sprintf("Page count mismatch in index of run "
+				    "%lld", (long long)run->id));
+		rc = -1;
+		goto out;
+	}
+	run->page_info = task->page_info;
+	run->info.bloom = task->info.bloom;
+	task->page_info = NULL;
+	task->info.bloom = NULL;
+	run->index_evicted = false;
+	cache->load++;
+	if (run->in_index_cache) {
+		cache->page_index_evicted -= run->page_index_size;
+		cache->bloom_evicted -= run->bloom_size;
+		rlist_add_entry(&cache->lru, run, in_index_lru);
+		cache->mem_used += vy_run_index_size(run);
+	}
+out:
+	vy_run_index_load_cb_free(&task->base);
+	return rc;
+}
+
+int
+vy_run_pin_index(struct vy_run *run, bool can_yield)
+{
+	struct vy_run_index_cache *cache = &run->env->index_cache;
+	if (run->index_evicted) {
+		if (vy_run_load_index(run, can_yield) != 0)
+			return -1;
+		vy_run_index_cache_truncate(run->env);
+	} else if (run->in_index_cache) {
+		rlist_move_entry(&cache->lru, run, in_index_lru);
+	}
+	run->index_pin_count++;
+	return 0;
+}
+
+void
+vy_run_unpin_index(struct vy_run *run)
+{
+	assert(run->index_pin_count > 0);
+	run->index_pin_count--;
+}
+
+/** }}} vy_run_index_cache */
+
 /* dump statement to the run page buffers (stmt header and data) */
 static int
 vy_run_dump_stmt(const struct tuple *value, struct xlog *data_xlog,
@@ -1901,6 +3138,8 @@ vy_run_info_encode(const struct vy_run_info *run_info,
 	uint32_t key_count = 5;
 	if (run_info->bloom != NULL)
 		key_count++;
+	if (run_info->blob_count > 0)
+		key_count++;
 
 	size_t size = mp_sizeof_map(key_count);
 	size += mp_sizeof_uint(VY_RUN_INFO_MIN_KEY) + min_key_size;
@@ -1914,6 +3153,17 @@ vy_run_info_encode(const struct vy_run_info *run_info,
 	if (run_info->bloom != NULL)
 		size += mp_sizeof_uint(VY_RUN_INFO_BLOOM) +
 			tuple_bloom_size(run_info->bloom);
+	if (run_info->blob_count > 0) {
+		size += mp_sizeof_uint(VY_RUN_INFO_BLOBS) +
+			mp_sizeof_array(run_info->blob_count);
+		for (uint32_t i = 0; i < run_info->blob_count; i++) {
+			const struct vy_run_blob_info *blob =
+						&run_info->blobs[i];
+			size += mp_sizeof_array(2) +
+				mp_sizeof_uint(blob->id) +
+				mp_sizeof_uint(blob->size);
+		}
+	}
 
 	char *pos = region_alloc(&fiber()->gc, size);
 	if (pos == NULL) {
@@ -1940,6 +3190,17 @@ vy_run_info_encode(const struct vy_run_info *run_info,
 		pos = mp_encode_uint(pos, VY_RUN_INFO_BLOOM);
 		pos = tuple_bloom_encode(run_info->bloom, pos);
 	}
+	if (run_info->blob_count > 0) {
+		pos = mp_encode_uint(pos, VY_RUN_INFO_BLOBS);
+		pos = mp_encode_array(pos, run_info->blob_count);
+		for (uint32_t i = 0; i < run_info->blob_count; i++) {
+			const struct vy_run_blob_info *blob =
+						&run_info->blobs[i];
+			pos = mp_encode_array(pos, 2);
+			pos = mp_encode_uint(pos, blob->id);
+			pos = mp_encode_uint(pos, blob->size);
+		}
+	}
 	xrow->body->iov_len = (void *)pos - xrow->body->iov_base;
 	xrow->bodycnt = 1;
 	xrow->type = VY_INDEX_RUN_INFO;
@@ -2003,6 +3264,7 @@ vy_run_write_index(struct vy_run *run, const char *dirpath,
 		goto fail;
 
 	xlog_close(&index_xlog, false);
+	vy_run_set_index_location(run, dirpath, space_id, iid);
 	return 0;
 
 fail_rollback:
@@ -2018,7 +3280,9 @@ int
 vy_run_writer_create(struct vy_run_writer *writer, struct vy_run *run,
 		     const char *dirpath, uint32_t space_id, uint32_t iid,
 		     struct key_def *cmp_def, struct key_def *key_def,
-		     uint64_t page_size, double bloom_fpr)
+		     uint64_t page_size, double bloom_fpr,
+		     enum bloom_type bloom_type,
+		     struct vy_blob_writer *blob_writer)
 {
 	memset(writer, 0, sizeof(*writer));
 	writer->run = run;
@@ -2029,6 +3293,8 @@ vy_run_writer_create(struct vy_run_writer *writer, struct vy_run *run,
 	writer->key_def = key_def;
 	writer->page_size = page_size;
 	writer->bloom_fpr = bloom_fpr;
+	writer->bloom_type = bloom_type;
+	writer->blob_writer = blob_writer;
 	if (bloom_fpr < 1) {
 		writer->bloom = tuple_bloom_builder_new(key_def->part_count);
 		if (writer->bloom == NULL)
@@ -2182,6 +3448,12 @@ vy_run_writer_append_stmt(struct vy_run_writer *writer, struct tuple *stmt)
 {
 	int rc = -1;
 	size_t region_svp = region_used(&fiber()->gc);
+	struct tuple *orig_stmt = stmt;
+	if (writer->blob_writer != NULL) {
+		stmt = vy_blob_writer_process(writer->blob_writer, stmt);
+		if (stmt == NULL)
+			goto out;
+	}
 	if (!xlog_is_open(&writer->data_xlog) &&
 	    vy_run_writer_create_xlog(writer) != 0)
 		goto out;
@@ -2195,6 +3467,8 @@ vy_run_writer_append_stmt(struct vy_run_writer *writer, struct tuple *stmt)
 		goto out;
 	rc = 0;
 out:
+	if (stmt != NULL && stmt != orig_stmt)
+		vy_stmt_unref_if_possible(stmt);
 	region_truncate(&fiber()->gc, region_svp);
 	return rc;
 }
@@ -2250,6 +3524,15 @@ vy_run_writer_commit(struct vy_run_writer *writer)
 		goto out;
 	});
 
+	/*
+	 * Sync the blob file before the run file is linked,
+	 * because the run refers to it.
+	 */
+	if (writer->blob_writer != NULL &&
+	    vy_blob_writer_commit(writer->blob_writer, &run->info.blobs,
+				  &run->info.blob_count) != 0)
+		goto out;
+
 	/* Sync data and link the file to the final name. */
 	if (xlog_sync(&writer->data_xlog) < 0 ||
 	    xlog_rename(&writer->data_xlog) < 0)
@@ -2257,6 +3540,7 @@ vy_run_writer_commit(struct vy_run_writer *writer)
 
 	if (writer->bloom != NULL) {
 		run->info.bloom = tuple_bloom_new(writer->bloom,
+						  writer->bloom_type,
 						  writer->bloom_fpr);
 		if (run->info.bloom == NULL)
 			goto out;
@@ -2265,8 +3549,14 @@ vy_run_writer_commit(struct vy_run_writer *writer)
 			       writer->space_id, writer->iid) != 0)
 		goto out;
 
+	/* The data file was renamed, so its xlog name is stale. */
+	char path[PATH_MAX];
+	vy_run_snprint_path(path, sizeof(path), writer->dirpath,
+			    writer->space_id, writer->iid,
+			    run->id, VY_FILE_RUN);
 	run->fd = writer->data_xlog.fd;
 	vy_run_writer_destroy(writer, true);
+	vy_run_open_direct(run, path);
 	rc = 0;
 out:
 	region_truncate(&fiber()->gc, region_svp);
@@ -2276,6 +3566,8 @@ out:
 void
 vy_run_writer_abort(struct vy_run_writer *writer)
 {
+	if (writer->blob_writer != NULL)
+		vy_blob_writer_abort(writer->blob_writer);
 	vy_run_writer_destroy(writer, false);
 }
 
@@ -2307,6 +3599,14 @@ vy_run_rebuild_index(struct vy_run *run, const char *dir,
 	int64_t min_lsn = INT64_MAX;
 	struct tuple *prev_tuple = NULL;
 
+	/*
+	 * Blob files referenced by the run are accounted by
+	 * a blob writer that doesn't separate values.
+	 */
+	struct vy_blob_writer blob_writer;
+	vy_blob_writer_create(&blob_writer, dir, space_id, iid,
+			      run->id, 0, NULL, 0);
+
 	struct tuple_bloom_builder *bloom_builder = NULL;
 	if (opts->bloom_fpr < 1) {
 		bloom_builder = tuple_bloom_builder_new(key_def->part_count);
@@ -2339,6 +3639,12 @@ vy_run_rebuild_index(struct vy_run *run, const char *dir,
 							     format, iid == 0);
 			if (tuple == NULL)
 				goto close_err;
+			if ((vy_stmt_flags(tuple) & VY_STMT_BLOB_REF) != 0 &&
+			    vy_blob_writer_process(&blob_writer,
+						   tuple) == NULL) {
+				tuple_unref(tuple);
+				goto close_err;
+			}
 			if (bloom_builder != NULL) {
 				uint32_t hashed_parts = prev_tuple == NULL ? 0 :
 					tuple_common_key_parts(prev_tuple,
@@ -2394,15 +3700,20 @@ vy_run_rebuild_index(struct vy_run *run, const char *dir,
 	region_truncate(region, mem_used);
 	run->fd = cursor.fd;
 	xlog_cursor_close(&cursor, true);
+	vy_run_open_direct(run, path);
 
 	if (bloom_builder != NULL) {
 		run->info.bloom = tuple_bloom_new(bloom_builder,
+						  opts->bloom_type,
 						  opts->bloom_fpr);
 		if (run->info.bloom == NULL)
 			goto close_err;
 		tuple_bloom_builder_delete(bloom_builder);
 		bloom_builder = NULL;
 	}
+	if (vy_blob_writer_commit(&blob_writer, &run->info.blobs,
+				  &run->info.blob_count) != 0)
+		goto close_err;
 
 	/* New run index is ready for write, unlink old file if exists */
 	vy_run_snprint_path(path, sizeof(path), dir,
@@ -2422,6 +3733,7 @@ close_err:
 		tuple_unref(prev_tuple);
 	if (bloom_builder != NULL)
 		tuple_bloom_builder_delete(bloom_builder);
+	vy_blob_writer_abort(&blob_writer);
 	if (xlog_cursor_is_open(&cursor))
 		xlog_cursor_close(&cursor, false);
 	return -1;
@@ -2596,6 +3908,38 @@ vy_slice_stream_next(struct vy_stmt_stream *virt_stream, struct tuple **ret)
 	return 0;
 }
 
+/**
+ * Advise the OS to drop the pages read by a slice stream from
+ * the page cache. A slice stream is used for reading compaction
+ * input, which is about to be replaced with the compaction output,
+ * so there's no point in letting it push more useful data out of
+ * the cache. Nothing to do if the run is read with O_DIRECT.
+ */
+static void
+vy_slice_stream_drop_cache(struct vy_slice_stream *stream)
+{
+#ifdef HAVE_POSIX_FADVISE
+	struct vy_slice *slice = stream->slice;
+	struct vy_run *run = slice->run;
+	uint32_t end_page_no = MIN(stream->page_no, slice->last_page_no + 1);
+	if (stream->page != NULL)
+		end_page_no = stream->page_no + 1;
+	if (run->is_direct || end_page_no <= slice->first_page_no)
+		return;
+	struct vy_page_info *first = vy_run_page_info(run, slice->first_page_no);
+	struct vy_page_info *last = vy_run_page_info(run, end_page_no - 1);
+	off_t len = last->offset + last->size - first->offset;
+	int rc = posix_fadvise(run->fd, first->offset, len,
+			       POSIX_FADV_DONTNEED);
+	if (rc != 0) {
+		errno = rc;
+		say_syserror("posix_fadvise, fd=%i", run->fd);
+	}
+#else
+	(void)stream;
+#endif /* HAVE_POSIX_FADVISE */
+}
+
 /**
  * Free resources.
  */
@@ -2604,6 +3948,7 @@ vy_slice_stream_close(struct vy_stmt_stream *virt_stream)
 {
 	assert(virt_stream->iface->close == vy_slice_stream_close);
 	struct vy_slice_stream *stream = (struct vy_slice_stream *)virt_stream;
+	vy_slice_stream_drop_cache(stream);
 	if (stream->page != NULL) {
 		vy_page_delete(stream->page);
 		stream->page = NULL;
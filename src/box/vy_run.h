@@ -40,6 +40,7 @@
 #include "vy_stmt_stream.h"
 #include "vy_read_view.h"
 #include "vy_stat.h"
+#include "vy_blob.h"
 #include "index_def.h"
 #include "xlog.h"
 
@@ -51,6 +52,56 @@ extern "C" {
 
 struct vy_history;
 struct vy_run_reader;
+struct vy_page_prefetch;
+struct mh_vy_page_cache_t;
+
+/**
+ * Cache of decompressed run pages shared by all run iterators.
+ * Pages are looked up by run id and page number and evicted in
+ * LRU order when the cache size exceeds the configured limit.
+ */
+struct vy_page_cache {
+	/** Run id, page number => struct vy_page. */
+	struct mh_vy_page_cache_t *hash;
+	/** LRU list of cached pages. The first element is the newest. */
+	struct rlist lru;
+	/** Size of memory occupied by cached pages. */
+	size_t mem_used;
+	/** Max memory size that can be used for the cache. */
+	size_t mem_quota;
+	/** Number of lookups that found a page in the cache. */
+	int64_t hit;
+	/** Number of lookups that had to read a page from disk. */
+	int64_t miss;
+	/** Number of pages evicted from the cache. */
+	int64_t evict;
+};
+
+/**
+ * Bloom filters and page indexes of runs registered in this
+ * cache are evicted from memory in LRU order when their total
+ * size exceeds the configured limit, and loaded back from the
+ * run index file on demand.
+ */
+struct vy_run_index_cache {
+	/**
+	 * LRU list of registered runs whose bloom filter and
+	 * page index are loaded. The first element is the newest.
+	 */
+	struct rlist lru;
+	/** Size of bloom filters and page indexes of runs in the list. */
+	size_t mem_used;
+	/** Max memory size that can be used by the cache, 0 - no limit. */
+	size_t mem_quota;
+	/** Size of page indexes of registered runs that were evicted. */
+	size_t page_index_evicted;
+	/** Size of bloom filters of registered runs that were evicted. */
+	size_t bloom_evicted;
+	/** Number of run indexes loaded from disk. */
+	int64_t load;
+	/** Number of run indexes evicted from memory. */
+	int64_t evict;
+};
 
 /** Part of vinyl environment for run read/write */
 struct vy_run_env {
@@ -69,6 +120,28 @@ struct vy_run_env {
 	 * processing the next read request.
 	 */
 	int next_reader;
+	/**
+	 * Set if run files should be read with io_uring. Each
+	 * reader thread submits reads to its own ring then and
+	 * decodes pages as the reads complete, so it may have
+	 * many reads in flight.
+	 */
+	bool use_io_uring;
+	/**
+	 * Max number of pages a run iterator reads ahead once
+	 * it detects a sequential scan, 0 disables readahead.
+	 */
+	uint32_t readahead;
+	/**
+	 * Set if run files should be read with O_DIRECT, bypassing
+	 * the kernel page cache, so that run pages aren't cached
+	 * twice, by the OS and by the vinyl caches.
+	 */
+	bool direct_io;
+	/** Cache of decompressed pages, used only by tx. */
+	struct vy_page_cache page_cache;
+	/** Cache of run bloom filters and page indexes, used only by tx. */
+	struct vy_run_index_cache index_cache;
 };
 
 /**
@@ -87,6 +160,13 @@ struct vy_run_info {
 	uint32_t page_count;
 	/** Bloom filter of all tuples in run */
 	struct tuple_bloom *bloom;
+	/**
+	 * Blob files statements of the run refer to, sorted
+	 * by ID, see vy_blob.h. NULL if there are none.
+	 */
+	struct vy_run_blob_info *blobs;
+	/** Number of entries in @blobs. */
+	uint32_t blob_count;
 };
 
 /**
@@ -117,14 +197,51 @@ struct vy_run {
 	struct vy_run_info info;
 	/** Info about the run pages stored in the index file. */
 	struct vy_page_info *page_info;
+	/**
+	 * Blob files statements of the run refer to, in the same
+	 * order as info.blobs. Set by vy_run_bind_blobs().
+	 */
+	struct vy_blob **blobs;
 	/** Run data file. */
 	int fd;
+	/**
+	 * Set if @fd was opened with O_DIRECT, in which case
+	 * reads must be aligned, see vy_run_open_direct().
+	 */
+	bool is_direct;
 	/** Unique ID of this run. */
 	int64_t id;
 	/** Number of statements in this run. */
 	struct vy_disk_stmt_counter count;
 	/** Size of memory used for storing page index. */
 	size_t page_index_size;
+	/** Size of memory used for storing bloom filter. */
+	size_t bloom_size;
+	/**
+	 * Location of the run index file, used for loading the
+	 * bloom filter and page index after they were evicted.
+	 * @dir points to vy_lsm_env::path.
+	 */
+	const char *dir;
+	uint32_t space_id;
+	uint32_t iid;
+	/**
+	 * Set if the bloom filter and page index of this run were
+	 * evicted from memory, see vy_run_index_cache. In this case
+	 * info.bloom and page_info are NULL, but page_index_size,
+	 * bloom_size and info.page_count are still valid.
+	 */
+	bool index_evicted;
+	/** Set if the run is registered in vy_run_index_cache. */
+	bool in_index_cache;
+	/**
+	 * Number of users that need the bloom filter and page index
+	 * of this run to stay in memory. The run index can't be
+	 * evicted while it's pinned.
+	 */
+	int index_pin_count;
+	/** Link in vy_run_index_cache::lru. */
+	struct rlist in_index_lru;
 	/** Max LSN stored on disk. */
 	int64_t dump_lsn;
 	/**
@@ -149,6 +266,8 @@ struct vy_run {
 	struct rlist in_unused;
 	/** Link in vy_lsm::runs list. */
 	struct rlist in_lsm;
+	/** List of pages of this run stored in the page cache. */
+	struct rlist cached_pages;
 };
 
 /**
@@ -257,6 +376,31 @@ struct vy_run_iterator {
 	 */
 	struct vy_page *curr_page;
 	struct vy_page *prev_page;
+	/**
+	 * Number of the page loaded last by the iterator or
+	 * UINT32_MAX if no page has been loaded yet.
+	 */
+	uint32_t last_page_no;
+	/**
+	 * Number of pages loaded one after another in the
+	 * iteration direction. Used for detecting sequential
+	 * scans, see vy_run_env::readahead.
+	 */
+	uint32_t seq_page_count;
+	/**
+	 * List of pages read ahead by this iterator, in the
+	 * order they are going to be loaded. A plain pointer
+	 * rather than rlist, because the iterator may be moved
+	 * in memory by the read iterator.
+	 */
+	struct vy_page_prefetch *prefetch;
+	/**
+	 * Run whose index is pinned by this iterator or NULL
+	 * if the search hasn't been started yet. The iterator
+	 * holds a reference to the run to unpin it on close,
+	 * because the slice may be gone by then.
+	 */
+	struct vy_run *pinned_run;
 	/** Is false until first .._get or .._next_.. method is called */
 	bool search_started;
 	/** Search is finished, you will not get more values from iterator */
@@ -277,6 +421,19 @@ struct vy_page {
 	uint32_t *row_index;
 	/** Pointer to the page data. */
 	char *data;
+	/**
+	 * Number of references to this page. A page is referenced
+	 * by each iterator that has it loaded and by the page cache.
+	 */
+	int refs;
+	/** ID of the run this page belongs to. */
+	int64_t run_id;
+	/** Set if this page is stored in the page cache. */
+	bool in_cache;
+	/** Link in vy_page_cache::lru. */
+	struct rlist in_lru;
+	/** Link in vy_run::cached_pages. */
+	struct rlist in_run;
 };
 
 /**
@@ -295,6 +452,21 @@ vy_run_env_create(struct vy_run_env *env, int read_threads);
 void
 vy_run_env_destroy(struct vy_run_env *env);
 
+/**
+ * Set memory limit for the page cache of a vinyl run environment.
+ * Pages are evicted from the cache until it fits in the new limit.
+ * Zero disables the cache.
+ */
+void
+vy_run_env_set_page_cache_quota(struct vy_run_env *env, size_t quota);
+
+/**
+ * Set memory limit for bloom filters and page indexes of runs
+ * registered in the run index cache. Zero means no limit.
+ */
+void
+vy_run_env_set_index_cache_quota(struct vy_run_env *env, size_t quota);
+
 /**
  * Enable coio reads for a vinyl run environment.
  *
@@ -316,9 +488,42 @@ vy_run_env_enable_coio(struct vy_run_env *env);
 size_t
 vy_run_bloom_size(struct vy_run *run);
 
+/**
+ * Register a run in the run index cache, making its bloom
+ * filter and page index evictable.
+ */
+void
+vy_run_index_cache_add(struct vy_run *run);
+
+/**
+ * Unregister a run from the run index cache.
+ */
+void
+vy_run_index_cache_remove(struct vy_run *run);
+
+/**
+ * Load the bloom filter and page index of a run if they were
+ * evicted and pin them in memory until vy_run_unpin_index()
+ * is called. If @can_yield is set, the index file is read by
+ * a reader thread, otherwise it is read in the calling thread.
+ *
+ * @retval 0 success
+ * @retval -1 error, check diag
+ */
+int
+vy_run_pin_index(struct vy_run *run, bool can_yield);
+
+/**
+ * Unpin the bloom filter and page index of a run pinned with
+ * vy_run_pin_index().
+ */
+void
+vy_run_unpin_index(struct vy_run *run);
+
 static inline struct vy_page_info *
 vy_run_page_info(struct vy_run *run, uint32_t pos)
 {
+	assert(!run->index_evicted);
 	assert(pos < run->info.page_count);
 	return &run->page_info[pos];
 }
@@ -350,6 +555,29 @@ vy_run_unref(struct vy_run *run)
 		vy_run_delete(run);
 }
 
+/**
+ * Look up the blob files a run refers to in the list of blob
+ * files of its LSM tree (linked by vy_blob::in_lsm) and reference
+ * them. @new_blob is the blob file written along with the run,
+ * it may be NULL.
+ *
+ * Return 0 on success, -1 if a blob file is missing.
+ */
+int
+vy_run_bind_blobs(struct vy_run *run, struct rlist *lsm_blobs,
+		  struct vy_blob *new_blob);
+
+/** Return true if the blob file with the run's ID is used by it. */
+static inline bool
+vy_run_has_own_blob(struct vy_run *run)
+{
+	for (uint32_t i = 0; i < run->info.blob_count; i++) {
+		if (run->info.blobs[i].id == run->id)
+			return true;
+	}
+	return false;
+}
+
 /**
  * Load run from disk
  * @param run - run to laod
@@ -599,6 +827,8 @@ struct vy_run_writer {
 	struct xlog data_xlog;
 	/** Bloom filter false positive rate. */
 	double bloom_fpr;
+	/** Type of bloom filter to build. */
+	enum bloom_type bloom_type;
 	/** Bloom filter. */
 	struct tuple_bloom_builder *bloom;
 	/** Buffer of a current page row offsets. */
@@ -608,14 +838,25 @@ struct vy_run_writer {
 	 * of max key of a finished run.
 	 */
 	struct tuple *last_stmt;
+	/**
+	 * Writer of the blob file of the run or NULL if values
+	 * aren't separated, see vy_blob.h.
+	 */
+	struct vy_blob_writer *blob_writer;
 };
 
-/** Create a run writer to fill a run with statements. */
+/**
+ * Create a run writer to fill a run with statements.
+ * If @blob_writer is not NULL, statements are passed through it
+ * before they are written to the run.
+ */
 int
 vy_run_writer_create(struct vy_run_writer *writer, struct vy_run *run,
 		     const char *dirpath, uint32_t space_id, uint32_t iid,
 		     struct key_def *cmp_def, struct key_def *key_def,
-		     uint64_t page_size, double bloom_fpr);
+		     uint64_t page_size, double bloom_fpr,
+		     enum bloom_type bloom_type,
+		     struct vy_blob_writer *blob_writer);
 
 /**
  * Write a specified statement into a run.
@@ -196,12 +196,43 @@ struct vy_task {
 	 * need to remember the slices we are compacting.
 	 */
 	struct vy_slice *first_slice, *last_slice;
+	/**
+	 * Compaction of a big range may be split into several
+	 * parts, each of which processes its own key interval
+	 * and writes its own run, see vy_task_compact_new().
+	 * The parts are executed by different workers, but
+	 * completed together by the task that processes the
+	 * first interval. That task links all parts, including
+	 * itself, in this list. A task that isn't split is the
+	 * only part of itself.
+	 */
+	struct rlist parts;
+	/** Link in the parts list of the parent task. */
+	struct rlist in_parts;
+	/** Task this one is a part of or NULL. */
+	struct vy_task *parent;
+	/**
+	 * Number of parts of this task that have been sent
+	 * to worker threads and haven't returned yet.
+	 */
+	int exec_count;
+	/**
+	 * Boundaries of the key interval processed by this
+	 * task, NULL means unbounded.
+	 */
+	struct tuple *begin, *end;
+	/**
+	 * Slices of the compacted runs cut by [begin, end).
+	 * Used only if the compaction was split.
+	 */
+	struct rlist cut_slices;
 	/**
 	 * Index options may be modified while a task is in
 	 * progress so we save them here to safely access them
 	 * from another thread.
 	 */
 	double bloom_fpr;
+	enum bloom_type bloom_type;
 	int64_t page_size;
 	/**
 	 * Deferred DELETE handler passed to the write iterator.
@@ -209,6 +240,30 @@ struct vy_task {
 	 * primary index compaction back to tx.
 	 */
 	struct vy_deferred_delete_handler deferred_delete_handler;
+	/**
+	 * Compaction filter passed to the write iterator. It
+	 * drops tuples that have expired by the time the task
+	 * was created, see index_opts::expire_field.
+	 */
+	struct vy_compaction_filter compaction_filter;
+	/**
+	 * Copy of index_opts::blob_threshold or 0 if values
+	 * aren't moved to blob files.
+	 */
+	uint32_t blob_threshold;
+	/**
+	 * Blob files, sorted by ID, values from which are copied
+	 * to the blob file of the new run, because they are mostly
+	 * garbage. Referenced by the task. Parts of a split
+	 * compaction use the array of the parent task.
+	 */
+	struct vy_blob **relocate_blobs;
+	/** Number of entries in @relocate_blobs. */
+	uint32_t relocate_blob_count;
+	/** Copy of index_opts::expire_field or 0 if unused. */
+	uint32_t expire_field;
+	/** Time tuples are checked for expiration against. */
+	double expire_time;
 	/** Batch of deferred deletes generated by this task. */
 	struct vy_deferred_delete_batch *deferred_delete_batch;
 	/**
@@ -223,6 +278,38 @@ struct vy_task {
 static const struct vy_deferred_delete_handler_iface
 vy_task_deferred_delete_iface;
 
+/**
+ * Compaction filter that drops a tuple if the field
+ * specified by index_opts::expire_field stores a time
+ * in the past. Tuples that don't have the field or
+ * store a non-numeric value in it never expire.
+ */
+static bool
+vy_task_expire_filter(struct vy_compaction_filter *filter,
+		      const struct tuple *stmt)
+{
+	struct vy_task *task = container_of(filter, struct vy_task,
+					    compaction_filter);
+	assert(task->expire_field > 0);
+	const char *field = tuple_field(stmt, task->expire_field - 1);
+	if (field == NULL)
+		return false;
+	double expire_time;
+	if (mp_read_double(&field, &expire_time) != 0)
+		return false;
+	return expire_time <= task->expire_time;
+}
+
+/**
+ * Return the compaction filter to pass to the write iterator
+ * of a task or NULL if tuples never expire in the LSM tree.
+ */
+static struct vy_compaction_filter *
+vy_task_compaction_filter(struct vy_task *task)
+{
+	return task->expire_field > 0 ? &task->compaction_filter : NULL;
+}
+
 /**
  * Allocate a new task to be executed by a worker thread.
  * When preparing an asynchronous task, this function must
@@ -259,6 +346,18 @@ vy_task_new(struct vy_scheduler *scheduler, struct vy_worker *worker,
 	vy_lsm_ref(lsm);
 	diag_create(&task->diag);
 	task->deferred_delete_handler.iface = &vy_task_deferred_delete_iface;
+	task->compaction_filter.filter = vy_task_expire_filter;
+	/*
+	 * Secondary indexes can't drop tuples on their own,
+	 * because they'd diverge from the primary index.
+	 */
+	task->expire_field = lsm->index_id == 0 ? lsm->opts.expire_field : 0;
+	task->expire_time = fiber_time();
+	task->blob_threshold = lsm->index_id == 0 ?
+			       lsm->opts.blob_threshold : 0;
+	rlist_create(&task->parts);
+	rlist_add_tail_entry(&task->parts, task, in_parts);
+	rlist_create(&task->cut_slices);
 	return task;
 }
 
@@ -268,6 +367,20 @@ vy_task_delete(struct vy_task *task)
 {
 	assert(task->deferred_delete_batch == NULL);
 	assert(task->deferred_delete_in_progress == 0);
+	assert(task->exec_count == 0);
+	assert(rlist_empty(&task->cut_slices));
+	struct vy_task *part, *next_part;
+	rlist_foreach_entry_safe(part, &task->parts, in_parts, next_part) {
+		if (part != task)
+			vy_task_delete(part);
+	}
+	if (task->begin != NULL)
+		tuple_unref(task->begin);
+	if (task->end != NULL)
+		tuple_unref(task->end);
+	for (uint32_t i = 0; i < task->relocate_blob_count; i++)
+		vy_blob_unref(task->relocate_blobs[i]);
+	free(task->relocate_blobs);
 	key_def_delete(task->cmp_def);
 	key_def_delete(task->key_def);
 	vy_lsm_unref(task->lsm);
@@ -437,6 +550,7 @@ vy_scheduler_create(struct vy_scheduler *scheduler, int write_threads,
 	scheduler->dump_complete_cb = dump_complete_cb;
 	scheduler->read_views = read_views;
 	scheduler->run_env = run_env;
+	scheduler->max_subcompactions = 1;
 
 	scheduler->scheduler_fiber = fiber_new("vinyl.scheduler",
 					       vy_scheduler_f);
@@ -797,6 +911,14 @@ vy_deferred_delete_process_one(struct space *deferred_delete_space,
 			       struct vy_deferred_delete_stmt *stmt)
 {
 	int64_t lsn = vy_stmt_lsn(stmt->new_stmt);
+	/*
+	 * A tuple dropped by the compaction filter is passed
+	 * as both the old and the new statement. Mark the DELETE
+	 * generated for it so that it purges the tuple from
+	 * secondary indexes, see VY_STMT_EXPIRED.
+	 */
+	uint8_t flags = stmt->old_stmt == stmt->new_stmt ?
+			VY_STMT_EXPIRED : 0;
 
 	struct tuple *delete;
 	delete = vy_stmt_new_surrogate_delete(format, stmt->old_stmt);
@@ -806,8 +928,10 @@ vy_deferred_delete_process_one(struct space *deferred_delete_space,
 	uint32_t delete_data_size;
 	const char *delete_data = tuple_data_range(delete, &delete_data_size);
 
-	size_t buf_size = (mp_sizeof_array(3) + mp_sizeof_uint(space_id) +
-			   mp_sizeof_uint(lsn) + delete_data_size);
+	uint32_t field_count = flags != 0 ? 4 : 3;
+	size_t buf_size = (mp_sizeof_array(field_count) +
+			   mp_sizeof_uint(space_id) + mp_sizeof_uint(lsn) +
+			   delete_data_size + mp_sizeof_uint(flags));
 	char *data = region_alloc(&fiber()->gc, buf_size);
 	if (data == NULL) {
 		diag_set(OutOfMemory, buf_size, "region", "buf");
@@ -816,11 +940,13 @@ vy_deferred_delete_process_one(struct space *deferred_delete_space,
 	}
 
 	char *data_end = data;
-	data_end = mp_encode_array(data_end, 3);
+	data_end = mp_encode_array(data_end, field_count);
 	data_end = mp_encode_uint(data_end, space_id);
 	data_end = mp_encode_uint(data_end, lsn);
 	memcpy(data_end, delete_data, delete_data_size);
 	data_end += delete_data_size;
+	if (flags != 0)
+		data_end = mp_encode_uint(data_end, flags);
 	assert(data_end <= data + buf_size);
 
 	struct request request;
@@ -1033,11 +1159,29 @@ vy_task_write_run(struct vy_task *task)
 	if (inj != NULL && inj->dparam > 0)
 		usleep(inj->dparam * 1000000);
 
+	/*
+	 * Statements of a primary index may refer to blob files
+	 * even if separation is disabled now, so the blob writer
+	 * is needed to account the references anyway.
+	 */
+	struct vy_blob_writer blob_writer;
+	if (lsm->index_id == 0) {
+		struct vy_task *owner = task->parent != NULL ?
+					task->parent : task;
+		vy_blob_writer_create(&blob_writer, lsm->env->path,
+				      lsm->space_id, lsm->index_id,
+				      task->new_run->id, task->blob_threshold,
+				      owner->relocate_blobs,
+				      owner->relocate_blob_count);
+	}
+
 	struct vy_run_writer writer;
 	if (vy_run_writer_create(&writer, task->new_run, lsm->env->path,
 				 lsm->space_id, lsm->index_id,
 				 task->cmp_def, task->key_def,
-				 task->page_size, task->bloom_fpr) != 0)
+				 task->page_size, task->bloom_fpr,
+				 task->bloom_type,
+				 lsm->index_id == 0 ? &blob_writer : NULL) != 0)
 		goto fail;
 
 	if (wi->iface->start(wi) != 0)
@@ -1118,6 +1262,9 @@ vy_task_dump_complete(struct vy_task *task)
 
 	assert(new_run->info.max_lsn <= dump_lsn);
 
+	if (vy_lsm_bind_run_blobs(lsm, new_run) != 0)
+		goto fail;
+
 	/*
 	 * Figure out which ranges intersect the new run.
 	 * @begin_range is the first range intersecting the run.
@@ -1168,6 +1315,8 @@ vy_task_dump_complete(struct vy_task *task)
 	 */
 	vy_log_tx_begin();
 	vy_log_create_run(lsm->id, new_run->id, dump_lsn);
+	if (vy_run_has_own_blob(new_run))
+		vy_log_create_blob(lsm->id, new_run->id);
 	for (range = begin_range, i = 0; range != end_range;
 	     range = vy_range_tree_next(lsm->tree, range), i++) {
 		assert(i < lsm->range_count);
@@ -1372,12 +1521,20 @@ vy_task_dump_new(struct vy_scheduler *scheduler, struct vy_worker *worker,
 	 * in case the overwritten tuple is found in-memory, no
 	 * deferred DELETE statement should be generated during
 	 * dump so we don't pass a deferred DELETE handler.
+	 *
+	 * For the same reason, we can't drop expired tuples on
+	 * dump if the space has secondary indexes, because they
+	 * would never be purged from them.
 	 */
+	struct vy_compaction_filter *filter = vy_task_compaction_filter(task);
+	struct space *space = space_by_id(lsm->space_id);
+	if (space != NULL && space->index_count > 1)
+		filter = NULL;
 	struct vy_stmt_stream *wi;
 	bool is_last_level = (lsm->run_count == 0);
 	wi = vy_write_iterator_new(task->cmp_def, lsm->disk_format,
 				   lsm->index_id == 0, is_last_level,
-				   scheduler->read_views, NULL);
+				   scheduler->read_views, NULL, filter);
 	if (wi == NULL)
 		goto err_wi;
 	rlist_foreach_entry(mem, &lsm->sealed, in_sealed) {
@@ -1390,6 +1547,7 @@ vy_task_dump_new(struct vy_scheduler *scheduler, struct vy_worker *worker,
 	task->new_run = new_run;
 	task->wi = wi;
 	task->bloom_fpr = lsm->opts.bloom_fpr;
+	task->bloom_type = lsm->opts.bloom_type;
 	task->page_size = lsm->opts.page_size;
 
 	lsm->is_dumping = true;
@@ -1425,6 +1583,93 @@ err:
 	return -1;
 }
 
+/**
+ * Unpin bloom filters and page indexes of runs compacted
+ * by a task, see vy_task_compact_new().
+ */
+static void
+vy_task_compact_unpin_runs(struct vy_task *task)
+{
+	struct vy_slice *slice = task->first_slice;
+	while (slice != NULL) {
+		vy_run_unpin_index(slice->run);
+		if (slice == task->last_slice)
+			break;
+		slice = rlist_next_entry(slice, in_range);
+	}
+}
+
+/**
+ * Unpin runs pinned by vy_task_compact_pin_range().
+ */
+static void
+vy_task_compact_unpin_range(struct vy_run **runs, int count)
+{
+	for (int i = 0; i < count; i++) {
+		vy_run_unpin_index(runs[i]);
+		vy_run_unref(runs[i]);
+	}
+	free(runs);
+}
+
+/**
+ * Pin bloom filters and page indexes of all runs of a range
+ * chosen for compaction, see vy_task_compact_new(). Indexes
+ * evicted from memory are read by reader threads so this
+ * function yields. Returns an array of pinned runs, which
+ * must be released with vy_task_compact_unpin_range(), or
+ * NULL on error.
+ */
+static struct vy_run **
+vy_task_compact_pin_range(struct vy_range *range, int *count)
+{
+	struct vy_run **runs = malloc(range->slice_count * sizeof(*runs));
+	if (runs == NULL) {
+		diag_set(OutOfMemory, range->slice_count * sizeof(*runs),
+			 "malloc", "struct vy_run *");
+		return NULL;
+	}
+	int n = 0;
+	struct vy_slice *slice;
+	rlist_foreach_entry(slice, &range->slices, in_range) {
+		struct vy_run *run = slice->run;
+		vy_run_ref(run);
+		if (vy_run_pin_index(run, true) != 0) {
+			vy_run_unref(run);
+			vy_task_compact_unpin_range(runs, n);
+			return NULL;
+		}
+		runs[n++] = run;
+	}
+	assert(n == range->slice_count);
+	*count = n;
+	return runs;
+}
+
+/**
+ * Close write iterators of all parts of a compaction task
+ * and delete the slices they were reading. Note, a cut slice
+ * counts as a user of the run it was cut from so this must
+ * be done before looking for runs that became unused.
+ */
+static void
+vy_task_compact_close(struct vy_task *task)
+{
+	struct vy_task *part;
+	rlist_foreach_entry(part, &task->parts, in_parts) {
+		/* The iterator has been cleaned up in worker. */
+		if (part->wi != NULL) {
+			part->wi->iface->close(part->wi);
+			part->wi = NULL;
+		}
+		struct vy_slice *slice, *next_slice;
+		rlist_foreach_entry_safe(slice, &part->cut_slices,
+					 in_range, next_slice)
+			vy_slice_delete(slice);
+		rlist_create(&part->cut_slices);
+	}
+}
+
 static int
 vy_task_compact_execute(struct vy_task *task)
 {
@@ -1436,32 +1681,92 @@ vy_task_compact_execute(struct vy_task *task)
 	return vy_task_write_run(task);
 }
 
+/** Check if a run refers to a blob file. */
+static bool
+vy_task_compact_run_uses_blob(struct vy_run *run, struct vy_blob *blob)
+{
+	return run->blobs != NULL &&
+	       vy_blob_find(run->blobs, run->info.blob_count,
+			    blob->id) != NULL;
+}
+
+/**
+ * Log removal of blob files that are referenced only by runs
+ * that became unused as a result of compaction.
+ */
+static void
+vy_task_compact_log_drop_blobs(struct vy_task *task, struct rlist *unused_runs,
+			       int64_t gc_lsn)
+{
+	struct vy_run *run, *other;
+	rlist_foreach_entry(run, unused_runs, in_unused) {
+		for (uint32_t i = 0; i < run->info.blob_count; i++) {
+			struct vy_blob *blob = run->blobs[i];
+			/*
+			 * Count unused runs referring to the blob
+			 * file. Log it only once, for the first run.
+			 */
+			int count = 0;
+			bool is_first = true;
+			rlist_foreach_entry(other, unused_runs, in_unused) {
+				if (!vy_task_compact_run_uses_blob(other, blob))
+					continue;
+				if (count++ == 0 && other != run)
+					is_first = false;
+			}
+			if (!is_first || count < blob->run_count)
+				continue;
+			bool is_used = false;
+			struct vy_task *part;
+			rlist_foreach_entry(part, &task->parts, in_parts) {
+				if (vy_task_compact_run_uses_blob(part->new_run,
+								  blob))
+					is_used = true;
+			}
+			if (!is_used)
+				vy_log_drop_blob(blob->id, gc_lsn);
+		}
+	}
+}
+
 static int
 vy_task_compact_complete(struct vy_task *task)
 {
 	struct vy_scheduler *scheduler = task->scheduler;
 	struct vy_lsm *lsm = task->lsm;
 	struct vy_range *range = task->range;
-	struct vy_run *new_run = task->new_run;
-	struct vy_disk_stmt_counter compact_out = new_run->count;
+	struct vy_disk_stmt_counter compact_out;
 	struct vy_disk_stmt_counter compact_in;
 	struct vy_slice *first_slice = task->first_slice;
 	struct vy_slice *last_slice = task->last_slice;
-	struct vy_slice *slice, *next_slice, *new_slice = NULL;
+	struct vy_slice *slice, *next_slice, *new_slice;
+	struct vy_task *part;
 	struct vy_run *run;
 
+	vy_task_compact_close(task);
+
 	/*
-	 * Allocate a slice of the new run.
+	 * Allocate slices of the new runs, one per each part
+	 * of the task.
 	 *
-	 * If the run is empty, we don't need to allocate a new slice
+	 * If a run is empty, we don't need to allocate a new slice
 	 * and insert it into the range, but we still need to delete
 	 * compacted runs.
 	 */
-	if (!vy_run_is_empty(new_run)) {
-		new_slice = vy_slice_new(vy_log_next_id(), new_run,
-					 NULL, NULL, lsm->cmp_def);
+	RLIST_HEAD(new_slices);
+	vy_disk_stmt_counter_reset(&compact_out);
+	rlist_foreach_entry(part, &task->parts, in_parts) {
+		run = part->new_run;
+		vy_disk_stmt_counter_add(&compact_out, &run->count);
+		if (vy_run_is_empty(run))
+			continue;
+		if (vy_lsm_bind_run_blobs(lsm, run) != 0)
+			goto fail;
+		new_slice = vy_slice_new(vy_log_next_id(), run, part->begin,
+					 part->end, lsm->cmp_def);
 		if (new_slice == NULL)
-			return -1;
+			goto fail;
+		rlist_add_tail_entry(&new_slices, new_slice, in_range);
 	}
 
 	/*
@@ -1484,7 +1789,8 @@ vy_task_compact_complete(struct vy_task *task)
 	}
 
 	/*
-	 * Log change in metadata.
+	 * Log change in metadata. Runs written by all parts
+	 * of the task are committed in one transaction.
 	 */
 	vy_log_tx_begin();
 	for (slice = first_slice; ; slice = rlist_next_entry(slice, in_range)) {
@@ -1495,17 +1801,18 @@ vy_task_compact_complete(struct vy_task *task)
 	int64_t gc_lsn = vy_log_signature();
 	rlist_foreach_entry(run, &unused_runs, in_unused)
 		vy_log_drop_run(run->id, gc_lsn);
-	if (new_slice != NULL) {
-		vy_log_create_run(lsm->id, new_run->id, new_run->dump_lsn);
-		vy_log_insert_slice(range->id, new_run->id, new_slice->id,
+	vy_task_compact_log_drop_blobs(task, &unused_runs, gc_lsn);
+	rlist_foreach_entry(new_slice, &new_slices, in_range) {
+		run = new_slice->run;
+		vy_log_create_run(lsm->id, run->id, run->dump_lsn);
+		if (vy_run_has_own_blob(run))
+			vy_log_create_blob(lsm->id, run->id);
+		vy_log_insert_slice(range->id, run->id, new_slice->id,
 				    tuple_data_or_null(new_slice->begin),
 				    tuple_data_or_null(new_slice->end));
 	}
-	if (vy_log_tx_commit() < 0) {
-		if (new_slice != NULL)
-			vy_slice_delete(new_slice);
-		return -1;
-	}
+	if (vy_log_tx_commit() < 0)
+		goto fail;
 
 	/*
 	 * Remove compacted run files that were created after
@@ -1522,30 +1829,38 @@ vy_task_compact_complete(struct vy_task *task)
 	}
 	vy_log_tx_try_commit();
 
+	/* Compacted runs aren't accessed by the worker anymore. */
+	vy_task_compact_unpin_runs(task);
+
 	/*
-	 * Account the new run if it is not empty,
-	 * otherwise discard it.
+	 * Account the new runs that are not empty,
+	 * discard the rest.
 	 */
-	if (new_slice != NULL) {
-		vy_lsm_add_run(lsm, new_run);
-		/* Drop the reference held by the task. */
-		vy_run_unref(new_run);
-	} else
-		vy_run_discard(new_run);
+	rlist_foreach_entry(part, &task->parts, in_parts) {
+		run = part->new_run;
+		if (!vy_run_is_empty(run)) {
+			vy_lsm_add_run(lsm, run);
+			/* Drop the reference held by the task. */
+			vy_run_unref(run);
+		} else
+			vy_run_discard(run);
+	}
 
 	/*
-	 * Replace compacted slices with the resulting slice and
+	 * Replace compacted slices with the resulting slices and
 	 * account compaction in LSM tree statistics.
 	 *
 	 * Note, since a slice might have been added to the range
 	 * by a concurrent dump while compaction was in progress,
-	 * we must insert the new slice at the same position where
+	 * we must insert the new slices at the same position where
 	 * the compacted slices were.
 	 */
 	RLIST_HEAD(compacted_slices);
 	vy_lsm_unacct_range(lsm, range);
-	if (new_slice != NULL)
+	rlist_foreach_entry_safe(new_slice, &new_slices, in_range, next_slice) {
+		rlist_del_entry(new_slice, in_range);
 		vy_range_add_slice_before(range, new_slice, first_slice);
+	}
 	vy_disk_stmt_counter_reset(&compact_in);
 	for (slice = first_slice; ; slice = next_slice) {
 		next_slice = rlist_next_entry(slice, in_range);
@@ -1572,9 +1887,6 @@ vy_task_compact_complete(struct vy_task *task)
 		vy_slice_delete(slice);
 	}
 
-	/* The iterator has been cleaned up in worker. */
-	task->wi->iface->close(task->wi);
-
 	assert(range->heap_node.pos == UINT32_MAX);
 	vy_range_heap_insert(&lsm->range_heap, &range->heap_node);
 	vy_scheduler_update_lsm(scheduler, lsm);
@@ -1582,6 +1894,10 @@ vy_task_compact_complete(struct vy_task *task)
 	say_info("%s: completed compacting range %s",
 		 vy_lsm_name(lsm), vy_range_str(range));
 	return 0;
+fail:
+	rlist_foreach_entry_safe(new_slice, &new_slices, in_range, next_slice)
+		vy_slice_delete(new_slice);
+	return -1;
 }
 
 static void
@@ -1591,8 +1907,8 @@ vy_task_compact_abort(struct vy_task *task)
 	struct vy_lsm *lsm = task->lsm;
 	struct vy_range *range = task->range;
 
-	/* The iterator has been cleaned up in worker. */
-	task->wi->iface->close(task->wi);
+	vy_task_compact_close(task);
+	vy_task_compact_unpin_runs(task);
 
 	/*
 	 * It's no use alerting the user if the server is
@@ -1605,13 +1921,206 @@ vy_task_compact_abort(struct vy_task *task)
 			  vy_lsm_name(lsm), vy_range_str(range));
 	}
 
-	vy_run_discard(task->new_run);
+	struct vy_task *part;
+	rlist_foreach_entry(part, &task->parts, in_parts)
+		vy_run_discard(part->new_run);
 
 	assert(range->heap_node.pos == UINT32_MAX);
 	vy_range_heap_insert(&lsm->range_heap, &range->heap_node);
 	vy_scheduler_update_lsm(scheduler, lsm);
 }
 
+/**
+ * Split a compaction task into several parts that process
+ * adjacent key intervals in parallel, each in its own worker
+ * thread. The number of parts is limited by the number of idle
+ * workers and vinyl_max_subcompactions. To avoid splitting small
+ * compactions, each part must span at least a few pages of the
+ * biggest compacted run. Interval boundaries are taken from the
+ * page index of that run so that the parts are of about the same
+ * size.
+ */
+static int
+vy_task_compact_split(struct vy_task *task)
+{
+	enum { MIN_PAGES_PER_PART = 16 };
+
+	struct vy_scheduler *scheduler = task->scheduler;
+	struct vy_lsm *lsm = task->lsm;
+
+	struct vy_slice *slice, *biggest = NULL;
+	for (slice = task->first_slice; ;
+	     slice = rlist_next_entry(slice, in_range)) {
+		if (biggest == NULL || slice->count.bytes_compressed >
+				       biggest->count.bytes_compressed)
+			biggest = slice;
+		if (slice == task->last_slice)
+			break;
+	}
+	if (biggest->run->info.page_count == 0)
+		return 0;
+
+	uint32_t page_count = biggest->last_page_no -
+			      biggest->first_page_no + 1;
+	int part_count = MIN(scheduler->max_subcompactions,
+			     (int)(page_count / MIN_PAGES_PER_PART));
+	if (part_count <= 1)
+		return 0;
+
+	/*
+	 * A boundary must be greater than the previous one,
+	 * otherwise the part would be empty.
+	 */
+	const char *prev_key;
+	if (biggest->begin != NULL)
+		prev_key = tuple_data(biggest->begin);
+	else
+		prev_key = vy_run_page_info(biggest->run,
+					    biggest->first_page_no)->min_key;
+
+	struct vy_task *prev = task;
+	for (int i = 1; i < part_count; i++) {
+		uint32_t page_no = biggest->first_page_no +
+				   page_count * i / part_count;
+		const char *key = vy_run_page_info(biggest->run,
+						   page_no)->min_key;
+		if (key_compare(key, prev_key, lsm->cmp_def) <= 0)
+			continue;
+
+		struct vy_worker *worker;
+		worker = vy_worker_pool_get(&scheduler->compact_pool);
+		if (worker == NULL)
+			break; /* all workers are busy */
+
+		struct tuple *begin = vy_key_from_msgpack(lsm->env->key_format,
+							  key);
+		if (begin == NULL) {
+			vy_worker_pool_put(worker);
+			return -1;
+		}
+		struct vy_task *part = vy_task_new(scheduler, worker,
+						   lsm, task->ops);
+		if (part == NULL) {
+			tuple_unref(begin);
+			vy_worker_pool_put(worker);
+			return -1;
+		}
+		rlist_del_entry(part, in_parts);
+		rlist_add_tail_entry(&task->parts, part, in_parts);
+		part->parent = task;
+		part->range = task->range;
+		part->first_slice = task->first_slice;
+		part->last_slice = task->last_slice;
+		part->bloom_fpr = task->bloom_fpr;
+		part->bloom_type = task->bloom_type;
+		part->page_size = task->page_size;
+		part->begin = begin;
+		tuple_ref(begin);
+		prev->end = begin;
+		prev = part;
+		prev_key = key;
+	}
+	return 0;
+}
+
+/**
+ * Choose blob files referenced by the compacted runs that are
+ * at least half garbage. Values stored in them will be copied
+ * to the blob file of the new run so that they can be dropped
+ * eventually.
+ */
+static int
+vy_task_compact_choose_blobs(struct vy_task *task)
+{
+	struct vy_slice *slice;
+	for (slice = task->first_slice; ;
+	     slice = rlist_next_entry(slice, in_range)) {
+		struct vy_run *run = slice->run;
+		for (uint32_t i = 0; i < run->info.blob_count; i++) {
+			struct vy_blob *blob = run->blobs[i];
+			if (vy_blob_garbage(blob) * 2 < blob->size ||
+			    vy_blob_find(task->relocate_blobs,
+					 task->relocate_blob_count,
+					 blob->id) != NULL)
+				continue;
+			uint32_t count = task->relocate_blob_count;
+			size_t size = (count + 1) * sizeof(*task->relocate_blobs);
+			struct vy_blob **blobs = realloc(task->relocate_blobs,
+							 size);
+			if (blobs == NULL) {
+				diag_set(OutOfMemory, size, "realloc",
+					 "struct vy_blob");
+				return -1;
+			}
+			uint32_t pos = count;
+			while (pos > 0 && blobs[pos - 1]->id > blob->id) {
+				blobs[pos] = blobs[pos - 1];
+				pos--;
+			}
+			blobs[pos] = blob;
+			vy_blob_ref(blob);
+			task->relocate_blobs = blobs;
+			task->relocate_blob_count = count + 1;
+		}
+		if (slice == task->last_slice)
+			break;
+	}
+	return 0;
+}
+
+/**
+ * Create the write iterator and the output run for a part of
+ * a compaction task. If the task was split, the iterator reads
+ * slices of the compacted runs cut by the key interval of the
+ * part.
+ */
+static int
+vy_task_compact_prepare(struct vy_task *task, bool is_last_level,
+			int64_t dump_lsn)
+{
+	struct vy_scheduler *scheduler = task->scheduler;
+	struct vy_lsm *lsm = task->lsm;
+	bool is_split = (task->begin != NULL || task->end != NULL);
+
+	task->new_run = vy_run_prepare(scheduler->run_env, lsm);
+	if (task->new_run == NULL)
+		return -1;
+	task->new_run->dump_lsn = dump_lsn;
+
+	task->wi = vy_write_iterator_new(task->cmp_def, lsm->disk_format,
+					 lsm->index_id == 0, is_last_level,
+					 scheduler->read_views,
+					 lsm->index_id > 0 ? NULL :
+					 &task->deferred_delete_handler,
+					 vy_task_compaction_filter(task));
+	if (task->wi == NULL)
+		return -1;
+
+	struct vy_slice *slice, *src;
+	for (slice = task->first_slice; ;
+	     slice = rlist_next_entry(slice, in_range)) {
+		src = slice;
+		if (is_split) {
+			/*
+			 * Cut slices are never logged so
+			 * they don't need a unique id.
+			 */
+			if (vy_slice_cut(slice, 0, task->begin, task->end,
+					 lsm->cmp_def, &src) != 0)
+				return -1;
+			if (src != NULL)
+				rlist_add_tail_entry(&task->cut_slices,
+						     src, in_range);
+		}
+		if (src != NULL &&
+		    vy_write_iterator_new_slice(task->wi, src) != 0)
+			return -1;
+		if (slice == task->last_slice)
+			break;
+	}
+	return 0;
+}
+
 static int
 vy_task_compact_new(struct vy_scheduler *scheduler, struct vy_worker *worker,
 		    struct vy_lsm *lsm, struct vy_task **p_task)
@@ -1632,9 +2141,39 @@ vy_task_compact_new(struct vy_scheduler *scheduler, struct vy_worker *worker,
 	range = container_of(range_node, struct vy_range, heap_node);
 	assert(range->compact_priority > 1);
 
+	/*
+	 * Splitting a range and preparing a compaction task
+	 * need page indexes of the range's runs, but they don't
+	 * yield so they would have to read index files evicted
+	 * from memory in tx. Load the indexes in reader threads
+	 * in advance and keep them pinned until we are done.
+	 * Since this yields, the LSM tree may be dropped or the
+	 * range may be superseded by another one meanwhile, in
+	 * which case we retry.
+	 */
+	int pinned_count;
+	struct vy_run **pinned;
+	vy_lsm_ref(lsm);
+	pinned = vy_task_compact_pin_range(range, &pinned_count);
+	if (pinned == NULL) {
+		diag_log();
+		say_error("%s: could not start compacting range %s",
+			  vy_lsm_name(lsm), vy_range_str(range));
+		vy_lsm_unref(lsm);
+		return -1;
+	}
+	if (lsm->is_dropped ||
+	    vy_range_heap_top(&lsm->range_heap) != range_node) {
+		vy_task_compact_unpin_range(pinned, pinned_count);
+		vy_lsm_unref(lsm);
+		return 0;
+	}
+
 	if (vy_lsm_split_range(lsm, range) ||
 	    vy_lsm_coalesce_range(lsm, range)) {
+		vy_task_compact_unpin_range(pinned, pinned_count);
 		vy_scheduler_update_lsm(scheduler, lsm);
+		vy_lsm_unref(lsm);
 		return 0;
 	}
 
@@ -1642,27 +2181,19 @@ vy_task_compact_new(struct vy_scheduler *scheduler, struct vy_worker *worker,
 	if (task == NULL)
 		goto err_task;
 
-	struct vy_run *new_run = vy_run_prepare(scheduler->run_env, lsm);
-	if (new_run == NULL)
-		goto err_run;
-
-	struct vy_stmt_stream *wi;
-	bool is_last_level = (range->compact_priority == range->slice_count);
-	wi = vy_write_iterator_new(task->cmp_def, lsm->disk_format,
-				   lsm->index_id == 0, is_last_level,
-				   scheduler->read_views,
-				   lsm->index_id > 0 ? NULL :
-				   &task->deferred_delete_handler);
-	if (wi == NULL)
-		goto err_wi;
-
 	struct vy_slice *slice;
+	int64_t dump_lsn = -1;
 	int n = range->compact_priority;
 	rlist_foreach_entry(slice, &range->slices, in_range) {
-		if (vy_write_iterator_new_slice(wi, slice) != 0)
-			goto err_wi_sub;
-		new_run->dump_lsn = MAX(new_run->dump_lsn,
-					slice->run->dump_lsn);
+		/*
+		 * The worker reads the page index of compacted
+		 * runs so pin it until the task is complete.
+		 * The index was loaded above so this doesn't
+		 * read the index file.
+		 */
+		if (vy_run_pin_index(slice->run, false) != 0)
+			goto err_pin;
+		dump_lsn = MAX(dump_lsn, slice->run->dump_lsn);
 		/* Remember the slices we are compacting. */
 		if (task->first_slice == NULL)
 			task->first_slice = slice;
@@ -1672,16 +2203,31 @@ vy_task_compact_new(struct vy_scheduler *scheduler, struct vy_worker *worker,
 			break;
 	}
 	assert(n == 0);
-	assert(new_run->dump_lsn >= 0);
-
-	range->needs_compaction = false;
+	assert(dump_lsn >= 0);
 
 	task->range = range;
-	task->new_run = new_run;
-	task->wi = wi;
 	task->bloom_fpr = lsm->opts.bloom_fpr;
+	task->bloom_type = lsm->opts.bloom_type;
 	task->page_size = lsm->opts.page_size;
 
+	if (vy_task_compact_choose_blobs(task) != 0)
+		goto err_prepare;
+
+	if (vy_task_compact_split(task) != 0)
+		goto err_prepare;
+
+	struct vy_task *part;
+	int part_count = 0;
+	bool is_last_level = (range->compact_priority == range->slice_count);
+	rlist_foreach_entry(part, &task->parts, in_parts) {
+		if (vy_task_compact_prepare(part, is_last_level,
+					    dump_lsn) != 0)
+			goto err_prepare;
+		part_count++;
+	}
+
+	range->needs_compaction = false;
+
 	/*
 	 * Remove the range we are going to compact from the heap
 	 * so that it doesn't get selected again.
@@ -1690,22 +2236,31 @@ vy_task_compact_new(struct vy_scheduler *scheduler, struct vy_worker *worker,
 	range_node->pos = UINT32_MAX;
 	vy_scheduler_update_lsm(scheduler, lsm);
 
-	say_info("%s: started compacting range %s, runs %d/%d",
+	say_info("%s: started compacting range %s, runs %d/%d, parts %d",
 		 vy_lsm_name(lsm), vy_range_str(range),
-                 range->compact_priority, range->slice_count);
+		 range->compact_priority, range->slice_count, part_count);
+	vy_task_compact_unpin_range(pinned, pinned_count);
+	vy_lsm_unref(lsm);
 	*p_task = task;
 	return 0;
 
-err_wi_sub:
-	task->wi->iface->close(wi);
-err_wi:
-	vy_run_discard(new_run);
-err_run:
+err_prepare:
+	vy_task_compact_close(task);
+	rlist_foreach_entry(part, &task->parts, in_parts) {
+		if (part->new_run != NULL)
+			vy_run_discard(part->new_run);
+		if (part != task)
+			vy_worker_pool_put(part->worker);
+	}
+err_pin:
+	vy_task_compact_unpin_runs(task);
 	vy_task_delete(task);
 err_task:
+	vy_task_compact_unpin_range(pinned, pinned_count);
 	diag_log();
 	say_error("%s: could not start compacting range %s: %s",
 		  vy_lsm_name(lsm), vy_range_str(range));
+	vy_lsm_unref(lsm);
 	return -1;
 }
 
@@ -1768,14 +2323,35 @@ vy_task_execute_f(struct cmsg *cmsg)
  * task from a worker thread. It adds the task to the processed
  * task queue and wakes up the scheduler so that it can complete
  * it.
+ *
+ * If the task was split in parts, it isn't queued until all
+ * of them are executed. A worker that executed a part other
+ * than the first one is released right away.
  */
 static void
 vy_task_complete_f(struct cmsg *cmsg)
 {
 	struct vy_task *task = container_of(cmsg, struct vy_task, cmsg);
-	stailq_add_tail_entry(&task->scheduler->processed_tasks,
+	struct vy_scheduler *scheduler = task->scheduler;
+	if (task->parent != NULL) {
+		vy_worker_pool_put(task->worker);
+		fiber_cond_signal(&scheduler->scheduler_cond);
+		task = task->parent;
+	}
+	assert(task->exec_count > 0);
+	if (--task->exec_count > 0)
+		return;
+	/* Fail the task if any of its parts failed. */
+	struct vy_task *part;
+	rlist_foreach_entry(part, &task->parts, in_parts) {
+		if (part->is_failed && !task->is_failed) {
+			task->is_failed = true;
+			diag_move(&part->diag, &task->diag);
+		}
+	}
+	stailq_add_tail_entry(&scheduler->processed_tasks,
 			      task, in_processed);
-	fiber_cond_signal(&task->scheduler->scheduler_cond);
+	fiber_cond_signal(&scheduler->scheduler_cond);
 }
 
 /**
@@ -2006,9 +2582,17 @@ vy_scheduler_f(va_list va)
 			continue;
 		}
 
-		/* Queue the task for execution. */
-		cmsg_init(&task->cmsg, vy_task_execute_route);
-		cpipe_push(&task->worker->worker_pipe, &task->cmsg);
+		/*
+		 * Queue the task for execution. Note, parts can't
+		 * complete until all of them have been queued,
+		 * because cpipe_push() doesn't yield.
+		 */
+		struct vy_task *part;
+		rlist_foreach_entry(part, &task->parts, in_parts) {
+			task->exec_count++;
+			cmsg_init(&part->cmsg, vy_task_execute_route);
+			cpipe_push(&part->worker->worker_pipe, &part->cmsg);
+		}
 
 		fiber_reschedule();
 		continue;
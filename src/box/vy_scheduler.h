@@ -149,6 +149,12 @@ struct vy_scheduler {
 	struct rlist *read_views;
 	/** Context needed for writing runs. */
 	struct vy_run_env *run_env;
+	/**
+	 * Max number of parts a compaction task may be split
+	 * in to be executed by several workers in parallel.
+	 * See vy_task_compact_new().
+	 */
+	int max_subcompactions;
 };
 
 /**
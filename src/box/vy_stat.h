@@ -92,6 +92,13 @@ struct vy_run_iterator_stat {
 	 * of disk reads.
 	 */
 	struct vy_disk_stmt_counter read;
+	/** Pages read ahead on sequential scans. */
+	struct {
+		/** Number of pages read ahead and used. */
+		int64_t useful;
+		/** Number of pages read ahead in vain. */
+		int64_t wasted;
+	} readahead;
 };
 
 /** TX write set iterator statistics. */
@@ -113,6 +113,7 @@ vy_stmt_alloc(struct tuple_format *format, uint32_t bsize)
 	say_debug("vy_stmt_alloc(format = %d %u, bsize = %zu) = %p",
 		format->id, tuple_format_meta_size(format), bsize, tuple);
 	tuple->refs = 1;
+	tuple->is_tiny = false;
 	tuple->format_id = tuple_format_id(format);
 	if (cord_is_main())
 		tuple_format_ref(format);
@@ -369,11 +370,18 @@ vy_stmt_new_surrogate_from_key(const char *key, enum iproto_type type,
 
 	char *raw = (char *) tuple_data(stmt);
 	uint32_t *field_map = (uint32_t *) raw;
+	/*
+	 * Fields beyond index_field_count may have offset slots,
+	 * see tuple_format::field_map_step. Nullify them.
+	 */
+	memset(raw - format->field_map_size, 0, format->field_map_size);
 	char *wpos = mp_encode_array(raw, field_count);
 	for (uint32_t i = 0; i < field_count; ++i) {
 		const struct tuple_field *field = &format->fields[i];
-		if (field->offset_slot != TUPLE_OFFSET_SLOT_NIL)
-			field_map[field->offset_slot] = wpos - raw;
+		if (field->offset_slot != TUPLE_OFFSET_SLOT_NIL) {
+			tuple_field_map_set(format, field_map,
+					    field->offset_slot, wpos - raw);
+		}
 		if (iov[i].iov_base == NULL) {
 			wpos = mp_encode_nil(wpos);
 		} else {
@@ -411,21 +419,22 @@ vy_stmt_new_surrogate_delete_raw(struct tuple_format *format,
 
 	const char *src_pos = src_data;
 	uint32_t src_count = mp_decode_array(&src_pos);
-	uint32_t field_count;
-	if (src_count < format->index_field_count) {
-		field_count = src_count;
-		/*
-		 * Nullify field map to be able to detect by 0,
-		 * which key fields are absent in tuple_field().
-		 */
-		memset((char *)field_map - format->field_map_size, 0,
-		       format->field_map_size);
-	} else {
-		field_count = format->index_field_count;
-	}
+	uint32_t field_count = MIN(src_count, format->index_field_count);
+	/*
+	 * Nullify field map to be able to detect by 0,
+	 * which key fields are absent in tuple_field().
+	 * Fields beyond index_field_count may have offset
+	 * slots too, see tuple_format::field_map_step.
+	 */
+	memset((char *)field_map - format->field_map_size, 0,
+	       format->field_map_size);
 	char *pos = mp_encode_array(data, field_count);
 	for (uint32_t i = 0; i < field_count; ++i) {
 		const struct tuple_field *field = &format->fields[i];
+		if (field->offset_slot != TUPLE_OFFSET_SLOT_NIL) {
+			tuple_field_map_set(format, field_map,
+					    field->offset_slot, pos - data);
+		}
 		if (! field->is_key_part) {
 			/* Unindexed field - write NIL. */
 			assert(i < src_count);
@@ -437,8 +446,6 @@ vy_stmt_new_surrogate_delete_raw(struct tuple_format *format,
 		const char *src_field = src_pos;
 		mp_next(&src_pos);
 		memcpy(pos, src_field, src_pos - src_field);
-		if (field->offset_slot != TUPLE_OFFSET_SLOT_NIL)
-			field_map[field->offset_slot] = pos - data;
 		pos += src_pos - src_field;
 	}
 	assert(pos <= data + src_size);
@@ -97,6 +97,24 @@ enum {
 	 * particular key.
 	 */
 	VY_STMT_SKIP_READ		= 1 << 1,
+	/**
+	 * This flag is set for REPLACE and INSERT statements
+	 * some field values of which were moved to blob files
+	 * and replaced with references, see vy_blob.h. Such
+	 * a statement must be resolved with vy_blob_resolve()
+	 * before it is returned to the user.
+	 */
+	VY_STMT_BLOB_REF		= 1 << 2,
+	/**
+	 * This flag is set for deferred DELETE statements that
+	 * purge tuples dropped from the primary index by the
+	 * compaction filter (see index_opts::expire_field) from
+	 * secondary indexes. Such a DELETE has the same LSN as
+	 * the REPLACE or INSERT it purges so it must take
+	 * precedence over any other statement with the same
+	 * key and LSN.
+	 */
+	VY_STMT_EXPIRED			= 1 << 3,
 };
 
 /**
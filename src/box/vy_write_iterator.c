@@ -32,6 +32,7 @@
 #include "vy_mem.h"
 #include "vy_run.h"
 #include "vy_upsert.h"
+#include "vy_blob.h"
 #include "column_mask.h"
 #include "fiber.h"
 
@@ -179,12 +180,22 @@ struct vy_write_iterator {
 	bool is_primary;
 	/** Deferred DELETE handler. */
 	struct vy_deferred_delete_handler *deferred_delete_handler;
+	/** Compaction filter or NULL if there's none. */
+	struct vy_compaction_filter *filter;
 	/**
 	 * Last scanned REPLACE or DELETE statement that was
 	 * inserted into the primary index without deletion
 	 * of the old tuple from secondary indexes.
 	 */
 	struct tuple *deferred_delete_stmt;
+	/**
+	 * Blob files referenced by the source runs, sorted by
+	 * ID. Used for resolving blob references of statements
+	 * UPSERTs are applied to.
+	 */
+	struct vy_blob **blobs;
+	/** Number of entries in @blobs. */
+	uint32_t blob_count;
 	/** Length of the @read_views. */
 	int rv_count;
 	/**
@@ -214,6 +225,18 @@ struct vy_write_iterator {
 	struct vy_read_view_stmt read_views[0];
 };
 
+/**
+ * Order of statements with the same key and LSN in the heap,
+ * see heap_less().
+ */
+static inline int
+vy_write_stmt_rank(const struct tuple *stmt)
+{
+	if (vy_stmt_type(stmt) != IPROTO_DELETE)
+		return 1;
+	return (vy_stmt_flags(stmt) & VY_STMT_EXPIRED) != 0 ? 0 : 2;
+}
+
 /**
  * Comparator of the heap. Put newer LSNs first, unless
  * it's a virtual source (is_end_of_key).
@@ -248,10 +271,13 @@ heap_less(heap_t *heap, struct heap_node *node1, struct heap_node *node2)
 	 * supposed to purge has the same key parts as the REPLACE that
 	 * overwrote it. Discard the deferred DELETE as the overwritten
 	 * tuple will be (or has already been) purged by the REPLACE.
+	 *
+	 * The only exception is a DELETE generated for a tuple dropped
+	 * by the compaction filter: it is supposed to purge the REPLACE
+	 * itself so it must go first.
 	 */
-	return (vy_stmt_type(src1->tuple) == IPROTO_DELETE ? 1 : 0) <
-	       (vy_stmt_type(src2->tuple) == IPROTO_DELETE ? 1 : 0);
-
+	return vy_write_stmt_rank(src1->tuple) <
+	       vy_write_stmt_rank(src2->tuple);
 }
 
 /**
@@ -343,13 +369,19 @@ struct vy_stmt_stream *
 vy_write_iterator_new(struct key_def *cmp_def, struct tuple_format *format,
 		      bool is_primary, bool is_last_level,
 		      struct rlist *read_views,
-		      struct vy_deferred_delete_handler *handler)
+		      struct vy_deferred_delete_handler *handler,
+		      struct vy_compaction_filter *filter)
 {
 	/*
 	 * Deferred DELETE statements can only be produced by
 	 * primary index compaction.
 	 */
 	assert(is_primary || handler == NULL);
+	/*
+	 * Dropping a tuple from a secondary index while keeping
+	 * it in the primary index would break the index.
+	 */
+	assert(is_primary || filter == NULL);
 	/*
 	 * One is reserved for INT64_MAX - maximal read view.
 	 */
@@ -384,6 +416,7 @@ vy_write_iterator_new(struct key_def *cmp_def, struct tuple_format *format,
 	stream->is_primary = is_primary;
 	stream->is_last_level = is_last_level;
 	stream->deferred_delete_handler = handler;
+	stream->filter = filter;
 	return &stream->base;
 }
 
@@ -444,6 +477,7 @@ vy_write_iterator_close(struct vy_stmt_stream *vstream)
 	struct vy_write_iterator *stream = (struct vy_write_iterator *)vstream;
 	vy_write_iterator_stop(vstream);
 	tuple_format_unref(stream->format);
+	free(stream->blobs);
 	free(stream);
 }
 
@@ -462,6 +496,45 @@ vy_write_iterator_new_mem(struct vy_stmt_stream *vstream, struct vy_mem *mem)
 	return 0;
 }
 
+/**
+ * Merge blob files referenced by a source run into the array
+ * of blob files of the iterator. The blob files are pinned by
+ * the run so they don't need to be referenced.
+ */
+static int
+vy_write_iterator_add_blobs(struct vy_write_iterator *stream,
+			    struct vy_run *run)
+{
+	uint32_t count = run->info.blob_count;
+	if (count == 0)
+		return 0;
+	size_t size = (stream->blob_count + count) * sizeof(*stream->blobs);
+	struct vy_blob **blobs = malloc(size);
+	if (blobs == NULL) {
+		diag_set(OutOfMemory, size, "malloc", "struct vy_blob");
+		return -1;
+	}
+	uint32_t i = 0, j = 0, n = 0;
+	while (i < stream->blob_count || j < count) {
+		struct vy_blob *blob;
+		if (j == count || (i < stream->blob_count &&
+				   stream->blobs[i]->id < run->blobs[j]->id)) {
+			blob = stream->blobs[i++];
+		} else if (i == stream->blob_count ||
+			   run->blobs[j]->id < stream->blobs[i]->id) {
+			blob = run->blobs[j++];
+		} else {
+			blob = stream->blobs[i++];
+			j++;
+		}
+		blobs[n++] = blob;
+	}
+	free(stream->blobs);
+	stream->blobs = blobs;
+	stream->blob_count = n;
+	return 0;
+}
+
 /**
  * Add a run slice as a source of iterator.
  * @return 0 on success or -1 on error (diag is set).
@@ -471,6 +544,8 @@ vy_write_iterator_new_slice(struct vy_stmt_stream *vstream,
 			    struct vy_slice *slice)
 {
 	struct vy_write_iterator *stream = (struct vy_write_iterator *)vstream;
+	if (vy_write_iterator_add_blobs(stream, slice->run) != 0)
+		return -1;
 	struct vy_write_src *src = vy_write_iterator_new_src(stream);
 	if (src == NULL)
 		return -1;
@@ -630,9 +705,46 @@ vy_write_iterator_deferred_delete(struct vy_write_iterator *stream,
 	return 0;
 }
 
+/**
+ * Replace a statement dropped by the compaction filter with
+ * a DELETE so that it shadows older versions of the tuple and
+ * push it to the given read view (optimization #7).
+ *
+ * @param stream Write iterator.
+ * @param stmt   Filtered REPLACE or INSERT statement.
+ * @param rv_i   Index of the read view to push the DELETE to.
+ *
+ * @retval  0 Success.
+ * @retval -1 Memory error.
+ */
+static int
+vy_write_iterator_push_filtered(struct vy_write_iterator *stream,
+				struct tuple *stmt, int rv_i)
+{
+	struct tuple *delete_stmt;
+	delete_stmt = vy_stmt_new_surrogate_delete(stream->format, stmt);
+	if (delete_stmt == NULL)
+		return -1;
+	vy_stmt_set_lsn(delete_stmt, vy_stmt_lsn(stmt));
+	vy_stmt_set_flags(delete_stmt, vy_stmt_flags(stmt));
+	/*
+	 * If the statement overwrote a tuple without deleting
+	 * it from secondary indexes, the DELETE must take over,
+	 * see vy_write_iterator_deferred_delete().
+	 */
+	if (stream->deferred_delete_stmt == stmt) {
+		vy_stmt_unref_if_possible(stream->deferred_delete_stmt);
+		vy_stmt_ref_if_possible(delete_stmt);
+		stream->deferred_delete_stmt = delete_stmt;
+	}
+	int rc = vy_write_iterator_push_rv(stream, delete_stmt, rv_i);
+	tuple_unref(delete_stmt);
+	return rc;
+}
+
 /**
  * Build the history of the current key.
- * Apply optimizations 1, 2 and 3 (@sa vy_write_iterator.h).
+ * Apply optimizations 1, 2, 3 and 7 (@sa vy_write_iterator.h).
  * When building a history, some statements can be
  * skipped (e.g. multiple REPLACE statements on the same key),
  * but nothing can be merged yet, since we don't know the first
@@ -747,6 +859,47 @@ vy_write_iterator_build_history(struct vy_write_iterator *stream,
 							   current_rv_i + 1);
 		}
 
+		/*
+		 * Optimization 7: drop the latest statement for
+		 * the key if the compaction filter says so, but
+		 * only if it isn't visible from any read view.
+		 */
+		if (stream->filter != NULL && current_rv_i == 0 &&
+		    *count == 0 &&
+		    (vy_stmt_type(src->tuple) == IPROTO_REPLACE ||
+		     vy_stmt_type(src->tuple) == IPROTO_INSERT) &&
+		    stream->filter->filter(stream->filter, src->tuple)) {
+			/*
+			 * The statement is still stored in secondary
+			 * indexes so make the handler purge it from
+			 * there, see VY_STMT_EXPIRED.
+			 */
+			struct vy_deferred_delete_handler *handler =
+					stream->deferred_delete_handler;
+			if (handler != NULL) {
+				rc = handler->iface->process(handler,
+							     src->tuple,
+							     src->tuple);
+				if (rc != 0)
+					break;
+			}
+			if (stream->is_last_level && merge_until_lsn == 0) {
+				current_rv_lsn = 0; /* Force skip */
+				goto next_lsn;
+			}
+			rc = vy_write_iterator_push_filtered(stream, src->tuple,
+							     current_rv_i);
+			if (rc != 0)
+				break;
+			++*count;
+			current_rv_i++;
+			current_rv_lsn = merge_until_lsn;
+			merge_until_lsn =
+				vy_write_iterator_get_vlsn(stream,
+							   current_rv_i + 1);
+			goto next_lsn;
+		}
+
 		/*
 		 * Optimization 1: skip last level delete.
 		 * @sa vy_write_iterator for details about this
@@ -868,8 +1021,18 @@ vy_read_view_merge(struct vy_write_iterator *stream, struct tuple *hint,
 	     vy_stmt_type(hint) != IPROTO_UPSERT))) {
 		assert(!stream->is_last_level || hint == NULL ||
 		       vy_stmt_type(hint) != IPROTO_UPSERT);
-		struct tuple *applied = vy_apply_upsert(h->tuple, hint,
+		struct tuple *base = hint;
+		if (hint != NULL &&
+		    (vy_stmt_flags(hint) & VY_STMT_BLOB_REF) != 0) {
+			base = vy_blob_resolve(hint, stream->blobs,
+					       stream->blob_count, false);
+			if (base == NULL)
+				return -1;
+		}
+		struct tuple *applied = vy_apply_upsert(h->tuple, base,
 				stream->cmp_def, stream->format, false);
+		if (base != hint)
+			vy_stmt_unref_if_possible(base);
 		if (applied == NULL)
 			return -1;
 		vy_stmt_unref_if_possible(h->tuple);
@@ -878,6 +1041,16 @@ vy_read_view_merge(struct vy_write_iterator *stream, struct tuple *hint,
 	/* Squash the rest of UPSERTs. */
 	struct vy_write_history *result = h;
 	h = h->next;
+	if (h != NULL &&
+	    (vy_stmt_flags(result->tuple) & VY_STMT_BLOB_REF) != 0) {
+		/* UPSERTs can only be applied to values. */
+		struct tuple *resolved = vy_blob_resolve(result->tuple,
+				stream->blobs, stream->blob_count, false);
+		if (resolved == NULL)
+			return -1;
+		vy_stmt_unref_if_possible(result->tuple);
+		result->tuple = resolved;
+	}
 	while (h != NULL) {
 		assert(h->tuple != NULL &&
 		       vy_stmt_type(h->tuple) == IPROTO_UPSERT);
@@ -954,6 +1127,8 @@ vy_read_view_merge(struct vy_write_iterator *stream, struct tuple *hint,
 		if (copy == NULL)
 			return -1;
 		vy_stmt_set_lsn(copy, vy_stmt_lsn(rv->tuple));
+		vy_stmt_set_flags(copy, vy_stmt_flags(rv->tuple) &
+				  VY_STMT_BLOB_REF);
 		vy_stmt_unref_if_possible(rv->tuple);
 		rv->tuple = copy;
 	}
@@ -210,10 +210,35 @@
  * also turn the first INSERT in the resulting key's history to a
  * REPLACE in case the oldest statement among all sources is not
  * an INSERT.
+ *
+ * ---------------------------------------------------------------
+ * Optimization #7: if a compaction filter is set, drop the
+ * REPLACE or INSERT that is the latest statement for a key if the
+ * filter says so, e.g. because the tuple has expired. Statements
+ * visible from any open read view are never filtered.
+ *
+ *                         --------
+ *                         SAME KEY
+ *                         --------
+ *
+ * 0                VLSN1                            INT64_MAX
+ * |                  |                                  |
+ * | LSN1 ... LSNi    | LSNi+1  ...  LSN_N-1  REPLACE    |
+ * \_________________/ \____________________/\_________/
+ *       merge                 skip            filter
+ *
+ * When the last level is written, the filtered statement and the
+ * rest of the history up to the oldest read view are skipped
+ * altogether. Otherwise the statement is replaced with a DELETE
+ * with the same LSN so as to shadow older versions of the tuple
+ * stored in the levels that are not being compacted. In either
+ * case the deferred DELETE handler, if any, is invoked for the
+ * filtered statement to purge it from secondary indexes.
  */
 
 struct vy_write_iterator;
 struct vy_deferred_delete_handler;
+struct vy_compaction_filter;
 struct key_def;
 struct tuple_format;
 struct tuple;
@@ -226,6 +251,10 @@ struct vy_slice;
  * a DELETE statement for secondary indexes. It is supposed to
  * produce a DELETE statement and insert it into secondary indexes.
  *
+ * It is also invoked for REPLACE and INSERT statements dropped by
+ * the compaction filter, in which case @old_stmt and @new_stmt
+ * point to the same statement, see VY_STMT_EXPIRED.
+ *
  * @param handler  Deferred DELETE handler.
  * @param old_stmt Overwritten tuple.
  * @param new_stmt Statement that overwrote @old_stmt.
@@ -255,6 +284,26 @@ struct vy_deferred_delete_handler {
 	const struct vy_deferred_delete_handler_iface *iface;
 };
 
+/**
+ * Callback invoked by the write iterator for the latest REPLACE
+ * or INSERT of a key that is not visible from any open read view.
+ * If it returns true, the statement is dropped from the output,
+ * see optimization #7.
+ *
+ * @param filter   Compaction filter.
+ * @param stmt     Statement to check.
+ *
+ * @retval true    The statement must be dropped.
+ * @retval false   The statement must be kept.
+ */
+typedef bool
+(*vy_compaction_filter_f)(struct vy_compaction_filter *filter,
+			  const struct tuple *stmt);
+
+struct vy_compaction_filter {
+	vy_compaction_filter_f filter;
+};
+
 /**
  * Open an empty write iterator. To add sources to the iterator
  * use vy_write_iterator_add_* functions.
@@ -266,13 +315,17 @@ struct vy_deferred_delete_handler {
  * @param handler - Deferred DELETE handler or NULL if no deferred DELETEs is
  * expected. Only relevant to primary index compaction. For secondary indexes
  * this argument must be set to NULL.
+ * @param filter - Compaction filter or NULL if all statements must be kept.
+ * Only relevant to the primary index. For secondary indexes this argument
+ * must be set to NULL.
  * @return the iterator or NULL on error (diag is set).
  */
 struct vy_stmt_stream *
 vy_write_iterator_new(struct key_def *cmp_def, struct tuple_format *format,
 		      bool is_primary, bool is_last_level,
 		      struct rlist *read_views,
-		      struct vy_deferred_delete_handler *handler);
+		      struct vy_deferred_delete_handler *handler,
+		      struct vy_compaction_filter *filter);
 
 /**
  * Add a mem as a source to the iterator.
@@ -39,10 +39,15 @@
 
 #include "xlog.h"
 #include "xrow.h"
+#include "xrow_buf.h"
 #include "vy_log.h"
 #include "cbus.h"
 #include "coio_task.h"
 #include "replication.h"
+#include "histogram.h"
+#include "latency.h"
+#include "info.h"
+#include "io_ring.h"
 
 
 const char *wal_mode_STRS[] = { "none", "write", "fsync", NULL };
@@ -72,6 +77,12 @@ struct wal_thread {
  * WAL writer - maintain a Write Ahead Log for every change
  * in the data state.
  *
+ * There is a writer per WAL stripe, each running in its own
+ * thread and writing xlogs to its own directory. Requests are
+ * distributed among stripes by wal_stripe(). Each writer
+ * advances its vclock only with the rows it writes, so the
+ * vclocks of xlogs of a stripe follow each other.
+ *
  * @sic the members are arranged to ensure proper cache alignment,
  * members used mainly in tx thread go first, wal thread members
  * following.
@@ -87,6 +98,19 @@ struct wal_writer
 	 * the wal-tx bus and are rolled back "on arrival".
 	 */
 	struct stailq rollback;
+	/** Thread doing the writes. */
+	struct wal_thread thread;
+	/** Stripe number, 0 for the writer of wal_dir. */
+	int stripe;
+	/** Route of in_rollback, see wal_writer_begin_rollback(). */
+	struct cmsg_hop rollback_route[4];
+	/**
+	 * Used to stop writing requests when a write to
+	 * another stripe fails, see wal_stripe_begin_rollback().
+	 */
+	struct cmsg stripe_rollback;
+	/** Route of stripe_rollback. */
+	struct cmsg_hop stripe_rollback_route[4];
 	/* ----------------- wal ------------------- */
 	/** A setting from instance configuration - rows_per_wal */
 	int64_t wal_max_rows;
@@ -122,10 +146,76 @@ struct wal_writer
 	 * Used for replication relays.
 	 */
 	struct rlist watchers;
+	/**
+	 * Rows recently written to WAL, kept in memory so that
+	 * relays following the WAL closely don't have to read
+	 * them back from xlog files.
+	 */
+	struct xrow_buf cache;
+	/**
+	 * Max time a request may wait for other requests to be
+	 * written to disk together, see wal_set_group_commit().
+	 * Zero means requests are written as soon as they arrive.
+	 */
+	double group_commit_timeout;
+	/**
+	 * The group is written early once it accumulates that
+	 * many bytes. Zero means no limit.
+	 */
+	int64_t group_commit_bytes;
+	/** Messages waiting to be written to disk together. */
+	struct stailq group;
+	/** Approximate size of the rows of the group, in bytes. */
+	int64_t group_size;
+	/** Timer writing the group on group_commit_timeout. */
+	struct ev_timer group_timer;
+	/**
+	 * In the fsync mode, if io_uring is available, the WAL
+	 * isn't opened with O_SYNC. Instead, fdatasync() of a
+	 * written group is submitted to this ring, and the next
+	 * group is collected while the sync is in progress. It
+	 * isn't written until the sync is done, so that relays
+	 * never read rows that may not be on disk.
+	 */
+	struct io_ring ring;
+	/** Request syncing sync_group to disk. */
+	struct io_ring_req sync_req;
+	/** Messages written to disk, but not synced yet. */
+	struct stailq sync_group;
+	/** Offset of sync_group in the current WAL file. */
+	off_t sync_offset;
+	/** Vclock of the writer before sync_group was written. */
+	struct vclock sync_vclock;
+	/** Number of disk writes. */
+	int64_t write_count;
+	/** Number of rows written to disk. */
+	int64_t row_count;
+	/** Histogram of the number of rows per disk write. */
+	struct histogram *batch_hist;
+	/** Max number of rows per disk write. */
+	int64_t batch_rows_max;
+	/**
+	 * Pipes between the thread of a secondary stripe and
+	 * the thread of stripe 0, which is the one WAL watchers
+	 * are attached to.
+	 */
+	struct cpipe watchers_pipe;
+	struct cpipe stripe_pipe;
+	/** Route of watchers_msg. */
+	struct cmsg_hop watchers_route[2];
+	/** Message forwarding events to WAL watchers. */
+	struct wal_watcher_msg watchers_msg;
+	/**
+	 * Bit mask of WAL events that happened while
+	 * watchers_msg was en route.
+	 */
+	unsigned watchers_events;
 };
 
 struct wal_msg {
 	struct cmsg base;
+	/** Writer of the stripe the requests are written to. */
+	struct wal_writer *writer;
 	/** Input queue, on output contains all committed requests. */
 	struct stailq commit;
 	/**
@@ -144,13 +234,265 @@ struct vy_log_writer {
 };
 
 static struct vy_log_writer vy_log_writer;
-static struct wal_thread wal_thread;
-static struct wal_writer wal_writer_singleton;
+/**
+ * WAL writers, one per stripe. The thread of the first one
+ * also writes the vinyl metadata log and notifies WAL watchers.
+ */
+static struct wal_writer wal_writers[WAL_STRIPE_MAX];
+/** Number of WAL stripes, see wal_thread_start(). */
+static int wal_writer_count = 1;
+/** Writer of the stripe the current WAL thread is doing writes for. */
+static __thread struct wal_writer *wal_writer_current;
+/**
+ * Time between submitting a request to WAL and getting
+ * the result back, including the group commit delay.
+ */
+static struct latency wal_commit_latency;
 
 enum wal_mode
 wal_mode()
 {
-	return wal_writer_singleton.wal_mode;
+	return wal_writers[0].wal_mode;
+}
+
+int
+wal_stripe_count(void)
+{
+	return wal_writer_count;
+}
+
+/**
+ * Vclock of the requests submitted to a striped WAL. Local
+ * rows are assigned LSNs in tx rather than by the WAL thread
+ * then, see wal_stripe_assign_lsn().
+ */
+static struct vclock wal_stripe_vclock;
+/** Stripe the last local request was written to. */
+static int wal_stripe_last;
+
+/**
+ * A request submitted to a striped WAL. Stripes are written
+ * independently, so a request may be written before the ones
+ * submitted earlier. Its fiber doesn't return from wal_write()
+ * until they are written too, so that a transaction never
+ * commits before the transactions it may depend on.
+ */
+struct wal_stripe_request {
+	/** Link in wal_stripe_requests. */
+	struct rlist in_queue;
+	/** Fiber that submitted the request. */
+	struct fiber *fiber;
+	/** Local LSN before the request was submitted. */
+	int64_t prev_lsn;
+	/** Local LSN after the request was submitted. */
+	int64_t lsn;
+	/** Set when the request has returned from the WAL thread. */
+	bool is_done;
+	/**
+	 * Set if the request must be rolled back, because
+	 * it or a request submitted before it failed.
+	 */
+	bool is_rollback;
+};
+
+/** Requests submitted to a striped WAL, in submission order. */
+static RLIST_HEAD(wal_stripe_requests);
+
+/**
+ * Set while a striped WAL is rolling back a failed write.
+ * New requests are rolled back on arrival then, see
+ * wal_stripe_begin_rollback().
+ */
+static bool wal_stripe_in_rollback;
+/** Number of writers that haven't stopped yet. */
+static int wal_stripe_rollback_pending;
+/** Local LSN of the earliest request rolled back so far. */
+static int64_t wal_stripe_rollback_lsn;
+/**
+ * Max local LSN of the requests rolled back after having
+ * been written. These LSNs can't be reused.
+ */
+static int64_t wal_stripe_rollback_written_lsn;
+
+/**
+ * Return the stripe to write rows of the given replica to.
+ * Local requests are spread over all stripes round-robin.
+ * All rows of another replica go to the same stripe, so
+ * that they can be merged with local rows by vclock on
+ * recovery, see recover_remaining_wals().
+ */
+static inline int
+wal_stripe(uint32_t replica_id)
+{
+	if (replica_id != 0 && replica_id != instance_id)
+		return replica_id % wal_writer_count;
+	wal_stripe_last = (wal_stripe_last + 1) % wal_writer_count;
+	return wal_stripe_last;
+}
+
+/**
+ * Assign LSNs to local rows of a request submitted to
+ * a striped WAL. Since requests are dispatched to stripes
+ * in the order of submission, LSNs of each replica grow
+ * within every stripe.
+ */
+static void
+wal_stripe_assign_lsn(struct journal_entry *entry)
+{
+	struct xrow_header **row = entry->rows;
+	for (; row < entry->rows + entry->n_rows; row++) {
+		if ((*row)->replica_id == 0) {
+			(*row)->lsn = vclock_inc(&wal_stripe_vclock,
+						 instance_id);
+			(*row)->replica_id = instance_id;
+		} else if ((*row)->replica_id == instance_id &&
+			   (*row)->lsn > vclock_get(&wal_stripe_vclock,
+						    instance_id)) {
+			/* Our own rows sent back by a peer. */
+			vclock_follow_xrow(&wal_stripe_vclock, *row);
+		}
+	}
+}
+
+/**
+ * Wake up the requests that may complete now: the first one
+ * unless it's rolled back, and the last one if it is.
+ */
+static void
+wal_stripe_wakeup_next(void)
+{
+	if (rlist_empty(&wal_stripe_requests))
+		return;
+	struct wal_stripe_request *first =
+		rlist_first_entry(&wal_stripe_requests,
+				  struct wal_stripe_request, in_queue);
+	struct wal_stripe_request *last =
+		rlist_last_entry(&wal_stripe_requests,
+				 struct wal_stripe_request, in_queue);
+	if (first->is_done && !first->is_rollback)
+		fiber_wakeup(first->fiber);
+	if (last->is_done && last->is_rollback)
+		fiber_wakeup(last->fiber);
+}
+
+/**
+ * Finish the rollback of a striped WAL once all requests
+ * submitted before it started have returned and all writers
+ * have stopped. Local LSNs of requests that didn't make it
+ * to disk are reused then, so as not to leave a gap.
+ */
+static void
+wal_stripe_end_rollback(void)
+{
+	if (!wal_stripe_in_rollback || wal_stripe_rollback_pending > 0 ||
+	    !rlist_empty(&wal_stripe_requests))
+		return;
+	vclock_reset(&wal_stripe_vclock, instance_id,
+		     MAX(wal_stripe_rollback_lsn,
+			 wal_stripe_rollback_written_lsn));
+	wal_stripe_in_rollback = false;
+}
+
+static void
+wal_stripe_rollback_f(struct cmsg *msg);
+
+static void
+wal_writer_clear_bus(struct cmsg *msg);
+
+static void
+wal_stripe_rollback_done_f(struct cmsg *msg)
+{
+	(void) msg;
+	assert(wal_stripe_rollback_pending > 0);
+	wal_stripe_rollback_pending--;
+	wal_stripe_end_rollback();
+}
+
+/**
+ * Roll back a request that failed to get written to a striped
+ * WAL and all requests submitted after it. Since the latter
+ * may be written to other stripes already, they are rolled
+ * back even if they succeed. Put all writers in rollback
+ * mode so that they don't write anything that hasn't been
+ * written yet.
+ */
+static void
+wal_stripe_begin_rollback(struct wal_stripe_request *request)
+{
+	struct wal_stripe_request *next;
+	rlist_foreach_entry_reverse(next, &wal_stripe_requests, in_queue) {
+		next->is_rollback = true;
+		if (next == request)
+			break;
+	}
+	if (!wal_stripe_in_rollback) {
+		wal_stripe_in_rollback = true;
+		wal_stripe_rollback_lsn = request->prev_lsn;
+		wal_stripe_rollback_written_lsn = 0;
+		for (int i = 0; i < wal_writer_count; i++) {
+			struct wal_writer *writer = &wal_writers[i];
+			struct cmsg_hop route[4] = {
+				{ wal_stripe_rollback_f,
+				  &writer->thread.tx_prio_pipe },
+				/*
+				 * Let the writer finish the rollback,
+				 * see wal_writer_begin_rollback().
+				 */
+				{ wal_writer_clear_bus,
+				  &writer->thread.wal_pipe },
+				{ wal_writer_clear_bus,
+				  &writer->thread.tx_prio_pipe },
+				{ wal_stripe_rollback_done_f, NULL },
+			};
+			memcpy(writer->stripe_rollback_route, route,
+			       sizeof(route));
+			cmsg_init(&writer->stripe_rollback,
+				  writer->stripe_rollback_route);
+			cpipe_push(&writer->thread.wal_pipe,
+				   &writer->stripe_rollback);
+			wal_stripe_rollback_pending++;
+		}
+	}
+	wal_stripe_wakeup_next();
+}
+
+/**
+ * Wait until all requests submitted to a striped WAL before
+ * the given one are written. If the request is rolled back,
+ * wait until all requests submitted after it are rolled back
+ * instead, so that transactions are rolled back in reverse
+ * order, as by tx_schedule_rollback().
+ */
+static void
+wal_stripe_request_wait(struct wal_stripe_request *request,
+			struct journal_entry *entry)
+{
+	request->is_done = true;
+	if (entry->res < 0 && !request->is_rollback)
+		wal_stripe_begin_rollback(request);
+	while (true) {
+		struct wal_stripe_request *next = request->is_rollback ?
+			rlist_last_entry(&wal_stripe_requests,
+					 struct wal_stripe_request, in_queue) :
+			rlist_first_entry(&wal_stripe_requests,
+					  struct wal_stripe_request, in_queue);
+		if (next == request)
+			break;
+		fiber_yield();
+	}
+	if (request->is_rollback) {
+		if (entry->res > 0) {
+			wal_stripe_rollback_written_lsn =
+				MAX(wal_stripe_rollback_written_lsn,
+				    request->lsn);
+		}
+		/* Requests are rolled back in reverse order. */
+		wal_stripe_rollback_lsn = request->prev_lsn;
+		entry->res = -1;
+	}
+	rlist_del_entry(request, in_queue);
+	wal_stripe_wakeup_next();
+	wal_stripe_end_rollback();
 }
 
 static void
@@ -159,15 +501,21 @@ wal_write_to_disk(struct cmsg *msg);
 static void
 tx_schedule_commit(struct cmsg *msg);
 
+/*
+ * The WAL thread forwards a request to tx only after it has been
+ * written to disk, which may happen after other requests arrive
+ * in case of group commit, see wal_write_group().
+ */
 static struct cmsg_hop wal_request_route[] = {
-	{wal_write_to_disk, &wal_thread.tx_prio_pipe},
+	{wal_write_to_disk, NULL},
 	{tx_schedule_commit, NULL},
 };
 
 static void
-wal_msg_create(struct wal_msg *batch)
+wal_msg_create(struct wal_msg *batch, struct wal_writer *writer)
 {
 	cmsg_init(&batch->base, wal_request_route);
+	batch->writer = writer;
 	stailq_create(&batch->commit);
 	stailq_create(&batch->rollback);
 }
@@ -241,7 +589,7 @@ tx_schedule_commit(struct cmsg *msg)
 	 * iteration of tx_schedule_queue loop.
 	 */
 	if (! stailq_empty(&batch->rollback)) {
-		struct wal_writer *writer = &wal_writer_singleton;
+		struct wal_writer *writer = batch->writer;
 		/* Closes the input valve. */
 		stailq_concat(&writer->rollback, &batch->rollback);
 	}
@@ -251,8 +599,8 @@ tx_schedule_commit(struct cmsg *msg)
 static void
 tx_schedule_rollback(struct cmsg *msg)
 {
-	(void) msg;
-	struct wal_writer *writer = &wal_writer_singleton;
+	struct wal_writer *writer = container_of(msg, struct wal_writer,
+						 in_rollback);
 	/*
 	 * Perform a cascading abort of all transactions which
 	 * depend on the transaction which failed to get written
@@ -266,17 +614,57 @@ tx_schedule_rollback(struct cmsg *msg)
 	stailq_create(&writer->rollback);
 }
 
+static void
+wal_group_timer_cb(struct ev_loop *loop, struct ev_timer *timer, int events);
+
+static void
+wal_write_group(struct wal_writer *writer);
+
+static void
+wal_sync_complete(struct wal_writer *writer);
+
+/** Buckets of the histogram of rows per disk write. */
+static const int64_t wal_batch_buckets[] = {
+	1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 15, 20, 30, 40, 50, 75,
+	100, 150, 200, 300, 400, 500, 750, 1000, 1500, 2000,
+	3000, 5000, 7500, 10000, 20000, 50000, 100000,
+};
+
 /**
- * Initialize WAL writer context. Even though it's a singleton,
- * encapsulate the details just in case we may use
- * more writers in the future.
+ * Initialize WAL writer context of a stripe.
  */
-static void
+static int
 wal_writer_create(struct wal_writer *writer, enum wal_mode wal_mode,
 		  const char *wal_dirname, const struct tt_uuid *instance_uuid,
 		  struct vclock *vclock, int64_t wal_max_rows,
-		  int64_t wal_max_size)
+		  int64_t wal_max_size, int64_t wal_cache_size,
+		  bool io_uring)
 {
+	writer->batch_hist = histogram_new(wal_batch_buckets,
+					   lengthof(wal_batch_buckets));
+	if (writer->batch_hist == NULL) {
+		diag_set(OutOfMemory, sizeof(struct histogram),
+			 "malloc", "struct histogram");
+		return -1;
+	}
+	writer->write_count = 0;
+	writer->row_count = 0;
+	writer->batch_rows_max = 0;
+	writer->group_commit_timeout = 0;
+	writer->group_commit_bytes = 0;
+	stailq_create(&writer->group);
+	writer->group_size = 0;
+	ev_timer_init(&writer->group_timer, wal_group_timer_cb, 0, 0);
+	writer->group_timer.data = writer;
+	writer->ring.fd = -1;
+	stailq_create(&writer->sync_group);
+	if (io_uring && wal_mode == WAL_FSYNC &&
+	    io_ring_create(&writer->ring, 2) != 0) {
+		diag_log();
+		say_warn("io_uring is unavailable, "
+			 "falling back to synchronous WAL writes");
+	}
+
 	writer->wal_mode = wal_mode;
 	writer->wal_max_rows = wal_max_rows;
 	writer->wal_max_size = wal_max_size;
@@ -285,7 +673,7 @@ wal_writer_create(struct wal_writer *writer, enum wal_mode wal_mode,
 
 	xdir_create(&writer->wal_dir, wal_dirname, XLOG, instance_uuid);
 	xlog_clear(&writer->current_wal);
-	if (wal_mode == WAL_FSYNC)
+	if (wal_mode == WAL_FSYNC && !io_ring_is_created(&writer->ring))
 		writer->wal_dir.open_wflags |= O_SYNC;
 
 	stailq_create(&writer->rollback);
@@ -296,36 +684,56 @@ wal_writer_create(struct wal_writer *writer, enum wal_mode wal_mode,
 	vclock_copy(&writer->vclock, vclock);
 
 	rlist_create(&writer->watchers);
+	xrow_buf_create(&writer->cache, vclock, wal_cache_size);
+	return 0;
 }
 
 /** Destroy a WAL writer structure. */
 static void
 wal_writer_destroy(struct wal_writer *writer)
 {
+	xrow_buf_destroy(&writer->cache);
 	xdir_destroy(&writer->wal_dir);
+	histogram_delete(writer->batch_hist);
+	io_ring_destroy(&writer->ring);
 }
 
 /** WAL thread routine. */
 static int
 wal_thread_f(va_list ap);
 
-/** Start WAL thread and setup pipes to and from TX. */
-void
-wal_thread_start()
+/** Name of the cord and cbus endpoint of a stripe writer. */
+static const char *
+wal_thread_name(int stripe)
 {
-	if (cord_costart(&wal_thread.cord, "wal", wal_thread_f, NULL) != 0)
-		panic("failed to start WAL thread");
+	return stripe == 0 ? "wal" : tt_sprintf("wal%d", stripe);
+}
 
-	/* Create a pipe to WAL thread. */
-	cpipe_create(&wal_thread.wal_pipe, "wal");
-	cpipe_set_max_input(&wal_thread.wal_pipe, IOV_MAX);
+/** Start WAL threads and setup pipes to and from TX. */
+void
+wal_thread_start(int stripe_count)
+{
+	assert(stripe_count > 0 && stripe_count <= WAL_STRIPE_MAX);
+	wal_writer_count = stripe_count;
+	for (int i = 0; i < stripe_count; i++) {
+		struct wal_writer *writer = &wal_writers[i];
+		writer->stripe = i;
+		const char *name = wal_thread_name(i);
+		if (cord_costart(&writer->thread.cord, name,
+				 wal_thread_f, writer) != 0)
+			panic("failed to start WAL thread");
+
+		/* Create a pipe to WAL thread. */
+		cpipe_create(&writer->thread.wal_pipe, wal_thread_name(i));
+		cpipe_set_max_input(&writer->thread.wal_pipe, IOV_MAX);
+	}
 }
 
 static int
 wal_open_f(struct cbus_call_msg *msg)
 {
 	(void)msg;
-	struct wal_writer *writer = &wal_writer_singleton;
+	struct wal_writer *writer = wal_writer_current;
 	const char *path = xdir_format_filename(&writer->wal_dir,
 				vclock_sum(&writer->vclock), NONE);
 	assert(!xlog_is_open(&writer->current_wal));
@@ -358,8 +766,8 @@ wal_open(struct wal_writer *writer)
 	 * thread.
 	 */
 	struct cbus_call_msg msg;
-	if (cbus_call(&wal_thread.wal_pipe, &wal_thread.tx_prio_pipe, &msg,
-		      wal_open_f, NULL, TIMEOUT_INFINITY) == 0) {
+	if (cbus_call(&writer->thread.wal_pipe, &writer->thread.tx_prio_pipe,
+		      &msg, wal_open_f, NULL, TIMEOUT_INFINITY) == 0) {
 		/*
 		 * Success: we can now append to
 		 * the existing WAL file.
@@ -398,56 +806,87 @@ wal_open(struct wal_writer *writer)
  *        mode are closed. WAL thread has been started.
  */
 int
-wal_init(enum wal_mode wal_mode, const char *wal_dirname,
+wal_init(enum wal_mode wal_mode, const char **wal_dirs,
 	 const struct tt_uuid *instance_uuid, struct vclock *vclock,
-	 int64_t wal_max_rows, int64_t wal_max_size)
+	 int64_t wal_max_rows, int64_t wal_max_size, int64_t wal_cache_size,
+	 bool io_uring)
 {
 	assert(wal_max_rows > 1);
 
-	struct wal_writer *writer = &wal_writer_singleton;
-
-	wal_writer_create(writer, wal_mode, wal_dirname, instance_uuid,
-			  vclock, wal_max_rows, wal_max_size);
-
+	if (latency_create(&wal_commit_latency) != 0) {
+		diag_set(OutOfMemory, sizeof(struct histogram),
+			 "malloc", "struct histogram");
+		return -1;
+	}
 	/*
-	 * Scan the WAL directory to build an index of all
-	 * existing WAL files. Required for garbage collection,
-	 * see wal_collect_garbage().
+	 * Relays can't merge stripes read from memory,
+	 * so don't keep rows in memory if there are many.
 	 */
-	if (xdir_scan(&writer->wal_dir))
-		return -1;
-
-	if (wal_open(writer) != 0)
-		return -1;
+	if (wal_writer_count > 1)
+		wal_cache_size = 0;
+
+	for (int i = 0; i < wal_writer_count; i++) {
+		struct wal_writer *writer = &wal_writers[i];
+		if (wal_writer_create(writer, wal_mode, wal_dirs[i],
+				      instance_uuid, vclock, wal_max_rows,
+				      wal_max_size, wal_cache_size,
+				      io_uring) != 0)
+			return -1;
+		/*
+		 * Scan the WAL directory to build an index of all
+		 * existing WAL files. Required for garbage collection,
+		 * see wal_collect_garbage().
+		 */
+		if (xdir_scan(&writer->wal_dir))
+			return -1;
 
-	journal_set(&writer->base);
+		if (wal_open(writer) != 0)
+			return -1;
+	}
+	vclock_copy(&wal_stripe_vclock, vclock);
+	journal_set(&wal_writers[0].base);
 	return 0;
 }
 
 /**
- * Stop WAL thread, wait until it exits, and destroy WAL writer
- * if it was initialized. Called on shutdown.
+ * Stop WAL threads, wait until they exit, and destroy WAL writers
+ * if they were initialized. Called on shutdown.
  */
 void
 wal_thread_stop()
 {
-	cbus_stop_loop(&wal_thread.wal_pipe);
+	/*
+	 * Secondary stripes go first, because they notify WAL
+	 * watchers via the thread of stripe 0.
+	 */
+	for (int i = wal_writer_count - 1; i >= 0; i--) {
+		struct wal_writer *writer = &wal_writers[i];
+		cbus_stop_loop(&writer->thread.wal_pipe);
 
-	if (cord_join(&wal_thread.cord)) {
-		/* We can't recover from this in any reasonable way. */
-		panic_syserror("WAL writer: thread join failed");
+		if (cord_join(&writer->thread.cord)) {
+			/* We can't recover from this in any reasonable way. */
+			panic_syserror("WAL writer: thread join failed");
+		}
 	}
 
-	if (journal_is_initialized(&wal_writer_singleton.base))
-		wal_writer_destroy(&wal_writer_singleton);
+	if (!journal_is_initialized(&wal_writers[0].base))
+		return;
+	for (int i = 0; i < wal_writer_count; i++) {
+		if (journal_is_initialized(&wal_writers[i].base))
+			wal_writer_destroy(&wal_writers[i]);
+	}
+	latency_destroy(&wal_commit_latency);
 }
 
 struct wal_checkpoint
 {
 	struct cmsg base;
-	struct vclock *vclock;
+	struct cmsg_hop route[2];
+	/** Vclock of the stripe. */
+	struct vclock vclock;
 	struct fiber *fiber;
 	bool rotate;
+	bool done;
 	int res;
 };
 
@@ -455,7 +894,10 @@ void
 wal_checkpoint_f(struct cmsg *data)
 {
 	struct wal_checkpoint *msg = (struct wal_checkpoint *) data;
-	struct wal_writer *writer = &wal_writer_singleton;
+	struct wal_writer *writer = wal_writer_current;
+	/* Don't let requests submitted before the checkpoint wait. */
+	wal_write_group(writer);
+	wal_sync_complete(writer);
 	if (writer->in_rollback.route != NULL) {
 		/* We're rolling back a failed write. */
 		msg->res = -1;
@@ -473,21 +915,39 @@ wal_checkpoint_f(struct cmsg *data)
 		 * The next WAL will be created on the first write.
 		 */
 	}
-	vclock_copy(msg->vclock, &writer->vclock);
+	vclock_copy(&msg->vclock, &writer->vclock);
 }
 
 void
 wal_checkpoint_done_f(struct cmsg *data)
 {
 	struct wal_checkpoint *msg = (struct wal_checkpoint *) data;
+	msg->done = true;
 	fiber_wakeup(msg->fiber);
 }
 
+/**
+ * Return a writer that is rolling back a failed write
+ * or NULL if there's no such writer. While a striped WAL
+ * is rolling back, all writers are.
+ */
+static struct wal_writer *
+wal_writer_in_rollback(void)
+{
+	if (wal_stripe_in_rollback)
+		return &wal_writers[0];
+	for (int i = 0; i < wal_writer_count; i++) {
+		if (! stailq_empty(&wal_writers[i].rollback))
+			return &wal_writers[i];
+	}
+	return NULL;
+}
+
 int
 wal_checkpoint(struct vclock *vclock, bool rotate)
 {
-	struct wal_writer *writer = &wal_writer_singleton;
-	if (! stailq_empty(&writer->rollback)) {
+	struct wal_writer *writer = wal_writer_in_rollback();
+	if (writer != NULL) {
 		/*
 		 * The writer rollback queue is not empty,
 		 * roll back this transaction immediately.
@@ -500,53 +960,86 @@ wal_checkpoint(struct vclock *vclock, bool rotate)
 			  vclock_sum(&writer->vclock));
 		return -1;
 	}
+	writer = &wal_writers[0];
 	if (writer->wal_mode == WAL_NONE) {
 		vclock_copy(vclock, &writer->vclock);
 		return 0;
 	}
-	static struct cmsg_hop wal_checkpoint_route[] = {
-		{wal_checkpoint_f, &wal_thread.tx_prio_pipe},
-		{wal_checkpoint_done_f, NULL},
-	};
+	/*
+	 * Rotate all stripes at once. Requests submitted before
+	 * the checkpoint are written by the time a stripe gets
+	 * the message, so the WAL vclock is the max of the
+	 * stripe vclocks.
+	 */
+	struct wal_checkpoint msg[WAL_STRIPE_MAX];
+	for (int i = 0; i < wal_writer_count; i++) {
+		writer = &wal_writers[i];
+		msg[i].route[0] = (struct cmsg_hop)
+			{wal_checkpoint_f, &writer->thread.tx_prio_pipe};
+		msg[i].route[1] = (struct cmsg_hop)
+			{wal_checkpoint_done_f, NULL};
+		cmsg_init(&msg[i].base, msg[i].route);
+		vclock_create(&msg[i].vclock);
+		msg[i].fiber = fiber();
+		msg[i].rotate = rotate;
+		msg[i].done = false;
+		msg[i].res = 0;
+		cpipe_push(&writer->thread.wal_pipe, &msg[i].base);
+	}
+	int rc = 0;
 	vclock_create(vclock);
-	struct wal_checkpoint msg;
-	cmsg_init(&msg.base, wal_checkpoint_route);
-	msg.vclock = vclock;
-	msg.fiber = fiber();
-	msg.rotate = rotate;
-	msg.res = 0;
-	cpipe_push(&wal_thread.wal_pipe, &msg.base);
 	fiber_set_cancellable(false);
-	fiber_yield();
+	for (int i = 0; i < wal_writer_count; i++) {
+		while (!msg[i].done)
+			fiber_yield();
+		if (msg[i].res != 0)
+			rc = -1;
+		vclock_merge_max(vclock, &msg[i].vclock);
+	}
 	fiber_set_cancellable(true);
-	return msg.res;
+	return rc;
 }
 
 struct wal_gc_msg
 {
 	struct cbus_call_msg base;
-	int64_t lsn;
+	const struct vclock *vclock;
 };
 
 static int
 wal_collect_garbage_f(struct cbus_call_msg *data)
 {
-	int64_t lsn = ((struct wal_gc_msg *)data)->lsn;
-	xdir_collect_garbage(&wal_writer_singleton.wal_dir, lsn, false);
+	struct wal_writer *writer = wal_writer_current;
+	struct vclock vclock;
+	vclock_copy(&vclock, ((struct wal_gc_msg *)data)->vclock);
+	/*
+	 * A stripe doesn't write all rows, so its xlogs may
+	 * have smaller signatures than the given vclock and
+	 * still be needed. Keep the xlog containing the rows
+	 * following the vclock and all xlogs after it.
+	 */
+	struct vclock *match = vclockset_match(&writer->wal_dir.index,
+					       &vclock);
+	if (match != NULL)
+		xdir_collect_garbage(&writer->wal_dir, vclock_sum(match),
+				     false);
 	return 0;
 }
 
 void
-wal_collect_garbage(int64_t lsn)
+wal_collect_garbage(const struct vclock *vclock)
 {
-	struct wal_writer *writer = &wal_writer_singleton;
-	if (writer->wal_mode == WAL_NONE)
+	if (wal_writers[0].wal_mode == WAL_NONE)
 		return;
 	struct wal_gc_msg msg;
-	msg.lsn = lsn;
+	msg.vclock = vclock;
 	bool cancellable = fiber_set_cancellable(false);
-	cbus_call(&wal_thread.wal_pipe, &wal_thread.tx_prio_pipe, &msg.base,
-		  wal_collect_garbage_f, NULL, TIMEOUT_INFINITY);
+	for (int i = 0; i < wal_writer_count; i++) {
+		struct wal_writer *writer = &wal_writers[i];
+		cbus_call(&writer->thread.wal_pipe,
+			  &writer->thread.tx_prio_pipe, &msg.base,
+			  wal_collect_garbage_f, NULL, TIMEOUT_INFINITY);
+	}
 	fiber_set_cancellable(cancellable);
 }
 
@@ -612,15 +1105,15 @@ wal_writer_clear_bus(struct cmsg *msg)
 static void
 wal_writer_end_rollback(struct cmsg *msg)
 {
-	(void) msg;
-	struct wal_writer *writer = &wal_writer_singleton;
+	struct wal_writer *writer = container_of(msg, struct wal_writer,
+						 in_rollback);
 	cmsg_init(&writer->in_rollback, NULL);
 }
 
 static void
 wal_writer_begin_rollback(struct wal_writer *writer)
 {
-	static struct cmsg_hop rollback_route[4] = {
+	struct cmsg_hop rollback_route[4] = {
 		/*
 		 * Step 1: clear the bus, so that it contains
 		 * no WAL write requests. This is achieved as a
@@ -629,26 +1122,28 @@ wal_writer_begin_rollback(struct wal_writer *writer)
 		 * valve is closed by non-empty writer->rollback
 		 * list.
 		 */
-		{ wal_writer_clear_bus, &wal_thread.wal_pipe },
-		{ wal_writer_clear_bus, &wal_thread.tx_prio_pipe },
+		{ wal_writer_clear_bus, &writer->thread.wal_pipe },
+		{ wal_writer_clear_bus, &writer->thread.tx_prio_pipe },
 		/*
 		 * Step 2: writer->rollback queue contains all
 		 * messages which need to be rolled back,
 		 * perform the rollback.
 		 */
-		{ tx_schedule_rollback, &wal_thread.wal_pipe },
+		{ tx_schedule_rollback, &writer->thread.wal_pipe },
 		/*
 		 * Step 3: re-open the WAL for writing.
 		 */
 		{ wal_writer_end_rollback, NULL }
 	};
+	memcpy(writer->rollback_route, rollback_route,
+	       sizeof(rollback_route));
 
 	/*
 	 * Make sure the WAL writer rolls back
 	 * all input until rollback mode is off.
 	 */
-	cmsg_init(&writer->in_rollback, rollback_route);
-	cpipe_push(&wal_thread.tx_prio_pipe, &writer->in_rollback);
+	cmsg_init(&writer->in_rollback, writer->rollback_route);
+	cpipe_push(&writer->thread.tx_prio_pipe, &writer->in_rollback);
 }
 
 static void
@@ -666,27 +1161,183 @@ wal_assign_lsn(struct wal_writer *writer, struct xrow_header **row,
 	}
 }
 
+/** Approximate size of a request in the log, in bytes. */
+static int64_t
+journal_entry_size(struct journal_entry *entry)
+{
+	int64_t size = 0;
+	for (int i = 0; i < entry->n_rows; i++) {
+		struct xrow_header *row = entry->rows[i];
+		size += XROW_HEADER_LEN_MAX;
+		for (int j = 0; j < row->bodycnt; j++)
+			size += row->body[j].iov_len;
+	}
+	return size;
+}
+
+/**
+ * Send messages of a group to the next hop, see
+ * wal_request_route.
+ */
 static void
-wal_write_to_disk(struct cmsg *msg)
+wal_writer_send(struct wal_writer *writer, struct stailq *group)
+{
+	struct wal_msg *wal_msg, *next;
+	stailq_foreach_entry_safe(wal_msg, next, group, base.fifo) {
+		wal_msg->base.hop++;
+		cpipe_push(&writer->thread.tx_prio_pipe, &wal_msg->base);
+	}
+}
+
+/**
+ * Complete a group written to disk: make its rows available
+ * to relays and send the messages back to tx.
+ */
+static void
+wal_writer_complete(struct wal_writer *writer, struct stailq *group)
+{
+	struct wal_msg *wal_msg;
+	struct journal_entry *entry;
+	/*
+	 * Make the rows available to relays before notifying
+	 * them. A failure here isn't fatal: relays will read
+	 * the rows from the xlog file.
+	 */
+	stailq_foreach_entry(wal_msg, group, base.fifo) {
+		stailq_foreach_entry(entry, &wal_msg->commit, fifo) {
+			if (xrow_buf_write(&writer->cache, entry->rows,
+					   entry->rows + entry->n_rows) != 0) {
+				diag_log();
+				diag_clear(diag_get());
+			}
+		}
+	}
+	fiber_gc();
+	wal_notify_watchers(writer, WAL_EVENT_WRITE);
+	wal_writer_send(writer, group);
+}
+
+/**
+ * Roll back a group that failed to get synced: cut its rows
+ * off the WAL file, forget their LSNs and send the group to
+ * tx to roll back, as if the write failed.
+ */
+static void
+wal_sync_rollback(struct wal_writer *writer, struct stailq *group)
+{
+	if (xlog_truncate(&writer->current_wal, writer->sync_offset) != 0) {
+		diag_log();
+		panic("failed to truncate WAL after sync error");
+	}
+	vclock_copy(&writer->vclock, &writer->sync_vclock);
+	struct wal_msg *wal_msg;
+	struct journal_entry *entry;
+	stailq_foreach_entry(wal_msg, group, base.fifo) {
+		stailq_foreach_entry(entry, &wal_msg->commit, fifo)
+			entry->res = -1;
+		stailq_concat(&wal_msg->rollback, &wal_msg->commit);
+	}
+	if (writer->in_rollback.route == NULL)
+		wal_writer_begin_rollback(writer);
+	wal_writer_send(writer, group);
+}
+
+/**
+ * Wait for the sync of writer->sync_group to complete,
+ * if there's one in progress, then complete the group.
+ */
+static void
+wal_sync_complete(struct wal_writer *writer)
+{
+	if (stailq_empty(&writer->sync_group))
+		return;
+	/* May complete the group via wal_sync_complete_cb(). */
+	io_ring_wait(&writer->ring, &writer->sync_req);
+	if (stailq_empty(&writer->sync_group))
+		return;
+	struct stailq group;
+	stailq_create(&group);
+	stailq_concat(&group, &writer->sync_group);
+	if (writer->sync_req.res < 0) {
+		errno = -writer->sync_req.res;
+		say_syserror("failed to sync WAL, fd=%i",
+			     writer->current_wal.fd);
+		wal_sync_rollback(writer, &group);
+		return;
+	}
+	wal_writer_complete(writer, &group);
+}
+
+static void
+wal_sync_complete_cb(struct io_ring_req *req)
+{
+	wal_sync_complete((struct wal_writer *) req->arg);
+}
+
+/**
+ * Start syncing writer->sync_group. The group is completed
+ * by wal_sync_complete(), either when the sync is done or
+ * before the next group is sent to tx.
+ */
+static void
+wal_sync_submit(struct wal_writer *writer)
+{
+	struct io_ring_req *req = &writer->sync_req;
+	int fd = writer->current_wal.fd;
+	if (io_ring_fsync(&writer->ring, req, fd, true) != 0) {
+		say_syserror("failed to submit fdatasync, fd=%i", fd);
+		/* Fall back on blocking sync. */
+		req->res = fdatasync(fd) == 0 ? 0 : -errno;
+		req->is_done = true;
+		req->on_complete = NULL;
+		return;
+	}
+	req->on_complete = wal_sync_complete_cb;
+	req->arg = writer;
+	if (!ev_is_active(&writer->ring.io))
+		io_ring_start(&writer->ring);
+}
+
+/**
+ * Write all messages of the group to disk at once and send
+ * them back to tx.
+ */
+static void
+wal_write_group(struct wal_writer *writer)
 {
-	struct wal_writer *writer = &wal_writer_singleton;
-	struct wal_msg *wal_msg = (struct wal_msg *) msg;
 	struct error *error;
+	struct wal_msg *wal_msg;
+	struct journal_entry *entry;
 
-	struct errinj *inj = errinj(ERRINJ_WAL_DELAY, ERRINJ_BOOL);
-	while (inj != NULL && inj->bparam)
-		usleep(10);
+	ev_timer_stop(loop(), &writer->group_timer);
+	if (stailq_empty(&writer->group))
+		return;
+	struct stailq group;
+	stailq_create(&group);
+	stailq_concat(&group, &writer->group);
+	writer->group_size = 0;
+
+	/*
+	 * Don't write the group until the previous one is synced:
+	 * relays may read the rows from the file, and a group that
+	 * failed to sync can only be cut off the end of the file.
+	 * Besides, requests must be sent to tx in order.
+	 */
+	wal_sync_complete(writer);
 
 	if (writer->in_rollback.route != NULL) {
 		/* We're rolling back a failed write. */
-		stailq_concat(&wal_msg->rollback, &wal_msg->commit);
-		return;
+		stailq_foreach_entry(wal_msg, &group, base.fifo)
+			stailq_concat(&wal_msg->rollback, &wal_msg->commit);
+		goto out;
 	}
 
 	/* Xlog is only rotated between queue processing  */
 	if (wal_opt_rotate(writer) != 0) {
-		stailq_concat(&wal_msg->rollback, &wal_msg->commit);
-		return wal_writer_begin_rollback(writer);
+		stailq_foreach_entry(wal_msg, &group, base.fifo)
+			stailq_concat(&wal_msg->rollback, &wal_msg->commit);
+		wal_writer_begin_rollback(writer);
+		goto out;
 	}
 
 	/*
@@ -711,27 +1362,46 @@ wal_write_to_disk(struct cmsg *msg)
 	 */
 
 	struct xlog *l = &writer->current_wal;
+	writer->sync_offset = l->offset;
+	vclock_copy(&writer->sync_vclock, &writer->vclock);
 
 	/*
 	 * Iterate over requests (transactions)
 	 */
-	struct journal_entry *entry;
+	struct wal_msg *last_msg = NULL;
 	struct stailq_entry *last_committed = NULL;
-	stailq_foreach_entry(entry, &wal_msg->commit, fifo) {
-		wal_assign_lsn(writer, entry->rows, entry->rows + entry->n_rows);
-		entry->res = vclock_sum(&writer->vclock);
-		int rc = xlog_write_entry(l, entry);
-		if (rc < 0)
-			goto done;
-		if (rc > 0)
-			last_committed = &entry->fifo;
-		/* rc == 0: the write is buffered in xlog_tx */
+	/* Vclock of the last committed request. */
+	struct vclock committed_vclock;
+	vclock_copy(&committed_vclock, &writer->vclock);
+	int64_t row_count = 0;
+	stailq_foreach_entry(wal_msg, &group, base.fifo) {
+		stailq_foreach_entry(entry, &wal_msg->commit, fifo) {
+			wal_assign_lsn(writer, entry->rows,
+				       entry->rows + entry->n_rows);
+			entry->res = vclock_sum(&writer->vclock);
+			int rc = xlog_write_entry(l, entry);
+			if (rc < 0)
+				goto done;
+			if (rc > 0) {
+				last_msg = wal_msg;
+				last_committed = &entry->fifo;
+				vclock_copy(&committed_vclock,
+					    &writer->vclock);
+			}
+			/* rc == 0: the write is buffered in xlog_tx */
+			row_count += entry->n_rows;
+		}
 	}
 	if (xlog_flush(l) < 0)
 		goto done;
 
-	last_committed = stailq_last(&wal_msg->commit);
+	last_msg = stailq_last_entry(&group, struct wal_msg, base.fifo);
+	last_committed = stailq_last(&last_msg->commit);
 
+	writer->write_count++;
+	writer->row_count += row_count;
+	histogram_collect(writer->batch_hist, row_count);
+	writer->batch_rows_max = MAX(writer->batch_rows_max, row_count);
 done:
 	error = diag_last_error(diag_get());
 	if (error) {
@@ -742,46 +1412,154 @@ done:
 	/*
 	 * We need to start rollback from the first request
 	 * following the last committed request. If
-	 * last_commit_req is NULL, it means we have committed
+	 * last_msg is NULL, it means we have committed
 	 * nothing, and need to start rollback from the first
-	 * request. Otherwise we rollback from the first request.
+	 * request of the first message.
 	 */
-	struct stailq rollback;
-	stailq_cut_tail(&wal_msg->commit, last_committed, &rollback);
-
-	if (!stailq_empty(&rollback)) {
+	bool is_rollback = false;
+	bool is_tail = (last_msg == NULL);
+	stailq_foreach_entry(wal_msg, &group, base.fifo) {
+		struct stailq rollback;
+		if (is_tail) {
+			stailq_cut_tail(&wal_msg->commit, NULL, &rollback);
+		} else if (wal_msg == last_msg) {
+			stailq_cut_tail(&wal_msg->commit, last_committed,
+					&rollback);
+			is_tail = true;
+		} else {
+			continue;
+		}
+		if (stailq_empty(&rollback))
+			continue;
 		/* Update status of the successfully committed requests. */
 		stailq_foreach_entry(entry, &rollback, fifo)
 			entry->res = -1;
 		/* Rollback unprocessed requests */
 		stailq_concat(&wal_msg->rollback, &rollback);
+		is_rollback = true;
+	}
+	/*
+	 * Forget LSNs of the rolled back rows so that they
+	 * can be reused, see wal_stripe_end_rollback().
+	 */
+	if (is_rollback)
+		vclock_copy(&writer->vclock, &committed_vclock);
+	bool is_sync_deferred = (io_ring_is_created(&writer->ring) &&
+				 last_msg != NULL);
+	if (is_sync_deferred) {
+		stailq_concat(&writer->sync_group, &group);
+		wal_sync_submit(writer);
+	}
+	if (is_rollback)
 		wal_writer_begin_rollback(writer);
+	if (is_sync_deferred) {
+		/* Don't delay rollback. */
+		if (is_rollback)
+			wal_sync_complete(writer);
+		fiber_gc();
+		return;
+	}
+	wal_writer_complete(writer, &group);
+	return;
+out:
+	wal_writer_send(writer, &group);
+}
+
+static void
+wal_group_timer_cb(struct ev_loop *loop, struct ev_timer *timer, int events)
+{
+	(void) loop;
+	(void) events;
+	wal_write_group((struct wal_writer *) timer->data);
+}
+
+/**
+ * Roll back the requests that haven't been written yet,
+ * because a write to another stripe failed, see
+ * wal_stripe_begin_rollback().
+ */
+static void
+wal_stripe_rollback_f(struct cmsg *msg)
+{
+	(void) msg;
+	struct wal_writer *writer = wal_writer_current;
+	/* Requests must be sent to tx in order. */
+	wal_sync_complete(writer);
+	if (writer->in_rollback.route != NULL)
+		return;
+	wal_writer_begin_rollback(writer);
+	wal_write_group(writer);
+}
+
+static void
+wal_write_to_disk(struct cmsg *msg)
+{
+	struct wal_msg *wal_msg = (struct wal_msg *) msg;
+	struct wal_writer *writer = wal_msg->writer;
+
+	struct errinj *inj = errinj(ERRINJ_WAL_DELAY, ERRINJ_BOOL);
+	while (inj != NULL && inj->bparam)
+		usleep(10);
+
+	stailq_add_tail_entry(&writer->group, wal_msg, base.fifo);
+	/*
+	 * Requests arriving during rollback must be rolled
+	 * back before the rollback message returns to tx,
+	 * so never delay them.
+	 */
+	if (writer->group_commit_timeout <= 0 ||
+	    writer->in_rollback.route != NULL)
+		return wal_write_group(writer);
+
+	struct journal_entry *entry;
+	stailq_foreach_entry(entry, &wal_msg->commit, fifo)
+		writer->group_size += journal_entry_size(entry);
+	if (writer->group_commit_bytes > 0 &&
+	    writer->group_size >= writer->group_commit_bytes)
+		return wal_write_group(writer);
+
+	if (!ev_is_active(&writer->group_timer)) {
+		ev_timer_set(&writer->group_timer,
+			     writer->group_commit_timeout, 0);
+		ev_timer_start(loop(), &writer->group_timer);
 	}
-	fiber_gc();
-	wal_notify_watchers(writer, WAL_EVENT_WRITE);
 }
 
 /** WAL thread main loop.  */
 static int
 wal_thread_f(va_list ap)
 {
-	(void) ap;
+	struct wal_writer *writer = va_arg(ap, struct wal_writer *);
+	wal_writer_current = writer;
 
 	/** Initialize eio in this thread */
 	coio_enable();
 
+	char name[FIBER_NAME_MAX];
+	snprintf(name, sizeof(name), "%s", wal_thread_name(writer->stripe));
 	struct cbus_endpoint endpoint;
-	cbus_endpoint_create(&endpoint, "wal", fiber_schedule_cb, fiber());
+	cbus_endpoint_create(&endpoint, name, fiber_schedule_cb, fiber());
 	/*
 	 * Create a pipe to TX thread. Use a high priority
 	 * endpoint, to ensure that WAL messages are delivered
 	 * even when tx fiber pool is used up by net messages.
 	 */
-	cpipe_create(&wal_thread.tx_prio_pipe, "tx_prio");
+	cpipe_create(&writer->thread.tx_prio_pipe, "tx_prio");
+	/*
+	 * WAL watchers are attached to the thread of stripe 0,
+	 * other stripes notify them through it.
+	 */
+	if (writer->stripe != 0) {
+		cbus_pair("wal", name, &writer->watchers_pipe,
+			  &writer->stripe_pipe, NULL, NULL, cbus_process);
+	}
 
 	cbus_loop(&endpoint);
 
-	struct wal_writer *writer = &wal_writer_singleton;
+	wal_write_group(writer);
+	wal_sync_complete(writer);
+	if (io_ring_is_created(&writer->ring))
+		io_ring_stop(&writer->ring);
 
 	/*
 	 * Create a new empty WAL on shutdown so that we don't
@@ -803,10 +1581,14 @@ wal_thread_f(va_list ap)
 	if (xlog_is_open(&writer->current_wal))
 		xlog_close(&writer->current_wal, false);
 
-	if (xlog_is_open(&vy_log_writer.xlog))
+	if (writer->stripe == 0 && xlog_is_open(&vy_log_writer.xlog))
 		xlog_close(&vy_log_writer.xlog, false);
 
-	cpipe_destroy(&wal_thread.tx_prio_pipe);
+	if (writer->stripe != 0) {
+		cbus_unpair(&writer->watchers_pipe, &writer->stripe_pipe,
+			    NULL, NULL, cbus_process);
+	}
+	cpipe_destroy(&writer->thread.tx_prio_pipe);
 	return 0;
 }
 
@@ -817,11 +1599,12 @@ wal_thread_f(va_list ap)
 int64_t
 wal_write(struct journal *journal, struct journal_entry *entry)
 {
-	struct wal_writer *writer = (struct wal_writer *) journal;
+	(void) journal;
+	struct wal_writer *writer = wal_writer_in_rollback();
 
 	ERROR_INJECT_RETURN(ERRINJ_WAL_IO);
 
-	if (! stailq_empty(&writer->rollback)) {
+	if (writer != NULL) {
 		/*
 		 * The writer rollback queue is not empty,
 		 * roll back this transaction immediately.
@@ -834,14 +1617,22 @@ wal_write(struct journal *journal, struct journal_entry *entry)
 			  vclock_sum(&writer->vclock));
 		return -1;
 	}
-
-	struct wal_msg *batch;
-	if (!stailq_empty(&wal_thread.wal_pipe.input) &&
-	    (batch = wal_msg(stailq_first_entry(&wal_thread.wal_pipe.input,
-						struct cmsg, fifo)))) {
-
-		stailq_add_tail_entry(&batch->commit, entry, fifo);
-	} else {
+	/*
+	 * All rows of a request come from the same instance,
+	 * local rows don't have replica_id assigned yet.
+	 */
+	uint32_t replica_id = entry->n_rows > 0 ?
+			      entry->rows[0]->replica_id : 0;
+	writer = &wal_writers[wal_stripe(replica_id)];
+	struct cpipe *wal_pipe = &writer->thread.wal_pipe;
+
+	struct wal_msg *batch = NULL;
+	if (!stailq_empty(&wal_pipe->input)) {
+		batch = wal_msg(stailq_first_entry(&wal_pipe->input,
+						   struct cmsg, fifo));
+	}
+	bool is_new_batch = (batch == NULL);
+	if (is_new_batch) {
 		batch = (struct wal_msg *)
 			region_alloc(&fiber()->gc, sizeof(struct wal_msg));
 		if (batch == NULL) {
@@ -849,26 +1640,44 @@ wal_write(struct journal *journal, struct journal_entry *entry)
 				 "region", "struct wal_msg");
 			return -1;
 		}
-		wal_msg_create(batch);
-		/*
-		 * Sic: first add a request, then push the batch,
-		 * since cpipe_push() may pass the batch to WAL
-		 * thread right away.
-		 */
-		stailq_add_tail_entry(&batch->commit, entry, fifo);
-		cpipe_push(&wal_thread.wal_pipe, &batch->base);
+		wal_msg_create(batch, writer);
+	}
+	struct wal_stripe_request request;
+	if (wal_writer_count > 1) {
+		request.prev_lsn = vclock_get(&wal_stripe_vclock,
+					      instance_id);
+		wal_stripe_assign_lsn(entry);
+		request.lsn = vclock_get(&wal_stripe_vclock, instance_id);
+		request.fiber = fiber();
+		request.is_done = false;
+		request.is_rollback = false;
+		rlist_add_tail_entry(&wal_stripe_requests, &request,
+				     in_queue);
 	}
-	wal_thread.wal_pipe.n_input += entry->n_rows * XROW_IOVMAX;
-	cpipe_flush_input(&wal_thread.wal_pipe);
+	/*
+	 * Sic: first add a request, then push the batch,
+	 * since cpipe_push() may pass the batch to WAL
+	 * thread right away.
+	 */
+	stailq_add_tail_entry(&batch->commit, entry, fifo);
+	if (is_new_batch)
+		cpipe_push(wal_pipe, &batch->base);
+	wal_pipe->n_input += entry->n_rows * XROW_IOVMAX;
+	cpipe_flush_input(wal_pipe);
 	/**
 	 * It's not safe to spuriously wakeup this fiber
 	 * since in that case it will ignore a possible
 	 * error from WAL writer and not roll back the
 	 * transaction.
 	 */
+	ev_tstamp start = ev_monotonic_now(loop());
 	bool cancellable = fiber_set_cancellable(false);
 	fiber_yield(); /* Request was inserted. */
+	if (wal_writer_count > 1)
+		wal_stripe_request_wait(&request, entry);
 	fiber_set_cancellable(cancellable);
+	latency_collect(&wal_commit_latency,
+			ev_monotonic_now(loop()) - start);
 	if (entry->res > 0) {
 		struct xrow_header **last = entry->rows + entry->n_rows - 1;
 		while (last >= entry->rows) {
@@ -947,10 +1756,11 @@ wal_write_vy_log_f(struct cbus_call_msg *msg)
 int
 wal_write_vy_log(struct journal_entry *entry)
 {
+	struct wal_thread *thread = &wal_writers[0].thread;
 	struct wal_write_vy_log_msg msg;
 	msg.entry= entry;
 	bool cancellable = fiber_set_cancellable(false);
-	int rc = cbus_call(&wal_thread.wal_pipe, &wal_thread.tx_prio_pipe,
+	int rc = cbus_call(&thread->wal_pipe, &thread->tx_prio_pipe,
 			   &msg.base, wal_write_vy_log_f, NULL,
 			   TIMEOUT_INFINITY);
 	fiber_set_cancellable(cancellable);
@@ -969,13 +1779,185 @@ wal_rotate_vy_log_f(struct cbus_call_msg *msg)
 void
 wal_rotate_vy_log()
 {
+	struct wal_thread *thread = &wal_writers[0].thread;
 	struct cbus_call_msg msg;
 	bool cancellable = fiber_set_cancellable(false);
-	cbus_call(&wal_thread.wal_pipe, &wal_thread.tx_prio_pipe, &msg,
+	cbus_call(&thread->wal_pipe, &thread->tx_prio_pipe, &msg,
 		  wal_rotate_vy_log_f, NULL, TIMEOUT_INFINITY);
 	fiber_set_cancellable(cancellable);
 }
 
+void
+wal_set_cache_size(int64_t size)
+{
+	/* See wal_init(). */
+	if (wal_writer_count > 1)
+		return;
+	xrow_buf_set_size(&wal_writers[0].cache, size);
+}
+
+struct wal_group_commit_msg {
+	struct cbus_call_msg base;
+	double timeout;
+	int64_t bytes;
+};
+
+static int
+wal_set_group_commit_f(struct cbus_call_msg *data)
+{
+	struct wal_group_commit_msg *msg = (struct wal_group_commit_msg *)data;
+	struct wal_writer *writer = wal_writer_current;
+	writer->group_commit_timeout = msg->timeout;
+	writer->group_commit_bytes = msg->bytes;
+	/* Apply the new limits to the pending group. */
+	if (writer->group_commit_timeout <= 0 ||
+	    (writer->group_commit_bytes > 0 &&
+	     writer->group_size >= writer->group_commit_bytes))
+		wal_write_group(writer);
+	return 0;
+}
+
+void
+wal_set_group_commit(double timeout, int64_t bytes)
+{
+	if (wal_writers[0].wal_mode == WAL_NONE)
+		return;
+	struct wal_group_commit_msg msg;
+	msg.timeout = timeout;
+	msg.bytes = bytes;
+	bool cancellable = fiber_set_cancellable(false);
+	for (int i = 0; i < wal_writer_count; i++) {
+		struct wal_writer *writer = &wal_writers[i];
+		cbus_call(&writer->thread.wal_pipe,
+			  &writer->thread.tx_prio_pipe, &msg.base,
+			  wal_set_group_commit_f, NULL, TIMEOUT_INFINITY);
+	}
+	fiber_set_cancellable(cancellable);
+}
+
+struct wal_stat_msg {
+	struct cbus_call_msg base;
+	int64_t write_count;
+	int64_t row_count;
+	/** Rows per disk write, summed up over all stripes. */
+	struct histogram *batch_hist;
+	int64_t batch_rows_max;
+	bool reset;
+};
+
+static const int wal_stat_pct[] = { 50, 75, 90, 95, 99 };
+
+static int
+wal_stat_f(struct cbus_call_msg *data)
+{
+	struct wal_stat_msg *msg = (struct wal_stat_msg *)data;
+	struct wal_writer *writer = wal_writer_current;
+	if (msg->reset) {
+		writer->write_count = 0;
+		writer->row_count = 0;
+		writer->batch_rows_max = 0;
+		histogram_reset(writer->batch_hist);
+		return 0;
+	}
+	struct histogram *hist = writer->batch_hist;
+	assert(hist->n_buckets == msg->batch_hist->n_buckets);
+	for (size_t i = 0; i < hist->n_buckets; i++)
+		msg->batch_hist->buckets[i].count += hist->buckets[i].count;
+	msg->batch_hist->total += hist->total;
+	msg->batch_hist->max = MAX(msg->batch_hist->max, hist->max);
+	msg->write_count += writer->write_count;
+	msg->row_count += writer->row_count;
+	msg->batch_rows_max = MAX(msg->batch_rows_max,
+				  writer->batch_rows_max);
+	return 0;
+}
+
+static void
+wal_stat_call(struct wal_stat_msg *msg)
+{
+	bool cancellable = fiber_set_cancellable(false);
+	for (int i = 0; i < wal_writer_count; i++) {
+		struct wal_writer *writer = &wal_writers[i];
+		cbus_call(&writer->thread.wal_pipe,
+			  &writer->thread.tx_prio_pipe, &msg->base,
+			  wal_stat_f, NULL, TIMEOUT_INFINITY);
+	}
+	fiber_set_cancellable(cancellable);
+}
+
+void
+wal_stat(struct info_handler *h)
+{
+	struct wal_writer *writer = &wal_writers[0];
+	struct wal_stat_msg msg;
+	memset(&msg, 0, sizeof(msg));
+	msg.batch_hist = histogram_new(wal_batch_buckets,
+				       lengthof(wal_batch_buckets));
+	if (msg.batch_hist != NULL &&
+	    journal_is_initialized(&writer->base) &&
+	    writer->wal_mode != WAL_NONE)
+		wal_stat_call(&msg);
+
+	char name[16];
+	info_begin(h);
+	info_append_int(h, "writes", msg.write_count);
+	info_append_int(h, "rows", msg.row_count);
+	info_table_begin(h, "batch_rows");
+	for (int i = 0; i < (int)lengthof(wal_stat_pct); i++) {
+		snprintf(name, sizeof(name), "p%d", wal_stat_pct[i]);
+		int64_t value = 0;
+		if (msg.batch_hist != NULL && msg.batch_hist->total > 0)
+			value = histogram_percentile(msg.batch_hist,
+						     wal_stat_pct[i]);
+		info_append_int(h, name, value);
+	}
+	info_append_int(h, "max", msg.batch_rows_max);
+	info_table_end(h);
+	info_table_begin(h, "commit_latency");
+	for (int i = 0; i < (int)lengthof(wal_stat_pct); i++) {
+		snprintf(name, sizeof(name), "p%d", wal_stat_pct[i]);
+		double value = 0;
+		if (journal_is_initialized(&writer->base))
+			value = latency_get(&wal_commit_latency,
+					    wal_stat_pct[i]);
+		info_append_double(h, name, value);
+	}
+	info_table_end(h);
+	info_end(h);
+	if (msg.batch_hist != NULL)
+		histogram_delete(msg.batch_hist);
+}
+
+void
+wal_reset_stat(void)
+{
+	struct wal_writer *writer = &wal_writers[0];
+	if (!journal_is_initialized(&writer->base))
+		return;
+	latency_reset(&wal_commit_latency);
+	if (writer->wal_mode == WAL_NONE)
+		return;
+	struct wal_stat_msg msg;
+	msg.reset = true;
+	wal_stat_call(&msg);
+}
+
+int
+wal_cache_cursor_create(struct xrow_buf_cursor *cursor,
+			const struct vclock *vclock)
+{
+	return xrow_buf_cursor_create(&wal_writers[0].cache,
+				      cursor, vclock);
+}
+
+int
+wal_cache_cursor_read(struct xrow_buf_cursor *cursor, struct ibuf *out,
+		      size_t max_size)
+{
+	return xrow_buf_cursor_read(&wal_writers[0].cache,
+				    cursor, out, max_size);
+}
+
 static void
 wal_watcher_notify(struct wal_watcher *watcher, unsigned events)
 {
@@ -1033,7 +2015,7 @@ static void
 wal_watcher_attach(void *arg)
 {
 	struct wal_watcher *watcher = (struct wal_watcher *) arg;
-	struct wal_writer *writer = &wal_writer_singleton;
+	struct wal_writer *writer = &wal_writers[0];
 
 	assert(rlist_empty(&watcher->next));
 	rlist_add_tail_entry(&writer->watchers, watcher, next);
@@ -1059,7 +2041,7 @@ wal_set_watcher(struct wal_watcher *watcher, const char *name,
 		void (*watcher_cb)(struct wal_watcher *, unsigned events),
 		void (*process_cb)(struct cbus_endpoint *))
 {
-	assert(journal_is_initialized(&wal_writer_singleton.base));
+	assert(journal_is_initialized(&wal_writers[0].base));
 
 	rlist_create(&watcher->next);
 	watcher->cb = watcher_cb;
@@ -1081,15 +2063,62 @@ void
 wal_clear_watcher(struct wal_watcher *watcher,
 		  void (*process_cb)(struct cbus_endpoint *))
 {
-	assert(journal_is_initialized(&wal_writer_singleton.base));
+	assert(journal_is_initialized(&wal_writers[0].base));
 
 	cbus_unpair(&watcher->wal_pipe, &watcher->watcher_pipe,
 		    wal_watcher_detach, watcher, process_cb);
 }
 
+static void
+wal_stripe_notify_perform(struct cmsg *cmsg)
+{
+	struct wal_watcher_msg *msg = (struct wal_watcher_msg *) cmsg;
+	wal_notify_watchers(&wal_writers[0], msg->events);
+}
+
+static void
+wal_stripe_notify_complete(struct cmsg *cmsg)
+{
+	struct wal_writer *writer = container_of(cmsg, struct wal_writer,
+						 watchers_msg.cmsg);
+	cmsg->route = NULL;
+	/*
+	 * Resend the message if we got notified while it was
+	 * en route, unless the thread is exiting: the pipes
+	 * are about to be unpaired, see wal_thread_f().
+	 */
+	if (writer->watchers_events != 0 && !fiber_is_cancelled()) {
+		wal_notify_watchers(writer, writer->watchers_events);
+		writer->watchers_events = 0;
+	}
+}
+
+/**
+ * Forward events of a secondary stripe to WAL watchers,
+ * which are attached to the thread of stripe 0.
+ */
+static void
+wal_stripe_notify(struct wal_writer *writer, unsigned events)
+{
+	if (writer->watchers_msg.cmsg.route != NULL) {
+		/* See wal_watcher_notify(). */
+		writer->watchers_events |= events;
+		return;
+	}
+	writer->watchers_route[0] = (struct cmsg_hop)
+		{ wal_stripe_notify_perform, &writer->stripe_pipe };
+	writer->watchers_route[1] = (struct cmsg_hop)
+		{ wal_stripe_notify_complete, NULL };
+	writer->watchers_msg.events = events;
+	cmsg_init(&writer->watchers_msg.cmsg, writer->watchers_route);
+	cpipe_push(&writer->watchers_pipe, &writer->watchers_msg.cmsg);
+}
+
 static void
 wal_notify_watchers(struct wal_writer *writer, unsigned events)
 {
+	if (writer->stripe != 0)
+		return wal_stripe_notify(writer, events);
 	struct wal_watcher *watcher;
 	rlist_foreach_entry(watcher, &writer->watchers, next)
 		wal_watcher_notify(watcher, events);
@@ -1105,8 +2134,11 @@ wal_notify_watchers(struct wal_writer *writer, unsigned events)
 void
 wal_atfork()
 {
-	if (xlog_is_open(&wal_writer_singleton.current_wal))
-		xlog_atfork(&wal_writer_singleton.current_wal);
+	for (int i = 0; i < wal_writer_count; i++) {
+		struct wal_writer *writer = &wal_writers[i];
+		if (xlog_is_open(&writer->current_wal))
+			xlog_atfork(&writer->current_wal);
+	}
 	if (xlog_is_open(&vy_log_writer.xlog))
 		xlog_atfork(&vy_log_writer.xlog);
 }
@@ -40,9 +40,17 @@ struct fiber;
 struct vclock;
 struct wal_writer;
 struct tt_uuid;
+struct xrow_buf_cursor;
+struct ibuf;
 
 enum wal_mode { WAL_NONE = 0, WAL_WRITE, WAL_FSYNC, WAL_MODE_MAX };
 
+/**
+ * Max number of WAL stripes, i.e. directories written
+ * by separate WAL threads, see box.cfg.wal_stripe_dirs.
+ */
+enum { WAL_STRIPE_MAX = 8 };
+
 /** String constants for the supported modes. */
 extern const char *wal_mode_STRS[];
 
@@ -52,13 +60,28 @@ extern int wal_dir_lock;
 extern "C" {
 #endif /* defined(__cplusplus) */
 
+/**
+ * Start @stripe_count WAL threads. Local transactions are
+ * spread over the threads round-robin, rows of replica N are
+ * written by the thread N % @stripe_count. If there's more
+ * than one thread, a failed write rolls back all transactions
+ * submitted after it, including those already written by
+ * other threads.
+ */
 void
-wal_thread_start();
+wal_thread_start(int stripe_count);
 
+/**
+ * @wal_dirs must contain a directory per each WAL stripe,
+ * see wal_thread_start(). If @io_uring is set, the WAL is
+ * synced with io_uring in the fsync mode, so that requests
+ * keep arriving while the previous write is being synced.
+ */
 int
-wal_init(enum wal_mode wal_mode, const char *wal_dirname,
+wal_init(enum wal_mode wal_mode, const char **wal_dirs,
 	 const struct tt_uuid *instance_uuid, struct vclock *vclock,
-	 int64_t wal_max_rows, int64_t wal_max_size);
+	 int64_t wal_max_rows, int64_t wal_max_size, int64_t wal_cache_size,
+	 bool io_uring);
 
 void
 wal_thread_stop();
@@ -138,12 +161,70 @@ void
 wal_clear_watcher(struct wal_watcher *watcher,
 		  void (*process_cb)(struct cbus_endpoint *));
 
+/**
+ * Set the max amount of memory used for keeping rows
+ * recently written to WAL. Zero disables the cache.
+ */
+void
+wal_set_cache_size(int64_t size);
+
+/**
+ * Configure group commit: delay writing a request to disk by
+ * up to @timeout seconds so that it is written and synced
+ * together with requests arriving after it, unless the pending
+ * requests take more than @bytes (zero means no limit). A zero
+ * @timeout disables group commit.
+ */
+void
+wal_set_group_commit(double timeout, int64_t bytes);
+
+struct info_handler;
+
+/**
+ * Report WAL statistics: the number of disk writes and rows
+ * written, percentiles of rows per disk write and of commit
+ * latency.
+ */
+void
+wal_stat(struct info_handler *h);
+
+/** Reset WAL statistics. */
+void
+wal_reset_stat(void);
+
+/**
+ * Position a cursor to read rows following @vclock from
+ * the WAL cache. Can be called from any thread.
+ *
+ * @retval  0 success
+ * @retval -1 the rows are not in the cache, read xlog files
+ */
+int
+wal_cache_cursor_create(struct xrow_buf_cursor *cursor,
+			const struct vclock *vclock);
+
+/**
+ * Copy rows following the cursor from the WAL cache to @out.
+ * See xrow_buf_cursor_read() for the details.
+ *
+ * @retval  0 success
+ * @retval  1 the relay fell behind, read xlog files
+ * @retval -1 memory error (diag is set)
+ */
+int
+wal_cache_cursor_read(struct xrow_buf_cursor *cursor, struct ibuf *out,
+		      size_t max_size);
+
 void
 wal_atfork();
 
 enum wal_mode
 wal_mode();
 
+/** Number of WAL stripes, see wal_thread_start(). */
+int
+wal_stripe_count(void);
+
 /**
  * Wait till all pending changes to the WAL are flushed.
  * Rotates the WAL.
@@ -156,10 +237,10 @@ wal_checkpoint(struct vclock *vclock, bool rotate);
 
 /**
  * Remove WAL files that are not needed to recover
- * from snapshot with @lsn or newer.
+ * from snapshot with @vclock or newer.
  */
 void
-wal_collect_garbage(int64_t lsn);
+wal_collect_garbage(const struct vclock *vclock);
 
 void
 wal_init_vy_log();
@@ -986,13 +986,12 @@ xdir_create_xlog(struct xdir *dir, struct xlog *xlog,
 }
 
 /**
- * Write a sequence of uncompressed xrow objects.
- *
- * @retval -1 error
- * @retval >= 0 the number of bytes written
+ * Format a sequence of uncompressed xrow objects accumulated
+ * in the xlog output buffer into a tx block: populate the
+ * fixheader reserved at the beginning of the buffer.
  */
-static off_t
-xlog_tx_write_plain(struct xlog *log)
+static void
+xlog_tx_format_plain(struct xlog *log)
 {
 	/**
 	 * We created an obuf savepoint at start of xlog_tx,
@@ -1029,28 +1028,16 @@ xlog_tx_write_plain(struct xlog *log)
 			data += padding - 1;
 		}
 	}
-
-	ERROR_INJECT(ERRINJ_WAL_WRITE_DISK, {
-		diag_set(ClientError, ER_INJECTION, "xlog write injection");
-		return -1;
-	});
-
-	ssize_t written = fio_writevn(log->fd, log->obuf.iov, log->obuf.pos + 1);
-	if (written < 0) {
-		diag_set(SystemError, "failed to write to '%s' file",
-			 log->filename);
-		return -1;
-	}
-	return obuf_size(&log->obuf);
 }
 
 /**
- * Write a compressed block of xrow objects.
- * @retval -1  error
- * @retval >= 0 the number of bytes written
+ * Compress xrow objects accumulated in the xlog output buffer
+ * into a tx block stored in the compressed output buffer.
+ * @retval -1 error
+ * @retval 0 success
  */
-static off_t
-xlog_tx_write_zstd(struct xlog *log)
+static int
+xlog_tx_format_zstd(struct xlog *log)
 {
 	char *fixheader = (char *)obuf_alloc(&log->zbuf,
 					     XLOG_FIXHEADER_SIZE);
@@ -1117,68 +1104,58 @@ xlog_tx_write_zstd(struct xlog *log)
 			data += padding - 1;
 		}
 	}
-
-	ERROR_INJECT(ERRINJ_WAL_WRITE_DISK, {
-		diag_set(ClientError, ER_INJECTION, "xlog write injection");
-		obuf_reset(&log->zbuf);
-		goto error;
-	});
-
-	ssize_t written;
-	written = fio_writevn(log->fd, log->zbuf.iov,
-			      log->zbuf.pos + 1);
-	if (written < 0) {
-		diag_set(SystemError, "failed to write to '%s' file",
-			 log->filename);
-		goto error;
-	}
-	obuf_reset(&log->zbuf);
-	return written;
+	return 0;
 error:
 	obuf_reset(&log->zbuf);
 	return -1;
 }
 
+/**
+ * Format xrow objects accumulated in the xlog output buffer
+ * into a tx block, compressing them if the block is big enough.
+ *
+ * @retval NULL error
+ * @retval not NULL the buffer storing the formatted block,
+ *         either the output buffer or the compressed one
+ */
+static struct obuf *
+xlog_tx_format(struct xlog *log)
+{
+	if (obuf_size(&log->obuf) >= XLOG_TX_COMPRESS_THRESHOLD) {
+		if (xlog_tx_format_zstd(log) != 0)
+			return NULL;
+		return &log->zbuf;
+	}
+	xlog_tx_format_plain(log);
+	return &log->obuf;
+}
+
 /* file syncing and posix_fadvise() should be rounded by a page boundary */
 #define SYNC_MASK		(4096 - 1)
 #define SYNC_ROUND_DOWN(size)	((size) & ~(4096 - 1))
 #define SYNC_ROUND_UP(size)	(SYNC_ROUND_DOWN(size + SYNC_MASK))
 
 /**
- * Writes xlog batch to file
+ * Simplify recovery after a temporary write failure:
+ * truncate the file to the best known good write
+ * position.
  */
-static ssize_t
-xlog_tx_write(struct xlog *log)
+static void
+xlog_truncate_failed_write(struct xlog *log)
 {
-	if (obuf_size(&log->obuf) == XLOG_FIXHEADER_SIZE)
-		return 0;
-	ssize_t written;
-
-	if (obuf_size(&log->obuf) >= XLOG_TX_COMPRESS_THRESHOLD) {
-		written = xlog_tx_write_zstd(log);
-	} else {
-		written = xlog_tx_write_plain(log);
-	}
-	ERROR_INJECT(ERRINJ_WAL_WRITE, {
-		diag_set(ClientError, ER_INJECTION, "xlog write injection");
-		written = -1;
-	});
+	if (lseek(log->fd, log->offset, SEEK_SET) < 0 ||
+	    ftruncate(log->fd, log->offset) != 0)
+		panic_syserror("failed to truncate xlog after write error");
+}
 
-	obuf_reset(&log->obuf);
-	/*
-	 * Simplify recovery after a temporary write failure:
-	 * truncate the file to the best known good write
-	 * position.
-	 */
-	if (written < 0) {
-		if (lseek(log->fd, log->offset, SEEK_SET) < 0 ||
-		    ftruncate(log->fd, log->offset) != 0)
-			panic_syserror("failed to truncate xlog after write error");
-		return -1;
-	}
+/**
+ * Account @a written bytes appended to the file, sync
+ * them to disk and throttle the writer if needed.
+ */
+static void
+xlog_advance(struct xlog *log, size_t written)
+{
 	log->offset += written;
-	log->rows += log->tx_rows;
-	log->tx_rows = 0;
 	if ((log->sync_interval && log->offset >=
 	    (off_t)(log->synced_size + log->sync_interval)) ||
 	    (log->rate_limit && log->offset >=
@@ -1217,9 +1194,123 @@ xlog_tx_write(struct xlog *log)
 		}
 		log->synced_size = log->offset;
 	}
+}
+
+/**
+ * Writes xlog batch to file
+ */
+static ssize_t
+xlog_tx_write(struct xlog *log)
+{
+	if (obuf_size(&log->obuf) == XLOG_FIXHEADER_SIZE)
+		return 0;
+	ssize_t written = -1;
+
+	struct obuf *buf = xlog_tx_format(log);
+	if (buf == NULL)
+		goto done;
+
+	ERROR_INJECT(ERRINJ_WAL_WRITE_DISK, {
+		diag_set(ClientError, ER_INJECTION, "xlog write injection");
+		obuf_reset(&log->zbuf);
+		goto done;
+	});
+
+	written = fio_writevn(log->fd, buf->iov, buf->pos + 1);
+	if (written < 0) {
+		diag_set(SystemError, "failed to write to '%s' file",
+			 log->filename);
+	}
+	obuf_reset(&log->zbuf);
+done:
+	ERROR_INJECT(ERRINJ_WAL_WRITE, {
+		diag_set(ClientError, ER_INJECTION, "xlog write injection");
+		written = -1;
+	});
+
+	obuf_reset(&log->obuf);
+	if (written < 0) {
+		xlog_truncate_failed_write(log);
+		return -1;
+	}
+	log->rows += log->tx_rows;
+	log->tx_rows = 0;
+	xlog_advance(log, written);
 	return written;
 }
 
+int
+xlog_create_buffer(struct xlog *xlog)
+{
+	if (xlog_init(xlog) != 0)
+		return -1;
+	xlog->fd = -1;
+	/* Rows are never flushed implicitly, there's no file. */
+	xlog->is_autocommit = false;
+	return 0;
+}
+
+void
+xlog_destroy_buffer(struct xlog *xlog)
+{
+	assert(xlog->fd < 0);
+	xlog_destroy(xlog);
+}
+
+ssize_t
+xlog_tx_encode(struct xlog *log, char **block)
+{
+	assert(log->fd < 0);
+	*block = NULL;
+	if (obuf_size(&log->obuf) <= XLOG_FIXHEADER_SIZE) {
+		obuf_reset(&log->obuf);
+		return 0;
+	}
+	ssize_t size = -1;
+	struct obuf *buf = xlog_tx_format(log);
+	if (buf == NULL)
+		goto out;
+	size = obuf_size(buf);
+	*block = (char *)malloc(size);
+	if (*block == NULL) {
+		diag_set(OutOfMemory, size, "malloc", "xlog tx block");
+		size = -1;
+		goto out;
+	}
+	char *pos = *block;
+	for (int i = 0; i <= buf->pos; i++) {
+		memcpy(pos, buf->iov[i].iov_base, buf->iov[i].iov_len);
+		pos += buf->iov[i].iov_len;
+	}
+	assert(pos == *block + size);
+out:
+	obuf_reset(&log->zbuf);
+	obuf_reset(&log->obuf);
+	log->rows += log->tx_rows;
+	log->tx_rows = 0;
+	return size;
+}
+
+ssize_t
+xlog_write_tx_block(struct xlog *log, const char *block, size_t size,
+		    int64_t rows)
+{
+	assert(log->is_autocommit && obuf_size(&log->obuf) == 0);
+	ERROR_INJECT(ERRINJ_WAL_WRITE_DISK, {
+		diag_set(ClientError, ER_INJECTION, "xlog write injection");
+		return -1;
+	});
+	if (fio_writen(log->fd, block, size) < 0) {
+		diag_set(SystemError, "failed to write to '%s' file",
+			 log->filename);
+		xlog_truncate_failed_write(log);
+		return -1;
+	}
+	log->rows += rows;
+	xlog_advance(log, size);
+	return size;
+}
+
 /*
  * Add a row to a log and possibly flush the log.
  *
@@ -1349,6 +1440,23 @@ sync_cb(eio_req *req)
 	return 0;
 }
 
+int
+xlog_truncate(struct xlog *l, off_t offset)
+{
+	assert(offset <= l->offset);
+	assert(obuf_size(&l->obuf) == 0);
+	if (lseek(l->fd, offset, SEEK_SET) < 0 ||
+	    ftruncate(l->fd, offset) != 0) {
+		diag_set(SystemError, "%s: failed to truncate xlog",
+			 l->filename);
+		return -1;
+	}
+	l->offset = offset;
+	if (l->synced_size > (uint64_t)offset)
+		l->synced_size = offset;
+	return 0;
+}
+
 int
 xlog_sync(struct xlog *l)
 {
@@ -460,6 +460,67 @@ xlog_tx_rollback(struct xlog *log);
 ssize_t
 xlog_flush(struct xlog *log);
 
+/**
+ * Initialize an xlog which is not backed by a file. It is
+ * used to encode and compress rows into xlog tx blocks in
+ * one thread, while the blocks are appended to the actual
+ * file in another one with xlog_write_tx_block().
+ * Rows are added with xlog_write_row() and are never
+ * flushed implicitly.
+ *
+ * @retval 0 success
+ * @retval -1 error
+ */
+int
+xlog_create_buffer(struct xlog *xlog);
+
+/** Destroy an xlog created with xlog_create_buffer(). */
+void
+xlog_destroy_buffer(struct xlog *xlog);
+
+/**
+ * Format rows accumulated in an xlog created with
+ * xlog_create_buffer() into a tx block, compressing it if it
+ * is big enough, and reset the row buffer.
+ *
+ * @param log          xlog buffer
+ * @param[out] block   the block, allocated with malloc(),
+ *                     the caller must free() it
+ *
+ * @retval -1 error
+ * @retval 0 no rows were buffered, *block is NULL
+ * @retval >0 the size of the block
+ */
+ssize_t
+xlog_tx_encode(struct xlog *log, char **block);
+
+/**
+ * Append a tx block formatted with xlog_tx_encode() to
+ * an xlog file. The file must not have buffered rows.
+ *
+ * @param log          xlog
+ * @param block        the block
+ * @param size         the block size
+ * @param rows         the number of rows in the block
+ *
+ * @retval -1 error
+ * @retval >= 0 the number of bytes written
+ */
+ssize_t
+xlog_write_tx_block(struct xlog *log, const char *block, size_t size,
+		    int64_t rows);
+
+
+/**
+ * Truncate a log file to the given offset, discarding
+ * the rows written after it. The file must not have
+ * buffered rows.
+ *
+ * @retval 0 success
+ * @retval -1 error
+ */
+int
+xlog_truncate(struct xlog *l, off_t offset);
 
 /**
  * Sync a log file. The exact action is defined
@@ -0,0 +1,273 @@
+/*
+ * Copyright 2010-2018, Tarantool AUTHORS, please see AUTHORS file.
+ *
+ * Redistribution and use in source and binary forms, with or
+ * without modification, are permitted provided that the following
+ * conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above
+ *    copyright notice, this list of conditions and the
+ *    following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials
+ *    provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY <COPYRIGHT HOLDER> ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * <COPYRIGHT HOLDER> OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+#include "xrow_buf.h"
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+#include <small/ibuf.h>
+
+#include "trivia/util.h"
+#include "diag.h"
+#include "tt_pthread.h"
+#include "xrow.h"
+
+static inline struct xrow_buf_chunk *
+xrow_buf_chunk(struct xrow_buf *buf, uint64_t chunk_id)
+{
+	return &buf->chunks[chunk_id % XROW_BUF_CHUNK_COUNT];
+}
+
+void
+xrow_buf_create(struct xrow_buf *buf, const struct vclock *vclock,
+		size_t size)
+{
+	memset(buf, 0, sizeof(*buf));
+	tt_pthread_mutex_init(&buf->mutex, NULL);
+	vclock_copy(&buf->vclock, vclock);
+	vclock_copy(&xrow_buf_chunk(buf, 0)->vclock, vclock);
+	buf->chunk_size_max = size / XROW_BUF_CHUNK_COUNT;
+}
+
+void
+xrow_buf_destroy(struct xrow_buf *buf)
+{
+	for (int i = 0; i < XROW_BUF_CHUNK_COUNT; i++)
+		free(buf->chunks[i].data);
+	tt_pthread_mutex_destroy(&buf->mutex);
+}
+
+/**
+ * Switch to the next chunk, discarding the oldest one if
+ * the ring is full. Must be called under the mutex.
+ */
+static struct xrow_buf_chunk *
+xrow_buf_next_chunk(struct xrow_buf *buf)
+{
+	buf->last_chunk_id++;
+	if (buf->last_chunk_id - buf->first_chunk_id >= XROW_BUF_CHUNK_COUNT)
+		buf->first_chunk_id++;
+	struct xrow_buf_chunk *chunk = xrow_buf_chunk(buf, buf->last_chunk_id);
+	if (chunk->capacity > 2 * buf->chunk_size_max) {
+		/* The size limit was lowered, release memory. */
+		free(chunk->data);
+		chunk->data = NULL;
+		chunk->capacity = 0;
+	}
+	chunk->size = 0;
+	vclock_copy(&chunk->vclock, &buf->vclock);
+	return chunk;
+}
+
+/**
+ * Discard all rows stored in the buffer, so that all
+ * cursors become stale. Must be called under the mutex.
+ */
+static void
+xrow_buf_reset(struct xrow_buf *buf)
+{
+	xrow_buf_next_chunk(buf);
+	buf->first_chunk_id = buf->last_chunk_id;
+}
+
+void
+xrow_buf_set_size(struct xrow_buf *buf, size_t size)
+{
+	tt_pthread_mutex_lock(&buf->mutex);
+	buf->chunk_size_max = size / XROW_BUF_CHUNK_COUNT;
+	if (buf->chunk_size_max == 0) {
+		xrow_buf_reset(buf);
+		for (int i = 0; i < XROW_BUF_CHUNK_COUNT; i++) {
+			struct xrow_buf_chunk *chunk = &buf->chunks[i];
+			free(chunk->data);
+			chunk->data = NULL;
+			chunk->capacity = 0;
+		}
+	}
+	tt_pthread_mutex_unlock(&buf->mutex);
+}
+
+/** Make sure a chunk has room for @size more bytes. */
+static int
+xrow_buf_chunk_reserve(struct xrow_buf_chunk *chunk, size_t size)
+{
+	if (chunk->size + size <= chunk->capacity)
+		return 0;
+	size_t capacity = MAX(chunk->capacity, (size_t)4096);
+	while (capacity < chunk->size + size)
+		capacity *= 2;
+	char *data = realloc(chunk->data, capacity);
+	if (data == NULL) {
+		diag_set(OutOfMemory, capacity, "realloc", "xrow buffer chunk");
+		return -1;
+	}
+	chunk->data = data;
+	chunk->capacity = capacity;
+	return 0;
+}
+
+/** Promote the buffer vclock, tolerating LSN gaps and reorders. */
+static inline void
+xrow_buf_follow(struct xrow_buf *buf, const struct xrow_header *row)
+{
+	if (row->lsn > vclock_get(&buf->vclock, row->replica_id))
+		vclock_follow(&buf->vclock, row->replica_id, row->lsn);
+}
+
+int
+xrow_buf_write(struct xrow_buf *buf, struct xrow_header **begin,
+	       struct xrow_header **end)
+{
+	struct xrow_header **row = begin;
+	tt_pthread_mutex_lock(&buf->mutex);
+	if (buf->chunk_size_max == 0)
+		goto skip;
+	struct xrow_buf_chunk *chunk = xrow_buf_chunk(buf, buf->last_chunk_id);
+	if (chunk->size >= buf->chunk_size_max)
+		chunk = xrow_buf_next_chunk(buf);
+	for (; row < end; row++) {
+		struct iovec iov[XROW_IOVMAX];
+		int iovcnt = xrow_header_encode(*row, 0, iov, 0);
+		if (iovcnt < 0)
+			goto fail;
+		size_t len = 0;
+		for (int i = 0; i < iovcnt; i++)
+			len += iov[i].iov_len;
+		if (xrow_buf_chunk_reserve(chunk, sizeof(uint32_t) + len) != 0)
+			goto fail;
+		char *pos = chunk->data + chunk->size;
+		uint32_t len32 = len;
+		memcpy(pos, &len32, sizeof(len32));
+		pos += sizeof(len32);
+		for (int i = 0; i < iovcnt; i++) {
+			memcpy(pos, iov[i].iov_base, iov[i].iov_len);
+			pos += iov[i].iov_len;
+		}
+		chunk->size = pos - chunk->data;
+		xrow_buf_follow(buf, *row);
+	}
+	tt_pthread_mutex_unlock(&buf->mutex);
+	return 0;
+fail:
+	for (; row < end; row++)
+		xrow_buf_follow(buf, *row);
+	xrow_buf_reset(buf);
+	tt_pthread_mutex_unlock(&buf->mutex);
+	return -1;
+skip:
+	for (; row < end; row++)
+		xrow_buf_follow(buf, *row);
+	tt_pthread_mutex_unlock(&buf->mutex);
+	return 0;
+}
+
+int
+xrow_buf_cursor_create(struct xrow_buf *buf, struct xrow_buf_cursor *cursor,
+		       const struct vclock *vclock)
+{
+	int rc = -1;
+	tt_pthread_mutex_lock(&buf->mutex);
+	if (buf->chunk_size_max == 0)
+		goto out;
+	/*
+	 * Look up the most recent chunk that doesn't start
+	 * after @vclock, so that the reader has as few rows
+	 * to skip as possible.
+	 */
+	for (uint64_t id = buf->last_chunk_id; ; id--) {
+		struct xrow_buf_chunk *chunk = xrow_buf_chunk(buf, id);
+		if (vclock_compare(&chunk->vclock, vclock) <= 0) {
+			cursor->chunk_id = id;
+			cursor->offset = 0;
+			rc = 0;
+			break;
+		}
+		if (id == buf->first_chunk_id)
+			break;
+	}
+out:
+	tt_pthread_mutex_unlock(&buf->mutex);
+	return rc;
+}
+
+int
+xrow_buf_cursor_read(struct xrow_buf *buf, struct xrow_buf_cursor *cursor,
+		     struct ibuf *out, size_t max_size)
+{
+	int rc = 0;
+	size_t copied = 0;
+	tt_pthread_mutex_lock(&buf->mutex);
+	if (cursor->chunk_id < buf->first_chunk_id) {
+		rc = 1;
+		goto out;
+	}
+	while (copied < max_size) {
+		struct xrow_buf_chunk *chunk = xrow_buf_chunk(buf,
+							      cursor->chunk_id);
+		assert(cursor->offset <= chunk->size);
+		size_t size = chunk->size - cursor->offset;
+		if (size > 0) {
+			char *data = ibuf_alloc(out, size);
+			if (data == NULL) {
+				diag_set(OutOfMemory, size, "ibuf_alloc",
+					 "xrow buffer data");
+				rc = -1;
+				break;
+			}
+			memcpy(data, chunk->data + cursor->offset, size);
+			cursor->offset += size;
+			copied += size;
+		}
+		if (cursor->chunk_id == buf->last_chunk_id)
+			break;
+		cursor->chunk_id++;
+		cursor->offset = 0;
+	}
+out:
+	tt_pthread_mutex_unlock(&buf->mutex);
+	return rc;
+}
+
+int
+xrow_buf_decode(struct xrow_header *row, const char **pos, const char *end)
+{
+	uint32_t len;
+	assert(end - *pos >= (ptrdiff_t)sizeof(len));
+	memcpy(&len, *pos, sizeof(len));
+	*pos += sizeof(len);
+	const char *row_end = *pos + len;
+	assert(row_end <= end);
+	(void)end;
+	if (xrow_header_decode(row, pos, row_end) != 0)
+		return -1;
+	*pos = row_end;
+	return 0;
+}
@@ -0,0 +1,176 @@
+#ifndef TARANTOOL_XROW_BUF_H_INCLUDED
+#define TARANTOOL_XROW_BUF_H_INCLUDED
+/*
+ * Copyright 2010-2018, Tarantool AUTHORS, please see AUTHORS file.
+ *
+ * Redistribution and use in source and binary forms, with or
+ * without modification, are permitted provided that the following
+ * conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above
+ *    copyright notice, this list of conditions and the
+ *    following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials
+ *    provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY <COPYRIGHT HOLDER> ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * <COPYRIGHT HOLDER> OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+#include <stdint.h>
+#include <stddef.h>
+#include <pthread.h>
+#include "vclock.h"
+
+#if defined(__cplusplus)
+extern "C" {
+#endif /* defined(__cplusplus) */
+
+struct xrow_header;
+struct ibuf;
+
+enum {
+	/** Number of chunks in an xrow buffer ring. */
+	XROW_BUF_CHUNK_COUNT = 16,
+};
+
+/**
+ * A piece of an xrow buffer. Rows are appended to the last
+ * chunk until it grows bigger than the chunk size limit, then
+ * the oldest chunk is discarded and reused for new rows.
+ */
+struct xrow_buf_chunk {
+	/** Vclock preceding the first row stored in the chunk. */
+	struct vclock vclock;
+	/** Encoded rows, each prefixed with its 32-bit length. */
+	char *data;
+	/** Number of bytes used in the data buffer. */
+	size_t size;
+	/** Size of the data buffer. */
+	size_t capacity;
+};
+
+/**
+ * A bounded in-memory ring of recently written rows.
+ *
+ * Rows are appended by one thread (WAL) and read by several
+ * others (relays), so all accesses go under a mutex. Readers
+ * never look at the data in place: they copy whole rows to
+ * their own buffer, which keeps the critical section short.
+ */
+struct xrow_buf {
+	/** Protects all members below. */
+	pthread_mutex_t mutex;
+	/** Ring of chunks, indexed by chunk id modulo count. */
+	struct xrow_buf_chunk chunks[XROW_BUF_CHUNK_COUNT];
+	/** Id of the oldest chunk that is still in the ring. */
+	uint64_t first_chunk_id;
+	/** Id of the chunk rows are appended to. */
+	uint64_t last_chunk_id;
+	/**
+	 * Chunk size limit, a fraction of the ring size.
+	 * 0 means the buffer is disabled.
+	 */
+	size_t chunk_size_max;
+	/** Vclock following the last row stored in the buffer. */
+	struct vclock vclock;
+};
+
+/** Position of a reader in an xrow buffer. */
+struct xrow_buf_cursor {
+	/** Id of the chunk to read from. */
+	uint64_t chunk_id;
+	/** Offset of the next row in the chunk. */
+	size_t offset;
+};
+
+/**
+ * Create an xrow buffer.
+ * @param buf     Buffer to initialize.
+ * @param vclock  Vclock preceding the first row to be written.
+ * @param size    Max amount of memory to use for rows.
+ */
+void
+xrow_buf_create(struct xrow_buf *buf, const struct vclock *vclock,
+		size_t size);
+
+void
+xrow_buf_destroy(struct xrow_buf *buf);
+
+/**
+ * Change the max amount of memory used by the buffer.
+ * The new limit is applied as chunks are reused.
+ * Zero disables the buffer and discards all rows.
+ */
+void
+xrow_buf_set_size(struct xrow_buf *buf, size_t size);
+
+/**
+ * Append rows to the buffer.
+ *
+ * On failure the buffer forgets everything written so far
+ * so that readers never miss a row, and fall back to other
+ * sources of rows instead.
+ *
+ * @retval  0 success
+ * @retval -1 memory error (diag is set)
+ */
+int
+xrow_buf_write(struct xrow_buf *buf, struct xrow_header **begin,
+	       struct xrow_header **end);
+
+/**
+ * Position a cursor to read rows following @vclock.
+ * The cursor may point to some rows preceding @vclock,
+ * so the reader has to skip rows it has already seen.
+ *
+ * @retval  0 success
+ * @retval -1 rows following @vclock are not in the buffer
+ */
+int
+xrow_buf_cursor_create(struct xrow_buf *buf, struct xrow_buf_cursor *cursor,
+		       const struct vclock *vclock);
+
+/**
+ * Copy rows following the cursor position to @out and
+ * advance the cursor. Rows are copied by whole chunks until
+ * at least @max_size bytes are copied or there are no more
+ * rows. Use xrow_buf_decode() to decode copied rows.
+ *
+ * @retval  0 success, possibly nothing was copied
+ * @retval  1 the rows the cursor points to have been
+ *            discarded from the buffer
+ * @retval -1 memory error (diag is set)
+ */
+int
+xrow_buf_cursor_read(struct xrow_buf *buf, struct xrow_buf_cursor *cursor,
+		     struct ibuf *out, size_t max_size);
+
+/**
+ * Decode a row copied by xrow_buf_cursor_read().
+ * The row body points to the copied data.
+ *
+ * @retval  0 success
+ * @retval -1 error (diag is set)
+ */
+int
+xrow_buf_decode(struct xrow_header *row, const char **pos, const char *end);
+
+#if defined(__cplusplus)
+} /* extern "C" */
+#endif /* defined(__cplusplus) */
+
+#endif /* TARANTOOL_XROW_BUF_H_INCLUDED */
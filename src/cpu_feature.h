@@ -34,6 +34,10 @@
 #include <stdbool.h>
 #include <stdint.h>
 
+#if defined(__cplusplus)
+extern "C" {
+#endif /* defined(__cplusplus) */
+
 /* Check whether CPU supports SSE 4.2 (needed to compute CRC32 in hardware).
  *
  * @param	feature		indetifier (see above) of the target feature
@@ -55,5 +59,9 @@ bool sse42_enabled_cpu();
 uint32_t crc32c_hw(uint32_t crc, const char *buf, unsigned int len);
 #endif
 
+#if defined(__cplusplus)
+} /* extern "C" */
+#endif /* defined(__cplusplus) */
+
 #endif /* TARANTOOL_CPU_FEATURES_H */
 
@@ -0,0 +1,401 @@
+/*
+ * Copyright 2010-2018, Tarantool AUTHORS, please see AUTHORS file.
+ *
+ * Redistribution and use in source and binary forms, with or
+ * without modification, are permitted provided that the following
+ * conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above
+ *    copyright notice, this list of conditions and the
+ *    following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials
+ *    provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY AUTHORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * AUTHORS OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+#include "io_ring.h"
+
+#include <alloca.h>
+#include <assert.h>
+#include <errno.h>
+#include <string.h>
+
+#include "trivia/config.h"
+#include "trivia/util.h"
+#include "diag.h"
+#include "fiber.h"
+#include "say.h"
+
+#if defined(HAVE_IO_URING)
+
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <linux/io_uring.h>
+
+static inline int
+sys_io_uring_setup(unsigned entries, struct io_uring_params *p)
+{
+	return syscall(__NR_io_uring_setup, entries, p);
+}
+
+static inline int
+sys_io_uring_enter(int fd, unsigned to_submit, unsigned min_complete,
+		   unsigned flags)
+{
+	return syscall(__NR_io_uring_enter, fd, to_submit, min_complete,
+		       flags, NULL, 0);
+}
+
+/*
+ * The ring head and tail are updated concurrently by the
+ * kernel, so they must be accessed with proper barriers.
+ */
+static inline unsigned
+io_ring_load(unsigned *p)
+{
+	return __atomic_load_n(p, __ATOMIC_ACQUIRE);
+}
+
+static inline void
+io_ring_store(unsigned *p, unsigned v)
+{
+	__atomic_store_n(p, v, __ATOMIC_RELEASE);
+}
+
+static void
+io_ring_cb(struct ev_loop *loop, struct ev_io *watcher, int events)
+{
+	(void) loop;
+	(void) events;
+	io_ring_reap((struct io_ring *) watcher->data);
+}
+
+int
+io_ring_create(struct io_ring *ring, unsigned entries)
+{
+	memset(ring, 0, sizeof(*ring));
+	ring->fd = -1;
+	ev_io_init(&ring->io, io_ring_cb, -1, EV_READ);
+	ring->io.data = ring;
+
+	struct io_uring_params p;
+	memset(&p, 0, sizeof(p));
+	int fd = sys_io_uring_setup(entries, &p);
+	if (fd < 0) {
+		diag_set(SystemError, "io_uring_setup failed");
+		return -1;
+	}
+	ring->sq_size = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+	ring->cq_size = p.cq_off.cqes +
+			p.cq_entries * sizeof(struct io_uring_cqe);
+	if ((p.features & IORING_FEAT_SINGLE_MMAP) != 0) {
+		ring->sq_size = MAX(ring->sq_size, ring->cq_size);
+		ring->cq_size = ring->sq_size;
+	}
+	ring->sq_ptr = mmap(NULL, ring->sq_size, PROT_READ | PROT_WRITE,
+			    MAP_SHARED | MAP_POPULATE, fd,
+			    IORING_OFF_SQ_RING);
+	if (ring->sq_ptr == MAP_FAILED)
+		goto err_sq;
+	if ((p.features & IORING_FEAT_SINGLE_MMAP) != 0) {
+		ring->cq_ptr = ring->sq_ptr;
+	} else {
+		ring->cq_ptr = mmap(NULL, ring->cq_size,
+				    PROT_READ | PROT_WRITE,
+				    MAP_SHARED | MAP_POPULATE, fd,
+				    IORING_OFF_CQ_RING);
+		if (ring->cq_ptr == MAP_FAILED)
+			goto err_cq;
+	}
+	ring->sqes_size = p.sq_entries * sizeof(struct io_uring_sqe);
+	ring->sqes = mmap(NULL, ring->sqes_size, PROT_READ | PROT_WRITE,
+			  MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+	if (ring->sqes == MAP_FAILED)
+		goto err_sqes;
+
+	char *sq = ring->sq_ptr;
+	ring->sq_head = (unsigned *)(sq + p.sq_off.head);
+	ring->sq_tail = (unsigned *)(sq + p.sq_off.tail);
+	ring->sq_mask = (unsigned *)(sq + p.sq_off.ring_mask);
+	ring->sq_array = (unsigned *)(sq + p.sq_off.array);
+	char *cq = ring->cq_ptr;
+	ring->cq_head = (unsigned *)(cq + p.cq_off.head);
+	ring->cq_tail = (unsigned *)(cq + p.cq_off.tail);
+	ring->cq_mask = (unsigned *)(cq + p.cq_off.ring_mask);
+	ring->cqes = (struct io_uring_cqe *)(cq + p.cq_off.cqes);
+	ring->sq_entries = p.sq_entries;
+	ring->fd = fd;
+	ev_io_set(&ring->io, fd, EV_READ);
+	return 0;
+err_sqes:
+	if (ring->cq_ptr != ring->sq_ptr)
+		munmap(ring->cq_ptr, ring->cq_size);
+err_cq:
+	munmap(ring->sq_ptr, ring->sq_size);
+err_sq:
+	diag_set(SystemError, "failed to map io_uring");
+	close(fd);
+	return -1;
+}
+
+void
+io_ring_destroy(struct io_ring *ring)
+{
+	if (!io_ring_is_created(ring))
+		return;
+	assert(!ev_is_active(&ring->io));
+	munmap(ring->sqes, ring->sqes_size);
+	if (ring->cq_ptr != ring->sq_ptr)
+		munmap(ring->cq_ptr, ring->cq_size);
+	munmap(ring->sq_ptr, ring->sq_size);
+	close(ring->fd);
+	ring->fd = -1;
+}
+
+/**
+ * Get a free submission queue entry. Return NULL and set
+ * errno if there are too many requests in flight: the
+ * completion queue must not overflow.
+ */
+static struct io_uring_sqe *
+io_ring_get_sqe(struct io_ring *ring, struct io_ring_req *req)
+{
+	assert(io_ring_is_created(ring));
+	if (ring->inflight >= ring->sq_entries) {
+		errno = EAGAIN;
+		return NULL;
+	}
+	unsigned tail = *ring->sq_tail;
+	unsigned index = tail & *ring->sq_mask;
+	struct io_uring_sqe *sqe = &ring->sqes[index];
+	memset(sqe, 0, sizeof(*sqe));
+	sqe->user_data = (uint64_t)(uintptr_t)req;
+	ring->sq_array[index] = index;
+	req->res = 0;
+	req->is_done = false;
+	req->on_complete = NULL;
+	req->arg = NULL;
+	return sqe;
+}
+
+/** Pass the entry returned by io_ring_get_sqe() to the kernel. */
+static int
+io_ring_submit(struct io_ring *ring)
+{
+	io_ring_store(ring->sq_tail, *ring->sq_tail + 1);
+	int rc;
+	do {
+		rc = sys_io_uring_enter(ring->fd, 1, 0, 0);
+	} while (rc < 0 && errno == EINTR);
+	if (rc < 0) {
+		/*
+		 * The kernel didn't consume the entry, so
+		 * take it back.
+		 */
+		io_ring_store(ring->sq_tail, *ring->sq_tail - 1);
+		return -1;
+	}
+	ring->inflight++;
+	return 0;
+}
+
+int
+io_ring_fsync(struct io_ring *ring, struct io_ring_req *req,
+	      int fd, bool datasync)
+{
+	struct io_uring_sqe *sqe = io_ring_get_sqe(ring, req);
+	if (sqe == NULL)
+		return -1;
+	sqe->opcode = IORING_OP_FSYNC;
+	sqe->fd = fd;
+	sqe->fsync_flags = datasync ? IORING_FSYNC_DATASYNC : 0;
+	return io_ring_submit(ring);
+}
+
+int
+io_ring_pread(struct io_ring *ring, struct io_ring_req *req,
+	      int fd, void *buf, size_t count, off_t offset)
+{
+	struct io_uring_sqe *sqe = io_ring_get_sqe(ring, req);
+	if (sqe == NULL)
+		return -1;
+	/* IORING_OP_READ needs a newer kernel than READV. */
+	req->iov.iov_base = buf;
+	req->iov.iov_len = count;
+	sqe->opcode = IORING_OP_READV;
+	sqe->fd = fd;
+	sqe->addr = (uint64_t)(uintptr_t)&req->iov;
+	sqe->len = 1;
+	sqe->off = offset;
+	return io_ring_submit(ring);
+}
+
+void
+io_ring_reap(struct io_ring *ring)
+{
+	unsigned head = *ring->cq_head;
+	unsigned tail = io_ring_load(ring->cq_tail);
+	unsigned count = tail - head;
+	if (count == 0)
+		return;
+	struct io_ring_req **done = alloca(count * sizeof(*done));
+	for (unsigned i = 0; head != tail; head++, i++) {
+		struct io_uring_cqe *cqe = &ring->cqes[head & *ring->cq_mask];
+		struct io_ring_req *req;
+		req = (struct io_ring_req *)(uintptr_t)cqe->user_data;
+		req->res = cqe->res;
+		req->is_done = true;
+		done[i] = req;
+		assert(ring->inflight > 0);
+		ring->inflight--;
+	}
+	io_ring_store(ring->cq_head, head);
+	/*
+	 * Run callbacks after the queue is consumed, because
+	 * they may submit new requests.
+	 */
+	for (unsigned i = 0; i < count; i++) {
+		struct io_ring_req *req = done[i];
+		if (req->on_complete != NULL)
+			req->on_complete(req);
+	}
+}
+
+int
+io_ring_wait(struct io_ring *ring, struct io_ring_req *req)
+{
+	while (true) {
+		io_ring_reap(ring);
+		if (req->is_done)
+			break;
+		if (sys_io_uring_enter(ring->fd, 0, 1,
+				       IORING_ENTER_GETEVENTS) < 0 &&
+		    errno != EINTR)
+			panic_syserror("io_uring_enter");
+	}
+	return req->res;
+}
+
+void
+io_ring_start(struct io_ring *ring)
+{
+	ev_io_start(loop(), &ring->io);
+}
+
+void
+io_ring_stop(struct io_ring *ring)
+{
+	ev_io_stop(loop(), &ring->io);
+}
+
+static void
+io_ring_wakeup_cb(struct io_ring_req *req)
+{
+	fiber_wakeup((struct fiber *) req->arg);
+}
+
+int
+io_ring_yield(struct io_ring *ring, struct io_ring_req *req)
+{
+	assert(ev_is_active(&ring->io));
+	(void) ring;
+	req->on_complete = io_ring_wakeup_cb;
+	req->arg = fiber();
+	bool cancellable = fiber_set_cancellable(false);
+	while (!req->is_done)
+		fiber_yield();
+	fiber_set_cancellable(cancellable);
+	return req->res;
+}
+
+#else /* !defined(HAVE_IO_URING) */
+
+int
+io_ring_create(struct io_ring *ring, unsigned entries)
+{
+	(void) entries;
+	memset(ring, 0, sizeof(*ring));
+	ring->fd = -1;
+	errno = ENOSYS;
+	diag_set(SystemError, "io_uring is not supported");
+	return -1;
+}
+
+void
+io_ring_destroy(struct io_ring *ring)
+{
+	(void) ring;
+}
+
+int
+io_ring_fsync(struct io_ring *ring, struct io_ring_req *req,
+	      int fd, bool datasync)
+{
+	(void) ring; (void) req; (void) fd; (void) datasync;
+	unreachable();
+	errno = ENOSYS;
+	return -1;
+}
+
+int
+io_ring_pread(struct io_ring *ring, struct io_ring_req *req,
+	      int fd, void *buf, size_t count, off_t offset)
+{
+	(void) ring; (void) req; (void) fd;
+	(void) buf; (void) count; (void) offset;
+	unreachable();
+	errno = ENOSYS;
+	return -1;
+}
+
+void
+io_ring_reap(struct io_ring *ring)
+{
+	(void) ring;
+}
+
+int
+io_ring_wait(struct io_ring *ring, struct io_ring_req *req)
+{
+	(void) ring;
+	unreachable();
+	return req->res;
+}
+
+void
+io_ring_start(struct io_ring *ring)
+{
+	(void) ring;
+}
+
+void
+io_ring_stop(struct io_ring *ring)
+{
+	(void) ring;
+}
+
+int
+io_ring_yield(struct io_ring *ring, struct io_ring_req *req)
+{
+	(void) ring;
+	unreachable();
+	return req->res;
+}
+
+#endif /* defined(HAVE_IO_URING) */
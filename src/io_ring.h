@@ -0,0 +1,186 @@
+#ifndef TARANTOOL_IO_RING_H_INCLUDED
+#define TARANTOOL_IO_RING_H_INCLUDED
+/*
+ * Copyright 2010-2018, Tarantool AUTHORS, please see AUTHORS file.
+ *
+ * Redistribution and use in source and binary forms, with or
+ * without modification, are permitted provided that the following
+ * conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above
+ *    copyright notice, this list of conditions and the
+ *    following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials
+ *    provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY AUTHORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * AUTHORS OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+#include <sys/uio.h>
+
+#include "tarantool_ev.h"
+
+#if defined(__cplusplus)
+extern "C" {
+#endif /* defined(__cplusplus) */
+
+/**
+ * A thin wrapper around Linux io_uring: a pair of rings shared
+ * with the kernel, one for submitting I/O requests and another
+ * one for reaping their results, which lets a thread have many
+ * requests in flight without blocking on any of them.
+ *
+ * A ring may only be used by one thread at a time. If the
+ * kernel or the build lacks io_uring support, io_ring_create()
+ * fails and the caller is supposed to fall back on plain
+ * blocking I/O.
+ */
+struct io_ring {
+	/** Ring file descriptor or -1 if the ring isn't created. */
+	int fd;
+	/** Number of submitted requests that haven't completed. */
+	unsigned inflight;
+	/** Number of entries in the submission queue. */
+	unsigned sq_entries;
+	/* Submission queue, shared with the kernel. */
+	unsigned *sq_head;
+	unsigned *sq_tail;
+	unsigned *sq_mask;
+	unsigned *sq_array;
+	struct io_uring_sqe *sqes;
+	/* Completion queue, shared with the kernel. */
+	unsigned *cq_head;
+	unsigned *cq_tail;
+	unsigned *cq_mask;
+	struct io_uring_cqe *cqes;
+	/* Memory mapped from the ring fd. */
+	void *sq_ptr;
+	size_t sq_size;
+	void *cq_ptr;
+	size_t cq_size;
+	size_t sqes_size;
+	/**
+	 * Watcher reaping completions from the event loop,
+	 * see io_ring_start().
+	 */
+	struct ev_io io;
+};
+
+/** An I/O request submitted to a ring. */
+struct io_ring_req {
+	/** Buffer of a read request. */
+	struct iovec iov;
+	/**
+	 * Result of the request: the return value of the
+	 * corresponding system call or -errno on failure.
+	 */
+	int res;
+	/** Set when the request is complete. */
+	bool is_done;
+	/**
+	 * Function called when the request completes or NULL.
+	 * Set it after the request is submitted.
+	 */
+	void (*on_complete)(struct io_ring_req *req);
+	/** Argument of @on_complete. */
+	void *arg;
+};
+
+/**
+ * Create a ring with room for @entries requests in flight.
+ * Return 0 on success, -1 if io_uring isn't supported or
+ * the ring couldn't be set up, in which case diag is set.
+ */
+int
+io_ring_create(struct io_ring *ring, unsigned entries);
+
+/**
+ * Destroy a ring. Requests still in flight are abandoned:
+ * their callbacks will never be called.
+ */
+void
+io_ring_destroy(struct io_ring *ring);
+
+/** Return true if the ring was successfully created. */
+static inline bool
+io_ring_is_created(const struct io_ring *ring)
+{
+	return ring->fd >= 0;
+}
+
+/**
+ * Submit fsync(2), or fdatasync(2) if @datasync is set,
+ * of file @fd. Return 0 on success, -1 on failure, in which
+ * case errno is set (EAGAIN if the ring is full) and the
+ * caller is expected to sync the file by itself.
+ */
+int
+io_ring_fsync(struct io_ring *ring, struct io_ring_req *req,
+	      int fd, bool datasync);
+
+/**
+ * Submit pread(2) of @count bytes at @offset of file @fd
+ * to @buf. Return value is the same as of io_ring_fsync().
+ */
+int
+io_ring_pread(struct io_ring *ring, struct io_ring_req *req,
+	      int fd, void *buf, size_t count, off_t offset);
+
+/**
+ * Process all completed requests: set their results and
+ * invoke their completion callbacks.
+ */
+void
+io_ring_reap(struct io_ring *ring);
+
+/**
+ * Block the calling thread until request @req completes.
+ * Completion callbacks of this and other requests may be
+ * invoked meanwhile. Return the result of the request.
+ */
+int
+io_ring_wait(struct io_ring *ring, struct io_ring_req *req);
+
+/**
+ * Start reaping completions from the event loop of the
+ * calling thread, see io_ring_yield().
+ */
+void
+io_ring_start(struct io_ring *ring);
+
+/** Stop reaping completions started by io_ring_start(). */
+void
+io_ring_stop(struct io_ring *ring);
+
+/**
+ * Yield the current fiber until request @req completes.
+ * The ring must be started with io_ring_start(). The fiber
+ * isn't cancellable while waiting, because the request may
+ * refer to its memory. Return the result of the request.
+ */
+int
+io_ring_yield(struct io_ring *ring, struct io_ring_req *req);
+
+#if defined(__cplusplus)
+} /* extern "C" */
+#endif /* defined(__cplusplus) */
+
+#endif /* TARANTOOL_IO_RING_H_INCLUDED */
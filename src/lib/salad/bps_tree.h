@@ -136,6 +136,8 @@
  *                      alloc_ctx);
  * void bps_tree_destroy(tree);
  * int bps_tree_build(tree, sorted_array, array_size);
+ * size_t bps_tree_build_leaf_count(array_size);
+ * int bps_tree_build_prepare(tree, sorted_array, array_size, leaves);
  * bps_tree_elem_t *bps_tree_find(tree, key);
  * int bps_tree_insert(tree, new_elem, replaced_elem);
  * int bps_tree_insert_get_iterator(tree, new_elem, replaced_elem,
@@ -347,6 +349,10 @@ typedef uint32_t bps_tree_block_id_t;
 
 #define bps_tree_create _api_name(create)
 #define bps_tree_build _api_name(build)
+#define bps_tree_build_leaf _api_name(build_leaf)
+#define bps_tree_build_leaf_count _api_name(build_leaf_count)
+#define bps_tree_build_prepare _api_name(build_prepare)
+#define bps_tree_build_impl _bps_tree(build_impl)
 #define bps_tree_destroy _api_name(destroy)
 #define bps_tree_find _api_name(find)
 #define bps_tree_insert _api_name(insert)
@@ -583,6 +589,44 @@ static inline int
 bps_tree_build(struct bps_tree *tree, bps_tree_elem_t *sorted_array,
 	       size_t array_size);
 
+/**
+ * A leaf of a tree built with bps_tree_build_prepare(),
+ * which is yet to be filled with elements.
+ */
+struct bps_tree_build_leaf {
+	/** Leaf elements to fill. */
+	bps_tree_elem_t *elems;
+	/** Offset of the first element in the sorted array. */
+	size_t offset;
+	/** Number of elements in the leaf. */
+	size_t count;
+};
+
+/**
+ * @brief Number of leaves of a tree built from an array.
+ * @param array_size - size of the array (count of elements)
+ * @return number of leaves
+ */
+static inline size_t
+bps_tree_build_leaf_count(size_t array_size);
+
+/**
+ * @brief Same as bps_tree_build(), but leaves are not filled
+ *  with elements. Instead, their description is stored in the
+ *  @a leaves array, which must have room for
+ *  bps_tree_build_leaf_count() entries. The caller must copy
+ *  the elements to the leaves before using the tree, which can
+ *  be done in several threads.
+ * @param tree - pointer to a tree
+ * @param sorted_array - pointer to the sorted array
+ * @param array_size - size of the array (count of elements)
+ * @param leaves - leaves to fill
+ * @return 0 on success, -1 on memory error
+ */
+static inline int
+bps_tree_build_prepare(struct bps_tree *tree, bps_tree_elem_t *sorted_array,
+		       size_t array_size, struct bps_tree_build_leaf *leaves);
+
 /**
  * @brief Tree destruction. Frees allocated memory.
  * @param tree - pointer to a tree
@@ -1081,17 +1125,21 @@ bps_tree_create(struct bps_tree *tree, bps_tree_arg_t arg,
 #endif
 }
 
+static inline size_t
+bps_tree_build_leaf_count(size_t array_size)
+{
+	return (array_size + BPS_TREE_MAX_COUNT_IN_LEAF - 1) /
+	       BPS_TREE_MAX_COUNT_IN_LEAF;
+}
+
 /**
  * @brief Fills a new (asserted) tree with values from sorted array.
- *  Elements are copied from the array. Array is not checked to be sorted!
- * @param tree - pointer to a tree
- * @param sorted_array - pointer to the sorted array
- * @param array_size - size of the array (count of elements)
- * @return 0 on success, -1 on memory error
+ *  If @a leaves is not NULL, elements are not copied to leaves,
+ *  see bps_tree_build_prepare().
  */
 static inline int
-bps_tree_build(struct bps_tree *tree, bps_tree_elem_t *sorted_array,
-	       size_t array_size)
+bps_tree_build_impl(struct bps_tree *tree, bps_tree_elem_t *sorted_array,
+		    size_t array_size, struct bps_tree_build_leaf *leaves)
 {
 	assert(tree->size == 0);
 	assert(tree->root_id == (bps_tree_block_id_t)(-1));
@@ -1151,8 +1199,15 @@ bps_tree_build(struct bps_tree *tree, bps_tree_elem_t *sorted_array,
 		leaf->header.size = elems_left / leaf_left;
 		leaf->prev_id = prev_leaf_id;
 		prev_leaf_id = id;
-		memmove(leaf->elems, current,
-			leaf->header.size * sizeof(*current));
+		if (leaves == NULL) {
+			memmove(leaf->elems, current,
+				leaf->header.size * sizeof(*current));
+		} else {
+			leaves->elems = leaf->elems;
+			leaves->offset = current - sorted_array;
+			leaves->count = leaf->header.size;
+			leaves++;
+		}
 
 		bps_tree_block_id_t insert_id = id;
 		for (bps_tree_block_id_t i = 0; i < depth - 1; i++) {
@@ -1223,6 +1278,29 @@ bps_tree_build(struct bps_tree *tree, bps_tree_elem_t *sorted_array,
 	return 0;
 }
 
+/**
+ * @brief Fills a new (asserted) tree with values from sorted array.
+ *  Elements are copied from the array. Array is not checked to be sorted!
+ * @param tree - pointer to a tree
+ * @param sorted_array - pointer to the sorted array
+ * @param array_size - size of the array (count of elements)
+ * @return 0 on success, -1 on memory error
+ */
+static inline int
+bps_tree_build(struct bps_tree *tree, bps_tree_elem_t *sorted_array,
+	       size_t array_size)
+{
+	return bps_tree_build_impl(tree, sorted_array, array_size, NULL);
+}
+
+static inline int
+bps_tree_build_prepare(struct bps_tree *tree, bps_tree_elem_t *sorted_array,
+		       size_t array_size, struct bps_tree_build_leaf *leaves)
+{
+	assert(leaves != NULL);
+	return bps_tree_build_impl(tree, sorted_array, array_size, leaves);
+}
+
 /**
  * @brief Tree destruction. Frees allocated memory.
  * @param tree - pointer to a tree
@@ -6021,6 +6099,10 @@ bps_tree_debug_check_internal_functions(bool assertme)
 
 #undef bps_tree_create
 #undef bps_tree_build
+#undef bps_tree_build_leaf
+#undef bps_tree_build_leaf_count
+#undef bps_tree_build_prepare
+#undef bps_tree_build_impl
 #undef bps_tree_destroy
 #undef bps_tree_find
 #undef bps_tree_insert
@@ -0,0 +1,344 @@
+/*
+ * Copyright 2010-2018, Tarantool AUTHORS, please see AUTHORS file.
+ *
+ * Redistribution and use in source and binary forms, with or
+ * without modification, are permitted provided that the following
+ * conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above
+ *    copyright notice, this list of conditions and the
+ *    following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials
+ *    provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY <COPYRIGHT HOLDER> ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * <COPYRIGHT HOLDER> OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include "xor_filter.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <math.h>
+#include <assert.h>
+#include <string.h>
+
+enum {
+	/** Max length of a segment, as suggested by the paper. */
+	XOR_FILTER_SEGMENT_LENGTH_MAX = 1 << 18,
+	/**
+	 * Number of failed construction attempts after which
+	 * the table is enlarged by one segment. Construction
+	 * fails with a very low probability so it is unlikely
+	 * to ever happen with distinct hashes.
+	 */
+	XOR_FILTER_ATTEMPTS_PER_SIZE = 10,
+};
+
+/**
+ * Choose segment_length and segment_count for the given number
+ * of values. The constants were found empirically by the paper
+ * authors for the arity of 3.
+ */
+static void
+xor_filter_set_size(struct xor_filter *filter, uint32_t count)
+{
+	uint32_t segment_length = 4;
+	if (count > 0) {
+		int shift = floor(log(count) / log(3.33) + 2.25);
+		segment_length = 1U << shift;
+	}
+	if (segment_length > XOR_FILTER_SEGMENT_LENGTH_MAX)
+		segment_length = XOR_FILTER_SEGMENT_LENGTH_MAX;
+	double size_factor = 0;
+	if (count > 1)
+		size_factor = fmax(1.125, 0.875 + 0.25 * log(1000000.0) /
+				   log(count));
+	uint64_t capacity = round(count * size_factor);
+	uint64_t segment_count = (capacity + segment_length - 1) /
+				 segment_length;
+	if (segment_count <= XOR_FILTER_ARITY - 1)
+		segment_count = 1;
+	else
+		segment_count -= XOR_FILTER_ARITY - 1;
+	filter->segment_length = segment_length;
+	filter->segment_count = segment_count;
+	filter->segment_count_length = segment_count * segment_length;
+}
+
+/** Number of fingerprints in the table. */
+static inline uint32_t
+xor_filter_table_size(const struct xor_filter *filter)
+{
+	return (filter->segment_count + XOR_FILTER_ARITY - 1) *
+		filter->segment_length;
+}
+
+/** splitmix64 generator, used for choosing the seed. */
+static inline uint64_t
+xor_filter_next_seed(uint64_t *state)
+{
+	uint64_t z = (*state += 0x9e3779b97f4a7c15ULL);
+	z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+	z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+	return z ^ (z >> 31);
+}
+
+static int
+xor_filter_hash_cmp(const void *a, const void *b)
+{
+	xor_filter_hash_t h1 = *(const xor_filter_hash_t *)a;
+	xor_filter_hash_t h2 = *(const xor_filter_hash_t *)b;
+	return h1 < h2 ? -1 : h1 > h2;
+}
+
+/**
+ * Sort an array of hashes and remove duplicates from it.
+ * Return the number of unique hashes.
+ */
+static uint32_t
+xor_filter_hash_unique(xor_filter_hash_t *hashes, uint32_t count)
+{
+	if (count == 0)
+		return 0;
+	qsort(hashes, count, sizeof(*hashes), xor_filter_hash_cmp);
+	uint32_t unique = 1;
+	for (uint32_t i = 1; i < count; i++) {
+		if (hashes[i] != hashes[unique - 1])
+			hashes[unique++] = hashes[i];
+	}
+	return unique;
+}
+
+/**
+ * Scratch memory used while building a filter.
+ */
+struct xor_filter_builder {
+	/**
+	 * For each cell: the number of values mapped to it
+	 * shifted left by 2, xored with the indexes (0..2) of
+	 * the cell among the cells of each value. When a cell
+	 * has exactly one value left, the lower two bits give
+	 * the index of the cell among the cells of the value.
+	 */
+	uint8_t *cell_count;
+	/** For each cell: xor of hashes of values mapped to it. */
+	uint64_t *cell_hash;
+	/** Queue of cells that have exactly one value left. */
+	uint32_t *queue;
+	/** Hashes of peeled values, in order of peeling. */
+	uint64_t *stack_hash;
+	/** Index of the cell each peeled value was peeled at. */
+	uint8_t *stack_cell;
+};
+
+static void
+xor_filter_builder_destroy(struct xor_filter_builder *builder)
+{
+	free(builder->cell_count);
+	free(builder->cell_hash);
+	free(builder->queue);
+	free(builder->stack_hash);
+	free(builder->stack_cell);
+}
+
+static int
+xor_filter_builder_create(struct xor_filter_builder *builder,
+			  uint32_t table_size, uint32_t count)
+{
+	builder->cell_count = malloc(table_size * sizeof(uint8_t));
+	builder->cell_hash = malloc(table_size * sizeof(uint64_t));
+	builder->queue = malloc(table_size * sizeof(uint32_t));
+	builder->stack_hash = malloc((count + 1) * sizeof(uint64_t));
+	builder->stack_cell = malloc((count + 1) * sizeof(uint8_t));
+	if (builder->cell_count == NULL || builder->cell_hash == NULL ||
+	    builder->queue == NULL || builder->stack_hash == NULL ||
+	    builder->stack_cell == NULL) {
+		xor_filter_builder_destroy(builder);
+		return -1;
+	}
+	return 0;
+}
+
+/**
+ * Try to peel the hypergraph formed by the values with the
+ * current seed and fill the table. Return false if the graph
+ * has a cycle, in which case another seed must be tried.
+ */
+static bool
+xor_filter_try_build(struct xor_filter *filter,
+		     struct xor_filter_builder *builder,
+		     const xor_filter_hash_t *hashes, uint32_t count)
+{
+	uint32_t table_size = xor_filter_table_size(filter);
+	uint8_t *cell_count = builder->cell_count;
+	uint64_t *cell_hash = builder->cell_hash;
+	memset(cell_count, 0, table_size * sizeof(*cell_count));
+	memset(cell_hash, 0, table_size * sizeof(*cell_hash));
+
+	uint32_t cells[XOR_FILTER_ARITY];
+	for (uint32_t i = 0; i < count; i++) {
+		uint64_t h = xor_filter_mix(hashes[i], filter->seed);
+		xor_filter_cells(filter, h, cells);
+		for (uint32_t j = 0; j < XOR_FILTER_ARITY; j++) {
+			uint32_t c = cells[j];
+			/* The counter has 6 bits, check for overflow. */
+			if (cell_count[c] >= 0xfc)
+				return false;
+			cell_count[c] += 4;
+			cell_count[c] ^= j;
+			cell_hash[c] ^= h;
+		}
+	}
+
+	uint32_t queue_size = 0;
+	for (uint32_t c = 0; c < table_size; c++) {
+		if ((cell_count[c] >> 2) == 1)
+			builder->queue[queue_size++] = c;
+	}
+	uint32_t stack_size = 0;
+	while (queue_size > 0) {
+		uint32_t c = builder->queue[--queue_size];
+		if ((cell_count[c] >> 2) != 1)
+			continue;
+		uint64_t h = cell_hash[c];
+		uint8_t found = cell_count[c] & 3;
+		builder->stack_hash[stack_size] = h;
+		builder->stack_cell[stack_size] = found;
+		stack_size++;
+		xor_filter_cells(filter, h, cells);
+		assert(cells[found] == c);
+		for (uint32_t j = 0; j < XOR_FILTER_ARITY; j++) {
+			uint32_t other = cells[j];
+			if ((cell_count[other] >> 2) == 2)
+				builder->queue[queue_size++] = other;
+			cell_count[other] -= 4;
+			cell_count[other] ^= j;
+			cell_hash[other] ^= h;
+		}
+	}
+	if (stack_size != count)
+		return false;
+
+	/*
+	 * Assign fingerprints in the reverse peeling order:
+	 * by the time a value is processed, the other two cells
+	 * it maps to are final, so the cell it was peeled at
+	 * can be set to make the xor match the fingerprint.
+	 */
+	uint8_t *table = filter->table;
+	memset(table, 0, table_size);
+	for (uint32_t i = stack_size; i-- > 0; ) {
+		uint64_t h = builder->stack_hash[i];
+		uint8_t found = builder->stack_cell[i];
+		xor_filter_cells(filter, h, cells);
+		table[cells[found]] = xor_filter_fingerprint(h) ^
+			table[cells[(found + 1) % 3]] ^
+			table[cells[(found + 2) % 3]];
+	}
+	return true;
+}
+
+int
+xor_filter_create(struct xor_filter *filter, xor_filter_hash_t *hashes,
+		  uint32_t count, struct quota *quota)
+{
+	count = xor_filter_hash_unique(hashes, count);
+	xor_filter_set_size(filter, count);
+	uint64_t seed_state = count;
+	for (;;) {
+		uint32_t table_size = xor_filter_table_size(filter);
+		if (quota_use(quota, table_size) < 0)
+			return -1;
+		filter->table = malloc(table_size);
+		if (filter->table == NULL) {
+			quota_release(quota, table_size);
+			return -1;
+		}
+		struct xor_filter_builder builder;
+		if (xor_filter_builder_create(&builder, table_size,
+					      count) != 0) {
+			xor_filter_destroy(filter, quota);
+			return -1;
+		}
+		bool ok = false;
+		for (uint32_t i = 0; i < XOR_FILTER_ATTEMPTS_PER_SIZE; i++) {
+			filter->seed = xor_filter_next_seed(&seed_state);
+			if (xor_filter_try_build(filter, &builder,
+						 hashes, count)) {
+				ok = true;
+				break;
+			}
+		}
+		xor_filter_builder_destroy(&builder);
+		if (ok)
+			return 0;
+		/* Unlucky. Enlarge the table and retry. */
+		xor_filter_destroy(filter, quota);
+		filter->segment_count++;
+		filter->segment_count_length += filter->segment_length;
+	}
+}
+
+void
+xor_filter_destroy(struct xor_filter *filter, struct quota *quota)
+{
+	quota_release(quota, xor_filter_table_size(filter));
+	free(filter->table);
+}
+
+double
+xor_filter_fpr(const struct xor_filter *filter)
+{
+	(void)filter;
+	return 1.0 / 256;
+}
+
+size_t
+xor_filter_store_size(const struct xor_filter *filter)
+{
+	return xor_filter_table_size(filter);
+}
+
+char *
+xor_filter_store(const struct xor_filter *filter, char *table)
+{
+	size_t store_size = xor_filter_store_size(filter);
+	memcpy(table, filter->table, store_size);
+	return table + store_size;
+}
+
+int
+xor_filter_load_table(struct xor_filter *filter, const char *table,
+		      struct quota *quota)
+{
+	filter->segment_count_length = filter->segment_count *
+				       filter->segment_length;
+	size_t size = xor_filter_table_size(filter);
+	if (quota_use(quota, size) < 0) {
+		filter->table = NULL;
+		return -1;
+	}
+	filter->table = malloc(size);
+	if (filter->table == NULL) {
+		quota_release(quota, size);
+		return -1;
+	}
+	memcpy(filter->table, table, size);
+	return 0;
+}
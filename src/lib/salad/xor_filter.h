@@ -0,0 +1,223 @@
+#ifndef TARANTOOL_XOR_FILTER_H_INCLUDED
+#define TARANTOOL_XOR_FILTER_H_INCLUDED
+/*
+ * Copyright 2010-2018, Tarantool AUTHORS, please see AUTHORS file.
+ *
+ * Redistribution and use in source and binary forms, with or
+ * without modification, are permitted provided that the following
+ * conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above
+ *    copyright notice, this list of conditions and the
+ *    following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials
+ *    provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY <COPYRIGHT HOLDER> ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * <COPYRIGHT HOLDER> OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/* Binary fuse filter, a static approximate membership filter
+ * that needs about 9 bits per value for the false positive rate
+ * of 1/256, compared to about 10 bits per value needed by a bloom
+ * filter for the false positive rate of 1/100:
+ *  Graf, Thomas Mueller; Lemire, Daniel (2022),
+ *  "Binary Fuse Filters: Fast and Smaller Than Xor Filters"
+ *  https://arxiv.org/abs/2201.01174
+ *
+ * Every value is mapped to three cells in three consecutive
+ * segments of the fingerprint table. The xor of the three cells
+ * equals the fingerprint of the value. Unlike a bloom filter,
+ * the filter can't be updated once built: all values must be
+ * known in advance.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "small/quota.h"
+
+#if defined(__cplusplus)
+extern "C" {
+#endif /* defined(__cplusplus) */
+
+enum {
+	/** Number of segments a value is mapped to. */
+	XOR_FILTER_ARITY = 3,
+};
+
+typedef uint32_t xor_filter_hash_t;
+
+/**
+ * Binary fuse filter data structure
+ */
+struct xor_filter {
+	/* Seed used for mixing value hashes */
+	uint64_t seed;
+	/* Number of fingerprints in a segment, a power of two */
+	uint32_t segment_length;
+	/* Number of segments a value's first cell may belong to */
+	uint32_t segment_count;
+	/* segment_count * segment_length, cached for lookups */
+	uint32_t segment_count_length;
+	/* Fingerprint table of (segment_count + 2) segments */
+	uint8_t *table;
+};
+
+/* {{{ API declaration */
+
+/**
+ * Build a filter storing the given set of values
+ *
+ * @param filter - structure to initialize
+ * @param hashes - hashes of the values, may contain duplicates;
+ *  note, the array is sorted and deduplicated in place
+ * @param count - number of hashes in the array
+ * @param quota - quota for memory allocation
+ * @return 0 - OK, -1 - memory error
+ */
+int
+xor_filter_create(struct xor_filter *filter, xor_filter_hash_t *hashes,
+		  uint32_t count, struct quota *quota);
+
+/**
+ * Free resources of the filter
+ *
+ * @param filter - the filter
+ * @param quota - quota for memory deallocation
+ */
+void
+xor_filter_destroy(struct xor_filter *filter, struct quota *quota);
+
+/**
+ * Query for presence of a value in the data set
+ * @param filter - the filter
+ * @param hash - hash of the value
+ * @return true - the value could be in data set; false - the value is
+ *  definitively not in data set
+ */
+static bool
+xor_filter_maybe_has(const struct xor_filter *filter, xor_filter_hash_t hash);
+
+/**
+ * Return the expected false positive rate of a filter.
+ * It doesn't depend on the number of stored values.
+ */
+double
+xor_filter_fpr(const struct xor_filter *filter);
+
+/**
+ * Calculate size of a buffer that is needed for storing filter table
+ * @param filter - the filter to store
+ * @return - Exact size
+ */
+size_t
+xor_filter_store_size(const struct xor_filter *filter);
+
+/**
+ * Store filter table to the given buffer
+ * seed, segment_length and segment_count must be stored manually.
+ * @param filter - the filter to store
+ * @param table - buffer to store to
+ * @return - end of written buffer
+ */
+char *
+xor_filter_store(const struct xor_filter *filter, char *table);
+
+/**
+ * Allocate table and load it from given buffer.
+ * seed, segment_length and segment_count must be loaded manually
+ * before calling this function.
+ *
+ * @param filter - structure to load to
+ * @param table - data to load
+ * @param quota - quota for memory allocation
+ * @return 0 - OK, -1 - memory error
+ */
+int
+xor_filter_load_table(struct xor_filter *filter, const char *table,
+		      struct quota *quota);
+
+/* }}} API declaration */
+
+/* {{{ API definition */
+
+/**
+ * Extend a value hash to 64 bits. The function is a bijection
+ * (murmur3 finalizer) so distinct hashes never collide.
+ */
+static inline uint64_t
+xor_filter_mix(xor_filter_hash_t hash, uint64_t seed)
+{
+	uint64_t h = hash + seed;
+	h ^= h >> 33;
+	h *= 0xff51afd7ed558ccdULL;
+	h ^= h >> 33;
+	h *= 0xc4ceb9fe1a85ec53ULL;
+	h ^= h >> 33;
+	return h;
+}
+
+static inline uint8_t
+xor_filter_fingerprint(uint64_t hash)
+{
+	return (uint8_t)(hash ^ (hash >> 32));
+}
+
+/**
+ * Calculate the three cells a value is mapped to. The first one
+ * is chosen uniformly among segment_count segments, the other two
+ * belong to the next two segments.
+ */
+static inline void
+xor_filter_cells(const struct xor_filter *filter, uint64_t hash,
+		 uint32_t cells[XOR_FILTER_ARITY])
+{
+	/*
+	 * (hash * segment_count_length) >> 64 without 128-bit
+	 * arithmetic, exact since segment_count_length < 2^32.
+	 */
+	uint64_t scl = filter->segment_count_length;
+	uint64_t lo = ((hash & 0xffffffffULL) * scl) >> 32;
+	uint32_t pos = ((hash >> 32) * scl + lo) >> 32;
+	uint32_t mask = filter->segment_length - 1;
+	cells[0] = pos;
+	cells[1] = (pos + filter->segment_length) ^
+		   ((uint32_t)(hash >> 18) & mask);
+	cells[2] = (pos + 2 * filter->segment_length) ^
+		   ((uint32_t)hash & mask);
+}
+
+static inline bool
+xor_filter_maybe_has(const struct xor_filter *filter, xor_filter_hash_t hash)
+{
+	uint64_t h = xor_filter_mix(hash, filter->seed);
+	uint32_t cells[XOR_FILTER_ARITY];
+	xor_filter_cells(filter, h, cells);
+	uint8_t f = xor_filter_fingerprint(h);
+	f ^= filter->table[cells[0]] ^ filter->table[cells[1]] ^
+	     filter->table[cells[2]];
+	return f == 0;
+}
+
+/* }}} API definition */
+
+#if defined(__cplusplus)
+} /* extern "C" */
+#endif /* defined(__cplusplus) */
+
+#endif /* TARANTOOL_XOR_FILTER_H_INCLUDED */
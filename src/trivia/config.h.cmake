@@ -166,6 +166,11 @@
 #cmakedefine HAVE_PTHREAD_YIELD 1
 #cmakedefine HAVE_SCHED_YIELD 1
 #cmakedefine HAVE_POSIX_FADVISE 1
+/*
+ * Defined if Linux io_uring is available at build time,
+ * see io_ring.h.
+ */
+#cmakedefine HAVE_IO_URING 1
 #cmakedefine HAVE_MREMAP 1
 
 #cmakedefine HAVE_PRCTL_H 1
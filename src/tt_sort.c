@@ -0,0 +1,287 @@
+/*
+ * Copyright 2010-2018, Tarantool AUTHORS, please see AUTHORS file.
+ *
+ * Redistribution and use in source and binary forms, with or
+ * without modification, are permitted provided that the following
+ * conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above
+ *    copyright notice, this list of conditions and the
+ *    following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials
+ *    provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY AUTHORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * AUTHORS OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+#include "tt_sort.h"
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <third_party/qsort_arg.h>
+
+#include "trivia/util.h"
+#include "fiber.h"
+
+enum {
+	/**
+	 * Min number of elements sorted by a thread. Smaller
+	 * arrays are sorted in fewer threads.
+	 */
+	TT_SORT_THREAD_ELEM_MIN = 10000,
+};
+
+/** Argument of a tt_parallel() thread. */
+struct tt_parallel_arg {
+	tt_parallel_f f;
+	void *arg;
+	int thread_id;
+	int thread_count;
+	/** Set if the thread was started. */
+	bool is_started;
+};
+
+static int
+tt_parallel_worker_f(va_list ap)
+{
+	struct tt_parallel_arg *a = va_arg(ap, struct tt_parallel_arg *);
+	a->f(a->arg, a->thread_id, a->thread_count);
+	return 0;
+}
+
+void
+tt_parallel(tt_parallel_f f, void *arg, int thread_count)
+{
+	if (thread_count <= 1) {
+		f(arg, 0, 1);
+		return;
+	}
+	struct cord *cords = calloc(thread_count, sizeof(*cords));
+	struct tt_parallel_arg *args = calloc(thread_count, sizeof(*args));
+	if (cords == NULL || args == NULL) {
+		free(cords);
+		free(args);
+		for (int i = 0; i < thread_count; i++)
+			f(arg, i, thread_count);
+		return;
+	}
+	for (int i = 1; i < thread_count; i++) {
+		char name[FIBER_NAME_MAX];
+		snprintf(name, sizeof(name), "parallel%d", i);
+		args[i].f = f;
+		args[i].arg = arg;
+		args[i].thread_id = i;
+		args[i].thread_count = thread_count;
+		args[i].is_started = cord_costart(&cords[i], name,
+						  tt_parallel_worker_f,
+						  &args[i]) == 0;
+		if (!args[i].is_started)
+			diag_clear(diag_get());
+	}
+	f(arg, 0, thread_count);
+	for (int i = 1; i < thread_count; i++) {
+		if (args[i].is_started)
+			cord_join(&cords[i]);
+		else
+			f(arg, i, thread_count);
+	}
+	free(cords);
+	free(args);
+}
+
+/** State of a parallel sort. */
+struct tt_sort {
+	/** The array to sort. */
+	char *data;
+	/** Number of elements in the array. */
+	size_t elem_count;
+	/** Size of an element. */
+	size_t elem_size;
+	/** Comparator and its argument. */
+	int (*cmp)(const void *a, const void *b, void *arg);
+	void *arg;
+	/** Number of threads, which is also the number of chunks. */
+	int thread_count;
+	/** Merge source and destination. */
+	const char *src;
+	char *dst;
+	/** Number of sorted chunks in a merge source run. */
+	int run_chunks;
+};
+
+/** Index of the first element of a chunk. */
+static inline size_t
+tt_sort_chunk_begin(const struct tt_sort *sort, int chunk)
+{
+	return sort->elem_count * chunk / sort->thread_count;
+}
+
+static inline void
+tt_sort_copy_elem(const struct tt_sort *sort, char *dst, const char *src)
+{
+	if (sort->elem_size == sizeof(void *))
+		*(void **)dst = *(void **)src;
+	else
+		memcpy(dst, src, sort->elem_size);
+}
+
+/** Sort a chunk of the array. */
+static void
+tt_sort_chunk_f(void *arg, int thread_id, int thread_count)
+{
+	(void)thread_count;
+	struct tt_sort *sort = (struct tt_sort *)arg;
+	size_t begin = tt_sort_chunk_begin(sort, thread_id);
+	size_t end = tt_sort_chunk_begin(sort, thread_id + 1);
+	qsort_arg_st(sort->data + begin * sort->elem_size, end - begin,
+		     sort->elem_size, sort->cmp, sort->arg);
+}
+
+/**
+ * Return the number of elements of sorted run @a a among the
+ * first @a k elements of the result of merging @a a and @a b.
+ * Elements of @a a go first if equal, so that merge is stable.
+ */
+static size_t
+tt_sort_corank(const struct tt_sort *sort, const char *a, size_t a_len,
+	       const char *b, size_t b_len, size_t k)
+{
+	size_t es = sort->elem_size;
+	size_t lo = k > b_len ? k - b_len : 0;
+	size_t hi = k < a_len ? k : a_len;
+	while (lo < hi) {
+		size_t i = lo + (hi - lo) / 2;
+		size_t j = k - i;
+		if (sort->cmp(a + i * es, b + (j - 1) * es, sort->arg) <= 0)
+			lo = i + 1;
+		else
+			hi = i;
+	}
+	return lo;
+}
+
+/** Merge two sorted runs. */
+static void
+tt_sort_merge(const struct tt_sort *sort, const char *a, size_t a_len,
+	      const char *b, size_t b_len, char *dst)
+{
+	size_t es = sort->elem_size;
+	const char *a_end = a + a_len * es;
+	const char *b_end = b + b_len * es;
+	while (a < a_end && b < b_end) {
+		if (sort->cmp(b, a, sort->arg) < 0) {
+			tt_sort_copy_elem(sort, dst, b);
+			b += es;
+		} else {
+			tt_sort_copy_elem(sort, dst, a);
+			a += es;
+		}
+		dst += es;
+	}
+	memcpy(dst, a, a_end - a);
+	dst += a_end - a;
+	memcpy(dst, b, b_end - b);
+}
+
+/**
+ * Merge pairs of runs of sort->run_chunks chunks each. Every
+ * thread produces the part of the output which corresponds to
+ * its chunk, so the work is evenly distributed regardless of
+ * the number of runs.
+ */
+static void
+tt_sort_merge_f(void *arg, int thread_id, int thread_count)
+{
+	struct tt_sort *sort = (struct tt_sort *)arg;
+	size_t es = sort->elem_size;
+	size_t out_begin = tt_sort_chunk_begin(sort, thread_id);
+	size_t out_end = tt_sort_chunk_begin(sort, thread_id + 1);
+	int width = sort->run_chunks;
+	for (int first = 0; first < thread_count; first += 2 * width) {
+		int mid = MIN(first + width, thread_count);
+		int last = MIN(first + 2 * width, thread_count);
+		size_t lo = tt_sort_chunk_begin(sort, first);
+		size_t m = tt_sort_chunk_begin(sort, mid);
+		size_t hi = tt_sort_chunk_begin(sort, last);
+		if (hi <= out_begin || lo >= out_end)
+			continue;
+		const char *a = sort->src + lo * es;
+		const char *b = sort->src + m * es;
+		size_t a_len = m - lo;
+		size_t b_len = hi - m;
+		size_t k1 = MAX(lo, out_begin) - lo;
+		size_t k2 = MIN(hi, out_end) - lo;
+		size_t i1 = tt_sort_corank(sort, a, a_len, b, b_len, k1);
+		size_t i2 = tt_sort_corank(sort, a, a_len, b, b_len, k2);
+		tt_sort_merge(sort, a + i1 * es, i2 - i1,
+			      b + (k1 - i1) * es, (k2 - i2) - (k1 - i1),
+			      sort->dst + (lo + k1) * es);
+	}
+}
+
+/** Copy the result of the last merge to the array. */
+static void
+tt_sort_copy_f(void *arg, int thread_id, int thread_count)
+{
+	(void)thread_count;
+	struct tt_sort *sort = (struct tt_sort *)arg;
+	size_t es = sort->elem_size;
+	size_t begin = tt_sort_chunk_begin(sort, thread_id);
+	size_t end = tt_sort_chunk_begin(sort, thread_id + 1);
+	memcpy(sort->data + begin * es, sort->src + begin * es,
+	       (end - begin) * es);
+}
+
+void
+tt_sort(void *data, size_t elem_count, size_t elem_size,
+	int (*cmp)(const void *a, const void *b, void *arg), void *arg,
+	int thread_count)
+{
+	if ((size_t)thread_count > elem_count / TT_SORT_THREAD_ELEM_MIN)
+		thread_count = elem_count / TT_SORT_THREAD_ELEM_MIN;
+	char *buf = NULL;
+	if (thread_count > 1)
+		buf = (char *)malloc(elem_count * elem_size);
+	if (buf == NULL) {
+		qsort_arg_st(data, elem_count, elem_size, cmp, arg);
+		return;
+	}
+	struct tt_sort sort;
+	sort.data = (char *)data;
+	sort.elem_count = elem_count;
+	sort.elem_size = elem_size;
+	sort.cmp = cmp;
+	sort.arg = arg;
+	sort.thread_count = thread_count;
+	tt_parallel(tt_sort_chunk_f, &sort, thread_count);
+
+	sort.src = sort.data;
+	sort.dst = buf;
+	for (sort.run_chunks = 1; sort.run_chunks < thread_count;
+	     sort.run_chunks *= 2) {
+		tt_parallel(tt_sort_merge_f, &sort, thread_count);
+		char *src = sort.dst;
+		sort.dst = (char *)sort.src;
+		sort.src = src;
+	}
+	if (sort.src != sort.data)
+		tt_parallel(tt_sort_copy_f, &sort, thread_count);
+	free(buf);
+}
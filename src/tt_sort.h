@@ -0,0 +1,74 @@
+#ifndef TARANTOOL_TT_SORT_H_INCLUDED
+#define TARANTOOL_TT_SORT_H_INCLUDED 1
+/*
+ * Copyright 2010-2018, Tarantool AUTHORS, please see AUTHORS file.
+ *
+ * Redistribution and use in source and binary forms, with or
+ * without modification, are permitted provided that the following
+ * conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above
+ *    copyright notice, this list of conditions and the
+ *    following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials
+ *    provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY AUTHORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * AUTHORS OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include <stddef.h>
+
+#if defined(__cplusplus)
+extern "C" {
+#endif /* defined(__cplusplus) */
+
+/**
+ * A function run by tt_parallel() in each thread.
+ * @param arg - argument passed to tt_parallel()
+ * @param thread_id - thread number, from 0 to thread_count - 1
+ * @param thread_count - total number of threads
+ */
+typedef void
+(*tt_parallel_f)(void *arg, int thread_id, int thread_count);
+
+/**
+ * Run @a f in @a thread_count threads, one of which is the
+ * calling thread, and wait for all of them to return. If a
+ * thread can't be started, its share of work is done by the
+ * calling thread, so the function never fails.
+ */
+void
+tt_parallel(tt_parallel_f f, void *arg, int thread_count);
+
+/**
+ * Sort an array in @a thread_count threads. Parts of the array
+ * are sorted in parallel with qsort_arg_st(), then merged, also
+ * in parallel. Unlike qsort_arg(), doesn't depend on open MP.
+ * Falls back on single-threaded sorting if the array is small
+ * or there is not enough memory for the merge buffer.
+ */
+void
+tt_sort(void *data, size_t elem_count, size_t elem_size,
+	int (*cmp)(const void *a, const void *b, void *arg), void *arg,
+	int thread_count);
+
+#if defined(__cplusplus)
+} /* extern "C" */
+#endif /* defined(__cplusplus) */
+
+#endif /* TARANTOOL_TT_SORT_H_INCLUDED */
@@ -131,6 +131,79 @@ box.cfg{net_msg_max = 2}
 box.cfg{net_msg_max = old + 1000}
 box.cfg{net_msg_max = old}
 
+--
+-- Multi-threaded iproto: box.cfg{iproto_threads}.
+--
+box.cfg{iproto_threads = 'invalid'}
+box.cfg.iproto_threads
+box.cfg{iproto_threads = 2}
+-- Connections are handed over to the threads round-robin and
+-- box.stat.net() sums up statistics of all threads.
+test_run:cmd('create server cfg_tester6 with script = "box/lua/cfg_iproto_threads.lua"')
+test_run:cmd("start server cfg_tester6")
+test_run:cmd('switch cfg_tester6')
+box.cfg.iproto_threads
+net_box = require('net.box')
+fiber = require('fiber')
+s = box.schema.space.create('test')
+_ = s:create_index('pk')
+test_run:cmd("setopt delimiter ';'")
+function run(uri, base)
+    local conns, fibers = {}, {}
+    for i = 1, 16 do
+        conns[i] = net_box.connect(uri)
+        fibers[i] = fiber.new(function(conn, id)
+            for j = 1, 50 do
+                conn.space.test:replace{base + id * 100 + j}
+            end
+        end, conns[i], i)
+        fibers[i]:set_joinable(true)
+    end
+    for i = 1, 16 do
+        fibers[i]:join()
+        conns[i]:close()
+    end
+end;
+function check_stat()
+    local served, sent, received = 0, 0, 0
+    for _, t in ipairs(box.stat.net.thread()) do
+        if t.RECEIVED.total > 0 then
+            served = served + 1
+        end
+        sent = sent + t.SENT.total
+        received = received + t.RECEIVED.total
+    end
+    local total = box.stat.net()
+    return served, sent == total.SENT.total,
+           received == total.RECEIVED.total
+end;
+test_run:cmd("setopt delimiter ''");
+run(box.cfg.listen, 0)
+s:count()
+#box.stat.net.thread()
+check_stat()
+-- Changing listen works with several threads.
+old_listen = box.cfg.listen
+box.cfg{listen = 'unix/:./cfg_tester6.sock'}
+net_box.connect(old_listen):ping()
+box.stat.reset()
+run(box.cfg.listen, 10000)
+s:count()
+check_stat()
+-- So does changing net_msg_max.
+old_msg_max = box.cfg.net_msg_max
+box.cfg{net_msg_max = 2}
+run(box.cfg.listen, 20000)
+s:count()
+box.cfg{net_msg_max = old_msg_max}
+run(box.cfg.listen, 30000)
+s:count()
+check_stat()
+s:drop()
+test_run:cmd("switch default")
+test_run:cmd("stop server cfg_tester6")
+test_run:cmd("cleanup server cfg_tester6")
+
 --
 -- gh-3266: box.cfg{} still not optional on 2.0 brach
 --
@@ -0,0 +1,51 @@
+--
+-- Sparse field map: offsets of every field_map_step-th
+-- field are stored in the tuple so that fields of wide
+-- tuples are found without decoding all preceding fields.
+--
+format = {}
+for i = 1, 100 do table.insert(format, {'f' .. i, 'unsigned', is_nullable = i > 1}) end
+s = box.schema.space.create('test', {format = format, field_map_step = 16})
+_ = s:create_index('pk')
+t = {}
+for i = 1, 100 do t[i] = i * 10 end
+_ = s:insert(t)
+t = s:get{10}
+ok = true
+for i = 1, 100 do if t[i] ~= i * 10 or t['f' .. i] ~= i * 10 then ok = false end end
+ok
+-- Short tuples do not have the tail fields.
+_ = s:insert{20, 1, 2}
+t = s:get{20}
+t[3], t[16], t[17], t[33], t.f100
+-- Indexed fields beyond the first step.
+_ = s:create_index('sk', {parts = {{50, 'unsigned', is_nullable = true}}})
+s.index.sk:select{500}[1][50]
+t = {}
+for i = 1, 100 do t[i] = i * 10 + 1 end
+_ = s:insert(t)
+s.index.sk:select{501}[1][60]
+-- The step can be changed on the fly.
+_ = box.space._space:update(s.id, {{'=', 6, {field_map_step = 7}}})
+_ = s:replace(t)
+t = s:get{11}
+t[70], t[71], t[99]
+s:drop()
+
+--
+-- Compact field map: offsets are stored as 16-bit integers.
+--
+s = box.schema.space.create('test', {compact_field_map = true})
+_ = s:create_index('pk')
+_ = s:create_index('sk', {parts = {3, 'string'}})
+_ = s:insert{1, string.rep('x', 100), 'a'}
+s:insert{2, string.rep('x', 70000), 'b'}
+-- A big field is fine if no offset is stored beyond it.
+_ = s:insert{3, 'c', string.rep('x', 70000)}
+#s:get{3}[3]
+s.index.sk:select{'a'}[1][1]
+s:count()
+_ = box.space._space:update(s.id, {{'=', 6, {}}})
+s:drop()
+
+s = box.schema.space.create('test', {engine = 'vinyl', compact_field_map = true})
@@ -0,0 +1,45 @@
+fiber = require('fiber')
+
+-- box.stat.wal() reports disk writes, rows and histograms.
+box.stat.reset()
+stat = box.stat.wal()
+stat.writes
+stat.rows
+stat.batch_rows.max
+type(stat.commit_latency.p99)
+
+s = box.schema.space.create('test')
+_ = s:create_index('pk')
+
+box.cfg{wal_group_commit_timeout = -1}
+box.cfg{wal_group_commit_bytes = -1}
+
+--
+-- With group commit enabled, requests wait for each other
+-- and are written to disk at once.
+--
+box.stat.reset()
+box.cfg{wal_group_commit_timeout = 100, wal_group_commit_bytes = 0}
+done = 0
+for i = 1, 10 do fiber.create(function() s:insert{i} done = done + 1 end) fiber.sleep(0.01) end
+done
+-- Disabling group commit writes the pending requests.
+box.cfg{wal_group_commit_timeout = 0}
+while done < 10 do fiber.sleep(0.01) end
+s:count()
+stat = box.stat.wal()
+stat.writes
+stat.rows
+stat.batch_rows.max
+
+--
+-- The size limit makes the group get written before
+-- the timeout expires.
+--
+box.stat.reset()
+box.cfg{wal_group_commit_timeout = 100, wal_group_commit_bytes = 1}
+s:insert{11}
+box.stat.wal().writes
+
+box.cfg{wal_group_commit_timeout = 0, wal_group_commit_bytes = 1024 * 1024}
+s:drop()
@@ -0,0 +1,46 @@
+--
+-- Small memtx tuples are stored with a truncated header.
+--
+s = box.schema.space.create('test')
+_ = s:create_index('pk')
+_ = s:create_index('sk', {parts = {2, 'string'}})
+count = box.slab.info().tiny_tuples
+saved = box.slab.info().tiny_tuples_saved
+for i = 1, 100 do s:insert{i, 'str' .. i} end
+box.slab.info().tiny_tuples - count
+box.slab.info().tiny_tuples_saved - saved
+s:get{10}
+s.index.sk:get{'str20'}
+s.index.sk:select({'str99'}, {iterator = 'GE'})
+#s:get{30}:tomap()
+-- Big tuples have the regular header.
+_ = s:insert{1000, string.rep('x', 300)}
+box.slab.info().tiny_tuples - count
+_ = s:update({10}, {{'=', 2, string.rep('y', 300)}})
+#s:get{10}[2]
+s:get{10}:bsize()
+s:get{11}:bsize()
+for i = 1, 100 do s:delete{i} end
+_ = s:delete{1000}
+collectgarbage('collect')
+box.slab.info().tiny_tuples - count
+box.slab.info().tiny_tuples_saved - saved
+-- A tiny tuple can be referenced more than 16383 times,
+-- which makes the tuple use a big reference counter.
+count = box.slab.info().tiny_tuples
+_ = s:insert{1, 'abc'}
+box.slab.info().tiny_tuples - count
+refs = {}
+for i = 1, 20000 do refs[i] = s:get{1} end
+refs[20000]:bsize()
+refs[20000][2]
+for i = 1, 10000 do refs[i] = nil end
+collectgarbage('collect')
+refs[20000]:bsize()
+refs[20000]:totable()
+box.slab.info().tiny_tuples - count
+_ = s:delete{1}
+refs = nil
+collectgarbage('collect')
+box.slab.info().tiny_tuples - count
+s:drop()
@@ -0,0 +1,81 @@
+--
+-- Comparison hints stored in tree index nodes along with
+-- tuples must not affect the order of tuples.
+--
+s = box.schema.space.create('test')
+_ = s:create_index('pk')
+
+-- Greatest unsigned values have equal hints.
+i = s:create_index('i1', {parts = {2, 'unsigned'}})
+_ = s:insert{1, 18446744073709551615ULL}
+_ = s:insert{2, 18446744073709551614ULL}
+_ = s:insert{3, 0}
+i:select()
+i:get{18446744073709551614ULL}
+i:select({18446744073709551614ULL}, {iterator = 'GT'})
+i:drop()
+s:truncate()
+
+i = s:create_index('i2', {parts = {2, 'integer'}})
+_ = s:insert{1, -9223372036854775807LL}
+_ = s:insert{2, -1}
+_ = s:insert{3, 0}
+_ = s:insert{4, 9223372036854775807LL}
+_ = s:insert{5, 18446744073709551615ULL}
+_ = s:insert{6, 9223372036854775806LL}
+i:select()
+i:select({0}, {iterator = 'LT'})
+i:drop()
+s:truncate()
+
+-- Integers and doubles are mixed in number fields.
+i = s:create_index('i3', {parts = {2, 'number'}})
+_ = s:insert{1, 1.5}
+_ = s:insert{2, 1}
+_ = s:insert{3, -0.5}
+_ = s:insert{4, 9007199254740993ULL}
+_ = s:insert{5, 9007199254740992}
+_ = s:insert{6, -1e300}
+_ = s:insert{7, 1e300}
+i:select()
+i:get{9007199254740993ULL}
+i:select({1}, {iterator = 'GE'})
+i:drop()
+s:truncate()
+
+-- Strings with a common 8-byte prefix have equal hints.
+i = s:create_index('i4', {parts = {2, 'string'}})
+_ = s:insert{1, 'abcdefgh2'}
+_ = s:insert{2, 'abcdefgh1'}
+_ = s:insert{3, 'abcdefgh'}
+_ = s:insert{4, 'abc'}
+_ = s:insert{5, ''}
+_ = s:insert{6, 'zzzzzzzzz'}
+i:select()
+i:select({'abcdefgh'}, {iterator = 'GT'})
+i:select({'abcdefgh1'}, {iterator = 'LE'})
+i:drop()
+s:truncate()
+
+-- NULL is less than any value.
+i = s:create_index('i5', {parts = {{2, 'unsigned', is_nullable = true}}, unique = false})
+_ = s:insert{1, 1}
+_ = s:insert{2, box.NULL}
+_ = s:insert{3, 0}
+_ = s:insert{4}
+i:select()
+i:select({box.NULL})
+i:select({0}, {iterator = 'GE'})
+i:drop()
+s:truncate()
+
+-- Hints are recomputed if the field type changes.
+i = s:create_index('i6', {parts = {2, 'unsigned'}})
+_ = s:insert{1, 10}
+_ = s:insert{2, 5}
+i:alter{parts = {2, 'integer'}}
+_ = s:insert{3, -5}
+i:select()
+i:select({0}, {iterator = 'GT'})
+
+s:drop()
@@ -0,0 +1,56 @@
+env = require('test_run')
+test_run = env.new()
+engine = test_run:get_cfg('engine')
+
+box.schema.user.grant('guest', 'replication')
+
+space = box.schema.space.create('test', {engine = engine});
+index = box.space.test:create_index('primary')
+
+test_run:cmd("create server replica with rpl_master=default, script='replication/replica.lua'")
+test_run:cmd("start server replica")
+
+--
+-- The applier reads rows ahead and applies them in batches.
+-- Check that all rows get to the replica and that the apply
+-- statistics are reported.
+--
+for i = 1, 1000 do space:insert{i} end
+vclock = test_run:get_vclock('default')
+_ = test_run:wait_vclock("replica", vclock)
+
+test_run:cmd("switch replica")
+box.space.test:count()
+box.space.test:get(1000)
+upstream = box.info.replication[1].upstream
+upstream.status
+upstream.apply.total >= 1000
+upstream.apply.batch_size >= 1
+type(upstream.apply.rps)
+
+--
+-- A conflicting row doesn't prevent other rows of the same
+-- batch from being applied if replication_skip_conflict is set.
+--
+box.cfg{replication_skip_conflict = true}
+box.space.test:insert{1002}
+
+test_run:cmd("switch default")
+box.begin() for i = 1001, 1010 do space:insert{i, i} end box.commit()
+vclock = test_run:get_vclock('default')
+_ = test_run:wait_vclock("replica", vclock)
+
+test_run:cmd("switch replica")
+box.info.replication[1].upstream.status
+box.info.replication[1].upstream.message
+box.space.test:count()
+box.space.test:get(1001)
+box.space.test:get(1002)
+box.space.test:get(1010)
+
+-- cleanup
+test_run:cmd("switch default")
+test_run:cmd("stop server replica")
+test_run:cmd("cleanup server replica")
+box.space.test:drop()
+box.schema.user.revoke('guest', 'replication')
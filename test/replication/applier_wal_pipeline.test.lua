@@ -0,0 +1,57 @@
+env = require('test_run')
+test_run = env.new()
+engine = test_run:get_cfg('engine')
+
+box.schema.user.grant('guest', 'replication')
+
+space = box.schema.space.create('test', {engine = engine});
+index = box.space.test:create_index('primary')
+
+test_run:cmd("create server replica with rpl_master=default, script='replication/replica.lua'")
+test_run:cmd("start server replica")
+
+--
+-- Pipeline WAL writes of applied rows. The new setting takes
+-- effect on reconnect.
+--
+test_run:cmd("switch replica")
+fiber = require('fiber')
+box.cfg{replication_wal_pipeline = 4}
+test_run:cmd("setopt delimiter ';'")
+do
+    local replication = box.cfg.replication
+    box.cfg{replication = {}}
+    box.cfg{replication = replication}
+    while box.info.replication[1].upstream.status ~= 'follow' do
+        fiber.sleep(0.001)
+    end
+end;
+test_run:cmd("setopt delimiter ''");
+box.cfg{replication_skip_conflict = true}
+box.space.test:insert{502}
+
+--
+-- Rows modifying the same key are applied in order, a conflict
+-- is skipped.
+--
+test_run:cmd("switch default")
+for i = 1, 1000 do space:replace{i % 100, i} end
+for i = 501, 600 do space:insert{i} end
+vclock = test_run:get_vclock('default')
+_ = test_run:wait_vclock("replica", vclock)
+
+test_run:cmd("switch replica")
+box.info.replication[1].upstream.status
+box.info.replication[1].upstream.message
+box.space.test:count()
+box.space.test:get(0)
+box.space.test:get(99)
+box.space.test:get(502)
+box.space.test:get(600)
+
+-- cleanup
+test_run:cmd("switch default")
+test_run:cmd("stop server replica")
+test_run:cmd("cleanup server replica")
+box.space.test:drop()
+box.schema.user.revoke('guest', 'replication')
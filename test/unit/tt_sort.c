@@ -0,0 +1,93 @@
+#include <stdlib.h>
+#include <stdint.h>
+
+#include "memory.h"
+#include "fiber.h"
+#include "trivia/util.h"
+#include "tt_sort.h"
+#include "unit.h"
+
+/*
+ * Elements are pointers to keys, like tuples in a memtx tree
+ * index, so that every comparison dereferences memory.
+ */
+static int
+key_ptr_cmp(const void *a, const void *b, void *arg)
+{
+	(void)arg;
+	uint64_t ka = **(const uint64_t **)a;
+	uint64_t kb = **(const uint64_t **)b;
+	return ka < kb ? -1 : ka > kb;
+}
+
+static uint64_t **
+key_ptr_array_new(uint64_t *keys, size_t count, uint64_t key_max)
+{
+	uint64_t **array = malloc(count * sizeof(*array));
+	fail_if(array == NULL);
+	for (size_t i = 0; i < count; i++) {
+		keys[i] = (((uint64_t)rand() << 31) ^ rand()) % key_max;
+		array[i] = &keys[i];
+	}
+	return array;
+}
+
+static bool
+key_ptr_array_is_sorted(uint64_t **array, size_t count)
+{
+	for (size_t i = 1; i < count; i++) {
+		if (*array[i - 1] > *array[i])
+			return false;
+	}
+	return true;
+}
+
+static void
+test_sort(size_t count, uint64_t key_max, int thread_count)
+{
+	uint64_t *keys = malloc(count * sizeof(*keys));
+	fail_if(keys == NULL);
+	uint64_t **array = key_ptr_array_new(keys, count, key_max);
+	uint64_t sum_before = 0;
+	for (size_t i = 0; i < count; i++)
+		sum_before += *array[i];
+	tt_sort(array, count, sizeof(*array), key_ptr_cmp, NULL,
+		thread_count);
+	uint64_t sum_after = 0;
+	for (size_t i = 0; i < count; i++)
+		sum_after += *array[i];
+	ok(key_ptr_array_is_sorted(array, count) && sum_before == sum_after,
+	   "sort %zu elements, %llu distinct keys, %d threads", count,
+	   (unsigned long long)key_max, thread_count);
+	free(array);
+	free(keys);
+}
+
+static void
+test(void)
+{
+	plan(10);
+	test_sort(0, 100, 4);
+	test_sort(1, 100, 4);
+	test_sort(1000, 100, 4);
+	test_sort(100000, 10, 1);
+	test_sort(100000, 10, 3);
+	test_sort(100000, UINT64_MAX, 4);
+	test_sort(123457, UINT64_MAX, 7);
+	test_sort(300000, 1000, 8);
+	test_sort(300000, UINT64_MAX, 16);
+	test_sort(1000000, UINT64_MAX, 5);
+	check_plan();
+}
+
+int
+main(void)
+{
+	memory_init();
+	fiber_init(fiber_c_invoke);
+	srand(42);
+	test();
+	fiber_free();
+	memory_free();
+	return 0;
+}
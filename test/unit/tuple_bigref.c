@@ -30,8 +30,8 @@ create_tuple()
  * What it checks:
  * 1) Till refs <= TUPLE_REF_MAX it shows number of refs
  * of tuple and it isn't a bigref.
- * 2) When refs > TUPLE_REF_MAX first 15 bits of it becomes
- * index of bigref and the last bit becomes true which
+ * 2) When refs > TUPLE_REF_MAX first 14 bits of it becomes
+ * index of bigref and the next bit becomes true which
  * shows that it is bigref.
  * 3) Each of tuple has its own number of refs, but all
  * these numbers more than it is needed for getting a bigref.
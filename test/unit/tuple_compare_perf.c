@@ -0,0 +1,205 @@
+/*
+ * Measure throughput of tuple comparators for different key
+ * shapes: part types, field numbers and nullability.
+ * Not run by the test suite, since the results depend on hardware.
+ *
+ * Usage: tuple_compare.perf [number of comparisons]
+ */
+#include "memory.h"
+#include "fiber.h"
+#include "tuple.h"
+#include "key_def.h"
+#include "msgpuck.h"
+#include "trivia/util.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+enum {
+	/** Number of fields in a test tuple. */
+	FIELD_COUNT = 4,
+	/** Number of test tuples. */
+	TUPLE_COUNT = 4096,
+	/** Number of distinct values of a field. */
+	VALUE_COUNT = 8,
+};
+
+struct key_shape {
+	const char *name;
+	uint32_t part_count;
+	uint32_t fieldno[FIELD_COUNT];
+	enum field_type type[FIELD_COUNT];
+	bool is_nullable;
+};
+
+static const struct key_shape shapes[] = {
+	{"unsigned", 1, {0}, {FIELD_TYPE_UNSIGNED}, false},
+	{"string", 1, {0}, {FIELD_TYPE_STRING}, false},
+	{"integer", 1, {0}, {FIELD_TYPE_INTEGER}, false},
+	{"number", 1, {0}, {FIELD_TYPE_NUMBER}, false},
+	{"scalar", 1, {0}, {FIELD_TYPE_SCALAR}, false},
+	{"unsigned?", 1, {1}, {FIELD_TYPE_UNSIGNED}, true},
+	{"integer?", 1, {1}, {FIELD_TYPE_INTEGER}, true},
+	{"unsigned,string", 2, {0, 1},
+	 {FIELD_TYPE_UNSIGNED, FIELD_TYPE_STRING}, false},
+	{"integer,integer", 2, {0, 1},
+	 {FIELD_TYPE_INTEGER, FIELD_TYPE_INTEGER}, false},
+	{"number,unsigned", 2, {2, 0},
+	 {FIELD_TYPE_NUMBER, FIELD_TYPE_UNSIGNED}, false},
+	{"string?,integer?", 2, {1, 3},
+	 {FIELD_TYPE_STRING, FIELD_TYPE_INTEGER}, true},
+	{"unsigned x3", 3, {0, 1, 2},
+	 {FIELD_TYPE_UNSIGNED, FIELD_TYPE_UNSIGNED, FIELD_TYPE_UNSIGNED},
+	 false},
+	{"integer,scalar,number", 3, {0, 1, 2},
+	 {FIELD_TYPE_INTEGER, FIELD_TYPE_SCALAR, FIELD_TYPE_NUMBER}, false},
+	{"unsigned x4", 4, {0, 1, 2, 3},
+	 {FIELD_TYPE_UNSIGNED, FIELD_TYPE_UNSIGNED, FIELD_TYPE_UNSIGNED,
+	  FIELD_TYPE_UNSIGNED}, false},
+};
+
+static double
+clock_monotonic(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static char *
+encode_field(char *data, enum field_type type, bool is_nullable)
+{
+	int val = rand() % VALUE_COUNT;
+	if (is_nullable && rand() % VALUE_COUNT == 0)
+		return mp_encode_nil(data);
+	char str[16];
+	switch (type) {
+	case FIELD_TYPE_STRING:
+		snprintf(str, sizeof(str), "key%04d", val);
+		return mp_encode_str(data, str, strlen(str));
+	case FIELD_TYPE_INTEGER:
+		if (val % 2 != 0)
+			return mp_encode_int(data, -val);
+		return mp_encode_uint(data, val);
+	case FIELD_TYPE_NUMBER:
+		return mp_encode_double(data, val / 2.0);
+	case FIELD_TYPE_SCALAR:
+		if (val % 2 != 0) {
+			snprintf(str, sizeof(str), "key%04d", val);
+			return mp_encode_str(data, str, strlen(str));
+		}
+		return mp_encode_uint(data, val);
+	default:
+		return mp_encode_uint(data, val);
+	}
+}
+
+static void
+bench_shape(const struct key_shape *shape, uint32_t count)
+{
+	struct key_part_def parts[FIELD_COUNT];
+	for (uint32_t i = 0; i < shape->part_count; i++) {
+		parts[i] = key_part_def_default;
+		parts[i].fieldno = shape->fieldno[i];
+		parts[i].type = shape->type[i];
+		if (shape->is_nullable) {
+			parts[i].is_nullable = true;
+			parts[i].nullable_action = ON_CONFLICT_ACTION_NONE;
+		}
+	}
+	struct key_def *key_def = key_def_new(parts, shape->part_count);
+	if (key_def == NULL)
+		abort();
+	struct tuple_format *format = box_tuple_format_new(&key_def, 1);
+	if (format == NULL)
+		abort();
+
+	/* Keys are encoded one after another without array headers. */
+	static struct tuple *tuples[TUPLE_COUNT];
+	static const char *keys[TUPLE_COUNT];
+	char *key_buf = malloc(TUPLE_COUNT * FIELD_COUNT * 16);
+	if (key_buf == NULL)
+		abort();
+	char *key_end = key_buf;
+	for (uint32_t i = 0; i < TUPLE_COUNT; i++) {
+		char data[FIELD_COUNT * 16];
+		char *data_end = mp_encode_array(data, FIELD_COUNT);
+		const char *fields[FIELD_COUNT];
+		for (uint32_t j = 0; j < FIELD_COUNT; j++) {
+			enum field_type type = FIELD_TYPE_UNSIGNED;
+			for (uint32_t k = 0; k < shape->part_count; k++) {
+				if (shape->fieldno[k] == j)
+					type = shape->type[k];
+			}
+			fields[j] = data_end;
+			data_end = encode_field(data_end, type,
+						shape->is_nullable);
+		}
+		keys[i] = key_end;
+		for (uint32_t k = 0; k < shape->part_count; k++) {
+			const char *field = fields[shape->fieldno[k]];
+			const char *field_end = field;
+			mp_next(&field_end);
+			memcpy(key_end, field, field_end - field);
+			key_end += field_end - field;
+		}
+		tuples[i] = tuple_new(format, data, data_end);
+		if (tuples[i] == NULL)
+			abort();
+		tuple_ref(tuples[i]);
+	}
+
+	/* Pair tuples in a pseudo-random order to defeat the cache. */
+	int sum = 0;
+	double t = clock_monotonic();
+	for (uint32_t i = 0; i < count; i++) {
+		uint32_t j = (i * 7919 + 1) % TUPLE_COUNT;
+		sum += tuple_compare(tuples[i % TUPLE_COUNT], tuples[j],
+				     key_def);
+	}
+	double cmp_ns = (clock_monotonic() - t) * 1e9 / count;
+
+	t = clock_monotonic();
+	for (uint32_t i = 0; i < count; i++) {
+		uint32_t j = (i * 7919 + 1) % TUPLE_COUNT;
+		sum += tuple_compare_with_key(tuples[i % TUPLE_COUNT], keys[j],
+					      shape->part_count, key_def);
+	}
+	double cmp_key_ns = (clock_monotonic() - t) * 1e9 / count;
+
+	printf("%-24s %12.1f %12.1f %12.2f %8d\n", shape->name, cmp_ns,
+	       cmp_key_ns, 1e3 / cmp_ns, sum);
+
+	for (uint32_t i = 0; i < TUPLE_COUNT; i++)
+		tuple_unref(tuples[i]);
+	free(key_buf);
+	tuple_format_unref(format);
+	key_def_delete(key_def);
+}
+
+int
+main(int argc, char **argv)
+{
+	uint32_t count = 10000000;
+	if (argc > 1)
+		count = atoi(argv[1]);
+	if (count == 0)
+		count = 1;
+
+	memory_init();
+	fiber_init(fiber_c_invoke);
+	tuple_init(NULL);
+	srand(time(NULL));
+
+	printf("comparisons: %u\n", count);
+	printf("%-24s %12s %12s %12s %8s\n", "key", "cmp ns",
+	       "cmp key ns", "Mcmp/sec", "checksum");
+	for (uint32_t i = 0; i < lengthof(shapes); i++)
+		bench_shape(&shapes[i], count);
+
+	tuple_free();
+	fiber_free();
+	memory_free();
+	return 0;
+}
@@ -0,0 +1,158 @@
+/*
+ * Compare throughput of the stable MurmurHash3 based tuple hash,
+ * which is used for bloom filters stored on disk, with the hash
+ * selected for the CPU, which is used by memtx hash indexes.
+ * Not run by the test suite, since the results depend on hardware.
+ *
+ * Usage: tuple_hash.perf [number of hashes]
+ */
+#include "memory.h"
+#include "fiber.h"
+#include "tuple.h"
+#include "tuple_hash.h"
+#include "key_def.h"
+#include "msgpuck.h"
+#include "trivia/util.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+enum {
+	/** Max number of key parts. */
+	PART_COUNT_MAX = 3,
+	/** Number of test tuples. */
+	TUPLE_COUNT = 4096,
+	/** Length of test strings. */
+	STRING_LEN = 20,
+};
+
+struct key_shape {
+	const char *name;
+	uint32_t part_count;
+	enum field_type type[PART_COUNT_MAX];
+};
+
+static const struct key_shape shapes[] = {
+	{"unsigned", 1, {FIELD_TYPE_UNSIGNED}},
+	{"unsigned,unsigned", 2, {FIELD_TYPE_UNSIGNED, FIELD_TYPE_UNSIGNED}},
+	{"string", 1, {FIELD_TYPE_STRING}},
+	{"string,unsigned", 2, {FIELD_TYPE_STRING, FIELD_TYPE_UNSIGNED}},
+	{"string,string", 2, {FIELD_TYPE_STRING, FIELD_TYPE_STRING}},
+	{"unsigned x3", 3,
+	 {FIELD_TYPE_UNSIGNED, FIELD_TYPE_UNSIGNED, FIELD_TYPE_UNSIGNED}},
+};
+
+static double
+clock_monotonic(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static char *
+encode_field(char *data, enum field_type type)
+{
+	if (type == FIELD_TYPE_STRING) {
+		char str[STRING_LEN];
+		for (int i = 0; i < STRING_LEN; i++)
+			str[i] = 'a' + rand() % 26;
+		return mp_encode_str(data, str, STRING_LEN);
+	}
+	return mp_encode_uint(data, rand());
+}
+
+static void
+bench_shape(const struct key_shape *shape, uint32_t count)
+{
+	uint32_t fields[PART_COUNT_MAX];
+	uint32_t types[PART_COUNT_MAX];
+	for (uint32_t i = 0; i < shape->part_count; i++) {
+		fields[i] = i;
+		types[i] = shape->type[i];
+	}
+	struct key_def *key_def = box_key_def_new(fields, types,
+						  shape->part_count);
+	if (key_def == NULL)
+		abort();
+	struct tuple_format *format = box_tuple_format_new(&key_def, 1);
+	if (format == NULL)
+		abort();
+
+	static struct tuple *tuples[TUPLE_COUNT];
+	static const char *keys[TUPLE_COUNT];
+	for (uint32_t i = 0; i < TUPLE_COUNT; i++) {
+		char data[PART_COUNT_MAX * (STRING_LEN + 16)];
+		char *data_end = mp_encode_array(data, shape->part_count);
+		for (uint32_t j = 0; j < shape->part_count; j++)
+			data_end = encode_field(data_end, shape->type[j]);
+		tuples[i] = tuple_new(format, data, data_end);
+		if (tuples[i] == NULL)
+			abort();
+		tuple_ref(tuples[i]);
+		/* A key is the tuple without the array header. */
+		keys[i] = tuple_data(tuples[i]);
+		mp_decode_array(&keys[i]);
+		if (tuple_hash(tuples[i], key_def) !=
+		    key_hash(keys[i], key_def) ||
+		    tuple_hash_stable(tuples[i], key_def) !=
+		    key_hash_stable(keys[i], key_def))
+			abort();
+	}
+
+	uint32_t sum = 0;
+	double t = clock_monotonic();
+	for (uint32_t i = 0; i < count; i++)
+		sum += tuple_hash_stable(tuples[i % TUPLE_COUNT], key_def);
+	double stable_ns = (clock_monotonic() - t) * 1e9 / count;
+
+	t = clock_monotonic();
+	for (uint32_t i = 0; i < count; i++)
+		sum += tuple_hash(tuples[i % TUPLE_COUNT], key_def);
+	double fast_ns = (clock_monotonic() - t) * 1e9 / count;
+
+	t = clock_monotonic();
+	for (uint32_t i = 0; i < count; i++)
+		sum += key_hash_stable(keys[i % TUPLE_COUNT], key_def);
+	double stable_key_ns = (clock_monotonic() - t) * 1e9 / count;
+
+	t = clock_monotonic();
+	for (uint32_t i = 0; i < count; i++)
+		sum += key_hash(keys[i % TUPLE_COUNT], key_def);
+	double fast_key_ns = (clock_monotonic() - t) * 1e9 / count;
+
+	printf("%-20s %10.1f %10.1f %10.1f %10.1f %10u\n", shape->name,
+	       stable_ns, fast_ns, stable_key_ns, fast_key_ns, sum);
+
+	for (uint32_t i = 0; i < TUPLE_COUNT; i++)
+		tuple_unref(tuples[i]);
+	tuple_format_unref(format);
+	key_def_delete(key_def);
+}
+
+int
+main(int argc, char **argv)
+{
+	uint32_t count = 10000000;
+	if (argc > 1)
+		count = atoi(argv[1]);
+	if (count == 0)
+		count = 1;
+
+	memory_init();
+	fiber_init(fiber_c_invoke);
+	tuple_init(NULL);
+	srand(time(NULL));
+
+	printf("hashes: %u\n", count);
+	printf("%-20s %10s %10s %10s %10s %10s\n", "key", "stable ns",
+	       "ns", "stable key", "key ns", "checksum");
+	for (uint32_t i = 0; i < lengthof(shapes); i++)
+		bench_shape(&shapes[i], count);
+
+	tuple_free();
+	fiber_free();
+	memory_free();
+	return 0;
+}
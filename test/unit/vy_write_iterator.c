@@ -28,12 +28,15 @@ test_handler_process(struct vy_deferred_delete_handler *base,
 
 	fail_if(vy_stmt_type(old_stmt) == IPROTO_DELETE);
 	fail_if(vy_stmt_type(new_stmt) != IPROTO_DELETE &&
-		vy_stmt_type(new_stmt) != IPROTO_REPLACE);
+		vy_stmt_type(new_stmt) != IPROTO_REPLACE &&
+		new_stmt != old_stmt);
 
 	struct tuple *delete = vy_stmt_new_surrogate_delete(handler->format,
 							    old_stmt);
 	fail_if(delete == NULL);
 	vy_stmt_set_lsn(delete, vy_stmt_lsn(new_stmt));
+	if (new_stmt == old_stmt)
+		vy_stmt_set_flags(delete, VY_STMT_EXPIRED);
 
 	fail_if(handler->count >= MAX_DEFERRED_COUNT);
 	handler->stmt[handler->count++] = delete;
@@ -62,6 +65,28 @@ test_handler_create(struct test_handler *handler, struct tuple_format *format)
 	tuple_format_ref(format);
 }
 
+/**
+ * Test compaction filter: drops tuples whose second field is 0.
+ */
+static bool
+test_filter_f(struct vy_compaction_filter *filter, const struct tuple *stmt)
+{
+	(void)filter;
+	const char *field = tuple_field(stmt, 1);
+	return field != NULL && mp_typeof(*field) == MP_UINT &&
+	       mp_decode_uint(&field) == 0;
+}
+
+static struct vy_compaction_filter test_filter = {
+	.filter = test_filter_f,
+};
+
+/**
+ * Compaction filter passed to the write iterator for primary
+ * indexes or NULL if statements must not be filtered.
+ */
+static struct vy_compaction_filter *write_iterator_filter;
+
 /**
  * Create a mem with the specified content, iterate over it with
  * write_iterator and compare actual result statements with the
@@ -107,7 +132,8 @@ compare_write_iterator_results(const struct vy_stmt_template *content,
 	struct vy_stmt_stream *wi;
 	wi = vy_write_iterator_new(key_def, mem->format, is_primary,
 				   is_last_level, &rv_list,
-				   is_primary ? &handler.base : NULL);
+				   is_primary ? &handler.base : NULL,
+				   is_primary ? write_iterator_filter : NULL);
 	fail_if(wi == NULL);
 	fail_if(vy_write_iterator_new_mem(wi, mem) != 0);
 
@@ -719,12 +745,177 @@ test_basic(void)
 	check_plan();
 }
 
+void
+test_compaction_filter(void)
+{
+	header();
+	plan(22);
+	write_iterator_filter = &test_filter;
+{
+/*
+ * STATEMENT: REPL(1, 1) REPL(1, 0) REPL(2, 2)
+ * LSN:          5          6          7
+ * FILTERED:                +
+ *
+ * is_last_level = true
+ *
+ * Check that a filtered statement is dropped along with
+ * the key history on major compaction.
+ */
+	const struct vy_stmt_template content[] = {
+		STMT_TEMPLATE(5, REPLACE, 1, 1),
+		STMT_TEMPLATE(6, REPLACE, 1, 0),
+		STMT_TEMPLATE(7, REPLACE, 2, 2),
+	};
+	const struct vy_stmt_template expected[] = { content[2] };
+	const struct vy_stmt_template deferred[] = {
+		STMT_TEMPLATE_FLAGS(6, DELETE, VY_STMT_EXPIRED, 1, 0),
+	};
+	const int vlsns[] = {};
+	int content_count = sizeof(content) / sizeof(content[0]);
+	int expected_count = sizeof(expected) / sizeof(expected[0]);
+	int deferred_count = sizeof(deferred) / sizeof(deferred[0]);
+	int vlsns_count = sizeof(vlsns) / sizeof(vlsns[0]);
+	compare_write_iterator_results(content, content_count,
+				       expected, expected_count,
+				       deferred, deferred_count,
+				       vlsns, vlsns_count, true, true);
+}
+{
+/*
+ * STATEMENT: REPL(1, 1) REPL(1, 0) REPL(2, 2)
+ * LSN:          5          6          7
+ * FILTERED:                +
+ *
+ * is_last_level = false
+ *
+ * Check that a filtered statement is replaced with a DELETE
+ * if there may be older statements for the same key.
+ */
+	const struct vy_stmt_template content[] = {
+		STMT_TEMPLATE(5, REPLACE, 1, 1),
+		STMT_TEMPLATE(6, REPLACE, 1, 0),
+		STMT_TEMPLATE(7, REPLACE, 2, 2),
+	};
+	const struct vy_stmt_template expected[] = {
+		STMT_TEMPLATE(6, DELETE, 1), content[2]
+	};
+	const struct vy_stmt_template deferred[] = {
+		STMT_TEMPLATE_FLAGS(6, DELETE, VY_STMT_EXPIRED, 1, 0),
+	};
+	const int vlsns[] = {};
+	int content_count = sizeof(content) / sizeof(content[0]);
+	int expected_count = sizeof(expected) / sizeof(expected[0]);
+	int deferred_count = sizeof(deferred) / sizeof(deferred[0]);
+	int vlsns_count = sizeof(vlsns) / sizeof(vlsns[0]);
+	compare_write_iterator_results(content, content_count,
+				       expected, expected_count,
+				       deferred, deferred_count,
+				       vlsns, vlsns_count, true, false);
+}
+{
+/*
+ * STATEMENT: REPL(1, 1) REPL(1, 0)
+ * LSN:          4          6
+ * READ VIEW:         *
+ * FILTERED:                +
+ *
+ * is_last_level = true
+ *
+ * Check that the statement visible from a read view is kept
+ * even if a newer statement is filtered.
+ */
+	const struct vy_stmt_template content[] = {
+		STMT_TEMPLATE(4, REPLACE, 1, 1),
+		STMT_TEMPLATE(6, REPLACE, 1, 0),
+	};
+	const struct vy_stmt_template expected[] = {
+		STMT_TEMPLATE(6, DELETE, 1), content[0]
+	};
+	const struct vy_stmt_template deferred[] = {
+		STMT_TEMPLATE_FLAGS(6, DELETE, VY_STMT_EXPIRED, 1, 0),
+	};
+	const int vlsns[] = {5};
+	int content_count = sizeof(content) / sizeof(content[0]);
+	int expected_count = sizeof(expected) / sizeof(expected[0]);
+	int deferred_count = sizeof(deferred) / sizeof(deferred[0]);
+	int vlsns_count = sizeof(vlsns) / sizeof(vlsns[0]);
+	compare_write_iterator_results(content, content_count,
+				       expected, expected_count,
+				       deferred, deferred_count,
+				       vlsns, vlsns_count, true, true);
+}
+{
+/*
+ * STATEMENT: REPL(1, 0)
+ * LSN:          5
+ * READ VIEW:          *
+ *
+ * is_last_level = true
+ *
+ * Check that a statement visible from a read view is never
+ * filtered.
+ */
+	const struct vy_stmt_template content[] = {
+		STMT_TEMPLATE(5, REPLACE, 1, 0),
+	};
+	const struct vy_stmt_template expected[] = { content[0] };
+	const struct vy_stmt_template deferred[] = {};
+	const int vlsns[] = {7};
+	int content_count = sizeof(content) / sizeof(content[0]);
+	int expected_count = sizeof(expected) / sizeof(expected[0]);
+	int deferred_count = sizeof(deferred) / sizeof(deferred[0]);
+	int vlsns_count = sizeof(vlsns) / sizeof(vlsns[0]);
+	compare_write_iterator_results(content, content_count,
+				       expected, expected_count,
+				       deferred, deferred_count,
+				       vlsns, vlsns_count, true, true);
+}
+{
+/*
+ * STATEMENT: REPL(1, 1) REPL(1, 0) REPL(2, 2)
+ * LSN:          5          6          7
+ * DEFERRED DELETE:         +
+ * FILTERED:                +
+ *
+ * is_last_level = true
+ *
+ * Check that a filtered statement is purged from secondary
+ * indexes along with the tuple it overwrote.
+ */
+	const struct vy_stmt_template content[] = {
+		STMT_TEMPLATE(5, REPLACE, 1, 1),
+		STMT_TEMPLATE_DEFERRED_DELETE(6, REPLACE, 1, 0),
+		STMT_TEMPLATE(7, REPLACE, 2, 2),
+	};
+	const struct vy_stmt_template expected[] = { content[2] };
+	const struct vy_stmt_template deferred[] = {
+		STMT_TEMPLATE_FLAGS(6, DELETE, VY_STMT_EXPIRED, 1, 0),
+		STMT_TEMPLATE(6, DELETE, 1, 1),
+	};
+	const int vlsns[] = {};
+	int content_count = sizeof(content) / sizeof(content[0]);
+	int expected_count = sizeof(expected) / sizeof(expected[0]);
+	int deferred_count = sizeof(deferred) / sizeof(deferred[0]);
+	int vlsns_count = sizeof(vlsns) / sizeof(vlsns[0]);
+	compare_write_iterator_results(content, content_count,
+				       expected, expected_count,
+				       deferred, deferred_count,
+				       vlsns, vlsns_count, true, true);
+}
+	write_iterator_filter = NULL;
+	fiber_gc();
+	footer();
+	check_plan();
+}
+
 int
 main(int argc, char *argv[])
 {
 	vy_iterator_C_test_init(0);
 
 	test_basic();
+	test_compaction_filter();
 
 	vy_iterator_C_test_finish();
 	return 0;
@@ -0,0 +1,99 @@
+#include "salad/xor_filter.h"
+#include <unordered_set>
+#include <vector>
+#include <iostream>
+#include <string.h>
+#include <stdlib.h>
+
+using namespace std;
+
+uint32_t h(uint32_t i)
+{
+	return i * 2654435761;
+}
+
+void
+simple_test()
+{
+	cout << "*** " << __func__ << " ***" << endl;
+	struct quota q;
+	quota_init(&q, 100500000);
+	srand(time(0));
+	uint32_t error_count = 0;
+	uint32_t fp_rate_too_big = 0;
+	for (uint32_t count = 0; count <= 100000; count = count * 3 + 1) {
+		uint64_t tests = 0;
+		uint64_t false_positive = 0;
+		unordered_set<uint32_t> check;
+		vector<uint32_t> hashes;
+		for (uint32_t i = 0; i < count; i++) {
+			uint32_t val = rand() % (count * 10);
+			check.insert(val);
+			hashes.push_back(h(val));
+		}
+		struct xor_filter filter;
+		xor_filter_create(&filter, hashes.data(), hashes.size(), &q);
+		for (uint32_t i = 0; i < count * 10 + 1000; i++) {
+			bool has = check.find(i) != check.end();
+			bool filter_possible =
+				xor_filter_maybe_has(&filter, h(i));
+			tests++;
+			if (has && !filter_possible)
+				error_count++;
+			if (!has && filter_possible)
+				false_positive++;
+		}
+		xor_filter_destroy(&filter, &q);
+		double fp_rate = (double)false_positive / tests;
+		if (fp_rate > xor_filter_fpr(&filter) * 2 + 0.005)
+			fp_rate_too_big++;
+	}
+	cout << "error_count = " << error_count << endl;
+	cout << "fp_rate_too_big = " << fp_rate_too_big << endl;
+	cout << "memory after destruction = " << quota_used(&q) << endl << endl;
+}
+
+void
+store_load_test()
+{
+	cout << "*** " << __func__ << " ***" << endl;
+	struct quota q;
+	quota_init(&q, 100500000);
+	srand(time(0));
+	uint32_t error_count = 0;
+	for (uint32_t count = 300; count <= 30000; count *= 10) {
+		unordered_set<uint32_t> check;
+		vector<uint32_t> hashes;
+		for (uint32_t i = 0; i < count; i++) {
+			uint32_t val = rand() % (count * 10);
+			check.insert(val);
+			hashes.push_back(h(val));
+		}
+		struct xor_filter filter;
+		xor_filter_create(&filter, hashes.data(), hashes.size(), &q);
+		struct xor_filter test = filter;
+		char *buf = (char *)malloc(xor_filter_store_size(&filter));
+		xor_filter_store(&filter, buf);
+		xor_filter_destroy(&filter, &q);
+		memset(&filter, '#', sizeof(filter));
+		test.table = NULL;
+		test.segment_count_length = 0;
+		xor_filter_load_table(&test, buf, &q);
+		free(buf);
+		for (uint32_t i = 0; i < count * 10; i++) {
+			bool has = check.find(i) != check.end();
+			if (has && !xor_filter_maybe_has(&test, h(i)))
+				error_count++;
+		}
+		xor_filter_destroy(&test, &q);
+	}
+	cout << "error_count = " << error_count << endl;
+	cout << "memory after destruction = " << quota_used(&q) << endl << endl;
+}
+
+int
+main(void)
+{
+	simple_test();
+	store_load_test();
+}
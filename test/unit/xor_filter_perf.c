@@ -0,0 +1,154 @@
+/*
+ * Compare build time, probe time, memory usage and false positive
+ * rate of the classic bloom filter and the binary fuse filter.
+ * Not run by the test suite, since the results depend on hardware.
+ *
+ * Usage: xor_filter.perf [number of keys]
+ */
+#include "salad/bloom.h"
+#include "salad/xor_filter.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+static double
+clock_monotonic(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static uint32_t
+h(uint32_t i)
+{
+	return i * 2654435761U;
+}
+
+struct result {
+	const char *name;
+	double build_ns;
+	double probe_hit_ns;
+	double probe_miss_ns;
+	double bits_per_key;
+	double fpr;
+};
+
+static void
+print_result(const struct result *r)
+{
+	printf("%-16s %10.1f %10.1f %10.1f %10.2f %10.4f%%\n",
+	       r->name, r->build_ns, r->probe_hit_ns, r->probe_miss_ns,
+	       r->bits_per_key, r->fpr * 100);
+}
+
+static void
+bench_bloom(const char *name, const uint32_t *keys, uint32_t count,
+	    double fpr, struct quota *quota, struct result *r)
+{
+	r->name = name;
+	double t = clock_monotonic();
+	struct bloom bloom;
+	if (bloom_create(&bloom, count, fpr, quota) != 0)
+		abort();
+	for (uint32_t i = 0; i < count; i++)
+		bloom_add(&bloom, h(keys[i]));
+	r->build_ns = (clock_monotonic() - t) * 1e9 / count;
+
+	uint32_t found = 0;
+	t = clock_monotonic();
+	for (uint32_t i = 0; i < count; i++)
+		found += bloom_maybe_has(&bloom, h(keys[i]));
+	r->probe_hit_ns = (clock_monotonic() - t) * 1e9 / count;
+	if (found != count)
+		abort();
+
+	found = 0;
+	t = clock_monotonic();
+	for (uint32_t i = 0; i < count; i++)
+		found += bloom_maybe_has(&bloom, h(count + i));
+	r->probe_miss_ns = (clock_monotonic() - t) * 1e9 / count;
+	r->fpr = (double)found / count;
+	r->bits_per_key = bloom_store_size(&bloom) * 8.0 / count;
+	bloom_destroy(&bloom, quota);
+}
+
+static void
+bench_xor_filter(const char *name, const uint32_t *keys, uint32_t count,
+		 struct quota *quota, struct result *r)
+{
+	r->name = name;
+	uint32_t *hashes = malloc(count * sizeof(*hashes));
+	if (hashes == NULL)
+		abort();
+	double t = clock_monotonic();
+	for (uint32_t i = 0; i < count; i++)
+		hashes[i] = h(keys[i]);
+	struct xor_filter filter;
+	if (xor_filter_create(&filter, hashes, count, quota) != 0)
+		abort();
+	r->build_ns = (clock_monotonic() - t) * 1e9 / count;
+	free(hashes);
+
+	uint32_t found = 0;
+	t = clock_monotonic();
+	for (uint32_t i = 0; i < count; i++)
+		found += xor_filter_maybe_has(&filter, h(keys[i]));
+	r->probe_hit_ns = (clock_monotonic() - t) * 1e9 / count;
+	if (found != count)
+		abort();
+
+	found = 0;
+	t = clock_monotonic();
+	for (uint32_t i = 0; i < count; i++)
+		found += xor_filter_maybe_has(&filter, h(count + i));
+	r->probe_miss_ns = (clock_monotonic() - t) * 1e9 / count;
+	r->fpr = (double)found / count;
+	r->bits_per_key = xor_filter_store_size(&filter) * 8.0 / count;
+	xor_filter_destroy(&filter, quota);
+}
+
+int
+main(int argc, char **argv)
+{
+	uint32_t count = 1000000;
+	if (argc > 1)
+		count = atoi(argv[1]);
+	if (count == 0)
+		count = 1;
+
+	/* Keys are a random permutation of [0, count). */
+	uint32_t *keys = malloc(count * sizeof(*keys));
+	if (keys == NULL)
+		abort();
+	for (uint32_t i = 0; i < count; i++)
+		keys[i] = i;
+	srand(time(NULL));
+	for (uint32_t i = count - 1; i > 0; i--) {
+		uint32_t j = rand() % (i + 1);
+		uint32_t tmp = keys[i];
+		keys[i] = keys[j];
+		keys[j] = tmp;
+	}
+
+	struct quota quota;
+	quota_init(&quota, QUOTA_MAX);
+
+	printf("keys: %u\n", count);
+	printf("%-16s %10s %10s %10s %10s %11s\n", "filter",
+	       "build ns", "hit ns", "miss ns", "bits/key", "fpr");
+
+	struct result r;
+	bench_bloom("bloom 5%", keys, count, 0.05, &quota, &r);
+	print_result(&r);
+	bench_bloom("bloom 1%", keys, count, 0.01, &quota, &r);
+	print_result(&r);
+	bench_bloom("bloom 0.39%", keys, count, 1.0 / 256, &quota, &r);
+	print_result(&r);
+	bench_xor_filter("xor 0.39%", keys, count, &quota, &r);
+	print_result(&r);
+
+	free(keys);
+	return 0;
+}
@@ -0,0 +1,135 @@
+#include <string.h>
+#include <msgpuck.h>
+#include <small/ibuf.h>
+
+#include "unit.h"
+#include "memory.h"
+#include "fiber.h"
+#include "box/iproto_constants.h"
+#include "box/vclock.h"
+#include "box/xrow.h"
+#include "box/xrow_buf.h"
+
+enum { ROW_PADDING_SIZE = 100 };
+
+/** Append rows from replica 1 with LSNs in range [from, to]. */
+static void
+write_rows(struct xrow_buf *buf, int64_t from, int64_t to)
+{
+	char padding[ROW_PADDING_SIZE];
+	memset(padding, 'x', sizeof(padding));
+	char body[ROW_PADDING_SIZE + 32];
+	for (int64_t lsn = from; lsn <= to; lsn++) {
+		char *pos = mp_encode_array(body, 2);
+		pos = mp_encode_uint(pos, lsn);
+		pos = mp_encode_str(pos, padding, sizeof(padding));
+		struct xrow_header row;
+		memset(&row, 0, sizeof(row));
+		row.type = IPROTO_INSERT;
+		row.replica_id = 1;
+		row.lsn = lsn;
+		row.bodycnt = 1;
+		row.body[0].iov_base = body;
+		row.body[0].iov_len = pos - body;
+		struct xrow_header *rows[] = { &row };
+		fail_unless(xrow_buf_write(buf, rows, rows + 1) == 0);
+	}
+	fiber_gc();
+}
+
+/**
+ * Read all rows following the cursor. Return the number of
+ * rows newer than @vclock or -1 if the cursor is stale.
+ */
+static int
+read_rows(struct xrow_buf *buf, struct xrow_buf_cursor *cursor,
+	  struct vclock *vclock)
+{
+	int count = 0;
+	struct ibuf ibuf;
+	ibuf_create(&ibuf, &cord()->slabc, 1024);
+	while (true) {
+		ibuf_reset(&ibuf);
+		int rc = xrow_buf_cursor_read(buf, cursor, &ibuf, 1024);
+		fail_unless(rc >= 0);
+		if (rc > 0) {
+			count = -1;
+			break;
+		}
+		if (ibuf_used(&ibuf) == 0)
+			break;
+		const char *pos = ibuf.rpos;
+		while (pos < (const char *)ibuf.wpos) {
+			struct xrow_header row;
+			fail_unless(xrow_buf_decode(&row, &pos, ibuf.wpos) == 0);
+			fail_unless(row.type == IPROTO_INSERT);
+			fail_unless(row.bodycnt == 1);
+			const char *data = row.body[0].iov_base;
+			fail_unless(mp_decode_array(&data) == 2);
+			fail_unless(mp_decode_uint(&data) == (uint64_t)row.lsn);
+			if (row.lsn <= vclock_get(vclock, row.replica_id))
+				continue;
+			vclock_follow(vclock, row.replica_id, row.lsn);
+			count++;
+		}
+	}
+	ibuf_destroy(&ibuf);
+	return count;
+}
+
+static void
+test_basic(void)
+{
+	struct vclock vclock;
+	vclock_create(&vclock);
+	struct xrow_buf buf;
+	/* 16 chunks, 1 KB each. */
+	xrow_buf_create(&buf, &vclock, 16 * 1024);
+
+	struct xrow_buf_cursor cursor;
+	struct vclock replica;
+	vclock_create(&replica);
+	is(xrow_buf_cursor_create(&buf, &cursor, &replica), 0,
+	   "cursor at the buffer start");
+	is(read_rows(&buf, &cursor, &replica), 0, "empty buffer");
+
+	write_rows(&buf, 1, 10);
+	is(read_rows(&buf, &cursor, &replica), 10, "read appended rows");
+	write_rows(&buf, 11, 20);
+	is(read_rows(&buf, &cursor, &replica), 10, "read more rows");
+	is(vclock_get(&replica, 1), 20, "reader vclock");
+
+	struct vclock lagging;
+	vclock_create(&lagging);
+	vclock_follow(&lagging, 1, 15);
+	struct xrow_buf_cursor lagging_cursor;
+	is(xrow_buf_cursor_create(&buf, &lagging_cursor, &lagging), 0,
+	   "cursor in the middle");
+	is(read_rows(&buf, &lagging_cursor, &lagging), 5,
+	   "rows seen by the reader are skipped");
+
+	/* Overwrite the whole ring. */
+	write_rows(&buf, 21, 1000);
+	is(read_rows(&buf, &cursor, &replica), -1, "stale cursor");
+	vclock_create(&lagging);
+	is(xrow_buf_cursor_create(&buf, &lagging_cursor, &lagging), -1,
+	   "rows are not in the buffer");
+
+	xrow_buf_set_size(&buf, 0);
+	is(xrow_buf_cursor_create(&buf, &lagging_cursor, &buf.vclock), -1,
+	   "disabled buffer");
+
+	xrow_buf_destroy(&buf);
+}
+
+int
+main(void)
+{
+	memory_init();
+	fiber_init(fiber_c_invoke);
+	plan(10);
+	test_basic();
+	fiber_free();
+	memory_free();
+	return check_plan();
+}
@@ -0,0 +1,86 @@
+test_run = require('test_run').new()
+fiber = require('fiber')
+
+--
+-- Big field values stored in blob files.
+--
+s = box.schema.space.create('test', {engine = 'vinyl'})
+-- The option is only supported by the primary index.
+_ = s:create_index('pk', {blob_threshold = 10})
+pk = s:create_index('pk', {run_count_per_level = 10, blob_threshold = 100})
+pk.options.blob_threshold
+_ = s:create_index('sk', {parts = {2, 'unsigned'}, blob_threshold = 100})
+
+function stat(i) \
+    local st = (i or pk):stat().disk.blob \
+    return st.count, st.bytes, st.garbage \
+end
+function compact() \
+    local count = pk:stat().disk.compact.count \
+    pk:compact() \
+    while pk:stat().disk.compact.count == count do fiber.sleep(0.001) end \
+end
+
+-- Small values stay in runs.
+for i = 1, 100 do s:replace{i, string.rep('x', 10)} end
+box.snapshot()
+stat()
+
+-- Big values go to a blob file on dump.
+for i = 1, 100 do s:replace{i, string.rep('x', 1000)} end
+box.snapshot()
+stat()
+#s:select()
+s:get(50)[2] == string.rep('x', 1000)
+
+-- Overwritten values become garbage after compaction.
+for i = 1, 60 do s:replace{i, i} end
+box.snapshot()
+compact()
+stat()
+s:get(10)
+s:get(70)[2] == string.rep('x', 1000)
+
+-- Upserts are applied to values stored in blob files.
+s:upsert({70, 0}, {{'=', 2, 'y'}})
+s:upsert({71, 0}, {{'!', 3, 'z'}})
+box.snapshot()
+s:get(70)
+s:get(71)[2] == string.rep('x', 1000)
+s:get(71)[3]
+
+-- Compaction relocates live values of a blob file
+-- that is mostly garbage and deletes the file.
+for i = 72, 80 do s:delete(i) end
+box.snapshot()
+compact()
+stat()
+#s:select()
+s:get(100)[2] == string.rep('x', 1000)
+
+-- Fields that may be stored in blob files can't be typed.
+s:format{{'id', 'unsigned'}, {'data', 'string'}}
+s:format{{'id', 'unsigned'}, {'data', 'any'}}
+
+-- Blob files are recovered on restart.
+test_run:cmd('restart server default')
+fiber = require('fiber')
+s = box.space.test
+pk = s.index.pk
+function stat(i) \
+    local st = (i or pk):stat().disk.blob \
+    return st.count, st.bytes, st.garbage \
+end
+pk.options.blob_threshold
+stat()
+#s:select()
+s:get(71)[2] == string.rep('x', 1000)
+s:get(100)[2] == string.rep('x', 1000)
+
+-- Secondary indexes store only key fields so they don't need
+-- blob files. Building one reads values from blob files.
+sk = s:create_index('sk', {parts = {1, 'unsigned'}, unique = false})
+sk:count()
+stat(sk)
+
+s:drop()
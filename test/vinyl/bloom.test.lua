@@ -133,3 +133,79 @@ new_seeks() < 20
 s:drop()
 
 box.cfg{vinyl_cache = vinyl_cache}
+
+--
+-- Binary fuse (xor) filter.
+--
+s = box.schema.space.create('test', {engine = 'vinyl'})
+s:create_index('pk', {bloom_type = 'foo'})
+_ = s:create_index('pk', {parts = {1, 'unsigned', 2, 'unsigned'}, bloom_type = 'xor'})
+s.index.pk.options.bloom_type
+
+box.cfg{vinyl_cache = 0}
+
+for i = 1, 1000 do s:replace{math.ceil(i / 10), i} end
+box.snapshot()
+
+--
+-- There are 100 unique first key parts and 1000 unique full keys.
+-- A binary fuse filter of this size takes about 1.6 bits per key
+-- (192 bytes) for the first part and about 11 bits per key (1408
+-- bytes) for the second part plus the header overhead.
+--
+size = s.index.pk:stat().disk.bloom_size
+size > 1600 and size < 1700
+
+reflects = 0
+seeks = 0
+_ = new_reflects()
+_ = new_seeks()
+
+for i = 1, 100 do s:select{i} end
+new_reflects() == 0
+new_seeks() == 100
+
+for i = 1, 1000 do s:select{math.ceil(i / 10), i} end
+new_reflects() == 0
+new_seeks() == 1000
+
+for i = 101, 1100 do s:select{i} end
+new_reflects() > 980
+new_seeks() < 20
+
+for i = 1, 1000 do s:select{math.ceil(i / 10), 2000 + i} end
+new_reflects() > 980
+new_seeks() < 20
+
+-- The filter survives restart.
+test_run:cmd('restart server default')
+
+vinyl_cache = box.cfg.vinyl_cache
+box.cfg{vinyl_cache = 0}
+
+s = box.space.test
+s.index.pk.options.bloom_type
+s.index.pk:stat().disk.bloom_size > 1600
+
+reflects = 0
+function cur_reflects() return box.space.test.index.pk:stat().disk.iterator.bloom.hit end
+function new_reflects() local o = reflects reflects = cur_reflects() return reflects - o end
+seeks = 0
+function cur_seeks() return box.space.test.index.pk:stat().disk.iterator.lookup end
+function new_seeks() local o = seeks seeks = cur_seeks() return seeks - o end
+
+for i = 1, 1000 do s:select{math.ceil(i / 10), i} end
+new_reflects() == 0
+new_seeks() == 1000
+
+for i = 1, 1000 do s:select{math.ceil(i / 10), 2000 + i} end
+new_reflects() > 980
+new_seeks() < 20
+
+-- The filter type can be changed on the fly.
+s.index.pk:alter{bloom_type = 'bloom'}
+s.index.pk.options.bloom_type
+
+s:drop()
+
+box.cfg{vinyl_cache = vinyl_cache}
@@ -95,3 +95,81 @@ compact()
 info() -- 4 ranges, 4 runs
 
 s:drop()
+
+--
+-- Tiered compaction: a run is merged only when the newer
+-- runs have grown as big as the run itself.
+--
+s = box.schema.space.create('test', {engine = 'vinyl'})
+s:create_index('pk', {compaction = 'foo'})
+_ = s:create_index('pk', {run_count_per_level = 2, compaction = 'tiered'})
+s.index.pk.options.compaction
+
+test_run:cmd("setopt delimiter ';'")
+key = 0
+function dump_keys(count)
+    for i = 1, count do
+        key = key + 1
+        s:replace{key, digest.urandom(1000)}
+    end
+    box.snapshot()
+end;
+test_run:cmd("setopt delimiter ''");
+
+dump_keys(25)
+dump_keys(10)
+dump_keys(10)
+s.index.pk:stat().run_count -- 3
+
+dump_keys(10)
+while s.index.pk:stat().disk.compact.count < 1 do fiber.sleep(0.01) end
+s.index.pk:stat().run_count -- 1
+
+for i = 1, 10 do s:get{i} end
+st = s.index.pk:stat().amplification
+st.write
+st.read
+st.space
+
+s.index.pk:alter{compaction = 'leveled'}
+s.index.pk.options.compaction
+
+s:drop()
+
+--
+-- Subcompactions: a big compaction is split in parts
+-- processed by different workers, each writing its own run.
+--
+box.cfg{vinyl_max_subcompactions = 0}
+box.cfg{vinyl_max_subcompactions = 3}
+s = box.schema.space.create('test', {engine = 'vinyl'})
+_ = s:create_index('pk', {page_size = 256, run_count_per_level = 1})
+
+for i = 1, 200 do s:replace{i, 1, string.rep('x', 100)} end
+box.snapshot()
+for i = 1, 200 do s:replace{i, 2, string.rep('x', 100)} end
+box.snapshot()
+while s.index.pk:stat().disk.compact.count < 1 do fiber.sleep(0.01) end
+s.index.pk:stat().run_count -- 3
+s.index.pk:stat().range_count -- 1
+s:count()
+s:count({100}, {iterator = 'ge'})
+#s:select({}, {iterator = 'ge'})
+#s:select({}, {iterator = 'le'})
+cnt = 0
+for _, t in s:pairs() do if t[2] == 2 then cnt = cnt + 1 end end
+cnt
+
+-- Runs written by a split compaction are counted as one run
+-- when deciding what to compact.
+for i = 1, 300 do s:replace{i, 3, string.rep('x', 100)} end
+box.snapshot()
+while s.index.pk:stat().disk.compact.count < 2 do fiber.sleep(0.01) end
+s.index.pk:stat().run_count -- 3
+s:count()
+cnt = 0
+for _, t in s:pairs() do if t[2] == 3 then cnt = cnt + 1 end end
+cnt
+
+s:drop()
+box.cfg{vinyl_max_subcompactions = 1}
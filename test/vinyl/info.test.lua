@@ -68,10 +68,16 @@ end;
 -- Return index statistics.
 --
 -- Note, latency measurement is beyond the scope of this test
--- so we just filter it out.
+-- so we just filter it out. Amplification factors are derived
+-- from other counters and checked by vinyl/compact.test.lua.
+-- Readahead counters are checked by vinyl/readahead.test.lua.
+-- Blob file counters are checked by vinyl/blob.test.lua.
 function istat()
     local st = box.space.test.index.pk:stat()
     st.latency = nil
+    st.amplification = nil
+    st.disk.iterator.readahead = nil
+    st.disk.blob = nil
     return st
 end;
 
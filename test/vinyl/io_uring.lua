@@ -0,0 +1,9 @@
+#!/usr/bin/env tarantool
+
+box.cfg{
+    listen = os.getenv("LISTEN"),
+    io_uring = true,
+    wal_mode = 'fsync',
+}
+
+require('console').listen(os.getenv('ADMIN'))
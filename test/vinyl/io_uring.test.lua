@@ -0,0 +1,95 @@
+test_run = require('test_run').new()
+fiber = require('fiber')
+
+-- io_uring can only be set on startup.
+box.cfg.io_uring
+box.cfg{io_uring = true}
+
+test_run:cmd("create server test with script='vinyl/io_uring.lua'")
+test_run:cmd("start server test")
+-- The ring must be set up for both WAL and vinyl.
+test_run:grep_log('test', 'io_uring is unavailable') == nil
+test_run:cmd('switch test')
+
+fiber = require('fiber')
+box.cfg.io_uring
+box.cfg.wal_mode
+
+--
+-- Check that WAL writes synced through the ring are acked in
+-- order and survive restart.
+--
+s = box.schema.space.create('test')
+_ = s:create_index('pk')
+test_run:cmd("setopt delimiter ';'")
+function write(id)
+    for i = 1, 100 do s:replace{id * 1000 + i, id} end
+end;
+test_run:cmd("setopt delimiter ''");
+fibers = {}
+for i = 1, 10 do fibers[i] = fiber.new(write, i) fibers[i]:set_joinable(true) end
+for i = 1, 10 do fibers[i]:join() end
+s:count()
+
+--
+-- Check that pages read through the ring return the same
+-- data as pages read by reader threads.
+--
+v = box.schema.space.create('test_vinyl', {engine = 'vinyl'})
+_ = v:create_index('pk', {page_size = 1000, run_count_per_level = 10})
+pad = string.rep('x', 333)
+for i = 1, 300 do v:replace{i, pad} end
+box.snapshot()
+for i = 1, 300, 3 do v:replace{i, pad .. 'y'} end
+box.snapshot()
+v.index.pk:stat().run_count
+
+test_run:cmd("setopt delimiter ';'")
+function check()
+    local count, sum = 0, 0
+    for _, t in v:pairs() do
+        count = count + 1
+        sum = sum + t[1] + #t[2]
+    end
+    return {count, sum}
+end;
+function get_all(from)
+    for i = from, 300, 10 do
+        local t = v:get(i)
+        if t == nil or t[2] ~= (i % 3 == 1 and pad .. 'y' or pad) then
+            error('wrong tuple ' .. i)
+        end
+    end
+end;
+test_run:cmd("setopt delimiter ''");
+check()
+
+-- Concurrent point lookups, each yielding on its own read.
+box.cfg{vinyl_cache = 0, vinyl_page_cache = 0}
+for i = 1, 10 do fibers[i] = fiber.new(get_all, i) fibers[i]:set_joinable(true) end
+ok = true
+for i = 1, 10 do ok = fibers[i]:join() and ok end
+ok
+
+v.index.pk:compact()
+test_run:wait_cond(function() return v.index.pk:stat().run_count == 1 end)
+check()
+
+test_run:cmd('switch default')
+test_run:cmd('restart server test')
+test_run:cmd('switch test')
+s = box.space.test
+v = box.space.test_vinyl
+box.cfg.io_uring
+s:count()
+s:get{10100}
+v:count()
+v:get(298)[2] == string.rep('x', 333) .. 'y'
+v:get(299)[2] == string.rep('x', 333)
+
+s:drop()
+v:drop()
+
+test_run:cmd('switch default')
+test_run:cmd("stop server test")
+test_run:cmd("cleanup server test")
@@ -0,0 +1,46 @@
+test_run = require('test_run').new()
+
+--
+-- Shared cache of decompressed run pages.
+--
+vinyl_cache = box.cfg.vinyl_cache
+box.cfg{vinyl_cache = 0, vinyl_page_cache = 1024 * 1024}
+
+s = box.schema.space.create('test', {engine = 'vinyl'})
+pk = s:create_index('pk', {page_size = 1024, run_count_per_level = 10})
+for i = 1, 100 do s:replace{i, string.rep('x', 100)} end
+box.snapshot()
+
+-- The first lookup of each page reads it from disk.
+gst = box.stat.vinyl().page_cache
+st = pk:stat().disk.iterator.read
+for i = 1, 100 do s:get{i} end
+box.stat.vinyl().page_cache.miss > gst.miss
+pk:stat().disk.iterator.read.pages > st.pages
+box.stat.vinyl().memory.page_cache > 0
+
+-- Pages are found in the cache on the second lookup.
+gst = box.stat.vinyl().page_cache
+st = pk:stat().disk.iterator.read
+for i = 1, 100 do s:get{i} end
+box.stat.vinyl().page_cache.miss == gst.miss
+box.stat.vinyl().page_cache.hit >= gst.hit + 100
+pk:stat().disk.iterator.read.pages == st.pages
+
+-- Shrinking the cache evicts pages.
+box.cfg{vinyl_page_cache = 4096}
+box.stat.vinyl().memory.page_cache <= 4096
+box.stat.vinyl().page_cache.evict > gst.evict
+
+-- Zero disables the cache.
+box.cfg{vinyl_page_cache = 0}
+box.stat.vinyl().memory.page_cache
+gst = box.stat.vinyl().page_cache
+st = pk:stat().disk.iterator.read
+for i = 1, 100 do s:get{i} end
+box.stat.vinyl().page_cache.hit == gst.hit
+box.stat.vinyl().page_cache.miss == gst.miss
+pk:stat().disk.iterator.read.pages > st.pages
+
+s:drop()
+box.cfg{vinyl_cache = vinyl_cache}
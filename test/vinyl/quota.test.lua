@@ -82,3 +82,14 @@ box.cfg.vinyl_memory
 test_run:cmd('switch default')
 test_run:cmd("stop server test")
 test_run:cmd("cleanup server test")
+
+--
+-- Transactions are paced by a rate limit, which is lifted
+-- while memory usage is below the dump watermark and there's
+-- no compaction debt.
+--
+st = box.stat.vinyl().regulator
+st.rate_limit
+st.throttle_time >= 0
+st.compaction_debt >= 0
+st.compaction_rate >= 0
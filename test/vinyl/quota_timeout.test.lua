@@ -98,6 +98,42 @@ _ = s2:auto_increment{pad}
 while s1.index.pk:stat().disk.dump.count == 0 do fiber.sleep(0.01) end
 s1.index.pk:stat().memory.bytes == 0
 
+s1:drop()
+s2:drop()
+
+--
+-- Check that transactions are throttled once memory usage
+-- exceeds the dump watermark while dump is in progress and
+-- that the rate limit never drops below 100 KB/s.
+--
+box.cfg{vinyl_timeout = 60}
+box.error.injection.set('ERRINJ_VY_RUN_WRITE_TIMEOUT', 2)
+
+s = box.schema.space.create('test', {engine = 'vinyl'})
+_ = s:create_index('pk')
+
+throttle_time = box.stat.vinyl().regulator.throttle_time
+box.stat.vinyl().regulator.rate_limit == 0
+
+pad = string.rep('x', 100 * 1024)
+c = fiber.channel(1)
+_ = fiber.create(function() for i = 1, 15 do s:replace{i, pad} end c:put(true) end)
+rate_limit = 0
+test_run:cmd("setopt delimiter ';'")
+for i = 1, 1000 do
+    rate_limit = box.stat.vinyl().regulator.rate_limit
+    if rate_limit > 0 then break end
+    fiber.sleep(0.01)
+end;
+test_run:cmd("setopt delimiter ''");
+rate_limit > 0
+rate_limit >= 100 * 1024
+c:get()
+box.stat.vinyl().regulator.throttle_time > throttle_time
+
+box.error.injection.set('ERRINJ_VY_RUN_WRITE_TIMEOUT', 0)
+s:drop()
+
 test_run:cmd('switch default')
 test_run:cmd("stop server test")
 test_run:cmd("cleanup server test")
@@ -0,0 +1,54 @@
+test_run = require('test_run').new()
+
+--
+-- Readahead of run pages on sequential scans.
+--
+box.cfg.vinyl_readahead
+box.cfg{vinyl_readahead = -1}
+
+vinyl_cache = box.cfg.vinyl_cache
+box.cfg{vinyl_cache = 0}
+
+s = box.schema.space.create('test', {engine = 'vinyl'})
+pk = s:create_index('pk', {page_size = 1024, run_count_per_level = 10})
+for i = 1, 100 do s:replace{i, string.rep('x', 100)} end
+box.snapshot()
+
+-- Readahead is disabled by default.
+st1 = pk:stat().disk.iterator
+#s:select()
+st2 = pk:stat().disk.iterator
+st2.read.pages > 4
+st2.readahead.useful - st1.readahead.useful
+st2.readahead.wasted - st1.readahead.wasted
+
+-- A sequential scan reads pages ahead, but doesn't read more.
+box.cfg{vinyl_readahead = 4}
+#s:select()
+st3 = pk:stat().disk.iterator
+st3.read.pages - st2.read.pages == st2.read.pages - st1.read.pages
+st3.readahead.useful - st2.readahead.useful > 0
+st3.readahead.wasted - st2.readahead.wasted
+
+-- So does a reverse scan.
+#s:select({}, {iterator = 'LE'})
+st4 = pk:stat().disk.iterator
+st4.readahead.useful - st3.readahead.useful > 0
+st4.readahead.wasted - st3.readahead.wasted
+
+-- Point lookups don't trigger readahead.
+for i = 1, 100, 10 do s:get{i} end
+st5 = pk:stat().disk.iterator
+st5.read.pages > st4.read.pages
+st5.readahead.useful - st4.readahead.useful
+st5.readahead.wasted - st4.readahead.wasted
+
+-- A scan stopped early wastes pages read ahead.
+#s:select({}, {limit = 50})
+st6 = pk:stat().disk.iterator
+st6.readahead.useful - st5.readahead.useful > 0
+st6.readahead.wasted - st5.readahead.wasted > 0
+
+s:drop()
+box.cfg{vinyl_readahead = 0}
+box.cfg{vinyl_cache = vinyl_cache}
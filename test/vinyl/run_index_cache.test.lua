@@ -0,0 +1,39 @@
+test_run = require('test_run').new()
+
+--
+-- Eviction of run bloom filters and page indexes.
+--
+s = box.schema.space.create('test', {engine = 'vinyl'})
+pk = s:create_index('pk', {run_count_per_level = 10})
+for i = 1, 10 do s:replace{i, i} end
+box.snapshot()
+for i = 11, 20 do s:replace{i, i} end
+box.snapshot()
+for i = 21, 30 do s:replace{i, i} end
+box.snapshot()
+pk:stat().run_count
+
+gst = box.stat.vinyl()
+index_size = pk:stat().disk.index_size
+gst.memory.page_index > 0
+gst.memory.bloom_filter > 0
+
+-- All run indexes but the most recently used one are evicted.
+box.cfg{vinyl_run_index_cache = 1}
+st = box.stat.vinyl()
+st.run_index.evict - gst.run_index.evict >= 2
+st.memory.page_index < gst.memory.page_index
+st.memory.bloom_filter < gst.memory.bloom_filter
+
+-- Evicted run indexes are loaded on demand.
+s:get{5}
+s:get{15}
+s:get{25}
+box.stat.vinyl().run_index.load > st.run_index.load
+#pk:select()
+
+-- Index statistics don't depend on eviction.
+pk:stat().disk.index_size == index_size
+
+box.cfg{vinyl_run_index_cache = 0}
+s:drop()
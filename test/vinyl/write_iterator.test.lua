@@ -417,3 +417,61 @@ sk:stat().disk.compact.count -- 1
 pk:select(1000, {iterator = 'LE'}) -- empty
 sk:select(1000, {iterator = 'LE'}) -- empty
 s:drop()
+
+--
+-- Expired tuples are dropped on dump and compaction.
+--
+s = box.schema.space.create('test', {engine = 'vinyl'})
+pk = s:create_index('pk', {expire_field = 3, run_count_per_level = 10})
+pk.options.expire_field
+s:create_index('sk', {parts = {2, 'string'}, expire_field = 3})
+function keys() return s:pairs():map(function(t) return t[1] end):totable() end
+now = fiber.time()
+_ = s:replace{1, 'a', now - 100}
+_ = s:replace{2, 'b', now + 100000}
+_ = s:replace{3, 'c'}
+_ = s:replace{4, 'd', 'never'}
+-- Expired tuples are visible until dumped.
+keys() -- {1, 2, 3, 4}
+-- Nothing to shadow on the last level: the tuple is skipped.
+box.snapshot()
+pk:stat().disk.rows -- 3
+keys() -- {2, 3, 4}
+-- The tuple is replaced with a DELETE to shadow the older run.
+_ = s:replace{2, 'b', now - 1}
+box.snapshot()
+pk:stat().disk.rows -- 4
+keys() -- {3, 4}
+pk:compact()
+while pk:stat().disk.compact.count == 0 do fiber.sleep(0.001) end
+pk:stat().disk.rows -- 2
+keys() -- {3, 4}
+s:drop()
+
+--
+-- Expired tuples are purged from secondary indexes on primary
+-- index compaction.
+--
+s = box.schema.space.create('test', {engine = 'vinyl'})
+pk = s:create_index('pk', {expire_field = 3})
+sk = s:create_index('sk', {parts = {2, 'unsigned'}})
+now = fiber.time()
+for i = 1, 10 do s:replace{i, i * 10, i <= 5 and now - 100 or now + 100000} end
+-- Expired tuples aren't dropped on dump if there are secondary
+-- indexes, because there would be nobody to purge them.
+box.snapshot()
+pk:stat().disk.rows -- 10
+sk:len() -- 10
+bsize = sk:bsize()
+pk:compact()
+while pk:stat().disk.compact.count == 0 do fiber.sleep(0.001) end
+pk:stat().disk.rows -- 5
+-- Deferred DELETEs shadow expired tuples in the secondary index.
+box.snapshot()
+sk:len() -- 15
+sk:compact()
+while sk:stat().disk.compact.count == 0 do fiber.sleep(0.001) end
+sk:len() -- 5
+sk:bsize() < bsize -- true
+sk:pairs():map(function(t) return t[2] end):totable()
+s:drop()
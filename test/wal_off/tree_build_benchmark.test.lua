@@ -0,0 +1,62 @@
+n_records = 300000
+env = require('test_run')
+test_run = env.new()
+clock = require('clock')
+digest = require('digest')
+
+file = io.open("tree_build_benchmark.res", "w")
+
+--
+-- Measure the time it takes to build a tree index over the
+-- tuples of a space, see memtx_tree_index_end_build(), with
+-- different numbers of sort threads.
+--
+s = box.schema.space.create('treebench')
+_ = s:create_index('primary')
+test_run:cmd("setopt delimiter ';'")
+for i = 1, n_records do
+    s:insert{i, math.random(n_records), digest.md5_hex(tostring(i))}
+end;
+
+-- Check that an index lists all tuples in the order of its key.
+function check(index)
+    local count = 0
+    local prev = nil
+    for _, t in index:pairs() do
+        if prev ~= nil and index.parts[1].type == 'string' and
+           prev[3] >= t[3] then
+            return false
+        end
+        if prev ~= nil and index.parts[1].type == 'unsigned' and
+           (prev[2] > t[2] or prev[2] == t[2] and prev[1] >= t[1]) then
+            return false
+        end
+        count = count + 1
+        prev = t
+    end
+    return count == n_records
+end;
+
+function bench(name, opts)
+    local ok = true
+    for _, threads in ipairs({1, 2, 4, 8, 16}) do
+        box.cfg{memtx_sort_threads = threads}
+        local start = clock.monotonic()
+        local index = s:create_index(name, opts)
+        file:write(string.format("%s, %d records, %2d threads: %.3f sec\n",
+                                 name, n_records, threads,
+                                 clock.monotonic() - start))
+        ok = ok and check(index)
+        index:drop()
+    end
+    return ok
+end;
+test_run:cmd("setopt delimiter ''");
+
+sort_threads = box.cfg.memtx_sort_threads
+bench('string', {parts = {3, 'string'}})
+bench('unsigned', {parts = {2, 'unsigned'}, unique = false})
+box.cfg{memtx_sort_threads = sort_threads}
+
+s:drop()
+file:close()
@@ -0,0 +1,56 @@
+env = require('test_run').new()
+digest = require('digest')
+
+--
+-- Snapshot written by several threads.
+--
+box.cfg{memtx_snap_threads = 0}
+box.cfg{memtx_snap_threads = 'invalid'}
+box.cfg{memtx_snap_threads = 4}
+box.cfg.memtx_snap_threads
+
+for i = 1, 3 do _ = box.schema.space.create('snap' .. i):create_index('pk') end
+_ = box.space.snap2:create_index('sk', {parts = {2, 'string'}})
+box.begin() for i = 1, 10000 do box.space.snap1:insert{i} end box.commit()
+box.begin() for i = 1, 10000 do box.space.snap2:insert{i, digest.urandom(16):hex()} end box.commit()
+for i = 1, 64 do box.space.snap3:insert{i, digest.urandom(64 * 1024)} end
+
+--
+-- Secondary keys of a space with more than one of them are
+-- built by several threads on recovery.
+--
+s = box.schema.space.create('snap4')
+_ = s:create_index('pk')
+_ = s:create_index('sk1', {parts = {2, 'string'}})
+_ = s:create_index('sk2', {parts = {3, 'unsigned'}, unique = false})
+_ = s:create_index('sk3', {type = 'hash', parts = {2, 'string'}})
+box.begin() for i = 1, 20000 do s:insert{i, digest.md5_hex(tostring(i)), i % 100} end box.commit()
+
+box.snapshot()
+
+env:cmd('restart server default')
+box.space.snap1:count()
+box.space.snap2:count()
+box.space.snap3:count()
+box.space.snap2.index.sk:count()
+s = box.space.snap4
+s:count()
+s.index.sk1:count()
+s.index.sk2:count()
+s.index.sk3:count()
+s.index.sk2:count(42)
+ok = true
+for _, t in s:pairs() do if s.index.sk1:get(t[2])[1] ~= t[1] or s.index.sk3:get(t[2])[1] ~= t[1] then ok = false end end
+ok
+prev = nil
+for _, t in s.index.sk2:pairs() do if prev ~= nil and (prev[3] > t[3] or prev[3] == t[3] and prev[1] >= t[1]) then ok = false end prev = t end
+ok
+prev = nil
+for _, t in s.index.sk1:pairs() do if prev ~= nil and prev[2] >= t[2] then ok = false end prev = t end
+ok
+
+stat = box.info.memtx().recovery
+stat.snap_rows > 20000
+stat.index_done == stat.index_total
+
+for i = 1, 4 do box.space['snap' .. i]:drop() end
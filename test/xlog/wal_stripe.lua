@@ -0,0 +1,11 @@
+#!/usr/bin/env tarantool
+
+local fio = require('fio')
+fio.mkdir('stripe1')
+
+box.cfg {
+    listen = os.getenv("LISTEN"),
+    wal_stripe_dirs = {'stripe1'},
+}
+
+require('console').listen(os.getenv('ADMIN'))
@@ -0,0 +1,40 @@
+env = require('test_run')
+test_run = env.new()
+
+test_run:cmd('create server test with script = "xlog/wal_stripe.lua"')
+test_run:cmd("start server test")
+test_run:cmd("switch test")
+
+fio = require('fio')
+box.cfg.wal_stripe_dirs
+
+-- Local transactions are spread over all stripes.
+s = box.schema.space.create('test')
+_ = s:create_index('pk')
+for i = 1, 10 do s:replace{i} end
+#fio.glob(fio.pathjoin(box.cfg.wal_dir, '*.xlog')) > 0
+#fio.glob(fio.pathjoin('stripe1', '*.xlog')) > 0
+for i = 1, 10 do s:replace{0, i} end
+
+-- Rows are recovered from all stripes in LSN order.
+test_run:cmd("restart server test")
+fio = require('fio')
+s = box.space.test
+s:count()
+s:get(0)
+for i = 11, 20 do s:replace{i} end
+
+-- Checkpoint rotates all stripes.
+box.snapshot()
+s:replace{21}
+test_run:cmd("restart server test")
+s = box.space.test
+s:count()
+s:get(21)
+
+-- Vinyl isn't supported.
+box.schema.space.create('vinyl', {engine = 'vinyl'})
+
+test_run:cmd("switch default")
+test_run:cmd("stop server test")
+test_run:cmd("cleanup server test")
@@ -0,0 +1,36 @@
+env = require('test_run')
+test_run = env.new()
+
+test_run:cmd('create server test with script = "xlog/wal_stripe.lua"')
+test_run:cmd("start server test")
+test_run:cmd("switch test")
+
+fiber = require('fiber')
+s = box.schema.space.create('test')
+_ = s:create_index('pk')
+s:replace{0}
+
+-- A failed write rolls back all transactions submitted
+-- after it, whichever stripe they were sent to.
+box.error.injection.set("ERRINJ_WAL_WRITE", true)
+ch = fiber.channel(10)
+for i = 1, 10 do fiber.create(function() ch:put((pcall(s.replace, s, {i}))) end) end
+ok = 0
+for i = 1, 10 do if ch:get() then ok = ok + 1 end end
+ok
+s:count()
+box.error.injection.set("ERRINJ_WAL_WRITE", false)
+
+-- Writes resume once all stripes have rolled back.
+for i = 1, 10 do s:replace{i} end
+s:count()
+
+-- LSNs of the failed writes are reused, so there's no gap.
+test_run:cmd("restart server test")
+s = box.space.test
+s:count()
+s:get(10)
+
+test_run:cmd("switch default")
+test_run:cmd("stop server test")
+test_run:cmd("cleanup server test")